@@ -0,0 +1,284 @@
+#include "bench.h"
+
+#include <server_lib/revision.h>
+
+#include <boost/asio/ip/host_name.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+namespace bench {
+
+    namespace {
+        struct scenario
+        {
+            std::string name;
+            uint64_t iterations;
+            scenario_type callback;
+        };
+
+        std::vector<scenario>& scenarios()
+        {
+            static std::vector<scenario> instance;
+            return instance;
+        }
+
+        struct run_result
+        {
+            uint64_t items = 0;
+            uint64_t bytes = 0;
+            double seconds = 0;
+            double items_per_second = 0;
+            double bytes_per_second = 0;
+            latency_summary latency;
+            std::string error;
+        };
+
+        std::string escape(const std::string& value)
+        {
+            std::stringstream ss;
+            for (auto ch : value)
+            {
+                switch (ch)
+                {
+                case '"':
+                    ss << "\\\"";
+                    break;
+                case '\\':
+                    ss << "\\\\";
+                    break;
+                case '\n':
+                    ss << "\\n";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20)
+                        ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(ch) << std::dec;
+                    else
+                        ss << ch;
+                }
+            }
+            return ss.str();
+        }
+
+        std::string now_iso()
+        {
+            auto now = std::time(nullptr);
+            char buff[32];
+            std::strftime(buff, sizeof(buff), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+            return buff;
+        }
+
+        run_result run_once(const scenario& item, uint64_t iterations)
+        {
+            bench_state state { iterations };
+            try
+            {
+                item.callback(state);
+            }
+            catch (const std::exception& e)
+            {
+                state.set_error(e.what());
+            }
+
+            run_result result;
+            result.error = state.error();
+            result.items = state.items();
+            result.bytes = state.bytes();
+            result.seconds = std::chrono::duration<double>(state.elapsed()).count();
+            if (result.seconds > 0)
+            {
+                result.items_per_second = static_cast<double>(result.items) / result.seconds;
+                result.bytes_per_second = static_cast<double>(result.bytes) / result.seconds;
+            }
+            result.latency = state.latency().summary();
+            return result;
+        }
+
+        void write_latency(std::ostream& out, const latency_summary& latency)
+        {
+            out << "{ \"count\": " << latency.count
+                << ", \"min\": " << latency.min.count()
+                << ", \"mean\": " << latency.mean.count()
+                << ", \"p50\": " << latency.p50.count()
+                << ", \"p90\": " << latency.p90.count()
+                << ", \"p99\": " << latency.p99.count()
+                << ", \"p999\": " << latency.p999.count()
+                << ", \"max\": " << latency.max.count() << " }";
+        }
+    } // namespace
+
+    bench_state::bench_state(uint64_t iterations)
+        : _iterations(iterations)
+    {
+        _started = _stopped = clock_type::now();
+    }
+
+    void bench_state::start()
+    {
+        _running = true;
+        _started = clock_type::now();
+    }
+
+    void bench_state::stop()
+    {
+        _stopped = clock_type::now();
+        _running = false;
+    }
+
+    std::chrono::nanoseconds bench_state::elapsed() const
+    {
+        auto stopped = _running ? clock_type::now() : _stopped;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(stopped - _started);
+    }
+
+    uint64_t bench_state::items() const
+    {
+        return _items ? _items : _iterations;
+    }
+
+    void completion::set(const std::string& error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_done)
+                return;
+            _done = true;
+            _error = error;
+        }
+        _condition.notify_all();
+    }
+
+    bool completion::wait(std::chrono::seconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_condition.wait_for(lock, timeout, [this]() { return _done; }))
+        {
+            _error = "Timeout";
+            return false;
+        }
+        return _error.empty();
+    }
+
+    void register_scenario(const std::string& name, uint64_t iterations, scenario_type&& callback)
+    {
+        scenarios().push_back({ name, iterations, std::move(callback) });
+    }
+
+    int run(const run_options& options)
+    {
+        if (options.list)
+        {
+            for (auto&& item : scenarios())
+                std::cout << item.name << std::endl;
+            return 0;
+        }
+
+        std::unique_ptr<std::ofstream> file;
+        if (!options.output.empty())
+        {
+            file = std::make_unique<std::ofstream>(options.output);
+            if (!file->is_open())
+            {
+                std::cerr << "Can't open " << options.output << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = file ? *file : std::cout;
+
+        out << "{\n";
+        out << "  \"context\": {\n";
+        out << "    \"date\": \"" << now_iso() << "\",\n";
+        out << "    \"host_name\": \"" << escape(boost::asio::ip::host_name()) << "\",\n";
+        out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "    \"library\": \"" << escape(PRJ_NAME) << "\",\n";
+        out << "    \"library_version\": \"" << escape(PRJ_VER) << "\",\n";
+        out << "    \"git_revision\": \"" << escape(PRJ_GIT_REVISION_SHA) << "\",\n";
+#if defined(NDEBUG)
+        out << "    \"library_build_type\": \"release\",\n";
+#else
+        out << "    \"library_build_type\": \"debug\",\n";
+#endif
+        out << "    \"repetitions\": " << options.repetitions << ",\n";
+        out << "    \"scale\": " << options.scale << "\n";
+        out << "  },\n";
+        out << "  \"benchmarks\": [";
+
+        int failed = 0;
+        bool first = true;
+        for (auto&& item : scenarios())
+        {
+            if (!options.filter.empty() && item.name.find(options.filter) == std::string::npos)
+                continue;
+
+            auto iterations = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(item.iterations) * options.scale));
+
+            std::cerr << item.name << " (" << iterations << ")" << std::flush;
+
+            std::vector<run_result> results;
+            std::string error;
+            for (size_t ci = 0; ci < std::max<size_t>(1, options.repetitions); ++ci)
+            {
+                auto result = run_once(item, iterations);
+                if (!result.error.empty())
+                {
+                    error = result.error;
+                    break;
+                }
+                std::cerr << " " << std::fixed << std::setprecision(0) << result.items_per_second << "/s" << std::flush;
+                results.emplace_back(std::move(result));
+            }
+            std::cerr << std::endl;
+
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "    {\n";
+            out << "      \"name\": \"" << escape(item.name) << "\",\n";
+            out << "      \"iterations\": " << iterations << ",\n";
+            if (!error.empty())
+            {
+                ++failed;
+                std::cerr << item.name << " failed: " << error << std::endl;
+                out << "      \"error\": \"" << escape(error) << "\"\n";
+                out << "    }";
+                continue;
+            }
+
+            // Median run is reported (it is stable for noisy hosts)
+            std::sort(results.begin(), results.end(), [](const run_result& a, const run_result& b) {
+                return a.items_per_second < b.items_per_second;
+            });
+            const auto& median = results[results.size() / 2];
+
+            out << std::setprecision(6) << std::defaultfloat;
+            out << "      \"items\": " << median.items << ",\n";
+            out << "      \"bytes\": " << median.bytes << ",\n";
+            out << "      \"real_time_sec\": " << median.seconds << ",\n";
+            out << "      \"items_per_second\": " << median.items_per_second << ",\n";
+            out << "      \"items_per_second_min\": " << results.front().items_per_second << ",\n";
+            out << "      \"items_per_second_max\": " << results.back().items_per_second << ",\n";
+            out << "      \"bytes_per_second\": " << median.bytes_per_second;
+            if (median.latency.count)
+            {
+                out << ",\n      \"latency_ns\": ";
+                write_latency(out, median.latency);
+            }
+            out << "\n    }";
+        }
+
+        out << "\n  ]\n}\n";
+        out.flush();
+
+        return failed ? 1 : 0;
+    }
+
+} // namespace bench
+} // namespace server_lib
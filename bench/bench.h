@@ -0,0 +1,143 @@
+#pragma once
+
+#include <server_lib/loop_stats.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace server_lib {
+namespace bench {
+
+    /**
+     * State of single scenario run. Scenario performs 'iterations'
+     * operations between start() and stop() and reports
+     * how many items (bytes) have been processed
+     */
+    class bench_state
+    {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        explicit bench_state(uint64_t iterations);
+
+        uint64_t iterations() const
+        {
+            return _iterations;
+        }
+
+        void start();
+        void stop();
+
+        // Items are iterations if not set
+        void set_items(uint64_t items)
+        {
+            _items = items;
+        }
+
+        void set_bytes(uint64_t bytes)
+        {
+            _bytes = bytes;
+        }
+
+        // Fail scenario (result is reported with error)
+        void set_error(const std::string& error)
+        {
+            _error = error;
+        }
+
+        // Per operation latency (optional)
+        latency_histogram& latency()
+        {
+            return _latency;
+        }
+
+        std::chrono::nanoseconds elapsed() const;
+
+        uint64_t items() const;
+
+        uint64_t bytes() const
+        {
+            return _bytes;
+        }
+
+        const std::string& error() const
+        {
+            return _error;
+        }
+
+    private:
+        const uint64_t _iterations;
+        clock_type::time_point _started;
+        clock_type::time_point _stopped;
+        bool _running = false;
+        uint64_t _items = 0;
+        uint64_t _bytes = 0;
+        std::string _error;
+        latency_histogram _latency;
+    };
+
+    /**
+     * One shot event for asynchronous scenarios.
+     * The first set() wins
+     */
+    class completion
+    {
+    public:
+        void set(const std::string& error = {});
+
+        // Return 'false' on timeout or error
+        bool wait(std::chrono::seconds timeout = std::chrono::seconds(60));
+
+        const std::string& error() const
+        {
+            return _error;
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _done = false;
+        std::string _error;
+    };
+
+    using scenario_type = std::function<void(bench_state&)>;
+
+    /**
+     * Add scenario with default iterations count
+     * (it is scaled by command line)
+     */
+    void register_scenario(const std::string& name, uint64_t iterations, scenario_type&& scenario);
+
+    struct scenario_registrar
+    {
+        scenario_registrar(const std::string& name, uint64_t iterations, scenario_type&& scenario)
+        {
+            register_scenario(name, iterations, std::move(scenario));
+        }
+    };
+
+    struct run_options
+    {
+        // Substring of scenario name
+        std::string filter;
+        size_t repetitions = 3;
+        double scale = 1.0;
+        // Output file for JSON report. stdout if empty
+        std::string output;
+        bool list = false;
+    };
+
+    // Run scenarios and write JSON report
+    int run(const run_options&);
+
+} // namespace bench
+} // namespace server_lib
+
+#define SERVER_LIB_BENCH(NAME, ITERATIONS)                                                   \
+    static void NAME(server_lib::bench::bench_state&);                                       \
+    static server_lib::bench::scenario_registrar NAME##_registrar(#NAME, ITERATIONS, NAME); \
+    static void NAME(server_lib::bench::bench_state& state)
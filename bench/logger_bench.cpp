@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <server_lib/platform_config.h>
+#include <server_lib/logger.h>
+#include <server_lib/logging_helper.h>
+
+#include <boost/filesystem.hpp>
+
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+namespace bench {
+
+    namespace {
+        class log_directory
+        {
+        public:
+            log_directory()
+            {
+                _path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("server_lib_bench_%%%%%%%%");
+                boost::filesystem::create_directories(_path);
+            }
+
+            ~log_directory()
+            {
+                boost::system::error_code ec;
+                boost::filesystem::remove_all(_path, ec);
+            }
+
+            std::string file() const
+            {
+                return (_path / "bench_%N.log").string();
+            }
+
+        private:
+            boost::filesystem::path _path;
+        };
+
+        // Logger is singleton so it is initialized once for all scenarios
+        void init_log()
+        {
+            static log_directory directory;
+            static bool initialized = [&]() {
+                const size_t rotation_size_kb = 64 * 1024;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+                logger::instance().init_mmap_file_log(directory.file().c_str(), rotation_size_kb);
+#else
+                logger::instance().init_file_log(directory.file().c_str(), rotation_size_kb);
+#endif
+                return true;
+            }();
+            (void)initialized;
+
+            logger::instance().set_level(logger::level_info);
+        }
+
+        void logger_records(bench_state& state, size_t writers)
+        {
+            init_log();
+
+            const auto total = state.iterations();
+
+            state.start();
+            std::vector<std::thread> threads;
+            for (size_t ci = 0; ci < writers; ++ci)
+            {
+                auto count = total / writers + (ci < total % writers ? 1 : 0);
+                threads.emplace_back([count]() {
+                    for (uint64_t cj = 0; cj < count; ++cj)
+                        LOG_INFO("Bench record #" << cj << " with some payload: " << 3.14159 * static_cast<double>(cj));
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            logger::instance().flush();
+            state.stop();
+        }
+    } // namespace
+
+    static scenario_registrar logger_records_1_writer_registrar("logger_records_1_writer", 500000, [](bench_state& state) {
+        logger_records(state, 1);
+    });
+
+    static scenario_registrar logger_records_4_writers_registrar("logger_records_4_writers", 500000, [](bench_state& state) {
+        logger_records(state, 4);
+    });
+
+    // Records below level filter should be almost free
+    SERVER_LIB_BENCH(logger_records_filtered, 10000000)
+    {
+        init_log();
+
+        state.start();
+        for (uint64_t ci = 0; ci < state.iterations(); ++ci)
+            LOG_TRACE("Filtered record #" << ci);
+        state.stop();
+    }
+
+} // namespace bench
+} // namespace server_lib
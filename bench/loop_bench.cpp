@@ -0,0 +1,102 @@
+#include "bench.h"
+
+#include <server_lib/event_loop.h>
+#include <server_lib/timers.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+namespace bench {
+
+    namespace {
+        // Handlers are posted from other threads (like network workers do)
+        void event_loop_post(bench_state& state, size_t producers)
+        {
+            event_loop loop;
+            loop.change_loop_name("bench");
+            loop.start();
+            loop.wait_result(true, [] { return true; });
+
+            const auto total = state.iterations();
+            uint64_t executed = 0;
+            std::promise<void> done;
+
+            auto handler = [&]() {
+                if (++executed == total)
+                    done.set_value();
+            };
+
+            state.start();
+            std::vector<std::thread> threads;
+            for (size_t ci = 0; ci < producers; ++ci)
+            {
+                auto count = total / producers + (ci < total % producers ? 1 : 0);
+                threads.emplace_back([&loop, &handler, count]() {
+                    for (uint64_t cj = 0; cj < count; ++cj)
+                        loop.post(handler);
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            done.get_future().wait();
+            state.stop();
+
+            loop.stop();
+        }
+    } // namespace
+
+    static scenario_registrar event_loop_post_1_producer_registrar("event_loop_post_1_producer", 1000000, [](bench_state& state) {
+        event_loop_post(state, 1);
+    });
+
+    static scenario_registrar event_loop_post_4_producers_registrar("event_loop_post_4_producers", 1000000, [](bench_state& state) {
+        event_loop_post(state, 4);
+    });
+
+    // Idle timeouts are restarted for every request. Every restart
+    // schedules new deadline and cancels previous one
+    SERVER_LIB_BENCH(timer_churn, 200000)
+    {
+        event_loop loop;
+        loop.change_loop_name("bench");
+        loop.start();
+        loop.wait_result(true, [] { return true; });
+
+        const size_t timers_count = 1000;
+        const auto total = state.iterations();
+
+        std::vector<std::unique_ptr<timer<event_loop>>> timers;
+        for (size_t ci = 0; ci < timers_count; ++ci)
+            timers.emplace_back(std::make_unique<timer<event_loop>>(loop));
+
+        std::atomic<uint64_t> fired { 0 };
+        std::promise<void> done;
+
+        state.start();
+        loop.post([&]() {
+            for (uint64_t ci = 0; ci < total; ++ci)
+            {
+                timers[ci % timers_count]->start(std::chrono::milliseconds(1 + ci % 4), [&fired]() {
+                    ++fired;
+                });
+            }
+            done.set_value();
+        });
+        done.get_future().wait();
+        state.stop();
+
+        // Wait for last deadlines
+        loop.wait_result(true, [] { return true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        loop.stop();
+
+        if (fired > timers_count)
+            state.set_error("Restarted timers have been fired");
+    }
+
+} // namespace bench
+} // namespace server_lib
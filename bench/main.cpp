@@ -0,0 +1,44 @@
+#include "bench.h"
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    namespace bpo = boost::program_options;
+
+    server_lib::bench::run_options options;
+
+    bpo::options_description description("server_lib_bench options");
+    // clang-format off
+    description.add_options()
+        ("help,h", "Print this help")
+        ("list,l", bpo::bool_switch(&options.list), "List scenarios")
+        ("filter,f", bpo::value<std::string>(&options.filter), "Run scenarios with names that contain substring")
+        ("repetitions,r", bpo::value<size_t>(&options.repetitions)->default_value(options.repetitions), "Runs of every scenario. Median run is reported")
+        ("scale,s", bpo::value<double>(&options.scale)->default_value(options.scale), "Multiplier of default iterations")
+        ("output,o", bpo::value<std::string>(&options.output), "JSON report file (stdout by default)");
+    // clang-format on
+
+    try
+    {
+        bpo::variables_map vm;
+        bpo::store(bpo::parse_command_line(argc, argv, description), vm);
+        bpo::notify(vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << description << std::endl;
+            return 0;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n"
+                  << description << std::endl;
+        return 1;
+    }
+
+    return server_lib::bench::run(options);
+}
@@ -0,0 +1,208 @@
+#include "bench.h"
+
+#include <server_lib/platform_config.h>
+
+#include <server_lib/network/server.h>
+#include <server_lib/network/client.h>
+#include <server_lib/network/protocols.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <string>
+
+namespace server_lib {
+namespace bench {
+
+    using namespace server_lib::network;
+
+    namespace {
+        const size_t max_msg_size = 64 * 1024;
+
+        unsigned short get_free_port()
+        {
+            boost::asio::io_service service;
+            boost::asio::ip::tcp::acceptor acceptor(service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+            return acceptor.local_endpoint().port();
+        }
+
+        tcp_server_config tcp_server(const unit_builder_i& protocol, unsigned short port)
+        {
+            return server::configurate_tcp()
+                .set_worker_name("bench-S")
+                .set_address("127.0.0.1", port)
+                .set_protocol(protocol);
+        }
+
+        tcp_client_config tcp_client(const unit_builder_i& protocol, unsigned short port)
+        {
+            return client::configurate_tcp()
+                .set_worker_name("bench-C")
+                .set_address("127.0.0.1", port)
+                .set_protocol(protocol);
+        }
+
+        unix_local_server_config unix_server(const unit_builder_i& protocol, const std::string& socket_file)
+        {
+            return server::configurate_unix_local()
+                .set_worker_name("bench-S")
+                .set_socket_file(socket_file)
+                .set_protocol(protocol);
+        }
+
+        unix_local_client_config unix_client(const unit_builder_i& protocol, const std::string& socket_file)
+        {
+            return client::configurate_unix_local()
+                .set_worker_name("bench-C")
+                .set_socket_file(socket_file)
+                .set_protocol(protocol);
+        }
+
+        // Start server and connect client. Return client connection
+        template <typename ServerConfig, typename ClientConfig>
+        pconnection connect(bench_state& state,
+                            server& server, const ServerConfig& server_config,
+                            client& client, const ClientConfig& client_config,
+                            std::function<void(pconnection, unit)>&& server_receive,
+                            std::function<void(pconnection, unit)>&& client_receive)
+        {
+            completion started;
+            server.on_start([&]() { started.set(); })
+                .on_fail([&](const std::string& error) { started.set(error); })
+                .on_new_connection([server_receive](pconnection pconn) {
+                    pconn->on_receive(connection::receive_callback_type { server_receive });
+                })
+                .start(server_config);
+            if (!started.wait())
+            {
+                state.set_error("Server: " + started.error());
+                return {};
+            }
+
+            completion connected;
+            pconnection result;
+            client.on_connect([&](pconnection pconn) {
+                      pconn->on_receive(std::move(client_receive));
+                      result = pconn;
+                      connected.set();
+                  })
+                .on_fail([&](const std::string& error) { connected.set(error); });
+            if (!client.connect(client_config) || !connected.wait())
+            {
+                state.set_error("Client: " + connected.error());
+                return {};
+            }
+            return result;
+        }
+
+        // Request is sent after response for previous one
+        template <typename ServerConfig, typename ClientConfig>
+        void ping_pong(bench_state& state, const ServerConfig& server_config, const ClientConfig& client_config, size_t payload_size)
+        {
+            using clock_type = bench_state::clock_type;
+
+            const std::string payload(payload_size, 'p');
+            const auto total = state.iterations();
+
+            server server;
+            client client;
+
+            completion done;
+            uint64_t pongs = 0;
+            clock_type::time_point sent;
+
+            auto server_receive = [](pconnection pconn, unit unit) {
+                pconn->send(unit.as_string());
+            };
+            auto client_receive = [&](pconnection pconn, unit) {
+                auto now = clock_type::now();
+                state.latency().record(now - sent);
+                if (++pongs == total)
+                {
+                    done.set();
+                    return;
+                }
+                sent = now;
+                pconn->send(payload);
+            };
+
+            auto pconn = connect(state, server, server_config, client, client_config, server_receive, client_receive);
+            if (!pconn)
+                return;
+
+            state.start();
+            sent = clock_type::now();
+            pconn->send(payload);
+            if (!done.wait())
+                state.set_error(done.error());
+            state.stop();
+
+            state.set_bytes(total * payload_size * 2);
+        }
+
+        // Client sends messages without waiting
+        template <typename ServerConfig, typename ClientConfig>
+        void streaming(bench_state& state, const ServerConfig& server_config, const ClientConfig& client_config, size_t payload_size)
+        {
+            const std::string payload(payload_size, 's');
+            const auto total = state.iterations();
+
+            server server;
+            client client;
+
+            completion done;
+            std::atomic<uint64_t> received { 0 };
+
+            auto server_receive = [&](pconnection, unit) {
+                if (++received == total)
+                    done.set();
+            };
+            auto client_receive = [](pconnection, unit) {};
+
+            auto pconn = connect(state, server, server_config, client, client_config, server_receive, client_receive);
+            if (!pconn)
+                return;
+
+            state.start();
+            for (uint64_t ci = 0; ci < total; ++ci)
+                pconn->send(payload);
+            if (!done.wait())
+                state.set_error(done.error());
+            state.stop();
+
+            state.set_bytes(total * payload_size);
+        }
+    } // namespace
+
+    SERVER_LIB_BENCH(tcp_ping_pong_64, 50000)
+    {
+        msg_protocol protocol { max_msg_size };
+        auto port = get_free_port();
+        ping_pong(state, tcp_server(protocol, port), tcp_client(protocol, port), 64);
+    }
+
+    SERVER_LIB_BENCH(tcp_streaming_1024, 200000)
+    {
+        msg_protocol protocol { max_msg_size };
+        auto port = get_free_port();
+        streaming(state, tcp_server(protocol, port), tcp_client(protocol, port), 1024);
+    }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    SERVER_LIB_BENCH(unix_ping_pong_64, 50000)
+    {
+        msg_protocol protocol { max_msg_size };
+        auto socket_file = unix_local_server_config::preserve_socket_file();
+        ping_pong(state, unix_server(protocol, socket_file), unix_client(protocol, socket_file), 64);
+    }
+
+    SERVER_LIB_BENCH(unix_streaming_1024, 200000)
+    {
+        msg_protocol protocol { max_msg_size };
+        auto socket_file = unix_local_server_config::preserve_socket_file();
+        streaming(state, unix_server(protocol, socket_file), unix_client(protocol, socket_file), 1024);
+    }
+#endif
+
+} // namespace bench
+} // namespace server_lib
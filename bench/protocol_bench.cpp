@@ -0,0 +1,123 @@
+#include "bench.h"
+
+#include <server_lib/network/protocols.h>
+
+#include <string>
+
+namespace server_lib {
+namespace bench {
+
+    namespace {
+        const size_t max_msg_size = 64 * 1024;
+
+        // Fixed payload for reproducible results
+        std::string make_payload(size_t size)
+        {
+            std::string payload;
+            payload.reserve(size);
+            for (size_t ci = 0; ci < size; ++ci)
+                payload.push_back(static_cast<char>('a' + ci % 26));
+            return payload;
+        }
+
+        void encode(bench_state& state, const network::unit_builder_i& builder, size_t payload_size)
+        {
+            auto payload = make_payload(payload_size);
+            uint64_t bytes = 0;
+
+            state.start();
+            for (uint64_t ci = 0; ci < state.iterations(); ++ci)
+            {
+                auto unit = builder.create(payload);
+                bytes += unit.to_network_string().size();
+            }
+            state.stop();
+
+            state.set_bytes(bytes);
+        }
+
+        // Stream is parsed the way connection does it: chunk is appended
+        // to buffer and builder consumes units from the buffer front
+        void decode(bench_state& state, network::unit_builder_i& builder, size_t payload_size)
+        {
+            const size_t units_per_chunk = 16;
+
+            auto payload = make_payload(payload_size);
+            std::string chunk;
+            for (size_t ci = 0; ci < units_per_chunk; ++ci)
+                chunk.append(builder.create(payload).to_network_string());
+
+            const auto chunks = (state.iterations() + units_per_chunk - 1) / units_per_chunk;
+            uint64_t units = 0;
+            uint64_t bytes = 0;
+
+            state.start();
+            for (uint64_t ci = 0; ci < chunks; ++ci)
+            {
+                std::string buffer = chunk;
+                while (!buffer.empty())
+                {
+                    builder << buffer;
+                    if (!builder.unit_ready())
+                        break;
+                    bytes += builder.get_unit().as_string().size();
+                    builder.reset();
+                    ++units;
+                }
+            }
+            state.stop();
+
+            if (units != chunks * units_per_chunk || bytes != units * payload_size)
+                state.set_error("Wrong units");
+
+            state.set_items(units);
+            state.set_bytes(chunks * chunk.size());
+        }
+    } // namespace
+
+    SERVER_LIB_BENCH(msg_protocol_encode_64, 2000000)
+    {
+        encode(state, network::msg_protocol { max_msg_size }, 64);
+    }
+
+    SERVER_LIB_BENCH(msg_protocol_encode_4096, 500000)
+    {
+        encode(state, network::msg_protocol { max_msg_size }, 4096);
+    }
+
+    SERVER_LIB_BENCH(msg_protocol_decode_64, 2000000)
+    {
+        network::msg_protocol builder { max_msg_size };
+        decode(state, builder, 64);
+    }
+
+    SERVER_LIB_BENCH(msg_protocol_decode_4096, 500000)
+    {
+        network::msg_protocol builder { max_msg_size };
+        decode(state, builder, 4096);
+    }
+
+    SERVER_LIB_BENCH(dstream_protocol_encode_64, 2000000)
+    {
+        encode(state, network::dstream_protocol {}, 64);
+    }
+
+    SERVER_LIB_BENCH(dstream_protocol_encode_4096, 500000)
+    {
+        encode(state, network::dstream_protocol {}, 4096);
+    }
+
+    SERVER_LIB_BENCH(dstream_protocol_decode_64, 2000000)
+    {
+        network::dstream_protocol builder;
+        decode(state, builder, 64);
+    }
+
+    SERVER_LIB_BENCH(dstream_protocol_decode_4096, 500000)
+    {
+        network::dstream_protocol builder;
+        decode(state, builder, 4096);
+    }
+
+} // namespace bench
+} // namespace server_lib
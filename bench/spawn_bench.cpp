@@ -0,0 +1,60 @@
+#include "bench.h"
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <server_lib/spawn.h>
+
+#include <vector>
+
+namespace server_lib {
+namespace bench {
+
+    namespace {
+        // Touched memory makes page tables of this process
+        // to be copied by fork
+        void inflate_rss()
+        {
+            static std::vector<char> rss = []() {
+                std::vector<char> result(128 * 1024 * 1024);
+                for (size_t ci = 0; ci < result.size(); ci += 4096)
+                    result[ci] = 1;
+                return result;
+            }();
+            (void)rss;
+        }
+
+        void spawn_launch(bench_state& state, spawn::launch_method launch)
+        {
+            inflate_rss();
+
+            using clock_type = bench_state::clock_type;
+
+            state.start();
+            for (uint64_t ci = 0; ci < state.iterations(); ++ci)
+            {
+                auto launch_time = clock_type::now();
+                spawn true_({ "true" }, {}, true, launch);
+                state.latency().record(clock_type::now() - launch_time);
+
+                if (true_.wait().returncode() != 0)
+                {
+                    state.set_error("Child has failed");
+                    break;
+                }
+            }
+            state.stop();
+        }
+    } // namespace
+
+    static scenario_registrar spawn_launch_fork_registrar("spawn_launch_fork", 200, [](bench_state& state) {
+        spawn_launch(state, spawn::launch_method::fork);
+    });
+
+    static scenario_registrar spawn_launch_posix_spawn_registrar("spawn_launch_posix_spawn", 200, [](bench_state& state) {
+        spawn_launch(state, spawn::launch_method::posix_spawn);
+    });
+
+} // namespace bench
+} // namespace server_lib
+#endif
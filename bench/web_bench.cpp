@@ -0,0 +1,111 @@
+#include "bench.h"
+
+#include <server_lib/network/web/web_server.h>
+#include <server_lib/network/web/web_client.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace server_lib {
+namespace bench {
+
+    using namespace server_lib::network::web;
+
+    namespace {
+        unsigned short get_free_port()
+        {
+            boost::asio::io_service service;
+            boost::asio::ip::tcp::acceptor acceptor(service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+            return acceptor.local_endpoint().port();
+        }
+
+        // Requests of every client slot are sent one after another
+        // by persistent (keep-alive) connections
+        void web_keep_alive(bench_state& state, size_t in_flight)
+        {
+            using clock_type = bench_state::clock_type;
+
+            const std::string path = "/bench";
+            const std::string body = "pong";
+            const auto total = state.iterations();
+
+            web_server server;
+            completion started;
+            server.on_request(path, "GET", [&body](std::shared_ptr<web_request_i>, std::shared_ptr<web_server_response_i> response) {
+                      response->post(http_status_code::success_ok, body, { { "Content-Type", "text/plain" } });
+                  })
+                .on_start([&]() { started.set(); })
+                .on_fail([&](std::shared_ptr<web_request_i> request, const std::string& error) {
+                    if (!request)
+                        started.set(error);
+                });
+
+            auto port = get_free_port();
+            server.start(server.configurate()
+                             .set_address("127.0.0.1", port)
+                             .set_worker_name("bench-S"));
+            if (!started.wait())
+            {
+                state.set_error("Server: " + started.error());
+                return;
+            }
+
+            web_client client;
+            if (!client.start(client.configurate()
+                                  .set_address("127.0.0.1", port)
+                                  .set_worker_name("bench-C"))
+                     .wait())
+            {
+                state.set_error("Client is not started");
+                return;
+            }
+
+            completion done;
+            std::atomic<uint64_t> sent { 0 };
+            std::atomic<uint64_t> received { 0 };
+
+            std::function<void()> send_next = [&]() {
+                if (sent++ >= total)
+                    return;
+
+                auto request_time = clock_type::now();
+                client.request(path, "GET", "", [&, request_time](std::shared_ptr<web_response_i> response, const std::string& error) {
+                    if (!response || !error.empty())
+                    {
+                        done.set("Request failed: " + error);
+                        return;
+                    }
+                    state.latency().record(clock_type::now() - request_time);
+                    if (++received == total)
+                    {
+                        done.set();
+                        return;
+                    }
+                    send_next();
+                });
+            };
+
+            state.start();
+            for (size_t ci = 0; ci < in_flight; ++ci)
+                send_next();
+            if (!done.wait())
+                state.set_error(done.error());
+            state.stop();
+
+            client.stop();
+            server.stop();
+        }
+    } // namespace
+
+    static scenario_registrar web_keep_alive_rps_1_registrar("web_keep_alive_rps_1", 20000, [](bench_state& state) {
+        web_keep_alive(state, 1);
+    });
+
+    static scenario_registrar web_keep_alive_rps_8_registrar("web_keep_alive_rps_8", 50000, [](bench_state& state) {
+        web_keep_alive(state, 8);
+    });
+
+} // namespace bench
+} // namespace server_lib
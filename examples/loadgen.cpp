@@ -0,0 +1,587 @@
+#include <server_lib/application.h>
+#include <server_lib/event_loop.h>
+#include <server_lib/loop_stats.h>
+#include <server_lib/network/client.h>
+#include <server_lib/network/protocols.h>
+#include <server_lib/network/web/web_client.h>
+
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//#define LOG_ON
+#if defined(LOG_ON)
+#include <server_lib/logger.h>
+#endif
+
+namespace {
+
+namespace network = server_lib::network;
+namespace web = server_lib::network::web;
+namespace bpo = boost::program_options;
+
+using clock_type = std::chrono::steady_clock;
+
+struct loadgen_options
+{
+    // tcp, unix or http
+    std::string mode = "tcp";
+    std::string host = "127.0.0.1";
+    unsigned short port = 19999;
+    std::string socket_file;
+    // msg or dstream for tcp/unix
+    std::string protocol = "msg";
+    std::string path = "/";
+    std::string method;
+    // Payload text. Message of 'size' bytes is used if empty
+    std::string message;
+    size_t size = 64;
+    size_t connections = 1;
+    // Requests in flight per connection
+    size_t depth = 1;
+    // Total requests per second. Closed loop if 0
+    double rate = 0;
+    size_t duration_sec = 10;
+    bool json = false;
+};
+
+/**
+ * Latency is measured from intended send time of request.
+ * For open loop it is time by schedule so requests that wait for
+ * slow responses (in backlog) are not omitted
+ * (coordinated omission correction). Service time is measured
+ * from actual send. Requests that are still in backlog when test
+ * is stopped are never sent. They are recorded to corrected latency
+ * as waiting until stop (lower bound) and counted as unsent.
+ */
+struct load_stats
+{
+    server_lib::latency_histogram corrected;
+    server_lib::latency_histogram service;
+    std::atomic<uint64_t> sent { 0 };
+    std::atomic<uint64_t> completed { 0 };
+    std::atomic<uint64_t> unsent { 0 };
+    std::atomic<uint64_t> errors { 0 };
+};
+
+struct request_times
+{
+    clock_type::time_point intended;
+    clock_type::time_point sent;
+};
+
+// Load of single connection
+class driver
+{
+public:
+    driver(const loadgen_options& options, load_stats& stats)
+        : _options(options)
+        , _stats(stats)
+    {
+    }
+
+    virtual ~driver() = default;
+
+    virtual bool connect() = 0;
+
+    // Request should be sent at 'intended' time
+    void schedule(clock_type::time_point intended)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        if (_stopped)
+            return;
+        _backlog.push_back(intended);
+        pump();
+    }
+
+    void stop(clock_type::time_point stopped)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _stopped = true;
+        for (auto&& intended : _backlog)
+        {
+            _stats.corrected.record(stopped - intended);
+            ++_stats.unsent;
+        }
+        _backlog.clear();
+    }
+
+    size_t in_flight() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _in_flight;
+    }
+
+protected:
+    virtual void send(const request_times&) = 0;
+
+    void on_response(const request_times& times, bool success)
+    {
+        auto now = clock_type::now();
+        if (success)
+        {
+            _stats.corrected.record(now - times.intended);
+            _stats.service.record(now - times.sent);
+            ++_stats.completed;
+        }
+        else
+        {
+            ++_stats.errors;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        --_in_flight;
+        // Closed loop sends next request at once
+        if (_options.rate <= 0 && !_stopped)
+            _backlog.push_back(now);
+        pump();
+    }
+
+    void on_disconnect()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _stats.errors += _backlog.size() + _in_flight;
+        _backlog.clear();
+        _in_flight = 0;
+        _stopped = true;
+    }
+
+    const loadgen_options& _options;
+    load_stats& _stats;
+
+private:
+    void pump()
+    {
+        while (!_stopped && _in_flight < _options.depth && !_backlog.empty())
+        {
+            request_times times { _backlog.front(), clock_type::now() };
+            _backlog.pop_front();
+            ++_in_flight;
+            ++_stats.sent;
+            send(times);
+        }
+    }
+
+    mutable std::recursive_mutex _mutex;
+    std::deque<clock_type::time_point> _backlog;
+    size_t _in_flight = 0;
+    bool _stopped = false;
+};
+
+// Server is expected to reply by one unit for every unit.
+// Replies are matched to requests in order
+class socket_driver : public driver
+{
+public:
+    socket_driver(const loadgen_options& options, load_stats& stats, const std::string& payload)
+        : driver(options, stats)
+        , _payload(payload)
+    {
+    }
+
+    ~socket_driver() override
+    {
+        _client.reset();
+    }
+
+    bool connect() override
+    {
+        const size_t max_msg_size = std::max<size_t>(1024, _payload.size());
+        std::unique_ptr<network::unit_builder_i> protocol;
+        if (_options.protocol == "dstream")
+            protocol = std::make_unique<network::dstream_protocol>();
+        else
+            protocol = std::make_unique<network::msg_protocol>(max_msg_size);
+
+        std::mutex guard;
+        std::condition_variable cond;
+        bool done = false;
+        bool connected = false;
+
+        auto finish = [&](bool result) {
+            std::unique_lock<std::mutex> lock(guard);
+            connected = result;
+            done = true;
+            cond.notify_one();
+        };
+
+        _client = std::make_unique<network::client>();
+        _client->on_connect([this, finish](network::pconnection pconn) {
+                   pconn->on_receive([this](network::pconnection, network::unit) {
+                            on_unit();
+                        })
+                       .on_disconnect([this](size_t) {
+                           on_disconnect();
+                       });
+                   _connection = pconn;
+                   finish(true);
+               })
+            .on_fail([finish](const std::string& error) {
+                std::cerr << "Can't connect: " << error << std::endl;
+                finish(false);
+            });
+
+        bool started = false;
+        if (_options.mode == "unix")
+        {
+            started = _client->connect(network::client::configurate_unix_local()
+                                           .set_socket_file(_options.socket_file)
+                                           .set_worker_name("loadgen")
+                                           .set_protocol(*protocol));
+        }
+        else
+        {
+            started = _client->connect(network::client::configurate_tcp()
+                                           .set_address(_options.host, _options.port)
+                                           .set_worker_name("loadgen")
+                                           .set_protocol(*protocol));
+        }
+        if (!started)
+            return false;
+
+        std::unique_lock<std::mutex> lock(guard);
+        if (!cond.wait_for(lock, std::chrono::seconds(10), [&]() { return done; }))
+            return false;
+        return connected;
+    }
+
+protected:
+    void send(const request_times& times) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_fifo_mutex);
+            _fifo.push_back(times);
+        }
+        _connection->send(_payload);
+    }
+
+private:
+    void on_unit()
+    {
+        request_times times;
+        {
+            std::lock_guard<std::mutex> lock(_fifo_mutex);
+            if (_fifo.empty())
+                return;
+            times = _fifo.front();
+            _fifo.pop_front();
+        }
+        on_response(times, true);
+    }
+
+    const std::string _payload;
+    std::unique_ptr<network::client> _client;
+    network::pconnection _connection;
+    std::mutex _fifo_mutex;
+    std::deque<request_times> _fifo;
+};
+
+// HTTP/1.1 keep-alive. Requests in flight are sent concurrently
+// (HTTP client doesn't pipeline)
+class http_driver : public driver
+{
+public:
+    http_driver(const loadgen_options& options, load_stats& stats, const std::string& payload)
+        : driver(options, stats)
+        , _payload(payload)
+    {
+    }
+
+    ~http_driver() override
+    {
+        _client.reset();
+    }
+
+    bool connect() override
+    {
+        _client = std::make_unique<web::web_client>();
+        _client->on_fail([](const std::string& error) {
+            std::cerr << "Can't start Web client: " << error << std::endl;
+        });
+        return _client->start(_client->configurate()
+                                  .set_address(_options.host, _options.port)
+                                  .set_worker_name("loadgen"))
+            .wait();
+    }
+
+protected:
+    void send(const request_times& times) override
+    {
+        _client->request(_options.path, _options.method, _payload,
+                         [this, times](std::shared_ptr<web::web_response_i> response, const std::string& error) {
+                             bool success = response && error.empty() && !response->status_code().empty() && response->status_code()[0] == '2';
+                             on_response(times, success);
+                         });
+    }
+
+private:
+    const std::string _payload;
+    std::unique_ptr<web::web_client> _client;
+};
+
+std::string to_ms(std::chrono::nanoseconds value)
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << static_cast<double>(value.count()) / 1e6;
+    return ss.str();
+}
+
+void print_latency(std::ostream& out, const char* title, const server_lib::latency_summary& latency)
+{
+    out << title << " (ms):\n"
+        << "  min " << to_ms(latency.min)
+        << "  p50 " << to_ms(latency.p50)
+        << "  p90 " << to_ms(latency.p90)
+        << "  p99 " << to_ms(latency.p99)
+        << "  p99.9 " << to_ms(latency.p999)
+        << "  max " << to_ms(latency.max)
+        << "  mean " << to_ms(latency.mean) << "\n";
+}
+
+void print_json_latency(std::ostream& out, const server_lib::latency_summary& latency)
+{
+    out << "{ \"count\": " << latency.count
+        << ", \"min_ns\": " << latency.min.count()
+        << ", \"p50_ns\": " << latency.p50.count()
+        << ", \"p90_ns\": " << latency.p90.count()
+        << ", \"p99_ns\": " << latency.p99.count()
+        << ", \"p999_ns\": " << latency.p999.count()
+        << ", \"max_ns\": " << latency.max.count()
+        << ", \"mean_ns\": " << latency.mean.count() << " }";
+}
+
+int run_load(const loadgen_options& options, const std::atomic_bool& interrupted)
+{
+    std::string payload = options.message;
+    if (payload.empty())
+    {
+        for (size_t ci = 0; ci < options.size; ++ci)
+            payload.push_back(static_cast<char>('a' + ci % 26));
+    }
+
+    load_stats stats;
+
+    std::vector<std::unique_ptr<driver>> drivers;
+    for (size_t ci = 0; ci < options.connections; ++ci)
+    {
+        std::unique_ptr<driver> item;
+        if (options.mode == "http")
+            item = std::make_unique<http_driver>(options, stats, payload);
+        else
+            item = std::make_unique<socket_driver>(options, stats, payload);
+        if (!item->connect())
+        {
+            std::cerr << "Connection #" << ci << " failed" << std::endl;
+            return 1;
+        }
+        drivers.emplace_back(std::move(item));
+    }
+
+    auto started = clock_type::now();
+    auto finish = started + std::chrono::seconds(options.duration_sec);
+
+    if (options.rate > 0)
+    {
+        // Open loop. Requests are scheduled by fixed intervals
+        // independently on responses
+        const auto interval = std::chrono::duration<double>(static_cast<double>(options.connections) / options.rate);
+        std::vector<uint64_t> scheduled(drivers.size(), 0);
+        while (!interrupted)
+        {
+            auto now = clock_type::now();
+            if (now >= finish)
+                break;
+
+            for (size_t ci = 0; ci < drivers.size(); ++ci)
+            {
+                // Connections are shifted to spread requests over interval
+                auto offset = interval * (static_cast<double>(ci) / static_cast<double>(drivers.size()));
+                while (true)
+                {
+                    auto intended = started + std::chrono::duration_cast<clock_type::duration>(offset + interval * static_cast<double>(scheduled[ci]));
+                    if (intended > now)
+                        break;
+                    drivers[ci]->schedule(intended);
+                    ++scheduled[ci];
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    else
+    {
+        // Closed loop. Next request is sent after response
+        for (auto&& item : drivers)
+        {
+            for (size_t ci = 0; ci < options.depth; ++ci)
+                item->schedule(started);
+        }
+        while (!interrupted && clock_type::now() < finish)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto stopped = clock_type::now();
+    for (auto&& item : drivers)
+        item->stop(stopped);
+
+    // Drain requests in flight
+    auto drain_deadline = clock_type::now() + std::chrono::seconds(5);
+    for (auto&& item : drivers)
+    {
+        while (item->in_flight() && clock_type::now() < drain_deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    drivers.clear();
+
+    auto elapsed = std::chrono::duration<double>(stopped - started).count();
+    auto throughput = elapsed > 0 ? static_cast<double>(stats.completed) / elapsed : 0;
+    auto corrected = stats.corrected.summary();
+    auto service = stats.service.summary();
+
+    if (options.json)
+    {
+        std::cout << "{\n"
+                  << "  \"mode\": \"" << options.mode << "\",\n"
+                  << "  \"connections\": " << options.connections << ",\n"
+                  << "  \"depth\": " << options.depth << ",\n"
+                  << "  \"rate\": " << options.rate << ",\n"
+                  << "  \"message_size\": " << payload.size() << ",\n"
+                  << "  \"duration_sec\": " << elapsed << ",\n"
+                  << "  \"sent\": " << stats.sent.load() << ",\n"
+                  << "  \"completed\": " << stats.completed.load() << ",\n"
+                  << "  \"unsent\": " << stats.unsent.load() << ",\n"
+                  << "  \"errors\": " << stats.errors.load() << ",\n"
+                  << "  \"requests_per_second\": " << throughput << ",\n"
+                  << "  \"latency\": ";
+        print_json_latency(std::cout, corrected);
+        std::cout << ",\n  \"service_time\": ";
+        print_json_latency(std::cout, service);
+        std::cout << "\n}" << std::endl;
+    }
+    else
+    {
+        std::cout << "Target: " << options.mode << " ";
+        if (options.mode == "unix")
+            std::cout << options.socket_file;
+        else
+            std::cout << options.host << ":" << options.port;
+        if (options.mode == "http")
+            std::cout << " " << options.method << " " << options.path;
+        else
+            std::cout << " (" << options.protocol << ")";
+        std::cout << "\n"
+                  << "Connections: " << options.connections << ", depth: " << options.depth
+                  << ", message: " << payload.size() << " bytes, ";
+        if (options.rate > 0)
+            std::cout << "open loop " << options.rate << " req/s";
+        else
+            std::cout << "closed loop";
+        std::cout << "\n"
+                  << "Requests: sent " << stats.sent.load() << ", completed " << stats.completed.load()
+                  << ", unsent " << stats.unsent.load() << ", errors " << stats.errors.load() << " in " << std::fixed << std::setprecision(2) << elapsed << " s\n"
+                  << "Throughput: " << std::setprecision(1) << throughput << " req/s\n";
+        print_latency(std::cout, "Latency, corrected for coordinated omission", corrected);
+        print_latency(std::cout, "Service time", service);
+        std::cout.flush();
+    }
+
+    return stats.errors ? 2 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+#if defined(LOG_ON)
+    server_lib::logger::instance().init_debug_log();
+#endif
+
+    loadgen_options options;
+
+    bpo::options_description description("Load generator for server_lib based servers.\n"
+                                         "Example: loadgen --mode tcp --port 19999 --message PING --connections 4 --rate 1000\n"
+                                         "Options");
+    // clang-format off
+    description.add_options()
+        ("help,h", "Print this help")
+        ("mode", bpo::value<std::string>(&options.mode)->default_value(options.mode), "tcp, unix or http")
+        ("host", bpo::value<std::string>(&options.host)->default_value(options.host), "Server host (tcp, http)")
+        ("port", bpo::value<unsigned short>(&options.port)->default_value(options.port), "Server port (tcp, http)")
+        ("socket-file", bpo::value<std::string>(&options.socket_file), "Server socket file (unix)")
+        ("protocol", bpo::value<std::string>(&options.protocol)->default_value(options.protocol), "msg or dstream (tcp, unix)")
+        ("path", bpo::value<std::string>(&options.path)->default_value(options.path), "Request path (http)")
+        ("method", bpo::value<std::string>(&options.method), "Request method (http). GET for empty message, POST otherwise")
+        ("message", bpo::value<std::string>(&options.message), "Request payload")
+        ("size", bpo::value<size_t>(&options.size)->default_value(options.size), "Generated payload size if message is not set")
+        ("connections,c", bpo::value<size_t>(&options.connections)->default_value(options.connections), "Concurrent connections")
+        ("depth,d", bpo::value<size_t>(&options.depth)->default_value(options.depth), "Requests in flight per connection (pipelining)")
+        ("rate,r", bpo::value<double>(&options.rate)->default_value(options.rate), "Total requests per second (open loop). Closed loop if 0")
+        ("duration,t", bpo::value<size_t>(&options.duration_sec)->default_value(options.duration_sec), "Test duration in seconds")
+        ("json", bpo::bool_switch(&options.json), "Print report in JSON");
+    // clang-format on
+
+    try
+    {
+        bpo::variables_map vm;
+        bpo::store(bpo::parse_command_line(argc, argv, description), vm);
+        bpo::notify(vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << description << std::endl;
+            return 0;
+        }
+
+        if (options.mode != "tcp" && options.mode != "unix" && options.mode != "http")
+            throw std::invalid_argument("Unknown mode " + options.mode);
+        if (options.mode == "unix" && options.socket_file.empty())
+            throw std::invalid_argument("Socket file required");
+        if (options.protocol != "msg" && options.protocol != "dstream")
+            throw std::invalid_argument("Unknown protocol " + options.protocol);
+        if (!options.connections || !options.depth)
+            throw std::invalid_argument("Connections and depth should be positive");
+        if (options.method.empty())
+            options.method = options.message.empty() && vm["size"].defaulted() ? "GET" : "POST";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n"
+                  << description << std::endl;
+        return 1;
+    }
+
+    if (options.mode == "http" && options.method == "GET")
+        options.size = 0;
+
+    std::atomic_bool interrupted { false };
+    std::thread runner;
+
+    auto&& app = server_lib::application::init();
+    auto result = app.on_start([&]() {
+                         runner = std::thread([&]() {
+                             app.stop(run_load(options, interrupted));
+                         });
+                     })
+                      .on_exit([&](const int) {
+                          // Application exits just after this callback.
+                          // Let runner print report for finished part
+                          interrupted = true;
+                          if (runner.joinable())
+                              runner.join();
+                      })
+                      .run();
+    if (runner.joinable())
+        runner.join();
+    return result;
+}
@@ -4,35 +4,77 @@
 #include <boost/optional.hpp>
 #include <functional>
 #include <atomic>
+#include <chrono>
+#include <vector>
 
 #include <server_lib/asserts.h>
+#include <server_lib/loop_stats.h>
 
 namespace server_lib {
 
 class start_observable_type;
 class stop_observable_type;
+class loop_instruments;
 
 class base_queuered_loop
 {
 public:
     using callback_type = std::function<void(void)>;
 
+    using stats_clock = std::chrono::steady_clock;
+
 protected:
+    // delay - handler is not expected to run before it
+    // (it is excluded from queue latency)
     template <typename Handler>
-    callback_type register_queue(Handler&& callback)
+    callback_type register_queue(Handler&& callback, std::chrono::nanoseconds delay = {})
     {
         SRV_ASSERT(_pservice);
-        auto callback_ = [this, callback = std::move(callback)]() mutable {
+        auto enqueued = on_post(delay);
+        auto callback_ = [this, callback = std::move(callback), enqueued]() mutable {
+            handler_scope scope(*this, enqueued);
             callback();
-            std::atomic_fetch_sub<uint64_t>(&this->_queue_size, 1);
         };
-        std::atomic_fetch_add<uint64_t>(&_queue_size, 1);
         return callback_;
     }
 
+    class handler_scope
+    {
+    public:
+        handler_scope(base_queuered_loop& loop, stats_clock::time_point enqueued)
+            : _loop(loop)
+            , _started(loop.on_handler_start(enqueued))
+        {
+        }
+
+        ~handler_scope()
+        {
+            _loop.on_handler_finish(_started);
+        }
+
+    private:
+        base_queuered_loop& _loop;
+        const stats_clock::time_point _started;
+    };
+
+    stats_clock::time_point on_post(std::chrono::nanoseconds delay);
+    stats_clock::time_point on_handler_start(stats_clock::time_point enqueued);
+    void on_handler_finish(stats_clock::time_point started);
+
     void set_thread_name(const std::string&);
     void apply_thread_name();
 
+    void set_busy_poll(std::chrono::microseconds spin_budget);
+
+    void set_cpu_affinity(const std::vector<int>& cpus);
+    void set_numa_node(int node);
+    void set_nice(int nice);
+    void set_realtime_priority(int priority);
+    void apply_thread_options();
+
+    void set_stats_enabled(bool enabled);
+    void set_stall_threshold(std::chrono::milliseconds threshold);
+
 protected:
     base_queuered_loop();
 
@@ -60,6 +102,59 @@ public:
         return _is_running;
     }
 
+    /**
+     * Busy-poll mode is enabled. Loop thread spins on polling
+     * instead of sleeping in epoll_wait
+     */
+    bool is_busy_poll() const
+    {
+        return _busy_poll_budget.count() > 0;
+    }
+
+    /**
+     * Time to spin without events before blocking wait.
+     * Maximum value means the loop never blocks
+     */
+    std::chrono::microseconds busy_poll_budget() const
+    {
+        return _busy_poll_budget;
+    }
+
+    const std::vector<int>& cpu_affinity() const
+    {
+        return _cpu_affinity;
+    }
+
+    // -1 if it is not bound
+    int numa_node() const
+    {
+        return _numa_node;
+    }
+
+    /**
+     * \brief Statistics of posted handlers
+     * (queue latency, handler duration, queue depth, stalls).
+     * It can be called from any thread
+     */
+    loop_stats stats() const;
+
+    // Start new statistics period
+    void reset_stats();
+
+    bool is_stats_enabled() const;
+
+    // 0 if stall detection is disabled
+    std::chrono::milliseconds stall_threshold() const
+    {
+        return _stall_threshold;
+    }
+
+    /**
+     * CPUs of NUMA node (Linux).
+     * Return empty list if node doesn't exist
+     */
+    static std::vector<int> numa_node_cpus(int node);
+
 protected:
     void start_loop();
 
@@ -71,6 +166,8 @@ protected:
 
     void run();
 
+    void run_busy_poll();
+
     virtual void reset();
 
     void notify_start();
@@ -79,10 +176,17 @@ protected:
 
 private:
     std::string _base_name = "io_service";
+    std::chrono::microseconds _busy_poll_budget { 0 };
+    std::vector<int> _cpu_affinity;
+    int _numa_node = -1;
+    int _nice = 0;
+    int _realtime_priority = 0;
     std::atomic_bool _is_running;
     std::shared_ptr<boost::asio::io_service> _pservice;
     boost::optional<boost::asio::io_service::work> _loop_maintainer;
     std::atomic_uint64_t _queue_size;
+    std::chrono::milliseconds _stall_threshold { 0 };
+    std::unique_ptr<loop_instruments> _instruments;
     std::unique_ptr<start_observable_type> _start_observer;
     std::unique_ptr<stop_observable_type> _stop_observer;
 };
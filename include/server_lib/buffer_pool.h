@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+
+/**
+ * \ingroup common
+ *
+ * \brief Size-class memory pool for network buffers and handlers.
+ *
+ * Requested size is rounded up to power of two class
+ * (min_block_size - max_block_size). Freed blocks are cached
+ * by calling thread without any lock. Excess of thread cache
+ * is moved to shared depot by batches. Thread cache is returned
+ * to depot when thread exits.
+ * Bigger blocks are passed to operator new directly.
+ */
+class buffer_pool
+{
+public:
+    static constexpr size_t min_block_size = 16;
+    static constexpr size_t max_block_size = 64 * 1024;
+
+    static void* allocate(size_t size);
+    static void deallocate(void* p, size_t size) noexcept;
+};
+
+/**
+ * \ingroup common
+ *
+ * \brief STL allocator for buffer_pool.
+ */
+template <typename T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept
+    {
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        using other = pool_allocator<U>;
+    };
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(buffer_pool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        buffer_pool::deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept
+{
+    return false;
+}
+
+using pooled_buffer = std::vector<char, pool_allocator<char>>;
+using pooled_string = std::basic_string<char, std::char_traits<char>, pool_allocator<char>>;
+
+} // namespace server_lib
@@ -33,6 +33,99 @@ public:
 
     event_loop& change_loop_name(const std::string&);
 
+    /**
+     * \brief Enable busy-poll mode for latency-critical loop
+     *
+     * Loop thread polls for ready handlers in spin loop
+     * instead of sleeping in epoll_wait. It blocks only if there
+     * were no events during spin budget. It should be set before start
+     *
+     * \param spin_budget - Spin time before blocking.
+     * Maximum value means the loop never blocks (one CPU is busy always)
+     *
+     * \return loop object
+     *
+     */
+    event_loop& enable_busy_poll(std::chrono::microseconds spin_budget = std::chrono::microseconds::max());
+
+    /**
+     * \brief Pin loop thread to CPU
+     *
+     * \param cpu - CPU number
+     *
+     * \return loop object
+     *
+     */
+    event_loop& pin_to_cpu(int cpu);
+
+    /**
+     * \brief Pin loop thread to CPU set
+     *
+     * \param cpus - CPU numbers
+     *
+     * \return loop object
+     *
+     */
+    event_loop& pin_to_cpus(const std::vector<int>& cpus);
+
+    /**
+     * \brief Bind loop thread to NUMA node (Linux)
+     *
+     * Thread is pinned to CPUs of node (or to intersection with
+     * pin_to_cpus set) and node is preferred for memory allocated
+     * by the thread first (first-touch policy)
+     *
+     * \param node - NUMA node number. -1 to unbind
+     *
+     * \return loop object
+     *
+     */
+    event_loop& bind_to_numa_node(int node);
+
+    /**
+     * \brief Set nice value for loop thread
+     *
+     * \param nice - [-20, 19]. Negative values require CAP_SYS_NICE
+     *
+     * \return loop object
+     *
+     */
+    event_loop& set_nice(int nice);
+
+    /**
+     * \brief Run loop thread with SCHED_FIFO policy.
+     * It requires CAP_SYS_NICE (or RLIMIT_RTPRIO)
+     *
+     * \param priority - [1, 99]. 0 to keep default policy
+     *
+     * \return loop object
+     *
+     */
+    event_loop& set_realtime_priority(int priority);
+
+    /**
+     * \brief Turn on/off handler statistics (see stats()).
+     * It is enabled by default
+     *
+     * \return loop object
+     *
+     */
+    event_loop& enable_stats(bool enable = true);
+
+    /**
+     * \brief Detect handlers that block loop.
+     *
+     * Watchdog thread logs warning with stack sample of loop thread
+     * if posted handler has been running longer than threshold.
+     * It should be set before start
+     *
+     * \param threshold - 0 to disable detection
+     *
+     * \return loop object
+     *
+     */
+    event_loop& set_stall_threshold(std::chrono::milliseconds threshold);
+
     /**
      * Start loop
      *
@@ -131,7 +224,7 @@ public:
         SRV_ASSERT(service());
         SRV_ASSERT(_pstrand);
 
-        auto callback_ = register_queue(callback);
+        auto callback_ = register_queue(callback, std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
 
         auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
 
@@ -262,6 +355,8 @@ protected:
     void reset() override;
 
 private:
+    void update_thread_options();
+
     const bool _run_in_separate_thread = false;
     std::atomic_bool _is_run;
     std::atomic<std::thread::id> _id;
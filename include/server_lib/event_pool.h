@@ -20,6 +20,27 @@ public:
 
     event_pool& change_pool_name(const std::string& name);
 
+    // Busy-poll mode for all pool threads (see event_loop::enable_busy_poll)
+    event_pool& enable_busy_poll(std::chrono::microseconds spin_budget = std::chrono::microseconds::max());
+
+    // Pin pool threads to CPU set
+    event_pool& pin_to_cpus(const std::vector<int>& cpus);
+
+    // Bind pool threads to NUMA node (see event_loop::bind_to_numa_node)
+    event_pool& bind_to_numa_node(int node);
+
+    // Nice value for pool threads
+    event_pool& set_nice(int nice);
+
+    // SCHED_FIFO priority for pool threads. 0 to keep default policy
+    event_pool& set_realtime_priority(int priority);
+
+    // Turn on/off handler statistics (see stats())
+    event_pool& enable_stats(bool enable = true);
+
+    // Detect handlers that block pool threads (see event_loop::set_stall_threshold)
+    event_pool& set_stall_threshold(std::chrono::milliseconds threshold);
+
     /**
      * Start pool
      *
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <server_lib/event_loop.h>
+#include <server_lib/logger.h>
 
 #include <boost/filesystem/path.hpp>
 #include <string>
+#include <mutex>
+#include <chrono>
 
 namespace server_lib {
 
@@ -39,17 +42,54 @@ struct log_files_watchdog_config
     const std::string pack_command;
 };
 
+/**
+ * \ingroup common
+ *
+ * Statistics of built-in log compression
+ */
+struct log_files_compression_stats
+{
+    size_t files = 0;
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+    // Total time of workers
+    std::chrono::microseconds duration { 0 };
+
+    // Bytes per second for single worker
+    double throughput() const
+    {
+        if (!duration.count())
+            return 0.;
+        return static_cast<double>(input_bytes) * 1000000. / static_cast<double>(duration.count());
+    }
+};
+
 class log_files_watchdog : public event_loop,
                            public log_files_watchdog_config
 {
 public:
     using log_files_watchdog_config::log_files_watchdog_config;
+    ~log_files_watchdog() override;
 
     static void remove_excess_logs(const log_files_watchdog_config& config);
 
     static void pack_excess_logs(const log_files_watchdog_config& config);
 
+    static void remove_log(const log_files_watchdog_config& config, const boost::filesystem::path& file);
+
+    static void pack_log(const log_files_watchdog_config& config, const boost::filesystem::path& file);
+
+    /**
+     * Compress file in-process with gzip (zlib) to 'file'.gz
+     * and remove original file. It doesn't fork 'pack_command'
+     *
+     * \return statistics for this file
+     */
+    static log_files_compression_stats compress_log(const boost::filesystem::path& file,
+                                                    const int level = -1);
+
     using Strategy = std::function<void(const log_files_watchdog_config&)>;
+    using Action = std::function<void(const log_files_watchdog_config&, const boost::filesystem::path&)>;
 
     void watch(const size_t seconds, Strategy strategy)
     {
@@ -80,11 +120,62 @@ public:
         strategy(*this);
     }
 
+    /**
+     * Apply action to the log segment that logger has just closed
+     * (see logger::init_mmap_file_log) instead of periodical
+     * directory polling. Action is invoked in the watchdog thread.
+     * Handler becomes no-op when watchdog is destroyed
+     *
+     * \return handler for logger
+     */
+    logger::rotation_handler_type rotation_handler(Action action);
+
     /**
      * Listen OS filesystem events (inotify)
      * effective if the output of the observed files
-     * is carried out in a separate folder
+     * is carried out in a separate folder.
+     *
+     * Strategy is applied when number of log files
+     * exceeds max_files
      */
     void auto_watch(Strategy strategy);
+
+    /**
+     * Listen OS filesystem events (inotify) and keep sorted
+     * index of log files. Directory is scanned only once.
+     *
+     * Oldest files that exceed max_files are passed to action
+     * (remove_log, pack_log) one by one. Action is invoked
+     * in background pool with nb_action_threads threads
+     */
+    void auto_watch(Action action, const uint8_t nb_action_threads = 1);
+
+    /**
+     * Listen OS filesystem events like auto_watch
+     * and compress excess log files by compress_log
+     * in nb_threads workers
+     *
+     * \param level - zlib compression level (-1 is default level)
+     */
+    void auto_compress(const uint8_t nb_threads = 1, const int level = -1);
+
+    log_files_compression_stats compression_stats() const
+    {
+        std::lock_guard<std::mutex> lck(_compression_stats_guard);
+        return _compression_stats;
+    }
+
+    void stop() override;
+
+private:
+    class auto_watch_impl;
+    struct rotation_state;
+
+    void start_auto_watch(Strategy&& strategy, Action&& action, const uint8_t nb_action_threads);
+
+    std::shared_ptr<auto_watch_impl> _auto_watch;
+    std::shared_ptr<rotation_state> _rotation;
+    mutable std::mutex _compression_stats_guard;
+    log_files_compression_stats _compression_stats;
 };
 } // namespace server_lib
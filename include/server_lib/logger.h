@@ -163,6 +163,7 @@ public:
     };
 
     using log_handler_type = std::function<void(const log_message&, int details_filter)>;
+    using rotation_handler_type = std::function<void(const std::string& closed_file_path)>;
 
 protected:
     logger();
@@ -176,6 +177,23 @@ public:
                          bool cerr = false);
     logger& init_file_log(const char* file_path,
                           const size_t rotation_size_kb);
+    /**
+     * \brief Write logs to memory-mapped file segments
+     *
+     * Segment is preallocated with rotation size. Records are appended
+     * by memory copying without system calls and survive application crash
+     * without flush.
+     *
+     * \param file_path - File path. It should contain variable pattern
+     * with %N (see log_files_watchdog_config)
+     * \param rotation_size_kb - Segment size
+     * \param rotation_handler - Callback for each closed segment
+     * (see log_files_watchdog::rotation_handler)
+     *
+     */
+    logger& init_mmap_file_log(const char* file_path,
+                               const size_t rotation_size_kb,
+                               rotation_handler_type&& rotation_handler = nullptr);
     logger& init_sys_log();
     logger& init_debug_log(bool async, bool cerr)
     {
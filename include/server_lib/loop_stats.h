@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace server_lib {
+
+/**
+ * \ingroup common
+ *
+ * \brief Summary of latency_histogram.
+ *
+ * Percentiles are upper bounds of histogram buckets.
+ */
+struct latency_summary
+{
+    uint64_t count = 0;
+    std::chrono::nanoseconds min { 0 };
+    std::chrono::nanoseconds max { 0 };
+    std::chrono::nanoseconds mean { 0 };
+    std::chrono::nanoseconds p50 { 0 };
+    std::chrono::nanoseconds p90 { 0 };
+    std::chrono::nanoseconds p99 { 0 };
+    std::chrono::nanoseconds p999 { 0 };
+};
+
+/**
+ * \ingroup common
+ *
+ * \brief Lock-free log-linear histogram of durations.
+ *
+ * Every power of two range is split to 16 linear sub-buckets
+ * (like HDR histogram) so relative error doesn't exceed 1/16.
+ * Values are in nanoseconds up to ~39 hours. Record is
+ * several relaxed atomic operations and it could be called
+ * from any thread.
+ */
+class latency_histogram
+{
+public:
+    latency_histogram();
+
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    void record(std::chrono::nanoseconds value) noexcept;
+
+    void reset() noexcept;
+
+    uint64_t count() const noexcept
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    // q in [0, 1]
+    std::chrono::nanoseconds percentile(double q) const noexcept;
+
+    latency_summary summary() const noexcept;
+
+private:
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_buckets = 1 << sub_bucket_bits;
+    static constexpr size_t max_exponent = 47;
+    static constexpr size_t buckets_count = (max_exponent - sub_bucket_bits + 2) * sub_buckets;
+
+    static size_t bucket_index(uint64_t value) noexcept;
+    static uint64_t bucket_upper_value(size_t idx) noexcept;
+
+    std::array<std::atomic<uint64_t>, buckets_count> _buckets;
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _min;
+    std::atomic<uint64_t> _max;
+};
+
+/**
+ * \ingroup common
+ *
+ * \brief Statistics of event_loop or event_pool.
+ *
+ * Counters are accumulated since loop creation
+ * or the last reset_stats call.
+ */
+struct loop_stats
+{
+    // Handlers posted to loop
+    uint64_t posts = 0;
+    // Handlers have been executed
+    uint64_t executed = 0;
+    // Average post rate
+    double posts_per_sec = 0;
+    // Handlers are waiting for execution
+    uint64_t queue_size = 0;
+    // Maximum queue depth (watermark)
+    uint64_t max_queue_size = 0;
+    // Handlers that were running longer than stall threshold
+    uint64_t stalls = 0;
+    // Time from post to execution start
+    latency_summary queue_latency;
+    // Handler execution time
+    latency_summary handler_duration;
+};
+
+} // namespace server_lib
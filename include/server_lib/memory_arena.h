@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+
+namespace server_lib {
+
+/**
+ * \ingroup common
+ *
+ * \brief Monotonic memory arena.
+ *
+ * Memory is taken from blocks by bumping pointer and is never
+ * returned one by one. All allocations are released at once by
+ * reset() (or destructor). First block is kept by reset() to be reused.
+ * Blocks are taken from buffer_pool.
+ * It is not thread safe.
+ */
+class memory_arena
+{
+public:
+    explicit memory_arena(size_t block_size = 4 * 1024);
+    ~memory_arena();
+
+    memory_arena(const memory_arena&) = delete;
+    memory_arena& operator=(const memory_arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    void reset();
+
+    // Bytes allocated since last reset
+    size_t allocated() const
+    {
+        return _allocated;
+    }
+
+private:
+    struct block;
+
+    block* new_block(size_t capacity);
+    void free_blocks();
+
+    const size_t _block_size;
+    block* _head = nullptr;
+    char* _ptr = nullptr;
+    char* _end = nullptr;
+    size_t _allocated = 0;
+};
+
+/**
+ * \ingroup common
+ *
+ * \brief STL allocator for memory_arena.
+ *
+ * Deallocation does nothing. Memory is returned by memory_arena::reset.
+ */
+template <typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    friend class arena_allocator;
+
+    explicit arena_allocator(memory_arena& arena) noexcept
+        : _arena(&arena)
+    {
+    }
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+        : _arena(other._arena)
+    {
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        using other = arena_allocator<U>;
+    };
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept
+    {
+    }
+
+    memory_arena& arena() const noexcept
+    {
+        return *_arena;
+    }
+
+private:
+    memory_arena* _arena;
+};
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+{
+    return &a.arena() == &b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+} // namespace server_lib
@@ -6,10 +6,12 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <string>
 #include <chrono>
 #include <limits>
 #include <memory>
+#include <vector>
 
 namespace server_lib {
 namespace network {
@@ -61,6 +63,54 @@ namespace network {
             return this->self();
         }
 
+        /// Enable busy-poll mode for worker threads (see event_loop::enable_busy_poll)
+        /// and SO_BUSY_POLL for sockets (Linux). Socket busy polling
+        /// above net.core.busy_poll requires CAP_NET_ADMIN
+        T& set_busy_poll(std::chrono::microseconds spin_budget = std::chrono::microseconds::max(),
+                         std::chrono::microseconds socket_busy_poll = std::chrono::microseconds { 50 })
+        {
+            SRV_ASSERT(spin_budget.count() > 0);
+            SRV_ASSERT(socket_busy_poll.count() >= 0 && socket_busy_poll.count() <= std::numeric_limits<int>::max());
+
+            _busy_poll_budget = spin_budget;
+            _socket_busy_poll = socket_busy_poll;
+            return this->self();
+        }
+
+        /// Pin worker threads to CPU set
+        T& set_worker_cpus(const std::vector<int>& cpus)
+        {
+            _worker_cpus = cpus;
+            return this->self();
+        }
+
+        /// Bind worker threads to NUMA node (CPUs and memory of node)
+        T& set_worker_numa_node(int node)
+        {
+            SRV_ASSERT(node >= -1);
+
+            _worker_numa_node = node;
+            return this->self();
+        }
+
+        /// Nice value for worker threads [-20, 19]
+        T& set_worker_nice(int nice)
+        {
+            SRV_ASSERT(nice >= -20 && nice <= 19);
+
+            _worker_nice = nice;
+            return this->self();
+        }
+
+        /// SCHED_FIFO priority for worker threads [1, 99]. 0 to keep default policy
+        T& set_worker_realtime_priority(int priority)
+        {
+            SRV_ASSERT(priority >= 0 && priority <= 99);
+
+            _worker_realtime_priority = priority;
+            return this->self();
+        }
+
         auto protocol() const
         {
             return _protocol;
@@ -76,6 +126,36 @@ namespace network {
             return _worker_threads;
         }
 
+        const std::vector<int>& worker_cpus() const
+        {
+            return _worker_cpus;
+        }
+
+        int worker_numa_node() const
+        {
+            return _worker_numa_node;
+        }
+
+        int worker_nice() const
+        {
+            return _worker_nice;
+        }
+
+        int worker_realtime_priority() const
+        {
+            return _worker_realtime_priority;
+        }
+
+        std::chrono::microseconds busy_poll_budget() const
+        {
+            return _busy_poll_budget;
+        }
+
+        std::chrono::microseconds socket_busy_poll() const
+        {
+            return _socket_busy_poll;
+        }
+
     protected:
         std::shared_ptr<unit_builder_i> _protocol;
 
@@ -85,6 +165,22 @@ namespace network {
         /// Number of threads that the server will use.
         /// Defaults to 1 thread.
         uint8_t _worker_threads = 1;
+
+        /// CPU set for worker threads. Empty means any CPU
+        std::vector<int> _worker_cpus;
+
+        /// NUMA node for worker threads. -1 means any node
+        int _worker_numa_node = -1;
+
+        int _worker_nice = 0;
+
+        int _worker_realtime_priority = 0;
+
+        /// Busy-poll spin budget. Zero means sleeping in epoll_wait (default)
+        std::chrono::microseconds _busy_poll_budget { 0 };
+
+        /// SO_BUSY_POLL value for sockets
+        std::chrono::microseconds _socket_busy_poll { 0 };
     };
 
     template <typename T>
@@ -102,6 +198,50 @@ namespace network {
             return this->self();
         }
 
+        /**
+         * Grow read block (twice) while reads fill it up to
+         * max_chunk_size and shrink it back to chunk size for
+         * small reads. Block is allocated when socket is readable
+         * so idle connection doesn't hold buffer.
+         * It is not used for message oriented connection
+         *
+         */
+        T& enable_adaptive_chunk_size(size_t max_chunk_size)
+        {
+            SRV_ASSERT(max_chunk_size > 0 && max_chunk_size <= static_cast<size_t>(std::numeric_limits<uint32_t>::max()));
+
+            _max_chunk_size = max_chunk_size;
+            return this->self();
+        }
+
+        /**
+         * Read into chain of blocks (chunk size each)
+         * by one scatter call (readv). Socket readiness is
+         * waited without holding buffers.
+         * It is used by TCP connection
+         *
+         */
+        T& set_read_chain(size_t buffers)
+        {
+            SRV_ASSERT(buffers > 0 && buffers <= 64);
+
+            _read_chain = buffers;
+            return this->self();
+        }
+
+        /**
+         * Read until socket would block (but not more than max_bytes)
+         * before units are built. It is used by TCP connection
+         *
+         */
+        T& enable_read_until_would_block(size_t max_bytes = 256 * 1024)
+        {
+            SRV_ASSERT(max_bytes > 0);
+
+            _read_until_would_block = max_bytes;
+            return this->self();
+        }
+
         bool valid() const override
         {
             return _chunk_size > 0;
@@ -112,9 +252,43 @@ namespace network {
             return _chunk_size;
         }
 
+        bool adaptive_chunk_size() const
+        {
+            return _max_chunk_size > _chunk_size;
+        }
+
+        size_t max_chunk_size() const
+        {
+            return std::max(_max_chunk_size, _chunk_size);
+        }
+
+        size_t read_chain() const
+        {
+            return _read_chain;
+        }
+
+        bool read_until_would_block() const
+        {
+            return _read_until_would_block > 0;
+        }
+
+        size_t read_until_would_block_limit() const
+        {
+            return _read_until_would_block;
+        }
+
     protected:
         /// Block size to read
         size_t _chunk_size = 4096;
+
+        /// Upper bound of adaptive block size. Disabled if it is not greater than _chunk_size
+        size_t _max_chunk_size = 0;
+
+        /// Blocks to read by one call
+        size_t _read_chain = 1;
+
+        /// Bytes to read until socket would block. Zero means one read
+        size_t _read_until_would_block = 0;
     };
 
     template <typename T>
@@ -140,13 +314,151 @@ namespace network {
             return _socket_file;
         }
 
+        /**
+         * Use SOCK_SEQPACKET instead of SOCK_STREAM. Both sides
+         * should be configured the same way.
+         *
+         * Every committed unit is sent as separate packet and every
+         * received packet is delivered as string unit. Message boundaries
+         * come from the kernel so protocol is not used to parse
+         * packets (it could be omitted). Packet should not be
+         * larger than chunk size of receiver otherwise connection
+         * is closed
+         */
+        T& enable_seqpacket(bool enabled = true)
+        {
+            _seqpacket = enabled;
+            return this->self();
+        }
+
+        bool seqpacket() const
+        {
+            return _seqpacket;
+        }
+
+        /**
+         * Transfer data by shared memory rings (one per direction).
+         * Socket is used for handshake and to detect peer
+         * disconnection only. Both sides should be configured
+         * the same way (ring size is chosen by client).
+         *
+         * \param ring_size - Bytes of one ring. Power of 2
+         * \param spin - Time to poll ring before sleeping on eventfd.
+         * It is adapted to traffic. Other handlers of loop
+         * are run between polls
+         */
+        T& enable_shared_memory(size_t ring_size = 1024 * 1024,
+                                std::chrono::microseconds spin = std::chrono::microseconds(50))
+        {
+            SRV_ASSERT(ring_size >= 4096 && (ring_size & (ring_size - 1)) == 0, "Ring size should be power of 2");
+            SRV_ASSERT(spin.count() >= 0);
+
+            _shared_memory_ring_size = ring_size;
+            _shared_memory_spin = spin;
+            return this->self();
+        }
+
+        bool shared_memory() const
+        {
+            return _shared_memory_ring_size > 0;
+        }
+
+        size_t shared_memory_ring_size() const
+        {
+            return _shared_memory_ring_size;
+        }
+
+        std::chrono::microseconds shared_memory_spin() const
+        {
+            return _shared_memory_spin;
+        }
+
         bool valid() const override
         {
-            return base_class::valid() && this->_protocol && !_socket_file.empty();
+            return base_class::valid() && (this->_protocol || _seqpacket) && !_socket_file.empty() && !(_seqpacket && shared_memory());
         }
 
     protected:
         std::string _socket_file;
+
+        bool _seqpacket = false;
+
+        size_t _shared_memory_ring_size = 0;
+        std::chrono::microseconds _shared_memory_spin { 0 };
+    };
+
+    template <typename T>
+    class base_datagram_config : public base_config<T>
+    {
+        using base_class = base_config<T>;
+
+    protected:
+        base_datagram_config() = default;
+
+    public:
+        /**
+         * Every received datagram is delivered as string unit
+         * and every committed unit is sent as separate datagram.
+         * Datagrams larger than this size are truncated by
+         * receiver and dropped
+         */
+        T& set_datagram_size(size_t sz)
+        {
+            SRV_ASSERT(sz > 0 && sz <= max_datagram_size);
+
+            _datagram_size = sz;
+            return this->self();
+        }
+
+        /// Number of datagrams per recvmmsg/sendmmsg call
+        T& set_batch_size(size_t sz)
+        {
+            SRV_ASSERT(sz > 0 && sz <= 1024);
+
+            _batch_size = sz;
+            return this->self();
+        }
+
+        /**
+         * Use UDP GRO for receiving and UDP GSO for sending
+         * (equal sized datagrams to the same peer are sent by one
+         * system call). It is ignored if kernel doesn't support it
+         */
+        T& enable_offload(bool enabled = true)
+        {
+            _offload = enabled;
+            return this->self();
+        }
+
+        bool valid() const override
+        {
+            return base_class::valid() && _datagram_size > 0 && _batch_size > 0;
+        }
+
+        size_t datagram_size() const
+        {
+            return _datagram_size;
+        }
+
+        size_t batch_size() const
+        {
+            return _batch_size;
+        }
+
+        bool offload() const
+        {
+            return _offload;
+        }
+
+        /// UDP payload limit for IPv4
+        static constexpr size_t max_datagram_size = 65507;
+
+    protected:
+        size_t _datagram_size = 1472;
+
+        size_t _batch_size = 32;
+
+        bool _offload = false;
     };
 
 } // namespace network
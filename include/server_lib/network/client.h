@@ -2,6 +2,7 @@
 
 #include <server_lib/network/connection.h>
 #include <server_lib/network/client_config.h>
+#include <server_lib/network/network_stats.h>
 #include <server_lib/simple_observer.h>
 
 #include <string>
@@ -15,6 +16,8 @@ namespace network {
         struct __connection_impl_i;
     } // namespace transport_layer
 
+    struct network_counters;
+
     /**
      * \ingroup network
      *
@@ -23,7 +26,7 @@ namespace network {
     class client
     {
     public:
-        client() = default;
+        client();
 
         client(const client&) = delete;
 
@@ -45,6 +48,12 @@ namespace network {
          */
         static unix_local_client_config configurate_unix_local();
 
+        /**
+         * Configurate UDP client
+         *
+         */
+        static udp_client_config configurate_udp();
+
         /**
          * Start client defined by configuration type
          *
@@ -83,9 +92,16 @@ namespace network {
          */
         void post(common_callback_type&& callback);
 
+        /**
+         * Traffic counters of all connections since client creation
+         *
+         */
+        network_stats stats() const;
+
     private:
         std::shared_ptr<transport_layer::__client_impl_i> create_impl(const tcp_client_config&);
         std::shared_ptr<transport_layer::__client_impl_i> create_impl(const unix_local_client_config&);
+        std::shared_ptr<transport_layer::__client_impl_i> create_impl(const udp_client_config&);
 
         bool connect_impl(std::function<std::shared_ptr<transport_layer::__client_impl_i>()>&&);
 
@@ -100,6 +116,7 @@ namespace network {
         simple_observable<fail_callback_type> _fail_observer;
         std::shared_ptr<unit_builder_i> _protocol;
         pconnection _connection;
+        std::shared_ptr<network_counters> _counters;
     };
 
 } // namespace network
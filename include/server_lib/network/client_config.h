@@ -49,6 +49,27 @@ namespace network {
             return this->self();
         }
 
+        /**
+         * Use io_uring instead of epoll (Linux 6.0+). Data is
+         * received by multishot recv into ring of provided buffers
+         * (chunk size each) and sent from registered buffers.
+         * epoll is used if kernel doesn't support it
+         *
+         * \param entries - Size of submission queue
+         * \param buffers - Count of receive buffers shared
+         * by all connections. Power of 2
+         */
+        T& enable_io_uring(unsigned entries = 256, unsigned buffers = 512)
+        {
+            SRV_ASSERT(entries > 0 && entries <= 4096);
+            SRV_ASSERT(buffers > 0 && buffers <= 32768 && (buffers & (buffers - 1)) == 0, "Count of buffers should be power of 2");
+
+            _io_uring = true;
+            _io_uring_entries = entries;
+            _io_uring_buffers = buffers;
+            return this->self();
+        }
+
         bool valid() const override
         {
             return base_type::valid() && _port > 0 && !_host.empty();
@@ -75,6 +96,21 @@ namespace network {
             return _timeout_connect_ms;
         }
 
+        bool io_uring() const
+        {
+            return _io_uring;
+        }
+
+        unsigned io_uring_entries() const
+        {
+            return _io_uring_entries;
+        }
+
+        unsigned io_uring_buffers() const
+        {
+            return _io_uring_buffers;
+        }
+
     private:
         T& set_worker_threads(uint8_t)
         {
@@ -92,6 +128,11 @@ namespace network {
 
         /// Set connect timeout in milliseconds.
         size_t _timeout_connect_ms = 0;
+
+        /// Use io_uring backend
+        bool _io_uring = false;
+        unsigned _io_uring_entries = 0;
+        unsigned _io_uring_buffers = 0;
     };
 
     /**
@@ -168,5 +209,73 @@ namespace network {
         size_t _timeout_connect_ms = 0;
     };
 
+    /**
+     * \ingroup network
+     *
+     * \brief This class configurates UDP client.
+     *
+     * Socket is connected to server endpoint so only
+     * datagrams from server are received
+     */
+    class udp_client_config : public base_datagram_config<udp_client_config>
+    {
+        friend class client;
+
+        using base_class = base_datagram_config<udp_client_config>;
+
+    protected:
+        udp_client_config()
+        {
+            this->set_worker_name("client");
+        }
+
+    private:
+        udp_client_config& set_worker_threads(uint8_t)
+        {
+            SRV_ERROR("Not supported for UDP client");
+            return *this;
+        }
+
+    public:
+        udp_client_config(const udp_client_config&) = default;
+        ~udp_client_config() = default;
+
+        udp_client_config& set_address(unsigned short port)
+        {
+            SRV_ASSERT(port > 0 && port <= std::numeric_limits<unsigned short>::max());
+
+            _port = port;
+            return *this;
+        }
+
+        udp_client_config& set_address(const std::string& host, unsigned short port)
+        {
+            SRV_ASSERT(!host.empty());
+
+            _host = host;
+            return this->set_address(port);
+        }
+
+        bool valid() const override
+        {
+            return base_class::valid() && _port > 0 && !_host.empty();
+        }
+
+        unsigned short port() const
+        {
+            return _port;
+        }
+
+        const std::string& host() const
+        {
+            return _host;
+        }
+
+    protected:
+        unsigned short _port = 0;
+
+        std::string _host = "localhost";
+    };
+
 } // namespace network
 } // namespace server_lib
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <server_lib/network/unit_builder_i.h>
+#include <server_lib/network/network_stats.h>
 #include <server_lib/simple_observer.h>
+#include <server_lib/buffer_pool.h>
 
 #include <string>
 #include <mutex>
+#include <vector>
 
 namespace server_lib {
 namespace network {
@@ -15,6 +18,8 @@ namespace network {
     class connection_impl;
     class unit_builder_manager;
     class connection;
+    struct connection_counters;
+    struct network_counters;
 
     using pconnection = std::shared_ptr<connection>;
 
@@ -30,7 +35,8 @@ namespace network {
 
     protected:
         connection(const std::shared_ptr<transport_layer::__connection_impl_i>&,
-                   const std::shared_ptr<unit_builder_i>&);
+                   const std::shared_ptr<unit_builder_i>&,
+                   const std::shared_ptr<connection_counters>&);
 
     public:
         ~connection();
@@ -49,6 +55,12 @@ namespace network {
 
         const unit_builder_i& protocol() const;
 
+        /**
+         * Traffic counters of this connection
+         *
+         */
+        connection_stats stats() const;
+
         connection& post(const std::string& unit);
 
         connection& post(const unit& unit);
@@ -65,6 +77,44 @@ namespace network {
             return post(unit).commit();
         }
 
+        /**
+         * Send unit with file descriptors attached (SCM_RIGHTS).
+         * Posted units are committed before. Descriptors are
+         * duplicated so caller could close them.
+         * It is supported by UNIX local socket only
+         *
+         */
+        connection& send(const unit& unit, const std::vector<int>& descriptors);
+
+        connection& send(const std::string& unit, const std::vector<int>& descriptors);
+
+        /**
+         * Take descriptors received by this moment. Caller owns
+         * them. Descriptors are received with the unit they
+         * were sent with (or earlier for stream socket) so they could
+         * be taken in receive callback.
+         * Not taken descriptors are closed with connection
+         *
+         */
+        std::vector<int> take_descriptors();
+
+        /**
+         * Relay bytes received from now on to destination as is.
+         * Protocol and receive callbacks are bypassed. Stream sockets
+         * are relayed by kernel (splice) on Linux, other transports
+         * are relayed by one buffer that is read again after
+         * destination has written it.
+         * This connection is disconnected if destination is
+         * disconnected or relay is failed.
+         * It should be called from receive callback (bytes received
+         * after the unit are relayed first) or when peer is waiting
+         * for response. Writes to destination are delayed
+         * while bytes are relayed by kernel.
+         * Call it for both sides for bidirectional proxy
+         *
+         */
+        connection& pipe_to(const pconnection& destination);
+
         connection& on_receive(receive_callback_type&&);
 
         connection& on_disconnect(disconnect_with_id_callback_type&&);
@@ -72,25 +122,49 @@ namespace network {
         connection& on_disconnect(disconnect_callback_type&&);
 
     protected:
+        // inbound - connection is accepted by server.
+        // total - counters of server (client)
         static pconnection create(
             const std::shared_ptr<transport_layer::__connection_impl_i>&,
-            const std::shared_ptr<unit_builder_i>&);
+            const std::shared_ptr<unit_builder_i>&,
+            bool inbound,
+            const std::shared_ptr<network_counters>& total);
 
         void async_read();
 
     private:
-        void on_raw_receive(const std::vector<char>& result);
+        void on_raw_receive(pooled_buffer& result, std::vector<pooled_buffer>& chain, std::vector<int>& descriptors);
         void on_diconnected();
 
+        pconnection pipe_destination();
+        void relay(pooled_buffer&& buffer, std::vector<pooled_buffer>&& chain, const pconnection& destination);
+        void continue_relay(const pconnection& destination);
+
         void call_disconnection_handler();
 
+        // Grow read block while reads fill it and shrink for small reads
+        void adapt_read_size(size_t received);
+
         std::unique_ptr<connection_impl> _impl;
         std::shared_ptr<transport_layer::__connection_impl_i> _raw_connection;
         std::unique_ptr<unit_builder_manager> _protocol;
+        // Shared with write completions that could outlive connection
+        std::shared_ptr<connection_counters> _counters;
 
-        std::string _send_buffer;
+        // Block size of next read
+        size_t _read_size = 0;
+
+        pooled_string _send_buffer;
+        // Units of message oriented connection
+        std::vector<pooled_string> _send_packets;
         std::mutex _send_buffer_mutex;
 
+        std::vector<int> _received_descriptors;
+        std::mutex _received_descriptors_mutex;
+
+        pconnection _pipe_destination;
+        std::mutex _pipe_mutex;
+
         simple_observable<receive_callback_type> _receive_observer;
         simple_observable<disconnect_with_id_callback_type> _disconnect_with_id_observer;
         simple_observable<disconnect_callback_type> _disconnect_observer;
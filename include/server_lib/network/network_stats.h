@@ -0,0 +1,59 @@
+#pragma once
+
+#include <server_lib/loop_stats.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * \ingroup network
+     *
+     * \brief Counters of single connection.
+     *
+     * RTT is measured for request/response pairs. For inbound (server)
+     * connection it is time from received unit to committed response.
+     * For outbound (client) connection it is time from committed
+     * request to received unit.
+     */
+    struct connection_stats
+    {
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t units_in = 0;
+        uint64_t units_out = 0;
+        // Completed read operations (one recv per read)
+        uint64_t read_calls = 0;
+        // Completed write operations
+        uint64_t write_calls = 0;
+        // Posted but not written bytes
+        uint64_t queued_bytes = 0;
+        uint64_t rtt_count = 0;
+        std::chrono::nanoseconds rtt_mean { 0 };
+        std::chrono::nanoseconds rtt_max { 0 };
+    };
+
+    /**
+     * \ingroup network
+     *
+     * \brief Counters of server (client) aggregated by all connections.
+     */
+    struct network_stats
+    {
+        // Connections since start
+        uint64_t connections = 0;
+        uint64_t active_connections = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t units_in = 0;
+        uint64_t units_out = 0;
+        uint64_t read_calls = 0;
+        uint64_t write_calls = 0;
+        uint64_t queued_bytes = 0;
+        latency_summary rtt;
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -2,6 +2,7 @@
 
 #include <server_lib/network/connection.h>
 #include <server_lib/network/server_config.h>
+#include <server_lib/network/network_stats.h>
 #include <server_lib/simple_observer.h>
 
 #include <string>
@@ -16,6 +17,8 @@ namespace network {
         struct __connection_impl_i;
     } // namespace transport_layer
 
+    struct network_counters;
+
     /**
      * \ingroup network
      *
@@ -24,7 +27,7 @@ namespace network {
     class server
     {
     public:
-        server() = default;
+        server();
 
         server(const server&) = delete;
 
@@ -46,6 +49,12 @@ namespace network {
          */
         static unix_local_server_config configurate_unix_local();
 
+        /**
+         * Configurate UDP server
+         *
+         */
+        static udp_server_config configurate_udp();
+
         /**
          * Start server defined by configuration type
          *
@@ -118,9 +127,16 @@ namespace network {
          */
         void post(common_callback_type&& callback);
 
+        /**
+         * Traffic counters of all connections since server creation
+         *
+         */
+        network_stats stats() const;
+
     private:
         std::shared_ptr<transport_layer::server_impl_i> create_impl(const tcp_server_config&);
         std::shared_ptr<transport_layer::server_impl_i> create_impl(const unix_local_server_config&);
+        std::shared_ptr<transport_layer::server_impl_i> create_impl(const udp_server_config&);
 
         server& start_impl(std::function<std::shared_ptr<transport_layer::server_impl_i>()>&&);
 
@@ -135,6 +151,8 @@ namespace network {
         std::unordered_map<size_t, std::shared_ptr<connection>> _connections;
         std::mutex _connections_mutex;
 
+        std::shared_ptr<network_counters> _counters;
+
         simple_observable<common_callback_type> _start_observer;
         simple_observable<new_connection_callback_type> _new_connection_observer;
         simple_observable<fail_callback_type> _fail_observer;
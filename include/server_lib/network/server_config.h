@@ -44,6 +44,27 @@ namespace network {
             return this->self();
         }
 
+        /**
+         * Use io_uring instead of epoll (Linux 6.0+). Data is
+         * received by multishot recv into ring of provided buffers
+         * (chunk size each) and sent from registered buffers.
+         * epoll is used if kernel doesn't support it
+         *
+         * \param entries - Size of submission queue
+         * \param buffers - Count of receive buffers shared
+         * by all connections. Power of 2
+         */
+        T& enable_io_uring(unsigned entries = 256, unsigned buffers = 512)
+        {
+            SRV_ASSERT(entries > 0 && entries <= 4096);
+            SRV_ASSERT(buffers > 0 && buffers <= 32768 && (buffers & (buffers - 1)) == 0, "Count of buffers should be power of 2");
+
+            _io_uring = true;
+            _io_uring_entries = entries;
+            _io_uring_buffers = buffers;
+            return this->self();
+        }
+
         bool valid() const override
         {
             return base_type::valid() && _port > 0 && !_address.empty();
@@ -64,6 +85,21 @@ namespace network {
             return _reuse_address;
         }
 
+        bool io_uring() const
+        {
+            return _io_uring;
+        }
+
+        unsigned io_uring_entries() const
+        {
+            return _io_uring_entries;
+        }
+
+        unsigned io_uring_buffers() const
+        {
+            return _io_uring_buffers;
+        }
+
     protected:
         /// Port number to use
         unsigned short _port = 0;
@@ -74,6 +110,11 @@ namespace network {
 
         /// Set to false to avoid binding the socket to an address that is already in use. Defaults to true.
         bool _reuse_address = true;
+
+        /// Use io_uring backend
+        bool _io_uring = false;
+        unsigned _io_uring_entries = 0;
+        unsigned _io_uring_buffers = 0;
     };
 
     /**
@@ -128,5 +169,98 @@ namespace network {
         static std::string preserve_socket_file(const std::string& folder_path = {});
     };
 
+    /**
+     * \ingroup network
+     *
+     * \brief This class configurates UDP server.
+     *
+     * Every remote endpoint is served by separate connection.
+     * Connection is closed by disconnect() or after idle timeout
+     */
+    class udp_server_config : public base_datagram_config<udp_server_config>
+    {
+        friend class server;
+
+        using base_class = base_datagram_config<udp_server_config>;
+
+    protected:
+        udp_server_config()
+        {
+            this->set_worker_name("server");
+        }
+
+    public:
+        udp_server_config(const udp_server_config&) = default;
+        ~udp_server_config() = default;
+
+        udp_server_config& set_address(unsigned short port)
+        {
+            SRV_ASSERT(port > 0 && port <= std::numeric_limits<unsigned short>::max());
+
+            _port = port;
+            return *this;
+        }
+
+        udp_server_config& set_address(const std::string& address, unsigned short port)
+        {
+            SRV_ASSERT(!address.empty());
+
+            _address = address;
+            return this->set_address(port);
+        }
+
+        udp_server_config& disable_reuse_address()
+        {
+            _reuse_address = false;
+            return *this;
+        }
+
+        /// Close connection if nothing is received from peer for duration
+        template <typename DurationType>
+        udp_server_config& set_idle_timeout(DurationType&& duration)
+        {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+            SRV_ASSERT(ms.count() > 0, "1 millisecond is minimum waiting accuracy");
+
+            _idle_timeout_ms = ms.count();
+            return *this;
+        }
+
+        bool valid() const override
+        {
+            return base_class::valid() && _port > 0 && !_address.empty();
+        }
+
+        unsigned short port() const
+        {
+            return _port;
+        }
+
+        const std::string& address() const
+        {
+            return _address;
+        }
+
+        bool reuse_address() const
+        {
+            return _reuse_address;
+        }
+
+        auto idle_timeout_ms() const
+        {
+            return _idle_timeout_ms;
+        }
+
+    protected:
+        unsigned short _port = 0;
+
+        std::string _address = "0.0.0.0";
+
+        bool _reuse_address = true;
+
+        /// Zero means that connections are never closed by timeout
+        size_t _idle_timeout_ms = 0;
+    };
+
 } // namespace network
 } // namespace server_lib
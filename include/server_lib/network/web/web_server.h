@@ -2,9 +2,12 @@
 
 #include "web_server_config.h"
 #include "web_server_i.h"
+#include <server_lib/network/network_stats.h>
 #include <server_lib/simple_observer.h>
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace server_lib {
 namespace network {
@@ -32,6 +35,8 @@ namespace network {
             using fail_callback_type = std::function<void(
                 std::shared_ptr<web_request_i>,
                 const std::string&)>;
+            using network_stats_callback_type = std::function<network_stats()>;
+            using loop_stats_callback_type = std::function<loop_stats()>;
 
             /**
              * Configurate Web server
@@ -126,6 +131,26 @@ namespace network {
              */
             web_server& on_request(request_callback_type&& callback);
 
+            /**
+             * Traffic counters of server. They are kept
+             * until next start
+             *
+             */
+            network_stats stats() const;
+
+            /**
+             * Add statistics of other server (client) or loop
+             * to metrics endpoint (see base_web_server_config::enable_metrics).
+             * Callback is called from worker thread
+             *
+             * \param source - label of samples
+             * \param callback
+             *
+             * \return this class
+             */
+            web_server& add_metrics(const std::string& source, network_stats_callback_type&& callback);
+            web_server& add_metrics(const std::string& source, loop_stats_callback_type&& callback);
+
         private:
             std::shared_ptr<web_server_impl_i> create_impl(const web_server_config&);
             std::shared_ptr<web_server_impl_i> create_impl(const websec_server_config&);
@@ -134,6 +159,7 @@ namespace network {
 
             void on_start_impl();
             void on_fail_impl(std::shared_ptr<web_request_i>, const std::string&);
+            std::string render_metrics();
 
             std::shared_ptr<web_server_impl_i> _impl;
 
@@ -141,6 +167,10 @@ namespace network {
             simple_observable<fail_callback_type> _fail_observer;
             size_t _next_subscription = 0;
             std::map<std::string, std::map<std::string, std::pair<size_t, request_callback_type>>> _request_callbacks;
+
+            std::mutex _metrics_mutex;
+            std::vector<std::pair<std::string, network_stats_callback_type>> _network_metrics;
+            std::vector<std::pair<std::string, loop_stats_callback_type>> _loop_metrics;
         };
 
     } // namespace web
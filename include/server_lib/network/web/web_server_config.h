@@ -51,6 +51,17 @@ namespace network {
                 return this->self();
             }
 
+            /**
+             * Serve statistics of server in Prometheus text format
+             * by GET requests to path
+             */
+            T& enable_metrics(const std::string& path = "/metrics")
+            {
+                SRV_ASSERT(!path.empty() && path[0] == '/', "Absolute path required");
+                _metrics_path = path;
+                return this->self();
+            }
+
             auto timeout_request() const
             {
                 return _timeout_request_sec;
@@ -66,6 +77,11 @@ namespace network {
                 return _max_request_streambuf_size;
             }
 
+            const std::string& metrics_path() const
+            {
+                return _metrics_path;
+            }
+
         private:
             T& set_protocol(const unit_builder_i&)
             {
@@ -88,6 +104,9 @@ namespace network {
             /// Maximum size of request stream buffer. Defaults to architecture maximum.
             /// Reaching this limit will result in a message_size error code.
             size_t _max_request_streambuf_size = std::numeric_limits<size_t>::max();
+
+            /// Path of metrics endpoint. Metrics are disabled if empty.
+            std::string _metrics_path;
         };
 
         /**
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <server_lib/network/web/web_entities.h>
+#include <server_lib/memory_arena.h>
+#include <server_lib/asserts.h>
 
 #include <chrono>
 
@@ -34,6 +36,15 @@ namespace network {
 
             /// Returns query keys with percent-decoded values.
             virtual web_query parse_query_string() const = 0;
+
+            /// Allocator of connection arena. Memory is released at once
+            /// when response has been sent. Don't use it after that
+            /// if request is not kept.
+            /// Default implementation is for requests without arena. It throws
+            virtual arena_allocator<char> get_allocator() const
+            {
+                SRV_ERROR("Request is not placed in arena");
+            }
         };
 
         class web_server_response_i
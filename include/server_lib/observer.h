@@ -5,6 +5,8 @@
 
 #include <utility>
 #include <vector>
+#include <memory>
+#include <algorithm>
 
 namespace server_lib {
 
@@ -17,6 +19,10 @@ namespace server_lib {
  * 'sink' and 'event_loop' objects are required
  *  until they will be unsubscribed.
  *  See 'subscribe' and 'notify'
+ *
+ *  Weak subscription (by shared_ptr) is finished automatically
+ *  when sink is destroyed.
+ *  Unsubscribed slots are removed from storage
  */
 template <class Observer>
 class observable
@@ -45,6 +51,24 @@ public:
     {
         subscribe_impl(sink, true, &loop);
     }
+
+    /**
+     * @brief Subscribe while sink exists
+     *
+     * @param sink
+     */
+    void subscribe(const std::shared_ptr<observer_i>& sink)
+    {
+        SRV_ASSERT(sink);
+        subscribe_impl(*sink, true, nullptr, sink);
+    }
+
+    void subscribe(const std::shared_ptr<observer_i>& sink, event_loop& loop)
+    {
+        SRV_ASSERT(sink);
+        subscribe_impl(*sink, true, &loop, sink);
+    }
+
     void unsubscribe(observer_i& sink)
     {
         subscribe_impl(sink, false, nullptr);
@@ -87,41 +111,67 @@ public:
     }
 
 protected:
-    void subscribe_impl(observer_i& sink, bool on, event_loop* ploop)
+    struct observer_item
+    {
+        observer_i* psink = nullptr;
+        event_loop* ploop = nullptr;
+        std::weak_ptr<observer_i> owner;
+        bool weak = false;
+    };
+
+    void subscribe_impl(observer_i& sink, bool on, event_loop* ploop, const std::shared_ptr<observer_i>& owner = {})
     {
         std::lock_guard<mutex_type> lck(_guard_for_observers);
-        void* psink = (void*)(&sink);
-        size_t i = 0;
-        for (auto&& item : _observers)
+        auto it = std::find_if(_observers.begin(), _observers.end(), [psink = &sink](const observer_item& item) {
+            return item.psink == psink;
+        });
+        if (!on)
         {
-            if (item.first == psink)
-            {
-                if (!on)
-                {
-                    auto empty_p = std::make_pair<void*, event_loop*>(nullptr, nullptr);
-                    _observers[i] = std::move(empty_p);
-                }
-                break;
-            }
-            ++i;
+            if (it != _observers.end())
+                _observers.erase(it);
         }
-        if (on && i == _observers.size())
+        else if (it == _observers.end())
         {
-            _observers.emplace_back(psink, ploop);
+            observer_item item;
+            item.psink = &sink;
+            item.ploop = ploop;
+            item.owner = owner;
+            item.weak = static_cast<bool>(owner);
+            _observers.emplace_back(std::move(item));
         }
     }
 
     void notify_impl(const sink_member& memf)
     {
         std::lock_guard<mutex_type> lck(_guard_for_observers);
+        bool expired = false;
         for (auto&& item : _observers)
         {
-            observer_i* psink = reinterpret_cast<observer_i*>(item.first);
-            if (!psink)
-                continue;
+            observer_i* psink = item.psink;
+            event_loop* p_el = item.ploop;
+            if (item.weak)
+            {
+                auto owner = item.owner.lock();
+                if (!owner)
+                {
+                    expired = true;
+                    continue;
+                }
 
-            event_loop* p_el = item.second;
-            if (p_el && !p_el->is_this_loop())
+                if (p_el && !p_el->is_this_loop())
+                {
+                    std::weak_ptr<observer_i> weak_owner = owner;
+                    auto pending = [memf, weak_owner]() {
+                        auto owner = weak_owner.lock();
+                        if (owner)
+                            memf(owner.get());
+                    };
+                    p_el->post(pending);
+                }
+                else
+                    memf(psink);
+            }
+            else if (p_el && !p_el->is_this_loop())
             {
                 auto pending = [memf, psink]() {
                     memf(psink);
@@ -131,11 +181,19 @@ protected:
             else
                 memf(psink);
         }
+
+        if (expired)
+        {
+            _observers.erase(std::remove_if(_observers.begin(), _observers.end(), [](const observer_item& item) {
+                                 return item.weak && item.owner.expired();
+                             }),
+                             _observers.end());
+        }
     }
 
 private:
     mutex_type _guard_for_observers;
-    std::vector<std::pair<void*, event_loop*>> _observers;
+    std::vector<observer_item> _observers;
 };
 
 } // namespace server_lib
@@ -48,9 +48,10 @@ public:
             SRV_ASSERT(!et_, "Attempt to unlock not locked mutex");
             SRV_ASSERT(et_ > 0, "Not owner try to unlock");
         }
+        // Owner is reset before unlock. Otherwise it could reset
+        // owner that has just locked the mutex
+        _ows.store(0);
         _mutex.unlock();
-        while (!_ows.compare_exchange_weak(et_, 0))
-            spin_loop_pause();
     }
 
 private:
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace server_lib {
+
+class sampling_profiler_impl;
+
+/**
+ * \ingroup common
+ *
+ * \brief In-process sampling CPU profiler.
+ *
+ * Every registered thread (threads of event_loop and event_pool
+ * are registered automatically) gets own timer of thread CPU time
+ * that sends SIGPROF to this thread. Signal handler stores
+ * stack (Boost.Stacktrace) to preallocated buffer. Symbols are
+ * resolved on dump only. Samples are grouped by thread name and
+ * written in collapsed format ("thread;outer;...;inner count")
+ * for flame graph tools (flamegraph.pl, speedscope, etc.).
+ *
+ * Profiler is opt-in and it installs nothing until start().
+ * Registered thread costs only index of its name.
+ * It works on Linux only (start() returns 'false' otherwise).
+ *
+ * It could be controlled by signal:
+ * \code
+ * app.on_control([](application::control_signal signal) {
+ *     if (signal == application::control_signal::USR2)
+ *         sampling_profiler::instance().toggle("/tmp/app.folded");
+ * });
+ * \endcode
+ * Then 'kill -USR2 <pid>' starts profiling and the next one
+ * stops it and writes profile.
+ */
+class sampling_profiler
+{
+protected:
+    sampling_profiler();
+
+public:
+    ~sampling_profiler();
+
+    sampling_profiler(const sampling_profiler&) = delete;
+    sampling_profiler& operator=(const sampling_profiler&) = delete;
+
+    // It is created thread-safely by the first call
+    static sampling_profiler& instance();
+
+    /**
+     * Start sampling of registered threads
+     *
+     * \param period - CPU time of thread between samples
+     * \param max_samples - Buffer capacity. Samples are dropped
+     * when it is exhausted
+     *
+     * \return 'false' if it is not supported or it has already started
+     */
+    bool start(std::chrono::microseconds period = std::chrono::milliseconds(10),
+               size_t max_samples = 100000);
+
+    void stop();
+
+    bool is_running() const;
+
+    /**
+     * Start profiling if it is stopped. Otherwise stop and
+     * write collapsed stacks to file
+     *
+     * \return 'false' on error
+     */
+    bool toggle(const std::string& output_path);
+
+    // Samples of the last (or current) session
+    size_t samples() const;
+    // Samples that did not fit to buffer
+    size_t dropped() const;
+
+    /**
+     * Samples of the last (or current) session in collapsed
+     * format. One stack per line
+     */
+    std::string collapsed_stacks() const;
+
+    bool dump(const std::string& output_path) const;
+
+    /**
+     * Add current thread to sampling (with thread name for stacks).
+     * It could be called while profiler is running
+     */
+    void add_thread(const std::string& name);
+
+    /**
+     * Remove current thread. It should be called before
+     * thread exit
+     */
+    void remove_thread();
+
+private:
+    std::unique_ptr<sampling_profiler_impl> _impl;
+};
+
+} // namespace server_lib
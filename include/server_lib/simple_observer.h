@@ -6,16 +6,146 @@
 
 #include <utility>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
 
 namespace server_lib {
 
+template <typename Callback, typename MutexType>
+class simple_observable;
+
+/**
+ * \ingroup common
+ *
+ * \brief Handle of subscription for simple_observable
+ *
+ * It doesn't unsubscribe in destructor (see scoped_subscription)
+ * thus it could be ignored by subscriber.
+ * Unsubscribe is amortized O(1). Slots of unsubscribed
+ * callbacks are compacted by observable when half of them are dead
+ */
+class subscription
+{
+    template <typename, typename>
+    friend class simple_observable;
+
+    struct registry_i
+    {
+        virtual ~registry_i() = default;
+
+        virtual void on_expired() = 0;
+    };
+
+    struct state
+    {
+        std::atomic_bool active { true };
+        std::weak_ptr<registry_i> registry;
+    };
+
+    static void expire(state& state_)
+    {
+        if (state_.active.exchange(false))
+        {
+            auto registry = state_.registry.lock();
+            if (registry)
+                registry->on_expired();
+        }
+    }
+
+    explicit subscription(std::shared_ptr<state> state_)
+        : _state(std::move(state_))
+    {
+    }
+
+public:
+    subscription() = default;
+
+    bool is_active() const
+    {
+        return _state && _state->active.load();
+    }
+
+    void unsubscribe()
+    {
+        if (_state)
+            expire(*_state);
+        _state.reset();
+    }
+
+private:
+    std::shared_ptr<state> _state;
+};
+
+/**
+ * \ingroup common
+ *
+ * \brief RAII wrapper for subscription
+ */
+class scoped_subscription
+{
+public:
+    scoped_subscription() = default;
+    scoped_subscription(const scoped_subscription&) = delete;
+    scoped_subscription(scoped_subscription&&) = default;
+
+    scoped_subscription(subscription&& subscription_)
+        : _subscription(std::move(subscription_))
+    {
+    }
+
+    ~scoped_subscription()
+    {
+        _subscription.unsubscribe();
+    }
+
+    scoped_subscription& operator=(scoped_subscription&& other)
+    {
+        if (this != &other)
+        {
+            _subscription.unsubscribe();
+            _subscription = std::move(other._subscription);
+        }
+        return *this;
+    }
+
+    bool is_active() const
+    {
+        return _subscription.is_active();
+    }
+
+    void unsubscribe()
+    {
+        _subscription.unsubscribe();
+    }
+
+    subscription release()
+    {
+        return std::move(_subscription);
+    }
+
+private:
+    subscription _subscription;
+};
+
 /**
  * \ingroup common
  *
  * \brief Design patterns: Simplified Observer
  *
  * Only one sink method supported per object.
- * Unsubscribe is not supported.
+ * Unsubscribe is supported by returned subscription.
+ * Weak subscription is finished automatically with owner.
+ *
+ * Subscribers are stored in immutable snapshot (copy-on-write).
+ * Subscription and compaction of unsubscribed slots
+ * replace snapshot under writer mutex.
+ * Notification doesn't lock: it counts itself as reader
+ * (two atomic increments per notify) and reads raw pointer
+ * to snapshot. Replaced snapshots are released by the next writer
+ * or by the last reader. Callbacks are invoked directly
+ * (arguments are copied only for posting to event_loop).
+ * Thus callbacks can subscribe or destroy observable.
  *
  */
 template <typename Callback, typename MutexType = protected_mutex<std::mutex>>
@@ -24,172 +154,400 @@ class simple_observable
 protected:
     using callback = Callback;
     using mutex_type = MutexType;
-    using callback_storage_type = std::vector<std::pair<callback, event_loop*>>;
+
+    struct observer_item
+    {
+        callback sink;
+        event_loop* ploop = nullptr;
+        std::shared_ptr<subscription::state> state;
+        std::weak_ptr<void> owner;
+        bool weak = false;
+    };
+
+    using callback_storage_type = std::vector<observer_item>;
+
+    // Published snapshot with counted readers.
+    // Core outlives observable while it is read
+    class observers_core : public subscription::registry_i
+    {
+        static constexpr size_t destroyed_flag = ~(~size_t(0) >> 1);
+
+    public:
+        ~observers_core()
+        {
+            delete _current.load();
+            release_retired();
+        }
+
+        const callback_storage_type* acquire()
+        {
+            _readers.fetch_add(1);
+            return _current.load();
+        }
+
+        void release()
+        {
+            std::vector<const callback_storage_type*> garbage;
+            // The last reader releases snapshots retired while it was reading.
+            // It is still counted thus core can't be destroyed meanwhile
+            if (_has_retired.load() && (_readers.load() & ~destroyed_flag) == 1)
+            {
+                std::lock_guard<mutex_type> lck(_guard);
+                collect_retired(garbage, 1);
+            }
+            if (_readers.fetch_sub(1) == (destroyed_flag | 1))
+            {
+                // The last reader of destroyed observable
+                auto self = std::move(_self);
+            }
+            delete_snapshots(garbage);
+        }
+
+        static void destroy(std::shared_ptr<observers_core>&& core)
+        {
+            auto pcore = core.get();
+            pcore->_self = std::move(core);
+            if (!(pcore->_readers.fetch_or(destroyed_flag) & ~destroyed_flag))
+            {
+                auto self = std::move(pcore->_self);
+            }
+        }
+
+        std::shared_ptr<subscription::state> make_state(const std::shared_ptr<observers_core>& self)
+        {
+            auto state = std::make_shared<subscription::state>();
+            state->registry = self;
+            return state;
+        }
+
+        void add(observer_item&& item)
+        {
+            update([this, &item]() {
+                auto new_observers = copy_active(1);
+                new_observers->emplace_back(std::move(item));
+                return new_observers;
+            });
+        }
+
+        void assign(std::unique_ptr<callback_storage_type>&& observers)
+        {
+            update([&observers]() {
+                return std::move(observers);
+            });
+        }
+
+        void on_expired() override
+        {
+            update([this]() {
+                ++_dead;
+                auto observers = _current.load();
+                // Amortized compaction: snapshot is rebuilt when half of it is dead
+                if (!observers || _dead * 2 < observers->size())
+                    return std::unique_ptr<callback_storage_type> {};
+                return copy_active(0);
+            });
+        }
+
+    private:
+        // Writers are serialized. Readers always see complete snapshot.
+        // Snapshots are released out of lock because subscribers
+        // could be unsubscribed in destructors of callbacks
+        template <typename Update>
+        void update(Update&& make_observers)
+        {
+            std::vector<const callback_storage_type*> garbage;
+            {
+                std::lock_guard<mutex_type> lck(_guard);
+                auto observers = make_observers();
+                if (observers)
+                {
+                    auto prev = _current.exchange(observers.release());
+                    if (prev)
+                    {
+                        _retired.push_back(prev);
+                        _has_retired = true;
+                    }
+                }
+                // Even if snapshot is not replaced
+                collect_retired(garbage, 0);
+            }
+            delete_snapshots(garbage);
+        }
+
+        // Must be called under guard.
+        // Readers that come after exchange can't see retired snapshots
+        // thus they are released if there are no other readers
+        void collect_retired(std::vector<const callback_storage_type*>& garbage, size_t own_readers)
+        {
+            if (_retired.empty() || (_readers.load() & ~destroyed_flag) != own_readers)
+                return;
+            garbage.swap(_retired);
+            _has_retired = false;
+        }
+
+        // Core could be destroyed by callback destructors
+        static void delete_snapshots(const std::vector<const callback_storage_type*>& garbage)
+        {
+            for (auto observers : garbage)
+                delete observers;
+        }
+
+        // Must be called under guard
+        std::unique_ptr<callback_storage_type> copy_active(size_t reserve)
+        {
+            auto observers = _current.load();
+            std::unique_ptr<callback_storage_type> new_observers { new callback_storage_type };
+            _dead = 0;
+            if (!observers)
+                return new_observers;
+
+            new_observers->reserve(observers->size() + reserve);
+            for (auto&& item : *observers)
+            {
+                if (item.state->active.load())
+                    new_observers->emplace_back(item);
+            }
+            return new_observers;
+        }
+
+        void release_retired()
+        {
+            for (auto observers : _retired)
+                delete observers;
+            _retired.clear();
+        }
+
+        mutex_type _guard;
+        std::atomic<const callback_storage_type*> _current { nullptr };
+        std::atomic<size_t> _readers { 0 };
+        std::vector<const callback_storage_type*> _retired;
+        std::atomic_bool _has_retired { false };
+        // Unsubscribed slots in current snapshot (it could be overestimated)
+        size_t _dead = 0;
+        std::shared_ptr<observers_core> _self;
+    };
+
+    class snapshot_type
+    {
+    public:
+        snapshot_type(observers_core& core)
+            : _core(core)
+            , _observers(core.acquire())
+        {
+        }
+        snapshot_type(const snapshot_type&) = delete;
+
+        ~snapshot_type()
+        {
+            _core.release();
+        }
+
+        const callback_storage_type* get() const
+        {
+            return _observers;
+        }
+
+    private:
+        observers_core& _core;
+        const callback_storage_type* _observers;
+    };
 
 public:
-    simple_observable() = default;
+    simple_observable()
+        : _core(std::make_shared<observers_core>())
+    {
+    }
 
+    /**
+     * Copy has own subscriptions. Subscription handles
+     * control subscribers of source observable only
+     */
     simple_observable(const simple_observable& other)
+        : simple_observable()
+    {
+        snapshot_type observers { *other._core };
+        if (!observers.get())
+            return;
+
+        std::unique_ptr<callback_storage_type> new_observers { new callback_storage_type };
+        new_observers->reserve(observers.get()->size());
+        for (auto&& item : *observers.get())
+        {
+            if (!item.state->active.load())
+                continue;
+            new_observers->emplace_back(item);
+            new_observers->back().state = _core->make_state(_core);
+        }
+        _core->assign(std::move(new_observers));
+    }
+
+    simple_observable& operator=(const simple_observable&) = delete;
+
+    ~simple_observable()
     {
-        std::lock_guard<mutex_type> lck(other._guard_for_observers);
-        _observers = other._observers;
+        observers_core::destroy(std::move(_core));
     }
 
-    void subscribe(callback&& sink)
+    subscription subscribe(callback&& sink)
     {
-        subscribe_impl(std::forward<callback>(sink), nullptr);
+        return subscribe_impl(std::forward<callback>(sink), nullptr, {}, false);
     }
 
-    void subscribe(callback&& sink, event_loop& loop)
+    subscription subscribe(callback&& sink, event_loop& loop)
     {
-        subscribe_impl(std::forward<callback>(sink), &loop);
+        return subscribe_impl(std::forward<callback>(sink), &loop, {}, false);
     }
 
-    void notify()
+    /**
+     * Subscription is active while owner exists.
+     * Owner is held during callback invocation
+     */
+    template <typename Owner>
+    subscription subscribe_weak(const std::shared_ptr<Owner>& owner, callback&& sink)
     {
-        notify_impl([this](callback sink) {
-            this->call_void(sink);
-        },
-                    true);
+        SRV_ASSERT(owner);
+        return subscribe_impl(std::forward<callback>(sink), nullptr, owner, true);
     }
 
+    template <typename Owner>
+    subscription subscribe_weak(const std::shared_ptr<Owner>& owner, callback&& sink, event_loop& loop)
+    {
+        SRV_ASSERT(owner);
+        return subscribe_impl(std::forward<callback>(sink), &loop, owner, true);
+    }
+
+    /**
+     * Arguments are forwarded to the last subscriber
+     * and copied for others
+     */
     template <typename... Arg>
-    void notify(const Arg&... args)
+    void notify(Arg&&... args)
     {
-        notify_impl([this, args...](callback sink) {
-            this->call_with_args(sink, args...);
-        },
-                    true);
+        snapshot_type observers { *_core };
+        if (!observers.get() || observers.get()->empty())
+            return;
+
+        // Callbacks could destroy this object.
+        // Only snapshot is used after that
+        auto& items = *observers.get();
+        auto last = items.size() - 1;
+        for (size_t ci = 0; ci < last; ++ci)
+        {
+            notify_item(items[ci], args...);
+        }
+        notify_item(items[last], std::forward<Arg>(args)...);
     }
 
     template <typename... Arg>
     void notify_ref(Arg&... args)
     {
+        snapshot_type observers { *_core };
+        if (!observers.get())
+            return;
+
         // Check if notification in the same thread
-        notify_impl([&](callback sink) {
-            this->call_with_args(sink, args...);
-        },
-                    false);
+        for (auto&& item : *observers.get())
+        {
+            event_loop* p_el = item.ploop;
+            SRV_ASSERT(!p_el || p_el->is_this_loop(), "Async mode is not allowed");
+
+            call_item(item, args...);
+        }
     }
 
-    // TODO: Use shared_lock for C++17 here
     bool is_any_subscriber() const
     {
-        std::lock_guard<mutex_type> lck(_guard_for_observers);
-        return !_observers.empty();
+        snapshot_type observers { *_core };
+        if (!observers.get())
+            return false;
+
+        for (auto&& item : *observers.get())
+        {
+            if (item.state->active.load() && (!item.weak || !item.owner.expired()))
+                return true;
+        }
+        return false;
     }
 
 protected:
-    void subscribe_impl(callback&& sink, event_loop* ploop)
+    subscription subscribe_impl(callback&& sink, event_loop* ploop, std::weak_ptr<void> owner, bool weak)
     {
-        std::lock_guard<mutex_type> lck(_guard_for_observers);
-        _observers.emplace_back(std::move(sink), ploop);
-    }
+        auto state = _core->make_state(_core);
 
-    template <typename Callback_>
-    void call_void(Callback_ sink)
-    {
-        sink();
-    }
+        observer_item item;
+        item.sink = std::move(sink);
+        item.ploop = ploop;
+        item.state = state;
+        item.owner = std::move(owner);
+        item.weak = weak;
 
-    template <typename Callback_, typename... Arg>
-    void call_with_args(Callback_ sink, const Arg&... args)
-    {
-        sink(args...);
-    }
+        _core->add(std::move(item));
 
-    template <typename Callback_, typename... Arg>
-    void call_with_args(Callback_ sink, Arg&... args)
-    {
-        sink(args...);
+        return subscription { std::move(state) };
     }
 
-    template <typename Call>
-    void notify_impl(Call call, bool async_allowed)
+    template <typename... Arg>
+    static void notify_item(const observer_item& item, Arg&&... args)
     {
-        std::lock_guard<mutex_type> lck(_guard_for_observers);
-        for (auto&& item : _observers)
+        event_loop* p_el = item.ploop;
+        if (p_el && !p_el->is_this_loop())
         {
-            notify_item_impl(call, async_allowed, item.first, item.second);
+            post_item(item, p_el, std::forward<Arg>(args)...);
+        }
+        else
+        {
+            call_item(item, std::forward<Arg>(args)...);
         }
     }
 
-    template <typename Call>
-    void notify_item_impl(Call call, bool async_allowed, callback& sink, event_loop* p_el)
+    template <typename... Arg>
+    static void call_item(const observer_item& item, Arg&&... args)
     {
-        if (p_el && !p_el->is_this_loop())
-        {
-            SRV_ASSERT(async_allowed, "Async mode is not allowed");
+        if (!item.state->active.load())
+            return;
 
-            auto pending = [call, sink]() {
-                call(sink);
-            };
-            p_el->post(pending);
+        if (item.weak)
+        {
+            auto owner = item.owner.lock();
+            if (!owner)
+            {
+                subscription::expire(*item.state);
+                return;
+            }
+            item.sink(std::forward<Arg>(args)...);
         }
         else
         {
-            call(sink);
+            item.sink(std::forward<Arg>(args)...);
         }
     }
 
+    template <typename... Arg>
+    static void post_item(const observer_item& item, event_loop* p_el, Arg&&... args)
+    {
+        // Arguments are stored in pending handler
+        auto pending = std::bind(
+            [](const observer_item& item, auto&... args) {
+                call_item(item, args...);
+            },
+            item, std::forward<Arg>(args)...);
+        p_el->post(pending);
+    }
+
 protected:
-    mutable mutex_type _guard_for_observers;
-    callback_storage_type _observers;
+    std::shared_ptr<observers_core> _core;
 };
 
 // Use if observable object could be destroyed in callback and
-// notify is invoked rare
+// notify is invoked rare.
+// Snapshot based simple_observable already provides this protection
 template <typename Callback, typename MutexType = std::mutex>
 class protected_observable : public simple_observable<Callback, MutexType>
 {
     using base_type = simple_observable<Callback, MutexType>;
-    using callback = typename base_type::callback;
-    using mutex_type = typename base_type::mutex_type;
-    using callback_storage_type = typename base_type::callback_storage_type;
 
 public:
     using base_type::base_type;
-
-    void notify()
-    {
-        protected_notify_impl([this](callback sink) {
-            this->call_void(sink);
-        },
-                              true);
-    }
-
-    template <typename... Arg>
-    void notify(const Arg&... args)
-    {
-        protected_notify_impl([this, args...](callback sink) {
-            this->call_with_args(sink, args...);
-        },
-                              true);
-    }
-
-    template <typename... Arg>
-    void notify(Arg&... args)
-    {
-        // Check if notification in the same thread
-        protected_notify_impl([&](callback sink) {
-            this->call_with_args(sink, args...);
-        },
-                              false);
-    }
-
-protected:
-    template <typename Call>
-    void protected_notify_impl(Call call, bool async_allowed)
-    {
-        callback_storage_type observers;
-        std::unique_lock<mutex_type> lck(this->_guard_for_observers);
-        observers = this->_observers;
-        lck.unlock();
-        for (auto&& item : observers)
-        {
-            this->notify_item_impl(call, async_allowed, item.first, item.second);
-        }
-    }
 };
 
 } // namespace server_lib
@@ -11,9 +11,12 @@
 #include <mutex>
 #include <atomic>
 #include <map>
+#include <functional>
 
 namespace server_lib {
 class spawn_iml;
+class spawn_polling_impl;
+class event_loop;
 
 // This class is pretty like Python3 subprocess.Popen one.
 // It manages IO and lifetime of the child process
@@ -22,16 +25,54 @@ class spawn
 public:
     using args_type = std::vector<std::string>;
     using envs_type = std::map<std::string, std::string>;
+    // It is invoked with empty chunk (nullptr, 0) when stream has closed
+    using output_callback_type = std::function<void(const char* data, size_t size)>;
+    using drain_callback_type = std::function<void()>;
+
+    // posix_spawn doesn't copy page tables of parent (vfork semantic).
+    // It is much faster than fork for parent with big RSS
+    enum class launch_method
+    {
+        posix_spawn,
+        fork
+    };
 
     spawn(const args_type& args);
     spawn(const args_type& args, const envs_type& envs);
     spawn(const args_type& args, const envs_type& envs, bool with_path);
     spawn(const args_type& args, bool with_path);
+    spawn(const args_type& args, const envs_type& envs, bool with_path, launch_method);
     ~spawn();
 
     bool poll();
     spawn& wait();
+    // Write input, close stdin and wait for process.
+    // Outputs are drained concurrently (no deadlock for big outputs)
+    // and could be read from stdout, stderr after that
     spawn& communicate(const std::string& input = {});
+    // Bulk transfer by splice (without copying to user space):
+    // input_fd -> process stdin, process stdout -> output_fd.
+    // Descriptors are expected to be blocking.
+    // Stderr could be read from stream after that
+    spawn& communicate(int input_fd, int output_fd);
+
+    // Switch stdio to non-blocking mode served by event loop.
+    // Streams stdin, stdout, stderr become unusable after that.
+    // Callbacks are invoked in the loop thread. Loop must outlive this object.
+    // If callback is not set the output is discarded
+    spawn& async_io(event_loop& loop,
+                    output_callback_type&& on_stdout,
+                    output_callback_type&& on_stderr = nullptr,
+                    size_t chunk_size = 64 * 1024);
+    // Queue data for stdin. Return size of pending (not written yet) data
+    // that is used for back-pressure together with on_drain
+    size_t async_write(std::string data);
+    // Callback is invoked in the loop thread when pending data size
+    // has fallen to low_watermark
+    spawn& on_drain(drain_callback_type&& callback, size_t low_watermark = 0);
+    // Close stdin when all pending data have been written
+    spawn& async_close_stdin();
+    size_t async_pending() const;
     spawn& send_signal(int);
     spawn& terminate();
     spawn& kill();
@@ -62,14 +103,19 @@ private:
 using spawn_ptr = std::shared_ptr<spawn>;
 
 // Asynchronous wait for >=1 spawned processes and kill them
-// if polling will be destroyed before
+// if polling will be destroyed before.
+// Exits are listened in own event loop thread by pidfd
+// (or SIGCHLD for kernels without pidfd) without polling
 class spawn_polling
 {
 public:
+    // It is invoked in polling thread when child has finished
+    using exit_callback_type = std::function<void(const spawn_ptr&)>;
+
     spawn_polling(const spawn_ptr& = {});
     ~spawn_polling();
 
-    spawn_polling& append(const spawn_ptr&);
+    spawn_polling& append(const spawn_ptr&, exit_callback_type&& callback = nullptr);
     bool empty() const
     {
         return _pool_size.load() == 0;
@@ -80,13 +126,8 @@ public:
     }
 
 private:
-    void wait();
-
-    std::unique_ptr<std::thread> _thread;
-    std::vector<spawn_ptr> _pool;
-    std::mutex _pool_protector;
-    std::atomic_bool _break;
     std::atomic_size_t _pool_size;
+    std::unique_ptr<spawn_polling_impl> _impl;
 };
 
 } // namespace server_lib
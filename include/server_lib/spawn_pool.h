@@ -0,0 +1,59 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include <server_lib/spawn.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+class spawn_pool_impl;
+
+// Pool of long-lived worker processes.
+// Requests are dispatched to the least loaded worker over its stdin
+// and responses are read from its stdout. Both are framed by
+// network::msg_protocol (size header and byte array).
+// Worker must answer requests in the order they have been received
+// (see spawn_pool::serve). Crashed workers are restarted.
+class spawn_pool
+{
+public:
+    // It is invoked in pool thread. If worker has crashed
+    // the callback is invoked with success = false
+    using response_callback_type = std::function<void(bool success, const std::string& response)>;
+    using request_handler_type = std::function<std::string(const std::string& request)>;
+
+    // max_in_flight = 0 means 16 requests per worker
+    spawn_pool(const spawn::args_type& worker_args,
+               const size_t nb_workers,
+               const size_t max_in_flight = 0,
+               const size_t msg_max_size = 1024 * 1024);
+    ~spawn_pool();
+
+    spawn_pool& start();
+    void stop();
+
+    // Return false if max_in_flight has been reached (back-pressure)
+    bool request(const std::string& payload, response_callback_type&& callback);
+
+    size_t in_flight() const;
+    size_t restarts() const;
+    std::vector<int> worker_pids() const;
+
+    // Worker side. Handle requests from stdin until EOF.
+    // Return exit code for worker process
+    static int serve(request_handler_type&& handler,
+                     const size_t msg_max_size = 1024 * 1024);
+
+private:
+    std::unique_ptr<spawn_pool_impl> _impl;
+};
+
+} // namespace server_lib
+
+#endif // SERVER_LIB_PLATFORM_LINUX
@@ -2,29 +2,31 @@
 
 #include <server_lib/types.h>
 
-#include <thread>
-#include <memory>
-#include <map>
-#include <mutex>
-#include <atomic>
-#include <vector>
+#include <cstdint>
+#include <cstddef>
 
 namespace server_lib {
 
 /**
  * \ingroup common
  *
- * This class is Thread-local storage (TLS) cross platform emulation
- * for set of buffers
+ * This class is Thread-local storage (TLS) for set of buffers.
+ *
+ * Every instance owns slot in native thread_local table of each thread.
+ * Thus buffer access doesn't take any lock.
+ * Buffers are released when thread exits. Buffers of destroyed
+ * instance are released on thread exit or when slot is reused
  */
 class thread_local_storage
 {
     using buffers_type = unsigned char;
-    using buffers_storage_type = std::vector<buffers_type>;
-    using buffers_by_thread_type = std::map<std::thread::id, buffers_storage_type>;
 
 public:
     thread_local_storage(uint8_t buffers_count = 1);
+    ~thread_local_storage();
+
+    thread_local_storage(const thread_local_storage&) = delete;
+    thread_local_storage& operator=(const thread_local_storage&) = delete;
 
     size_t size(uint8_t buff_idx = 0) const;
 
@@ -44,8 +46,8 @@ public:
     string_ref get_ref(uint8_t buff_idx = 0);
 
 private:
-    mutable std::mutex _tid_mutex;
-    std::vector<buffers_by_thread_type> _buffers;
-    std::atomic<uint8_t> _buffers_count;
+    const uint8_t _buffers_count;
+    size_t _slot = 0;
+    uint64_t _generation = 0;
 };
 } // namespace server_lib
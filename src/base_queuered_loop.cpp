@@ -1,9 +1,26 @@
 #include <server_lib/base_queuered_loop.h>
 
+#include <server_lib/sampling_profiler.h>
 #include <server_lib/simple_observer.h>
+#include <server_lib/thread_sync_helpers.h>
 
 #include <boost/utility/in_place_factory.hpp>
 
+#include "stall_watchdog.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#endif
+
 #include "logger_set_internal_group.h"
 
 namespace server_lib {
@@ -16,6 +33,76 @@ class stop_observable_type : public protected_observable<base_queuered_loop::cal
 {
 };
 
+class loop_instruments
+{
+public:
+    std::atomic_bool enabled { true };
+    std::atomic<uint64_t> posts { 0 };
+    std::atomic<uint64_t> max_queue_size { 0 };
+    std::atomic<uint64_t> stalls { 0 };
+    std::atomic<int64_t> since { stall_watchdog::now_ns() };
+    latency_histogram queue_latency;
+    latency_histogram handler_duration;
+};
+
+namespace {
+    // Probe of loop that is running in this thread
+    thread_local stall_probe* tls_probe = nullptr;
+    thread_local const base_queuered_loop* tls_probe_loop = nullptr;
+
+    stall_probe* current_probe(const base_queuered_loop* loop)
+    {
+        return tls_probe_loop == loop ? tls_probe : nullptr;
+    }
+
+    int64_t to_ns(base_queuered_loop::stats_clock::time_point time_point)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time_point.time_since_epoch()).count();
+    }
+
+    class probe_registration
+    {
+    public:
+        probe_registration(const base_queuered_loop* loop, const std::string& loop_name, std::chrono::milliseconds threshold)
+        {
+            if (threshold.count() <= 0)
+                return;
+
+            _probe = std::make_unique<stall_probe>(loop_name, threshold);
+            tls_probe = _probe.get();
+            tls_probe_loop = loop;
+            stall_watchdog::instance().add(_probe.get());
+        }
+
+        ~probe_registration()
+        {
+            if (!_probe)
+                return;
+
+            stall_watchdog::instance().remove(_probe.get());
+            tls_probe = nullptr;
+            tls_probe_loop = nullptr;
+        }
+
+    private:
+        std::unique_ptr<stall_probe> _probe;
+    };
+
+    // Loop thread is sampled with own name if profiler starts
+    class profiler_registration
+    {
+    public:
+        profiler_registration(const std::string& loop_name)
+        {
+            sampling_profiler::instance().add_thread(loop_name);
+        }
+
+        ~profiler_registration()
+        {
+            sampling_profiler::instance().remove_thread();
+        }
+    };
+} // namespace
 
 void base_queuered_loop::set_thread_name(const std::string& name)
 {
@@ -33,7 +120,250 @@ void base_queuered_loop::apply_thread_name()
 #endif
 }
 
+void base_queuered_loop::set_busy_poll(std::chrono::microseconds spin_budget)
+{
+    SRV_ASSERT(!is_running(), "Busy-poll mode should be set before start");
+    SRV_ASSERT(spin_budget.count() >= 0);
+
+    _busy_poll_budget = spin_budget;
+}
+
+void base_queuered_loop::set_cpu_affinity(const std::vector<int>& cpus)
+{
+    for (auto cpu : cpus)
+    {
+        SRV_ASSERT(cpu >= 0, "Invalid CPU number");
+    }
+
+    _cpu_affinity = cpus;
+}
+
+void base_queuered_loop::set_numa_node(int node)
+{
+    if (node >= 0)
+    {
+        SRV_ASSERT(!numa_node_cpus(node).empty(), "Unknown NUMA node");
+    }
+
+    _numa_node = node;
+}
+
+void base_queuered_loop::set_nice(int nice)
+{
+    SRV_ASSERT(nice >= -20 && nice <= 19, "Nice value should be in range [-20, 19]");
+
+    _nice = nice;
+}
+
+void base_queuered_loop::set_realtime_priority(int priority)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    SRV_ASSERT(priority == 0 || (priority >= sched_get_priority_min(SCHED_FIFO) && priority <= sched_get_priority_max(SCHED_FIFO)),
+               "Invalid SCHED_FIFO priority");
+#endif
+
+    _realtime_priority = priority;
+}
+
+std::vector<int> base_queuered_loop::numa_node_cpus(int node)
+{
+    std::vector<int> result;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // Format: "0-7,16-23"
+    std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string range;
+    while (std::getline(input, range, ','))
+    {
+        int first = 0, last = 0;
+        auto n = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n < 1)
+            continue;
+        if (n == 1)
+            last = first;
+        for (int cpu = first; cpu <= last; ++cpu)
+            result.emplace_back(cpu);
+    }
+#endif
+    return result;
+}
+
+void base_queuered_loop::apply_thread_options()
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    std::vector<int> cpus = _cpu_affinity;
+    if (_numa_node >= 0)
+    {
+        auto node_cpus = numa_node_cpus(_numa_node);
+        if (cpus.empty())
+        {
+            cpus = node_cpus;
+        }
+        else
+        {
+            // Keep requested CPUs of the node only
+            cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&node_cpus](int cpu) {
+                           return std::find(node_cpus.begin(), node_cpus.end(), cpu) == node_cpus.end();
+                       }),
+                       cpus.end());
+            if (cpus.empty())
+            {
+                SRV_LOGC_WARN("CPU set doesn't intersect NUMA node " << _numa_node);
+                cpus = node_cpus;
+            }
+        }
+
+        // Prefer the node for memory that is touched by thread first
+        // (connection buffers, handler allocations)
+        static constexpr int MPOL_PREFERRED_ = 1;
+        unsigned long nodemask[16] = {};
+        static constexpr size_t MASK_BITS = sizeof(nodemask) * 8;
+        if (static_cast<size_t>(_numa_node) < MASK_BITS)
+        {
+            nodemask[_numa_node / (sizeof(unsigned long) * 8)] |= 1ul << (_numa_node % (sizeof(unsigned long) * 8));
+            if (syscall(SYS_set_mempolicy, MPOL_PREFERRED_, nodemask, MASK_BITS + 1) != 0)
+            {
+                SRV_LOGC_WARN("Can't set NUMA memory policy: " << strerror(errno));
+            }
+        }
+    }
+
+    if (!cpus.empty())
+    {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (auto cpu : cpus)
+            CPU_SET(cpu, &cpuset);
+        auto err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err)
+        {
+            SRV_LOGC_WARN("Can't set CPU affinity: " << strerror(err));
+        }
+    }
+
+    if (_realtime_priority > 0)
+    {
+        sched_param param {};
+        param.sched_priority = _realtime_priority;
+        auto err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err)
+        {
+            SRV_LOGC_WARN("Can't set SCHED_FIFO priority: " << strerror(err));
+        }
+    }
+    else if (_nice != 0)
+    {
+        // Nice value is per thread on Linux
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), _nice) != 0)
+        {
+            SRV_LOGC_WARN("Can't set nice value: " << strerror(errno));
+        }
+    }
+#endif
+}
+
+void base_queuered_loop::set_stats_enabled(bool enabled)
+{
+    _instruments->enabled = enabled;
+}
+
+void base_queuered_loop::set_stall_threshold(std::chrono::milliseconds threshold)
+{
+    SRV_ASSERT(!is_running(), "Stall threshold should be set before start");
+    SRV_ASSERT(threshold.count() >= 0);
+
+    _stall_threshold = threshold;
+}
+
+bool base_queuered_loop::is_stats_enabled() const
+{
+    return _instruments->enabled;
+}
+
+loop_stats base_queuered_loop::stats() const
+{
+    auto& instruments = *_instruments;
+
+    loop_stats result;
+    result.posts = instruments.posts.load(std::memory_order_relaxed);
+    result.queue_size = _queue_size.load(std::memory_order_relaxed);
+    result.max_queue_size = instruments.max_queue_size.load(std::memory_order_relaxed);
+    result.stalls = instruments.stalls.load(std::memory_order_relaxed);
+    result.queue_latency = instruments.queue_latency.summary();
+    result.handler_duration = instruments.handler_duration.summary();
+    result.executed = result.handler_duration.count;
+
+    auto elapsed = std::chrono::nanoseconds(stall_watchdog::now_ns() - instruments.since.load());
+    if (elapsed.count() > 0)
+        result.posts_per_sec = static_cast<double>(result.posts) / std::chrono::duration<double>(elapsed).count();
+    return result;
+}
+
+void base_queuered_loop::reset_stats()
+{
+    auto& instruments = *_instruments;
+
+    instruments.posts = 0;
+    instruments.max_queue_size = _queue_size.load();
+    instruments.stalls = 0;
+    instruments.queue_latency.reset();
+    instruments.handler_duration.reset();
+    instruments.since = stall_watchdog::now_ns();
+}
+
+base_queuered_loop::stats_clock::time_point base_queuered_loop::on_post(std::chrono::nanoseconds delay)
+{
+    auto queue_size = std::atomic_fetch_add<uint64_t>(&_queue_size, 1) + 1;
+
+    auto& instruments = *_instruments;
+    if (!instruments.enabled.load(std::memory_order_relaxed))
+        return {};
+
+    instruments.posts.fetch_add(1, std::memory_order_relaxed);
+    auto max_queue_size = instruments.max_queue_size.load(std::memory_order_relaxed);
+    while (queue_size > max_queue_size && !instruments.max_queue_size.compare_exchange_weak(max_queue_size, queue_size, std::memory_order_relaxed))
+    {
+    }
+
+    return stats_clock::now() + std::chrono::duration_cast<stats_clock::duration>(delay);
+}
+
+base_queuered_loop::stats_clock::time_point base_queuered_loop::on_handler_start(stats_clock::time_point enqueued)
+{
+    auto& instruments = *_instruments;
+    bool enabled = instruments.enabled.load(std::memory_order_relaxed);
+    auto* probe = current_probe(this);
+    if (!enabled && !probe)
+        return {};
+
+    auto now = stats_clock::now();
+    if (enabled && enqueued != stats_clock::time_point {})
+        instruments.queue_latency.record(now - enqueued);
+    if (probe && probe->depth++ == 0)
+        probe->handler_started = to_ns(now);
+    return now;
+}
+
+void base_queuered_loop::on_handler_finish(stats_clock::time_point started)
+{
+    std::atomic_fetch_sub<uint64_t>(&_queue_size, 1);
+
+    if (started == stats_clock::time_point {})
+        return;
+
+    auto& instruments = *_instruments;
+    auto duration = stats_clock::now() - started;
+    if (instruments.enabled.load(std::memory_order_relaxed))
+        instruments.handler_duration.record(duration);
+    if (_stall_threshold.count() > 0 && duration >= _stall_threshold)
+        instruments.stalls.fetch_add(1, std::memory_order_relaxed);
+
+    auto* probe = current_probe(this);
+    if (probe && --probe->depth == 0)
+        probe->handler_started = 0;
+}
+
 base_queuered_loop::base_queuered_loop()
+    : _instruments(std::make_unique<loop_instruments>())
 {
     _is_running = false;
     _queue_size = 0;
@@ -111,10 +441,17 @@ void base_queuered_loop::run()
         SRV_ASSERT(_pservice);
 
         apply_thread_name();
+        apply_thread_options();
+
+        probe_registration probe(this, _base_name, _stall_threshold);
+        profiler_registration profiler(_base_name);
 
         SRV_LOGC_TRACE("Event loop is starting");
 
-        _pservice->run();
+        if (is_busy_poll())
+            run_busy_poll();
+        else
+            _pservice->run();
 
         SRV_LOGC_TRACE("Event loop has stopped");
 
@@ -128,6 +465,36 @@ void base_queuered_loop::run()
     }
 }
 
+void base_queuered_loop::run_busy_poll()
+{
+    using clock_type = std::chrono::steady_clock;
+
+    const bool can_block = _busy_poll_budget != std::chrono::microseconds::max();
+    auto idle_since = clock_type::now();
+
+    // poll() checks reactor without sleeping. Thread gets back
+    // to blocking run_one() only after spin budget has been expired
+    // without any event
+    while (!_pservice->stopped())
+    {
+        if (_pservice->poll() > 0)
+        {
+            idle_since = clock_type::now();
+            continue;
+        }
+
+        if (can_block && clock_type::now() - idle_since >= _busy_poll_budget)
+        {
+            _pservice->run_one();
+            idle_since = clock_type::now();
+        }
+        else
+        {
+            spin_loop_pause();
+        }
+    }
+}
+
 void base_queuered_loop::reset()
 {
     _is_running = false;
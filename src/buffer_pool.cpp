@@ -0,0 +1,183 @@
+#include <server_lib/buffer_pool.h>
+
+#include <array>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace server_lib {
+
+namespace {
+    // 16, 32, ... 64K
+    constexpr size_t size_classes = 13;
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    size_t class_index(size_t size)
+    {
+        size_t idx = 0;
+        size_t block_size = buffer_pool::min_block_size;
+        while (block_size < size)
+        {
+            block_size <<= 1;
+            ++idx;
+        }
+        return idx;
+    }
+
+    constexpr size_t class_block_size(size_t idx)
+    {
+        return buffer_pool::min_block_size << idx;
+    }
+
+    // Blocks count that thread keeps for size class
+    constexpr size_t thread_cache_limit(size_t idx)
+    {
+        return class_block_size(idx) >= 16 * 1024 ? 8 : 64;
+    }
+
+    struct block_list
+    {
+        free_block* head = nullptr;
+        size_t count = 0;
+
+        void push(void* p)
+        {
+            auto* block = static_cast<free_block*>(p);
+            block->next = head;
+            head = block;
+            ++count;
+        }
+
+        void* pop()
+        {
+            auto* block = head;
+            head = block->next;
+            --count;
+            return block;
+        }
+
+        // Split off n blocks from the head
+        block_list take(size_t n)
+        {
+            block_list result;
+            while (n-- > 0 && head)
+                result.push(pop());
+            return result;
+        }
+
+        void release()
+        {
+            while (head)
+                ::operator delete(pop());
+        }
+    };
+
+    // Shared store of block batches
+    class depot
+    {
+    public:
+        bool get(size_t idx, block_list& to)
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            auto& batches = _batches[idx];
+            if (batches.empty())
+                return false;
+            to = batches.back();
+            batches.pop_back();
+            return true;
+        }
+
+        void put(size_t idx, block_list&& batch)
+        {
+            if (!batch.count)
+                return;
+
+            {
+                const std::lock_guard<std::mutex> lock(_mutex);
+                auto& batches = _batches[idx];
+                // Don't keep more than several thread caches
+                if (batches.size() < 16)
+                {
+                    batches.emplace_back(batch);
+                    return;
+                }
+            }
+            batch.release();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::array<std::vector<block_list>, size_classes> _batches;
+    };
+
+    depot& shared_depot()
+    {
+        // Intentionally is not destroyed. Threads could exit after static destruction
+        static depot* pdepot = new depot;
+        return *pdepot;
+    }
+
+    // Other thread_local objects could use pool after cache destruction
+    thread_local bool tls_cache_destroyed = false;
+
+    struct thread_cache
+    {
+        std::array<block_list, size_classes> lists;
+
+        ~thread_cache()
+        {
+            tls_cache_destroyed = true;
+            for (size_t idx = 0; idx < size_classes; ++idx)
+                shared_depot().put(idx, std::move(lists[idx]));
+        }
+    };
+
+    thread_local thread_cache tls_cache;
+} // namespace
+
+void* buffer_pool::allocate(size_t size)
+{
+    if (size > max_block_size)
+        return ::operator new(size);
+
+    auto idx = class_index(size);
+    if (tls_cache_destroyed)
+        return ::operator new(class_block_size(idx));
+
+    auto& list = tls_cache.lists[idx];
+    if (!list.count)
+    {
+        if (!shared_depot().get(idx, list))
+            return ::operator new(class_block_size(idx));
+    }
+    return list.pop();
+}
+
+void buffer_pool::deallocate(void* p, size_t size) noexcept
+{
+    if (!p)
+        return;
+
+    if (size > max_block_size || tls_cache_destroyed)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    auto idx = class_index(size);
+    auto& list = tls_cache.lists[idx];
+    list.push(p);
+
+    auto limit = thread_cache_limit(idx);
+    if (list.count > limit)
+    {
+        // Move half to depot for other threads
+        shared_depot().put(idx, list.take(limit / 2));
+    }
+}
+
+} // namespace server_lib
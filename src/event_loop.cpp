@@ -91,6 +91,71 @@ event_loop& event_loop::change_loop_name(const std::string& name)
     return *this;
 }
 
+event_loop& event_loop::enable_busy_poll(std::chrono::microseconds spin_budget)
+{
+    base_class::set_busy_poll(spin_budget);
+    return *this;
+}
+
+event_loop& event_loop::pin_to_cpu(int cpu)
+{
+    return pin_to_cpus({ cpu });
+}
+
+event_loop& event_loop::pin_to_cpus(const std::vector<int>& cpus)
+{
+    base_class::set_cpu_affinity(cpus);
+    update_thread_options();
+    return *this;
+}
+
+event_loop& event_loop::bind_to_numa_node(int node)
+{
+    base_class::set_numa_node(node);
+    update_thread_options();
+    return *this;
+}
+
+event_loop& event_loop::set_nice(int nice)
+{
+    base_class::set_nice(nice);
+    update_thread_options();
+    return *this;
+}
+
+event_loop& event_loop::set_realtime_priority(int priority)
+{
+    base_class::set_realtime_priority(priority);
+    update_thread_options();
+    return *this;
+}
+
+event_loop& event_loop::enable_stats(bool enable)
+{
+    base_class::set_stats_enabled(enable);
+    return *this;
+}
+
+event_loop& event_loop::set_stall_threshold(std::chrono::milliseconds threshold)
+{
+    base_class::set_stall_threshold(threshold);
+    return *this;
+}
+
+void event_loop::update_thread_options()
+{
+    if (!_run_in_separate_thread)
+    {
+        apply_thread_options();
+    }
+    else if (is_running())
+    {
+        post([this]() {
+            apply_thread_options();
+        });
+    }
+}
+
 event_loop& event_loop::start()
 {
     if (is_running())
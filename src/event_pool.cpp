@@ -41,6 +41,52 @@ event_pool& event_pool::change_pool_name(const std::string& name)
     return *this;
 }
 
+event_pool& event_pool::enable_busy_poll(std::chrono::microseconds spin_budget)
+{
+    base_class::set_busy_poll(spin_budget);
+    return *this;
+}
+
+event_pool& event_pool::pin_to_cpus(const std::vector<int>& cpus)
+{
+    SRV_ASSERT(!is_running(), "Not implemented for already runned");
+    base_class::set_cpu_affinity(cpus);
+    return *this;
+}
+
+event_pool& event_pool::bind_to_numa_node(int node)
+{
+    SRV_ASSERT(!is_running(), "Not implemented for already runned");
+    base_class::set_numa_node(node);
+    return *this;
+}
+
+event_pool& event_pool::set_nice(int nice)
+{
+    SRV_ASSERT(!is_running(), "Not implemented for already runned");
+    base_class::set_nice(nice);
+    return *this;
+}
+
+event_pool& event_pool::set_realtime_priority(int priority)
+{
+    SRV_ASSERT(!is_running(), "Not implemented for already runned");
+    base_class::set_realtime_priority(priority);
+    return *this;
+}
+
+event_pool& event_pool::enable_stats(bool enable)
+{
+    base_class::set_stats_enabled(enable);
+    return *this;
+}
+
+event_pool& event_pool::set_stall_threshold(std::chrono::milliseconds threshold)
+{
+    base_class::set_stall_threshold(threshold);
+    return *this;
+}
+
 event_pool& event_pool::start()
 {
     if (is_running())
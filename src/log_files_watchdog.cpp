@@ -1,4 +1,5 @@
 #include <server_lib/log_files_watchdog.h>
+#include <server_lib/event_pool.h>
 #include <server_lib/fs_helper.h>
 
 #include <boost/shared_ptr.hpp>
@@ -10,16 +11,25 @@
 #include <boost/date_time/time_facet.hpp>
 #include <boost/exception/diagnostic_information.hpp>
 
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/copy.hpp>
+
 #include <server_lib/asserts.h>
 
 #include <iostream>
+#include <fstream>
 #include <locale>
 #include <cstdlib>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <array>
 
 #ifdef SERVER_LIB_PLATFORM_LINUX
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/inotify.h>
 
 #include <linux/fs.h>
 #endif
@@ -292,18 +302,12 @@ namespace impl {
         return true;
     }
 
-    template <typename Action>
-    void base_max_files_strategy(const log_files_watchdog_config& config, Action&& act)
-    {
-        if (!check_pattern(config.log_variable_pattern))
-            return; //always single file
-
-        std::string time_pattern;
+    using matched_files_type = std::multimap<file_sequence_id_type, bfs::path>;
 
-        using matched_files_type = std::multimap<file_sequence_id_type, bfs::path>;
+    matched_files_type scan_matched_files(const log_files_watchdog_config& config, match_context& context)
+    {
         matched_files_type matched_files;
         bfs::directory_iterator it(config.dir_path), endit;
-        match_context context { config.log_variable_pattern };
         while (it != endit)
         {
             auto file = *it++;
@@ -313,6 +317,17 @@ namespace impl {
 
             matched_files.emplace(get_file_sequence_id(file), file);
         }
+        return matched_files;
+    }
+
+    template <typename Action>
+    void base_max_files_strategy(const log_files_watchdog_config& config, Action&& act)
+    {
+        if (!check_pattern(config.log_variable_pattern))
+            return; //always single file
+
+        match_context context { config.log_variable_pattern };
+        auto matched_files = scan_matched_files(config, context);
 
         if (matched_files.size() > config.max_files)
         {
@@ -354,8 +369,8 @@ void log_files_watchdog::remove_excess_logs(const log_files_watchdog_config& con
 {
     SRV_LOGC_TRACE(SRV_FUNCTION_NAME_);
 
-    impl::base_max_files_strategy(config, [](const path& file) {
-        bfs::remove(file);
+    impl::base_max_files_strategy(config, [&config](const path& file) {
+        remove_log(config, file);
     });
 }
 
@@ -363,26 +378,407 @@ void log_files_watchdog::pack_excess_logs(const log_files_watchdog_config& confi
 {
     SRV_LOGC_TRACE(SRV_FUNCTION_NAME_);
 
+    impl::base_max_files_strategy(config, [&config](const path& file) {
+        pack_log(config, file);
+    });
+}
+
+void log_files_watchdog::remove_log(const log_files_watchdog_config&, const boost::filesystem::path& file)
+{
+    boost::system::error_code ec;
+    bfs::remove(file, ec);
+    if (ec)
+    {
+        SRV_LOGC_WARN("Can't remove " << file << ": " << ec.message());
+    }
+}
+
+void log_files_watchdog::pack_log(const log_files_watchdog_config& config, const boost::filesystem::path& file)
+{
 #ifdef SERVER_LIB_PLATFORM_LINUX
     SRV_ASSERT(!config.pack_command.empty());
     SRV_ASSERT(system(NULL), "Command processor is not available");
 
-    impl::base_max_files_strategy(config, [&config](const path& file) {
-        auto compress = config.pack_command;
-        compress.append(" ");
-        auto path = bfs::absolute(file);
-        compress.append(path.c_str());
-        auto r = system(compress.c_str());
-        if (r)
+    auto compress = config.pack_command;
+    compress.append(" ");
+    auto path = bfs::absolute(file);
+    compress.append(path.c_str());
+    auto r = system(compress.c_str());
+    if (r)
+    {
+        SRV_LOGC_WARN("Comressor return " << r << ". It is should be error code");
+    }
+#endif
+}
+
+log_files_compression_stats log_files_watchdog::compress_log(const boost::filesystem::path& file, const int level)
+{
+    namespace bio = boost::iostreams;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto packed_file = file;
+    packed_file += ".gz";
+    auto tmp_file = packed_file;
+    tmp_file += ".tmp";
+
+    log_files_compression_stats stats;
+
+    bool written = false;
+    try
+    {
+        std::ifstream input { file.generic_string(), std::ios_base::binary };
+        SRV_ASSERT(input, "Can't open log file");
+
+        std::ofstream output { tmp_file.generic_string(), std::ios_base::binary | std::ios_base::trunc };
+        SRV_ASSERT(output, "Can't create packed file");
+
         {
-            SRV_LOGC_WARN("Comressor return " << r << ". It is should be error code");
+            bio::gzip_params params { level };
+            params.file_name = file.filename().string();
+            params.mtime = bfs::last_write_time(file);
+
+            bio::filtering_ostreambuf compressor;
+            compressor.push(bio::gzip_compressor { params });
+            compressor.push(output);
+
+            // Compressor is flushed and closed by copy
+            stats.input_bytes = bio::copy(input, compressor);
+        }
+
+        // Write errors (ENOSPC) are reported by closing
+        output.close();
+        written = !output.fail();
+    }
+    catch (const std::exception&)
+    {
+        boost::system::error_code ec;
+        bfs::remove(tmp_file, ec);
+        throw;
+    }
+
+    if (!written)
+    {
+        // Original log is kept
+        boost::system::error_code ec;
+        bfs::remove(tmp_file, ec);
+        SRV_ERROR("Can't write packed file " + tmp_file.generic_string());
+    }
+
+    // Packed file appears only when it is complete
+    bfs::rename(tmp_file, packed_file);
+    bfs::remove(file);
+
+    stats.files = 1;
+    stats.output_bytes = bfs::file_size(packed_file);
+    stats.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+}
+
+#ifdef SERVER_LIB_PLATFORM_LINUX
+class log_files_watchdog::auto_watch_impl
+{
+public:
+    auto_watch_impl(log_files_watchdog& owner,
+                    Strategy&& strategy,
+                    Action&& action,
+                    const uint8_t nb_action_threads)
+        : _owner(owner)
+        , _strategy(std::move(strategy))
+        , _action(std::move(action))
+        , _service(owner.service())
+        , _descriptor(*_service)
+        , _context(owner.log_variable_pattern)
+    {
+        if (_action)
+        {
+            _action_pool = std::make_unique<event_pool>(nb_action_threads);
+            _action_pool->change_pool_name("log_watch");
+            _action_pool->start();
+        }
+    }
+
+    ~auto_watch_impl()
+    {
+        // Stop actions before closing descriptor
+        _action_pool.reset();
+    }
+
+    // Invoked in watchdog thread
+    void start()
+    {
+        int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        SRV_ASSERT(fd >= 0, "Can't initialize inotify");
+
+        _descriptor.assign(fd);
+
+        auto wd = ::inotify_add_watch(fd, _owner.dir_path.c_str(),
+                                      IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR);
+        SRV_ASSERT(wd >= 0, "Can't watch log directory");
+
+        // The only full scan. Events that arise during scanning
+        // are read after it and are idempotent for index
+        rebuild_index();
+        enforce_max_files();
+
+        read_events();
+    }
+
+private:
+    using index_key_type = std::pair<impl::file_sequence_id_type, std::string>;
+
+    void rebuild_index()
+    {
+        _ordered_files.clear();
+        _file_keys.clear();
+
+        for (auto&& item : impl::scan_matched_files(_owner, _context))
+        {
+            add_to_index(item.first, item.second.filename().string());
+        }
+    }
+
+    void add_to_index(const impl::file_sequence_id_type& id, const std::string& file_name)
+    {
+        remove_from_index(file_name);
+
+        _ordered_files.emplace(id, file_name);
+        _file_keys.emplace(file_name, id);
+    }
+
+    void remove_from_index(const std::string& file_name)
+    {
+        auto it = _file_keys.find(file_name);
+        if (it == _file_keys.end())
+            return;
+
+        _ordered_files.erase(std::make_pair(it->second, file_name));
+        _file_keys.erase(it);
+    }
+
+    void read_events()
+    {
+        _descriptor.async_read_some(boost::asio::buffer(_buffer),
+                                    [this](const boost::system::error_code& ec, size_t sz) {
+                                        if (ec)
+                                        {
+                                            if (ec != boost::asio::error::operation_aborted)
+                                            {
+                                                SRV_LOGC_ERROR("Can't read log directory events: " << ec.message());
+                                            }
+                                            return;
+                                        }
+
+                                        process_events(sz);
+                                        read_events();
+                                    });
+    }
+
+    void process_events(const size_t sz)
+    {
+        bool rebuild = false;
+        for (size_t pos = 0; pos + sizeof(struct inotify_event) <= sz;)
+        {
+            const auto* pevent = reinterpret_cast<const struct inotify_event*>(_buffer.data() + pos);
+            pos += sizeof(struct inotify_event) + pevent->len;
+
+            if (pevent->mask & IN_Q_OVERFLOW)
+            {
+                rebuild = true;
+                continue;
+            }
+
+            if (!pevent->len)
+                continue;
+
+            std::string file_name { pevent->name };
+
+            if (pevent->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                remove_from_index(file_name);
+            }
+            else if (pevent->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                auto file = _owner.dir_path / file_name;
+                if (impl::match_file(file, _owner, _context))
+                    add_to_index(impl::get_file_sequence_id(file), file_name);
+            }
+        }
+
+        if (rebuild)
+        {
+            SRV_LOGC_WARN("Log directory events have been lost");
+            rebuild_index();
+        }
+
+        enforce_max_files();
+    }
+
+    void enforce_max_files()
+    {
+        if (_ordered_files.size() <= _owner.max_files)
+            return;
+
+        if (_strategy)
+        {
+            // Index will be updated by events of strategy
+            _strategy(_owner);
+            return;
+        }
+
+        while (_ordered_files.size() > _owner.max_files)
+        {
+            auto it = _ordered_files.begin();
+            auto file = _owner.dir_path / it->second;
+            _file_keys.erase(it->second);
+            _ordered_files.erase(it);
+
+            _action_pool->post([this, file]() {
+                _action(_owner, file);
+            });
+        }
+    }
+
+private:
+    log_files_watchdog& _owner;
+    const Strategy _strategy;
+    const Action _action;
+    // Keep io_service alive while descriptor exists
+    std::shared_ptr<boost::asio::io_service> _service;
+    boost::asio::posix::stream_descriptor _descriptor;
+    impl::match_context _context;
+    std::set<index_key_type> _ordered_files;
+    std::unordered_map<std::string, impl::file_sequence_id_type> _file_keys;
+    std::unique_ptr<event_pool> _action_pool;
+    alignas(struct inotify_event) std::array<char, 64 * 1024> _buffer;
+};
+#else
+class log_files_watchdog::auto_watch_impl
+{
+};
+#endif
+
+struct log_files_watchdog::rotation_state
+{
+    std::mutex guard;
+    log_files_watchdog* owner = nullptr;
+};
+
+log_files_watchdog::~log_files_watchdog()
+{
+    if (_rotation)
+    {
+        // Logger can keep rotation handler longer than watchdog
+        std::lock_guard<std::mutex> lck(_rotation->guard);
+        _rotation->owner = nullptr;
+    }
+
+    try
+    {
+        stop();
+    }
+    catch (const std::exception& e)
+    {
+        SRV_LOGC_ERROR(e.what());
+    }
+}
+
+void log_files_watchdog::auto_watch(Strategy strategy)
+{
+    SRV_ASSERT(strategy);
+
+    start_auto_watch(std::move(strategy), nullptr, 0);
+}
+
+void log_files_watchdog::auto_watch(Action action, const uint8_t nb_action_threads)
+{
+    SRV_ASSERT(action);
+    SRV_ASSERT(nb_action_threads > 0, "Threads are required");
+
+    start_auto_watch(nullptr, std::move(action), nb_action_threads);
+}
+
+void log_files_watchdog::auto_compress(const uint8_t nb_threads, const int level)
+{
+    auto action = [this, level](const log_files_watchdog_config&, const path& file) {
+        try
+        {
+            auto stats = compress_log(file, level);
+
+            SRV_LOGC_DEBUG("Log " << file << " has packed: " << stats.input_bytes << " -> " << stats.output_bytes
+                                  << " bytes, " << static_cast<uint64_t>(stats.throughput()) << " bytes/s");
+
+            std::lock_guard<std::mutex> lck(_compression_stats_guard);
+            _compression_stats.files += stats.files;
+            _compression_stats.input_bytes += stats.input_bytes;
+            _compression_stats.output_bytes += stats.output_bytes;
+            _compression_stats.duration += stats.duration;
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR("Can't pack " << file << ": " << e.what());
+        }
+    };
+
+    auto_watch(std::move(action), nb_threads);
+}
+
+logger::rotation_handler_type log_files_watchdog::rotation_handler(Action action)
+{
+    SRV_ASSERT(action);
+
+    if (!_rotation)
+    {
+        _rotation = std::make_shared<rotation_state>();
+        _rotation->owner = this;
+    }
+
+    std::weak_ptr<rotation_state> weak_state = _rotation;
+    return [weak_state, action](const std::string& closed_file_path) {
+        auto state = weak_state.lock();
+        if (!state)
+            return;
+
+        std::lock_guard<std::mutex> lck(state->guard);
+        auto owner = state->owner;
+        if (!owner)
+            return;
+
+        path file { closed_file_path };
+        owner->post([owner, action, file]() {
+            action(*owner, file);
+        });
+    };
+}
+
+void log_files_watchdog::start_auto_watch(Strategy&& strategy, Action&& action, const uint8_t nb_action_threads)
+{
+#ifdef SERVER_LIB_PLATFORM_LINUX
+    SRV_ASSERT(!_auto_watch, "Auto watch has already set");
+
+    SRV_LOGC_TRACE(SRV_FUNCTION_NAME_);
+
+    _auto_watch = std::make_shared<auto_watch_impl>(*this, std::move(strategy), std::move(action), nb_action_threads);
+
+    post([this]() {
+        try
+        {
+            _auto_watch->start();
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR(e.what());
         }
     });
+#else
+    SRV_ERROR("Not implemented");
 #endif
 }
 
-void log_files_watchdog::auto_watch(Strategy)
+void log_files_watchdog::stop()
 {
-    // TODO
+    event_loop::stop();
+
+    _auto_watch.reset();
 }
 } // namespace server_lib
@@ -3,6 +3,7 @@
 #include <server_lib/asserts.h>
 
 #include "logging_trace.h"
+#include "logging_mmap_backend.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -293,6 +294,32 @@ logger& logger::init_file_log(const char* file_path, const size_t rotation_size_
     return *this;
 }
 
+logger& logger::init_mmap_file_log(const char* file_path,
+                                   const size_t rotation_size_kb,
+                                   rotation_handler_type&& rotation_handler)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    using namespace boost::log;
+
+    boost::shared_ptr<impl::mmap_file_backend> backend = boost::make_shared<impl::mmap_file_backend>(
+        file_path,
+        rotation_size_kb * 1024,
+        std::move(rotation_handler));
+
+    using mmap_file_sink = sinks::asynchronous_sink<impl::mmap_file_backend>;
+
+    boost::shared_ptr<mmap_file_sink> sink = boost::make_shared<mmap_file_sink>(backend);
+
+    add_boost_log_destination(sink, _time_format);
+
+    unlock();
+#else
+    SRV_ERROR("Not implemented");
+#endif
+
+    return *this;
+}
+
 logger& logger::init_sys_log()
 {
     //Use init_sys_log to switch on syslog instead obsolete macro USE_NATIVE_SYSLOG
@@ -0,0 +1,241 @@
+#include "logging_mmap_backend.h"
+
+#include <server_lib/platform_config.h>
+#include <server_lib/asserts.h>
+
+#include "logging_trace.h"
+
+#include <ctime>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace server_lib {
+namespace impl {
+
+    namespace {
+        // Check for %N, %3N
+        bool has_counter_pattern(const std::string& pattern)
+        {
+            for (size_t ci = 0; ci + 1 < pattern.size(); ++ci)
+            {
+                if (pattern[ci] != '%')
+                    continue;
+
+                size_t cj = ci + 1;
+                if (pattern[cj] == '%')
+                {
+                    ci = cj;
+                    continue;
+                }
+
+                while (cj < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[cj])))
+                    ++cj;
+
+                if (cj < pattern.size() && pattern[cj] == 'N')
+                    return true;
+            }
+            return false;
+        }
+    } // namespace
+
+    mmap_file_backend::mmap_file_backend(const std::string& file_path_pattern,
+                                         const size_t rotation_size,
+                                         logger::rotation_handler_type&& rotation_handler)
+        : _file_path_pattern(file_path_pattern)
+        , _rotation_size(rotation_size)
+        , _rotation_handler(std::move(rotation_handler))
+    {
+        SRV_ASSERT(!_file_path_pattern.empty(), "File path is required");
+        SRV_ASSERT(_rotation_size > 0, "Invalid rotation size");
+        // Each segment is opened with truncation
+        SRV_ASSERT(has_counter_pattern(_file_path_pattern), "File path requires %N pattern");
+    }
+
+    mmap_file_backend::~mmap_file_backend()
+    {
+        try
+        {
+            // Report the last segment as well
+            rotate_file();
+        }
+        catch (const std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+
+    void mmap_file_backend::consume(const boost::log::record_view&, const string_type& formatted_message)
+    {
+        const size_t record_size = formatted_message.size() + 1;
+
+        if (_segment && _written + record_size > _segment_size)
+            rotate_file();
+
+        if (!_segment)
+            open_segment(record_size);
+
+        char* pos = _segment + _written;
+        std::memcpy(pos, formatted_message.data(), formatted_message.size());
+        pos[formatted_message.size()] = '\n';
+        _written += record_size;
+    }
+
+    void mmap_file_backend::flush()
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (_segment)
+        {
+            // Schedule write back only. The mapped pages are already in page cache
+            ::msync(_segment, _segment_size, MS_ASYNC);
+        }
+#endif
+    }
+
+    void mmap_file_backend::rotate_file()
+    {
+        auto closed_file_path = _file_path;
+
+        close_segment();
+
+        if (closed_file_path.empty() || !_rotation_handler)
+            return;
+
+        try
+        {
+            _rotation_handler(closed_file_path);
+        }
+        catch (const std::exception& e)
+        {
+            SRV_TRACE_SIGNAL(e.what());
+        }
+    }
+
+    std::string mmap_file_backend::generate_file_name()
+    {
+        std::string time_pattern;
+        time_pattern.reserve(_file_path_pattern.size());
+
+        // Replace %N, %3N by file counter and leave other patterns for strftime
+        for (size_t ci = 0; ci < _file_path_pattern.size(); ++ci)
+        {
+            char ch = _file_path_pattern[ci];
+            if (ch != '%' || ci + 1 == _file_path_pattern.size())
+            {
+                time_pattern.push_back(ch);
+                continue;
+            }
+
+            if (_file_path_pattern[ci + 1] == '%')
+            {
+                time_pattern.append("%%");
+                ++ci;
+                continue;
+            }
+
+            size_t cj = ci + 1;
+            int width = 0;
+            while (cj < _file_path_pattern.size() && std::isdigit(static_cast<unsigned char>(_file_path_pattern[cj])))
+            {
+                width = width * 10 + (_file_path_pattern[cj] - '0');
+                ++cj;
+            }
+
+            if (cj < _file_path_pattern.size() && _file_path_pattern[cj] == 'N')
+            {
+                auto counter = std::to_string(_file_counter);
+                if (static_cast<int>(counter.size()) < width)
+                    time_pattern.append(width - counter.size(), '0');
+                time_pattern.append(counter);
+                ci = cj;
+            }
+            else
+            {
+                time_pattern.push_back(ch);
+            }
+        }
+
+        if (time_pattern.find('%') == std::string::npos)
+            return time_pattern;
+
+        std::time_t now = std::time(nullptr);
+        std::tm tm_now;
+#if defined(SERVER_LIB_PLATFORM_WINDOWS)
+        localtime_s(&tm_now, &now);
+#else
+        localtime_r(&now, &tm_now);
+#endif
+        std::string file_name(time_pattern.size() + 64, '\0');
+        auto sz = std::strftime(&file_name[0], file_name.size(), time_pattern.c_str(), &tm_now);
+        SRV_ASSERT(sz > 0, "Invalid file name pattern");
+        file_name.resize(sz);
+        return file_name;
+    }
+
+    void mmap_file_backend::open_segment(const size_t required_size)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        SRV_ASSERT(!_segment);
+
+        _file_path = generate_file_name();
+        ++_file_counter;
+
+        _fd = ::open(_file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        SRV_ASSERT(_fd >= 0, "Can't open log file");
+
+        _segment_size = std::max(_rotation_size, required_size);
+
+        // Reserve disk blocks to avoid SIGBUS for full disk.
+        // Sparse file is acceptable if filesystem doesn't support it
+        if (::fallocate(_fd, 0, 0, static_cast<off_t>(_segment_size)) != 0)
+        {
+            SRV_ASSERT(::ftruncate(_fd, static_cast<off_t>(_segment_size)) == 0, "Can't allocate log file");
+        }
+
+        void* p = ::mmap(nullptr, _segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(_fd);
+            _fd = -1;
+            SRV_ERROR("Can't map log file");
+        }
+        _segment = static_cast<char*>(p);
+        _written = 0;
+#else
+        SRV_ERROR("Not implemented");
+#endif
+    }
+
+    void mmap_file_backend::close_segment()
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        _file_path.clear();
+        if (_segment)
+        {
+            ::munmap(_segment, _segment_size);
+            _segment = nullptr;
+        }
+        if (_fd >= 0)
+        {
+            // Cut off preallocated tail
+            if (::ftruncate(_fd, static_cast<off_t>(_written)) != 0)
+            {
+                SRV_TRACE_SIGNAL("Can't trim log file");
+            }
+            ::close(_fd);
+            _fd = -1;
+        }
+        _segment_size = 0;
+        _written = 0;
+#endif
+    }
+
+} // namespace impl
+} // namespace server_lib
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <server_lib/logger.h>
+
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/core/record_view.hpp>
+
+#include <string>
+
+namespace server_lib {
+namespace impl {
+
+    /**
+     * Boost.Log backend that writes formatted records to
+     * memory-mapped file segments.
+     *
+     * Each segment is preallocated (fallocate) with rotation size
+     * and mapped as shared. Records are appended with memcpy.
+     * When the segment is full it is trimmed to the written size, unmapped
+     * and reported to the rotation handler. Then the next segment is mapped.
+     *
+     * File path should contain variable pattern (%N, %3N and strftime patterns)
+     * like log_files_watchdog_config::log_variable_pattern. %N is required
+     * because each segment is opened with truncation.
+     * The last segment is reported to the rotation handler on destruction.
+     *
+     * Pages of the mapped segment belong to page cache. Thus written records
+     * survive application crash without explicit flush.
+     */
+    class mmap_file_backend : public boost::log::sinks::basic_formatted_sink_backend<char, boost::log::sinks::synchronized_feeding>
+    {
+    public:
+        mmap_file_backend(const std::string& file_path_pattern,
+                          const size_t rotation_size,
+                          logger::rotation_handler_type&& rotation_handler);
+        ~mmap_file_backend();
+
+        void consume(const boost::log::record_view&, const string_type& formatted_message);
+
+        void flush();
+
+        void rotate_file();
+
+    private:
+        std::string generate_file_name();
+        void open_segment(const size_t required_size);
+        void close_segment();
+
+    private:
+        const std::string _file_path_pattern;
+        const size_t _rotation_size;
+        logger::rotation_handler_type _rotation_handler;
+        unsigned _file_counter = 0;
+
+        std::string _file_path;
+        int _fd = -1;
+        char* _segment = nullptr;
+        size_t _segment_size = 0;
+        size_t _written = 0;
+    };
+
+} // namespace impl
+} // namespace server_lib
@@ -0,0 +1,126 @@
+#include <server_lib/loop_stats.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace server_lib {
+
+namespace {
+    // Index of most significant bit (value > 0)
+    size_t log2_floor(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#else
+        size_t result = 0;
+        while (value >>= 1)
+            ++result;
+        return result;
+#endif
+    }
+} // namespace
+
+latency_histogram::latency_histogram()
+{
+    reset();
+}
+
+size_t latency_histogram::bucket_index(uint64_t value) noexcept
+{
+    if (value < sub_buckets)
+        return static_cast<size_t>(value);
+
+    auto exponent = log2_floor(value);
+    if (exponent > max_exponent)
+        return buckets_count - 1;
+
+    auto sub = (value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+    return (exponent - sub_bucket_bits + 1) * sub_buckets + static_cast<size_t>(sub);
+}
+
+uint64_t latency_histogram::bucket_upper_value(size_t idx) noexcept
+{
+    if (idx < sub_buckets)
+        return idx;
+
+    size_t exponent = idx / sub_buckets + sub_bucket_bits - 1;
+    uint64_t sub = idx % sub_buckets;
+    uint64_t width = uint64_t(1) << (exponent - sub_bucket_bits);
+    return (sub_buckets + sub) * width + width - 1;
+}
+
+void latency_histogram::record(std::chrono::nanoseconds value) noexcept
+{
+    uint64_t ns = value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+
+    _buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(ns, std::memory_order_relaxed);
+
+    // Extremes are rarely changed so CAS loops are cold
+    auto min = _min.load(std::memory_order_relaxed);
+    while (ns < min && !_min.compare_exchange_weak(min, ns, std::memory_order_relaxed))
+    {
+    }
+    auto max = _max.load(std::memory_order_relaxed);
+    while (ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void latency_histogram::reset() noexcept
+{
+    for (auto& bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds latency_histogram::percentile(double q) const noexcept
+{
+    // Buckets are read one by one while other threads record,
+    // so take total from buckets themselves
+    uint64_t total = 0;
+    for (auto& bucket : _buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    if (!total)
+        return {};
+
+    q = std::min(std::max(q, 0.0), 1.0);
+    auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(total) + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t idx = 0; idx < buckets_count; ++idx)
+    {
+        seen += _buckets[idx].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            auto value = std::min(bucket_upper_value(idx), _max.load(std::memory_order_relaxed));
+            return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(value));
+        }
+    }
+    return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(_max.load(std::memory_order_relaxed)));
+}
+
+latency_summary latency_histogram::summary() const noexcept
+{
+    using ns_type = std::chrono::nanoseconds;
+
+    latency_summary result;
+    result.count = count();
+    if (!result.count)
+        return result;
+
+    result.min = ns_type(static_cast<ns_type::rep>(_min.load(std::memory_order_relaxed)));
+    result.max = ns_type(static_cast<ns_type::rep>(_max.load(std::memory_order_relaxed)));
+    result.mean = ns_type(static_cast<ns_type::rep>(_sum.load(std::memory_order_relaxed) / result.count));
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    return result;
+}
+
+} // namespace server_lib
@@ -0,0 +1,125 @@
+#include <server_lib/memory_arena.h>
+#include <server_lib/buffer_pool.h>
+#include <server_lib/asserts.h>
+
+#include <cstdint>
+
+namespace server_lib {
+
+struct memory_arena::block
+{
+    block* next;
+    size_t capacity;
+
+    char* data()
+    {
+        return reinterpret_cast<char*>(this + 1);
+    }
+};
+
+memory_arena::memory_arena(size_t block_size)
+    : _block_size(block_size)
+{
+    SRV_ASSERT(block_size > 0);
+}
+
+memory_arena::~memory_arena()
+{
+    free_blocks();
+}
+
+void* memory_arena::allocate(size_t size, size_t alignment)
+{
+    SRV_ASSERT(alignment > 0 && !(alignment & (alignment - 1)), "Invalid alignment");
+
+    auto aligned = [alignment](char* p) {
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((addr + alignment - 1) & ~(alignment - 1));
+    };
+
+    char* p = _ptr ? aligned(_ptr) : nullptr;
+    if (!p || p + size > _end)
+    {
+        auto capacity = size + alignment;
+        if (capacity > _block_size / 2)
+        {
+            // Big allocation gets own block behind current one
+            // to keep filling current one
+            auto* pblock = new_block(capacity);
+            if (_head)
+            {
+                pblock->next = _head->next;
+                _head->next = pblock;
+            }
+            else
+            {
+                _head = pblock;
+            }
+            _allocated += size;
+            return aligned(pblock->data());
+        }
+
+        auto* pblock = new_block(_block_size);
+        pblock->next = _head;
+        _head = pblock;
+        _ptr = pblock->data();
+        _end = _ptr + pblock->capacity;
+        p = aligned(_ptr);
+    }
+
+    _ptr = p + size;
+    _allocated += size;
+    return p;
+}
+
+void memory_arena::reset()
+{
+    // Keep first regular block (the last one in list)
+    block* keep = nullptr;
+    for (auto* pblock = _head; pblock; pblock = pblock->next)
+    {
+        if (pblock->capacity == _block_size)
+            keep = pblock;
+    }
+
+    while (_head)
+    {
+        auto* pblock = _head;
+        _head = pblock->next;
+        if (pblock != keep)
+            buffer_pool::deallocate(pblock, sizeof(block) + pblock->capacity);
+    }
+
+    if (keep)
+    {
+        keep->next = nullptr;
+        _head = keep;
+        _ptr = keep->data();
+        _end = _ptr + keep->capacity;
+    }
+    else
+    {
+        _ptr = _end = nullptr;
+    }
+    _allocated = 0;
+}
+
+memory_arena::block* memory_arena::new_block(size_t capacity)
+{
+    auto* pblock = static_cast<block*>(buffer_pool::allocate(sizeof(block) + capacity));
+    pblock->next = nullptr;
+    pblock->capacity = capacity;
+    return pblock;
+}
+
+void memory_arena::free_blocks()
+{
+    while (_head)
+    {
+        auto* pblock = _head;
+        _head = pblock->next;
+        buffer_pool::deallocate(pblock, sizeof(block) + pblock->capacity);
+    }
+}
+
+} // namespace server_lib
@@ -2,6 +2,10 @@
 
 #include "transport/tcp_client_impl.h"
 #include "transport/unix_local_client_impl.h"
+#include "transport/udp_client_impl.h"
+#include "network_counters.h"
+
+#include <server_lib/network/raw_builder.h>
 
 #include <server_lib/asserts.h>
 
@@ -10,6 +14,11 @@
 namespace server_lib {
 namespace network {
 
+    client::client()
+        : _counters(std::make_shared<network_counters>())
+    {
+    }
+
     client::~client()
     {
         SRV_LOGC_TRACE("attempts to destroy");
@@ -36,6 +45,11 @@ namespace network {
         return {};
     }
 
+    udp_client_config client::configurate_udp()
+    {
+        return {};
+    }
+
     std::shared_ptr<transport_layer::__client_impl_i> client::create_impl(const tcp_client_config& config)
     {
         SRV_ASSERT(config.valid());
@@ -51,7 +65,28 @@ namespace network {
         auto impl = std::make_shared<transport_layer::unix_local_client_impl>();
         impl->config(config);
         _protocol = config.protocol();
+        // Packets are not parsed in SOCK_SEQPACKET mode
+        if (!_protocol)
+            _protocol = std::make_shared<raw_builder>();
+        return impl;
+    }
+
+    std::shared_ptr<transport_layer::__client_impl_i> client::create_impl(const udp_client_config& config)
+    {
+        SRV_ASSERT(config.valid());
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        auto impl = std::make_shared<transport_layer::udp_client_impl>();
+        impl->config(config);
+        _protocol = config.protocol();
+        // Datagrams are not parsed
+        if (!_protocol)
+            _protocol = std::make_shared<raw_builder>();
         return impl;
+#else
+        SRV_ERROR("Not implemented at current platform");
+        return {};
+#endif
     }
 
     bool client::connect_impl(std::function<std::shared_ptr<transport_layer::__client_impl_i>()>&& create_impl)
@@ -86,7 +121,7 @@ namespace network {
             SRV_ASSERT(_impl);
             SRV_ASSERT(_protocol);
 
-            auto conn = connection::create(raw_connection, _protocol);
+            auto conn = connection::create(raw_connection, _protocol, false, _counters);
             conn->on_disconnect(std::bind(&client::on_diconnect_impl, this, std::placeholders::_1));
             _connection = conn;
 
@@ -137,6 +172,11 @@ namespace network {
         }
     }
 
+    network_stats client::stats() const
+    {
+        return _counters->snapshot();
+    }
+
     void client::clear()
     {
         if (_connection)
@@ -1,10 +1,20 @@
 #include <server_lib/network/connection.h>
 
 #include "transport/connection_impl_i.h"
+#include "transport/splice_relay.h"
 
 #include <server_lib/asserts.h>
 
 #include "unit_builder_manager.h"
+#include "network_counters.h"
+
+#include <server_lib/platform_config.h>
+
+#include <algorithm>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <unistd.h>
+#endif
 
 #include "../logger_set_internal_group.h"
 
@@ -41,14 +51,14 @@ namespace network {
         }
 
     private:
-        void on_raw_receive(const transport_layer::__connection_impl_i::read_result& result)
+        void on_raw_receive(transport_layer::__connection_impl_i::read_result& result)
         {
             if (!result.success)
             {
                 return;
             }
 
-            _self.on_raw_receive(result.buffer);
+            _self.on_raw_receive(result.buffer, result.chain, result.descriptors);
         }
 
         connection& _self;
@@ -56,16 +66,21 @@ namespace network {
     };
 
     connection::connection(const std::shared_ptr<transport_layer::__connection_impl_i>& raw_connection,
-                           const std::shared_ptr<unit_builder_i>& protocol)
+                           const std::shared_ptr<unit_builder_i>& protocol,
+                           const std::shared_ptr<connection_counters>& counters)
         : _raw_connection(raw_connection)
+        , _counters(counters)
     {
         SRV_ASSERT(_raw_connection);
         SRV_ASSERT(protocol);
+        SRV_ASSERT(_counters);
 
         _protocol = std::make_unique<unit_builder_manager>();
         //initialize personal protocol state
         _protocol->set_builder(std::shared_ptr<unit_builder_i>(protocol->clone()));
 
+        _read_size = _raw_connection->chunk_size();
+
         _impl = std::make_unique<connection_impl>(*this, *_raw_connection);
         _raw_connection->set_disconnect_handler(std::bind(&connection::on_diconnected, this));
 
@@ -82,6 +97,11 @@ namespace network {
 
             _raw_connection->set_disconnect_handler(nullptr);
 
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            for (auto fd : _received_descriptors)
+                ::close(fd);
+#endif
+
             SRV_LOGC_TRACE("destroyed");
         }
         catch (const std::exception& e)
@@ -119,18 +139,38 @@ namespace network {
         return _protocol->builder();
     }
 
+    connection_stats connection::stats() const
+    {
+        return _counters->snapshot();
+    }
+
     connection& connection::post(const std::string& input)
     {
         SRV_ASSERT(_protocol);
+        SRV_ASSERT(_raw_connection);
+
+        // Message boundaries are kept by transport
+        if (_raw_connection->is_message_oriented())
+            return post(unit { input });
 
         return post(_protocol->builder().create(input));
     }
 
     connection& connection::post(const unit& unit)
     {
+        SRV_ASSERT(_raw_connection);
+
+        auto data = unit.to_network_string();
+
         std::unique_lock<std::mutex> lock(_send_buffer_mutex);
 
-        _send_buffer += unit.to_network_string();
+        // Bytes are counted before they become committable. Otherwise
+        // concurrent commit could release them before they are queued
+        _counters->on_queued(data.size());
+        if (_raw_connection->is_message_oriented())
+            _send_packets.emplace_back(data.data(), data.size());
+        else
+            _send_buffer.append(data.data(), data.size());
 
         lock.unlock();
 
@@ -147,16 +187,40 @@ namespace network {
 
         std::unique_lock<std::mutex> lock(_send_buffer_mutex);
 
-        std::string buffer = std::move(_send_buffer);
+        pooled_string buffer = std::move(_send_buffer);
+        std::vector<pooled_string> packets = std::move(_send_packets);
+        _send_packets.clear();
 
         lock.unlock();
 
         try
         {
-            SRV_ASSERT(!buffer.empty());
+            SRV_ASSERT(!buffer.empty() || !packets.empty());
+
+            _counters->on_commit();
+
+            auto on_written = [counters = _counters](transport_layer::__connection_impl_i::write_result& result) {
+                counters->on_written(result.size);
+            };
+
+            if (!buffer.empty())
+            {
+                transport_layer::__connection_impl_i::write_request request = {
+                    pooled_buffer { buffer.begin(), buffer.end() },
+                    on_written
+                };
+                _raw_connection->async_write(request);
+            }
 
-            transport_layer::__connection_impl_i::write_request request = { std::vector<char> { buffer.begin(), buffer.end() }, nullptr };
-            _raw_connection->async_write(request);
+            // One write per packet
+            for (auto&& packet : packets)
+            {
+                transport_layer::__connection_impl_i::write_request request = {
+                    pooled_buffer { packet.begin(), packet.end() },
+                    on_written
+                };
+                _raw_connection->async_write(request);
+            }
         }
         catch (const std::exception& e)
         {
@@ -172,6 +236,90 @@ namespace network {
         return *this;
     }
 
+    connection& connection::send(const unit& unit, const std::vector<int>& descriptors)
+    {
+        SRV_ASSERT(_raw_connection);
+
+        bool pending = false;
+        {
+            std::lock_guard<std::mutex> lock(_send_buffer_mutex);
+            pending = !_send_buffer.empty() || !_send_packets.empty();
+        }
+        // Posted units go first
+        if (pending)
+            commit();
+
+        auto data = unit.to_network_string();
+        _counters->on_queued(data.size());
+        _counters->on_commit();
+
+        bool supported = true;
+        try
+        {
+            transport_layer::__connection_impl_i::write_request request = {
+                pooled_buffer { data.begin(), data.end() },
+                [counters = _counters](transport_layer::__connection_impl_i::write_result& result) {
+                    counters->on_written(result.size);
+                }
+            };
+            supported = _raw_connection->async_write_descriptors(request, descriptors);
+        }
+        catch (const std::exception& e)
+        {
+            /**
+            * Client disconnected in the meantime
+            */
+
+            SRV_LOGC_WARN(e.what());
+        }
+
+        SRV_ASSERT(supported, "Descriptors passing is not supported by transport");
+
+        return *this;
+    }
+
+    connection& connection::send(const std::string& input, const std::vector<int>& descriptors)
+    {
+        SRV_ASSERT(_protocol);
+        SRV_ASSERT(_raw_connection);
+
+        if (_raw_connection->is_message_oriented())
+            return send(unit { input }, descriptors);
+
+        return send(_protocol->builder().create(input), descriptors);
+    }
+
+    std::vector<int> connection::take_descriptors()
+    {
+        std::lock_guard<std::mutex> lock(_received_descriptors_mutex);
+        return std::move(_received_descriptors);
+    }
+
+    connection& connection::pipe_to(const pconnection& destination)
+    {
+        SRV_ASSERT(destination);
+        SRV_ASSERT(destination.get() != this);
+        SRV_ASSERT(!_raw_connection->is_message_oriented() || destination->_raw_connection->is_message_oriented(),
+                   "Packets could not be relayed to stream");
+
+        {
+            std::lock_guard<std::mutex> lock(_pipe_mutex);
+            SRV_ASSERT(!_pipe_destination, "Connection is piped already");
+            _pipe_destination = destination;
+        }
+
+        std::weak_ptr<transport_layer::__connection_impl_i> weak_raw_connection = _raw_connection;
+        destination->on_disconnect([weak_raw_connection]() {
+            auto raw_connection = weak_raw_connection.lock();
+            if (raw_connection)
+                raw_connection->disconnect();
+        });
+        if (!destination->is_connected())
+            disconnect();
+
+        return *this;
+    }
+
     connection& connection::on_receive(receive_callback_type&& callback)
     {
         _receive_observer.subscribe(std::forward<receive_callback_type>(callback));
@@ -192,10 +340,12 @@ namespace network {
 
     pconnection connection::create(
         const std::shared_ptr<transport_layer::__connection_impl_i>& raw_connection,
-        const std::shared_ptr<unit_builder_i>& protocol)
+        const std::shared_ptr<unit_builder_i>& protocol,
+        bool inbound,
+        const std::shared_ptr<network_counters>& total)
     {
         pconnection conn;
-        conn.reset(new connection(raw_connection, protocol));
+        conn.reset(new connection(raw_connection, protocol, std::make_shared<connection_counters>(inbound, total)));
         return conn;
     }
 
@@ -204,20 +354,79 @@ namespace network {
         SRV_ASSERT(_impl);
         SRV_ASSERT(_raw_connection);
 
-        _impl->async_read(_raw_connection->chunk_size());
+        _impl->async_read(_read_size);
     }
 
-    void connection::on_raw_receive(const std::vector<char>& result)
+    void connection::adapt_read_size(size_t received)
+    {
+        auto min_size = _raw_connection->chunk_size();
+        auto max_size = _raw_connection->max_chunk_size();
+
+        // Packet should fit block
+        if (max_size <= min_size || _raw_connection->is_message_oriented())
+            return;
+
+        if (received >= _read_size)
+            _read_size = std::min(_read_size * 2, max_size);
+        else if (received < _read_size / 4)
+            _read_size = std::max(_read_size / 2, min_size);
+    }
+
+    void connection::on_raw_receive(pooled_buffer& result, std::vector<pooled_buffer>& chain, std::vector<int>& descriptors)
     {
         auto hold_self = shared_from_this();
 
         SRV_ASSERT(_protocol);
         SRV_ASSERT(_raw_connection);
 
+        auto received = result.size();
+        for (auto&& buffer : chain)
+            received += buffer.size();
+
+        _counters->on_read(received);
+
+        adapt_read_size(received);
+
+        if (!descriptors.empty())
+        {
+            std::lock_guard<std::mutex> lock(_received_descriptors_mutex);
+            _received_descriptors.insert(_received_descriptors.end(), descriptors.begin(), descriptors.end());
+            descriptors.clear();
+        }
+
+        auto destination = pipe_destination();
+        if (destination)
+        {
+            relay(std::move(result), std::move(chain), destination);
+            return;
+        }
+
+        if (_raw_connection->is_message_oriented())
+        {
+            // Packet is unit
+            _counters->on_unit_in();
+
+            _receive_observer.notify(hold_self, unit { std::string(result.begin(), result.end()) });
+
+            destination = pipe_destination();
+            if (destination)
+                continue_relay(destination);
+            else
+                async_read();
+            return;
+        }
+
+        // Units are built by one pass.
+        // Data is kept to relay the rest of it if it is piped
+        std::string data;
         try
         {
             SRV_LOGC_TRACE("receives packet, attempts to build unit");
-            *_protocol << std::string(result.begin(), result.end());
+            data.reserve(received);
+            data.append(result.begin(), result.end());
+            for (auto&& buffer : chain)
+                data.append(buffer.begin(), buffer.end());
+            *_protocol << data;
         }
         catch (const std::exception& e)
         {
@@ -231,14 +440,107 @@ namespace network {
             SRV_LOGC_TRACE("unit fully built");
 
             auto unit = _protocol->get_front();
+            auto unit_end = _protocol->front_end();
             _protocol->pop_front();
 
+            _counters->on_unit_in();
+
             _receive_observer.notify(hold_self, unit);
+
+            // Piped from receive callback. Bytes after unit
+            // are received by this read
+            destination = pipe_destination();
+            if (destination)
+            {
+                auto rest = static_cast<size_t>(unit_end - (_protocol->fed() - data.size()));
+                _protocol->reset();
+                relay(pooled_buffer { data.begin() + rest, data.end() }, {}, destination);
+                return;
+            }
         }
 
         async_read();
     }
 
+    pconnection connection::pipe_destination()
+    {
+        std::lock_guard<std::mutex> lock(_pipe_mutex);
+        return _pipe_destination;
+    }
+
+    void connection::relay(pooled_buffer&& buffer, std::vector<pooled_buffer>&& chain, const pconnection& destination)
+    {
+        if (buffer.empty() && chain.empty())
+        {
+            continue_relay(destination);
+            return;
+        }
+
+        auto hold_self = shared_from_this();
+
+        try
+        {
+            // Next read is after the last buffer is written
+            auto write = [&](pooled_buffer&& data, bool last) {
+                transport_layer::__connection_impl_i::write_request request = {
+                    std::move(data),
+                    [hold_self, destination, last](transport_layer::__connection_impl_i::write_result& result) {
+                        destination->_counters->on_written(result.size);
+                        if (last)
+                            hold_self->continue_relay(destination);
+                    }
+                };
+                destination->_raw_connection->async_write(request);
+            };
+
+            write(std::move(buffer), chain.empty());
+            for (size_t ci = 0; ci < chain.size(); ++ci)
+                write(std::move(chain[ci]), ci + 1 == chain.size());
+        }
+        catch (const std::exception& e)
+        {
+            /**
+            * Destination disconnected in the meantime
+            */
+
+            SRV_LOGC_WARN(e.what());
+            _raw_connection->disconnect();
+        }
+    }
+
+    void connection::continue_relay(const pconnection& destination)
+    {
+        if (!is_connected())
+            return;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (transport_layer::splice_relay::supported(*_raw_connection, *destination->_raw_connection))
+        {
+            SRV_LOGC_TRACE("relays by splice");
+
+            std::weak_ptr<transport_layer::__connection_impl_i> weak_raw_connection = _raw_connection;
+            auto relay = std::make_shared<transport_layer::splice_relay>(
+                _raw_connection,
+                destination->_raw_connection,
+                [counters = _counters](size_t bytes) {
+                    counters->on_read(bytes);
+                },
+                [counters = destination->_counters](size_t bytes) {
+                    counters->on_written(bytes);
+                },
+                [weak_raw_connection]() {
+                    auto raw_connection = weak_raw_connection.lock();
+                    if (raw_connection)
+                        raw_connection->disconnect();
+                });
+            relay->start();
+            return;
+        }
+#endif
+
+        async_read();
+    }
+
     void connection::on_diconnected()
     {
         SRV_LOGC_TRACE("has been disconnected");
@@ -247,8 +549,17 @@ namespace network {
             std::lock_guard<std::mutex> lock(_send_buffer_mutex);
 
             _send_buffer.clear();
+            _send_packets.clear();
         }
 
+        {
+            // Break cycle of bidirectional proxy
+            std::lock_guard<std::mutex> lock(_pipe_mutex);
+            _pipe_destination.reset();
+        }
+
+        _counters->on_disconnected();
+
         auto hold_self = shared_from_this();
 
         _disconnect_with_id_observer.notify(hold_self->id());
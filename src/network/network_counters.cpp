@@ -0,0 +1,189 @@
+#include "network_counters.h"
+
+namespace server_lib {
+namespace network {
+
+    namespace {
+        int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       connection_counters::clock_type::now().time_since_epoch())
+                .count();
+        }
+    } // namespace
+
+    size_t sharded_counter::shard_index() noexcept
+    {
+        // Threads get shards in turn
+        static std::atomic<size_t> next_index { 0 };
+        static thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % shards_count;
+        return index;
+    }
+
+    uint64_t sharded_counter::value() const noexcept
+    {
+        uint64_t result = 0;
+        for (auto&& shard : _shards)
+            result += shard.value.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    network_stats network_counters::snapshot() const
+    {
+        network_stats result;
+        result.connections = connections.value();
+        result.active_connections = active_connections.value();
+        result.bytes_in = bytes_in.value();
+        result.bytes_out = bytes_out.value();
+        result.units_in = units_in.value();
+        result.units_out = units_out.value();
+        result.read_calls = read_calls.value();
+        result.write_calls = write_calls.value();
+        result.queued_bytes = queued_bytes.value();
+        result.rtt = rtt.summary();
+        return result;
+    }
+
+    connection_counters::connection_counters(bool inbound, std::shared_ptr<network_counters> total)
+        : _inbound(inbound)
+        , _total(std::move(total))
+    {
+        if (_total)
+        {
+            _total->connections.add();
+            _total->active_connections.add();
+        }
+    }
+
+    connection_counters::~connection_counters()
+    {
+        on_disconnected();
+    }
+
+    void connection_counters::on_read(size_t bytes)
+    {
+        _bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+        _read_calls.fetch_add(1, std::memory_order_relaxed);
+        if (_total)
+        {
+            _total->bytes_in.add(bytes);
+            _total->read_calls.add();
+        }
+    }
+
+    void connection_counters::on_unit_in()
+    {
+        _units_in.fetch_add(1, std::memory_order_relaxed);
+        if (_total)
+            _total->units_in.add();
+
+        if (_inbound)
+            start_rtt();
+        else
+            finish_rtt();
+    }
+
+    void connection_counters::on_queued(size_t bytes)
+    {
+        _units_out.fetch_add(1, std::memory_order_relaxed);
+        _queued_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (_total)
+        {
+            _total->units_out.add();
+            _total->queued_bytes.add(bytes);
+        }
+    }
+
+    void connection_counters::on_commit()
+    {
+        if (_inbound)
+            finish_rtt();
+        else
+            start_rtt();
+    }
+
+    void connection_counters::on_written(size_t bytes)
+    {
+        _bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+        _write_calls.fetch_add(1, std::memory_order_relaxed);
+        auto released = release_queued(bytes);
+        if (_total)
+        {
+            _total->bytes_out.add(bytes);
+            _total->write_calls.add();
+            _total->queued_bytes.sub(released);
+        }
+    }
+
+    void connection_counters::on_disconnected()
+    {
+        auto released = _queued_bytes.exchange(0);
+        bool active = _active.exchange(false);
+        if (_total)
+        {
+            _total->queued_bytes.sub(released);
+            if (active)
+                _total->active_connections.sub(1);
+        }
+    }
+
+    connection_stats connection_counters::snapshot() const
+    {
+        connection_stats result;
+        result.bytes_in = _bytes_in.load(std::memory_order_relaxed);
+        result.bytes_out = _bytes_out.load(std::memory_order_relaxed);
+        result.units_in = _units_in.load(std::memory_order_relaxed);
+        result.units_out = _units_out.load(std::memory_order_relaxed);
+        result.read_calls = _read_calls.load(std::memory_order_relaxed);
+        result.write_calls = _write_calls.load(std::memory_order_relaxed);
+        result.queued_bytes = _queued_bytes.load(std::memory_order_relaxed);
+        result.rtt_count = _rtt_count.load(std::memory_order_relaxed);
+        if (result.rtt_count)
+        {
+            result.rtt_mean = std::chrono::nanoseconds(static_cast<int64_t>(_rtt_sum.load(std::memory_order_relaxed) / result.rtt_count));
+            result.rtt_max = std::chrono::nanoseconds(static_cast<int64_t>(_rtt_max.load(std::memory_order_relaxed)));
+        }
+        return result;
+    }
+
+    void connection_counters::start_rtt()
+    {
+        // Keep the first one for pipelined requests
+        int64_t expected = 0;
+        _rtt_start.compare_exchange_strong(expected, now_ns(), std::memory_order_relaxed);
+    }
+
+    void connection_counters::finish_rtt()
+    {
+        auto started = _rtt_start.exchange(0, std::memory_order_relaxed);
+        if (!started)
+            return;
+
+        auto rtt = now_ns() - started;
+        if (rtt < 0)
+            rtt = 0;
+
+        _rtt_count.fetch_add(1, std::memory_order_relaxed);
+        _rtt_sum.fetch_add(static_cast<uint64_t>(rtt), std::memory_order_relaxed);
+        auto max = _rtt_max.load(std::memory_order_relaxed);
+        while (static_cast<uint64_t>(rtt) > max && !_rtt_max.compare_exchange_weak(max, static_cast<uint64_t>(rtt), std::memory_order_relaxed))
+        {
+        }
+        if (_total)
+            _total->rtt.record(std::chrono::nanoseconds(rtt));
+    }
+
+    uint64_t connection_counters::release_queued(uint64_t bytes)
+    {
+        // Counter could have been dropped by disconnection
+        auto queued = _queued_bytes.load(std::memory_order_relaxed);
+        uint64_t released = 0;
+        do
+        {
+            released = std::min(queued, bytes);
+        } while (!_queued_bytes.compare_exchange_weak(queued, queued - released, std::memory_order_relaxed));
+        return released;
+    }
+
+} // namespace network
+} // namespace server_lib
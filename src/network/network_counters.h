@@ -0,0 +1,115 @@
+#pragma once
+
+#include <server_lib/network/network_stats.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * Counter that is sharded by threads. Every thread updates
+     * own shard so pool threads don't contend for one cache line.
+     * Value is sum of shards. Subtraction wraps around
+     * and it is valid while sum is not negative
+     */
+    class sharded_counter
+    {
+    public:
+        void add(uint64_t value = 1) noexcept
+        {
+            _shards[shard_index()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        void sub(uint64_t value) noexcept
+        {
+            _shards[shard_index()].value.fetch_sub(value, std::memory_order_relaxed);
+        }
+
+        uint64_t value() const noexcept;
+
+    private:
+        static constexpr size_t shards_count = 16;
+
+        // Padded to cache line
+        struct shard
+        {
+            std::atomic<uint64_t> value { 0 };
+            char padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+        static size_t shard_index() noexcept;
+
+        std::array<shard, shards_count> _shards;
+    };
+
+    /**
+     * Aggregated counters of server or client
+     */
+    struct network_counters
+    {
+        sharded_counter connections;
+        sharded_counter active_connections;
+        sharded_counter bytes_in;
+        sharded_counter bytes_out;
+        sharded_counter units_in;
+        sharded_counter units_out;
+        sharded_counter read_calls;
+        sharded_counter write_calls;
+        sharded_counter queued_bytes;
+        latency_histogram rtt;
+
+        network_stats snapshot() const;
+    };
+
+    /**
+     * Counters of connection. Connection is served by one thread
+     * at a time mostly so plain atomics are used
+     */
+    struct connection_counters
+    {
+        using clock_type = std::chrono::steady_clock;
+
+        // inbound - connection is accepted by server
+        connection_counters(bool inbound, std::shared_ptr<network_counters> total);
+        ~connection_counters();
+
+        void on_read(size_t bytes);
+        void on_unit_in();
+        void on_queued(size_t bytes);
+        void on_commit();
+        void on_written(size_t bytes);
+        // Drop queued bytes of disconnected connection
+        void on_disconnected();
+
+        connection_stats snapshot() const;
+
+    private:
+        void start_rtt();
+        void finish_rtt();
+        uint64_t release_queued(uint64_t bytes);
+
+        const bool _inbound;
+        const std::shared_ptr<network_counters> _total;
+
+        std::atomic_bool _active { true };
+        std::atomic<uint64_t> _bytes_in { 0 };
+        std::atomic<uint64_t> _bytes_out { 0 };
+        std::atomic<uint64_t> _units_in { 0 };
+        std::atomic<uint64_t> _units_out { 0 };
+        std::atomic<uint64_t> _read_calls { 0 };
+        std::atomic<uint64_t> _write_calls { 0 };
+        std::atomic<uint64_t> _queued_bytes { 0 };
+        // Start of pending request/response pair (ns). 0 if none
+        std::atomic<int64_t> _rtt_start { 0 };
+        std::atomic<uint64_t> _rtt_count { 0 };
+        std::atomic<uint64_t> _rtt_sum { 0 };
+        std::atomic<uint64_t> _rtt_max { 0 };
+    };
+
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <server_lib/buffer_pool.h>
+
+#include <boost/asio.hpp>
+#include <boost/version.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * Asio handler wrapper to recycle memory of asynchronous operations
+     * by buffer_pool. Associated allocator is used by modern Boost.Asio
+     * and allocation hooks are used by old one
+     */
+    template <typename Handler>
+    class pooled_handler
+    {
+    public:
+        using allocator_type = pool_allocator<void>;
+
+        explicit pooled_handler(Handler&& handler)
+            : _handler(std::move(handler))
+        {
+        }
+
+        allocator_type get_allocator() const noexcept
+        {
+            return {};
+        }
+
+        template <typename... Args>
+        void operator()(Args&&... args)
+        {
+            _handler(std::forward<Args>(args)...);
+        }
+
+#if !defined(BOOST_ASIO_NO_DEPRECATED)
+        friend void* asio_handler_allocate(std::size_t size, pooled_handler*)
+        {
+            return buffer_pool::allocate(size);
+        }
+
+        friend void asio_handler_deallocate(void* p, std::size_t size, pooled_handler*)
+        {
+            buffer_pool::deallocate(p, size);
+        }
+#endif
+
+    private:
+        Handler _handler;
+    };
+
+    template <typename Handler>
+    pooled_handler<typename std::decay<Handler>::type> make_pooled_handler(Handler&& handler)
+    {
+        return pooled_handler<typename std::decay<Handler>::type>(typename std::decay<Handler>::type(std::forward<Handler>(handler)));
+    }
+
+} // namespace network
+} // namespace server_lib
@@ -2,6 +2,10 @@
 
 #include "transport/tcp_server_impl.h"
 #include "transport/unix_local_server_impl.h"
+#include "transport/udp_server_impl.h"
+#include "network_counters.h"
+
+#include <server_lib/network/raw_builder.h>
 
 #include <server_lib/asserts.h>
 #include <server_lib/thread_sync_helpers.h>
@@ -11,6 +15,11 @@
 namespace server_lib {
 namespace network {
 
+    server::server()
+        : _counters(std::make_shared<network_counters>())
+    {
+    }
+
     server::~server()
     {
         try
@@ -33,6 +42,11 @@ namespace network {
         return {};
     }
 
+    udp_server_config server::configurate_udp()
+    {
+        return {};
+    }
+
     std::shared_ptr<transport_layer::server_impl_i> server::create_impl(const tcp_server_config& config)
     {
         SRV_ASSERT(config.valid());
@@ -51,6 +65,27 @@ namespace network {
         auto impl = std::make_shared<transport_layer::unix_local_server_impl>();
         impl->config(config);
         _protocol = config.protocol();
+        // Packets are not parsed in SOCK_SEQPACKET mode
+        if (!_protocol)
+            _protocol = std::make_shared<raw_builder>();
+        return impl;
+#else
+        SRV_ERROR("Not implemented at current platform");
+        return {};
+#endif
+    }
+
+    std::shared_ptr<transport_layer::server_impl_i> server::create_impl(const udp_server_config& config)
+    {
+        SRV_ASSERT(config.valid());
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        auto impl = std::make_shared<transport_layer::udp_server_impl>();
+        impl->config(config);
+        _protocol = config.protocol();
+        // Datagrams are not parsed
+        if (!_protocol)
+            _protocol = std::make_shared<raw_builder>();
         return impl;
 #else
         SRV_ERROR("Not implemented at current platform");
@@ -159,6 +194,11 @@ namespace network {
         }
     }
 
+    network_stats server::stats() const
+    {
+        return _counters->snapshot();
+    }
+
     void server::on_start_impl()
     {
         _start_observer.notify();
@@ -174,7 +214,7 @@ namespace network {
         SRV_ASSERT(raw_connection);
         SRV_ASSERT(_protocol);
 
-        auto conn = connection::create(raw_connection, _protocol);
+        auto conn = connection::create(raw_connection, _protocol, true, _counters);
         auto client_disconnected_handler = std::bind(&server::on_client_disconnected, this, std::placeholders::_1);
         conn->on_disconnect(client_disconnected_handler);
         std::unique_lock<std::mutex> lock(_connections_mutex);
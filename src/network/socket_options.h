@@ -0,0 +1,54 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <sys/socket.h>
+#endif
+
+namespace server_lib {
+namespace network {
+
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(SO_BUSY_POLL)
+    using busy_poll_option = boost::asio::detail::socket_option::integer<SOL_SOCKET, SO_BUSY_POLL>;
+#endif
+
+    /**
+     * Set SO_BUSY_POLL to let kernel poll device queue
+     * for socket reads instead of waiting for interrupt.
+     * It does nothing for zero timeout or unsupported platform
+     */
+    template <typename Socket>
+    boost::system::error_code set_socket_busy_poll(Socket& socket, std::chrono::microseconds timeout)
+    {
+        boost::system::error_code ec;
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(SO_BUSY_POLL)
+        if (timeout.count() > 0)
+            socket.lowest_layer().set_option(busy_poll_option(static_cast<int>(timeout.count())), ec);
+#endif
+        return ec;
+    }
+
+    /**
+     * The same for native socket
+     */
+    inline boost::system::error_code set_socket_busy_poll(int fd, std::chrono::microseconds timeout)
+    {
+        boost::system::error_code ec;
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(SO_BUSY_POLL)
+        int value = static_cast<int>(timeout.count());
+        if (value > 0 && ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) != 0)
+            ec = boost::system::error_code(errno, boost::system::system_category());
+#else
+        (void)fd;
+        (void)timeout;
+#endif
+        return ec;
+    }
+
+} // namespace network
+} // namespace server_lib
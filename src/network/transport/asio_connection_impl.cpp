@@ -2,51 +2,147 @@
 
 #include <server_lib/asserts.h>
 
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#endif
+
 #include "../../logger_set_internal_group.h"
 
 namespace server_lib {
 namespace network {
     namespace transport_layer {
 
-        std::function<void(boost::system::error_code, size_t)> async_handler(
-            std::function<bool()>&& scope_lock,
-            std::function<void(size_t)>&& success_case,
-            std::function<void()>&& failed_case)
+        void log_handler_error(const std::exception& e)
+        {
+            (void)e;
+            SRV_LOGC_ERROR(e.what());
+        }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        long scatter_read(int fd,
+                          size_t size,
+                          const read_options& options,
+                          pooled_buffer& buffer,
+                          std::vector<pooled_buffer>& chain)
         {
-            using error_code = boost::system::error_code;
+            constexpr size_t max_chain = 64;
 
-            return [scope_lock = std::move(scope_lock),
-                    success_case = std::move(success_case),
-                    failed_case = std::move(failed_case)](
-                       const error_code& ec, size_t transferred) {
-                try
+            SRV_ASSERT(size > 0);
+
+            const size_t max_count = std::min(std::max<size_t>(options.chain, 1), max_chain);
+            size_t total = 0;
+            for (;;)
+            {
+                // Blocks are allocated for pending bytes only
+                size_t count = 1;
+                if (max_count > 1)
                 {
-                    if (!scope_lock())
-                        return;
-                    if (!ec)
-                    {
-                        success_case(transferred);
-                    }
-                    else
-                    {
-                        failed_case();
-                    }
+                    int pending = 0;
+                    if (::ioctl(fd, FIONREAD, &pending) == 0 && pending > 0)
+                        count = std::min((static_cast<size_t>(pending) + size - 1) / size, max_count);
                 }
-                catch (const std::exception& e)
+
+                pooled_buffer blocks[max_chain];
+                iovec iov[max_chain];
+                for (size_t ci = 0; ci < count; ++ci)
                 {
-                    SRV_LOGC_ERROR(e.what());
-                    try
-                    {
-                        failed_case();
-                    }
-                    catch (const std::exception& e)
+                    blocks[ci].resize(size);
+                    iov[ci] = iovec { blocks[ci].data(), size };
+                }
+
+                msghdr msg = {};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = count;
+
+                ssize_t received = 0;
+                do
+                {
+                    received = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+                } while (received < 0 && errno == EINTR);
+
+                if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+
+                if (received <= 0)
+                {
+                    if (received < 0)
                     {
-                        SRV_LOGC_ERROR(e.what());
-                        throw;
+                        SRV_LOGC_TRACE("recvmsg: " << std::strerror(errno));
                     }
+                    // It is returned by next read
+                    if (total > 0)
+                        break;
+                    return 0;
+                }
+
+                auto left = static_cast<size_t>(received);
+                for (size_t ci = 0; ci < count && left > 0; ++ci)
+                {
+                    auto used = std::min(left, size);
+                    blocks[ci].resize(used);
+                    left -= used;
+
+                    if (total == 0 && ci == 0)
+                        buffer = std::move(blocks[ci]);
+                    else
+                        chain.emplace_back(std::move(blocks[ci]));
                 }
-            };
+                total += static_cast<size_t>(received);
+
+                // Socket is drained if blocks were not filled
+                if (!options.until_would_block || static_cast<size_t>(received) < count * size || total >= options.until_would_block)
+                    break;
+            }
+
+            return total > 0 ? static_cast<long>(total) : -1;
+        }
+
+        long send_descriptors(int fd,
+                              const pooled_buffer& buffer,
+                              const std::vector<int>& descriptors)
+        {
+            SRV_ASSERT(!buffer.empty());
+            SRV_ASSERT(!descriptors.empty() && descriptors.size() <= max_descriptors);
+
+            iovec iov = { const_cast<char*>(buffer.data()), buffer.size() };
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_descriptors)];
+            std::memset(control, 0, sizeof(control));
+
+            msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * descriptors.size());
+
+            auto* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * descriptors.size());
+            std::memcpy(CMSG_DATA(cmsg), descriptors.data(), sizeof(int) * descriptors.size());
+
+            ssize_t sent = 0;
+            do
+            {
+                sent = ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+            } while (sent < 0 && errno == EINTR);
+
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return -1;
+
+            if (sent <= 0)
+            {
+                SRV_LOGC_ERROR("Can't send descriptors: " << std::strerror(errno));
+                return 0;
+            }
+
+            return static_cast<long>(sent);
         }
+#endif
 
     } // namespace transport_layer
 } // namespace network
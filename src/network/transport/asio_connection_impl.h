@@ -1,9 +1,15 @@
 #pragma once
 
 #include "connection_impl_i.h"
+#include "read_options.h"
+#include "../pooled_handler.h"
+
+#include <server_lib/platform_config.h>
 
 #include <boost/asio.hpp>
 
+#include <deque>
+#include <mutex>
 #include <vector>
 #include <server_lib/asserts.h>
 
@@ -13,10 +19,102 @@ namespace server_lib {
 namespace network {
     namespace transport_layer {
 
-        std::function<void(boost::system::error_code, size_t)> async_handler(
-            std::function<bool()>&& scope_lock,
-            std::function<void(size_t)>&& success_case,
-            std::function<void()>&& failed_case);
+        void log_handler_error(const std::exception&);
+
+        /**
+         * Completion handler of asynchronous operation.
+         * It keeps functors as is (without std::function)
+         * thus pooled_handler holds whole handler state
+         */
+        template <typename ScopeLock, typename SuccessCase, typename FailedCase>
+        class async_handler_type
+        {
+        public:
+            async_handler_type(ScopeLock&& scope_lock, SuccessCase&& success_case, FailedCase&& failed_case)
+                : _scope_lock(std::move(scope_lock))
+                , _success_case(std::move(success_case))
+                , _failed_case(std::move(failed_case))
+            {
+            }
+
+            void operator()(const boost::system::error_code& ec, size_t transferred)
+            {
+                try
+                {
+                    if (!_scope_lock())
+                        return;
+                    if (!ec)
+                    {
+                        _success_case(transferred);
+                    }
+                    else
+                    {
+                        _failed_case();
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    log_handler_error(e);
+                    try
+                    {
+                        _failed_case();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        log_handler_error(e);
+                        throw;
+                    }
+                }
+            }
+
+        private:
+            ScopeLock _scope_lock;
+            SuccessCase _success_case;
+            FailedCase _failed_case;
+        };
+
+        template <typename ScopeLock, typename SuccessCase, typename FailedCase>
+        async_handler_type<typename std::decay<ScopeLock>::type,
+                           typename std::decay<SuccessCase>::type,
+                           typename std::decay<FailedCase>::type>
+        async_handler(ScopeLock&& scope_lock, SuccessCase&& success_case, FailedCase&& failed_case)
+        {
+            return { typename std::decay<ScopeLock>::type(std::forward<ScopeLock>(scope_lock)),
+                     typename std::decay<SuccessCase>::type(std::forward<SuccessCase>(success_case)),
+                     typename std::decay<FailedCase>::type(std::forward<FailedCase>(failed_case)) };
+        }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        /**
+         * Read socket into blocks (of size) by scatter calls without
+         * blocking. First block is put to buffer, next ones to chain.
+         * Blocks are allocated for bytes pending in socket only
+         *
+         * \return Bytes read, 0 for end of stream or error,
+         * -1 if socket would block
+         *
+         */
+        long scatter_read(int fd,
+                          size_t size,
+                          const read_options& options,
+                          pooled_buffer& buffer,
+                          std::vector<pooled_buffer>& chain);
+
+        // Limit of descriptors in one message
+        constexpr size_t max_descriptors = 64;
+
+        /**
+         * Send buffer with descriptors (SCM_RIGHTS) attached
+         * to the first byte without blocking
+         *
+         * \return Bytes written, 0 for error,
+         * -1 if socket would block
+         *
+         */
+        long send_descriptors(int fd,
+                              const pooled_buffer& buffer,
+                              const std::vector<int>& descriptors);
+#endif
 
         template <typename SocketType>
         class asio_connection_impl : public __connection_impl_i,
@@ -29,12 +127,12 @@ namespace network {
             template <typename... SocketConstructionArgs>
             asio_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
                                  uint64_t id,
-                                 size_t chunk_size,
+                                 const read_options& options,
                                  SocketConstructionArgs&&... args)
                 : _io_service(io_service)
                 , _socket(new socket_type(std::forward<SocketConstructionArgs>(args)...))
                 , _id(id)
-                , _chunk_size(chunk_size)
+                , _read_options(options)
             {
             }
 
@@ -82,7 +180,12 @@ namespace network {
 
             size_t chunk_size() const override
             {
-                return _chunk_size;
+                return _read_options.chunk_size;
+            }
+
+            size_t max_chunk_size() const override
+            {
+                return _read_options.max_chunk_size;
             }
 
             void set_disconnect_handler(const disconnect_callback_type& callback) override
@@ -101,54 +204,88 @@ namespace network {
             {
                 SRV_ASSERT(is_connected());
 
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+                // Idle connection should not keep block (it could be grown
+                // by adaptive size) thus it is allocated when socket is readable
+                if (_read_options.chain > 1 || _read_options.until_would_block > 0 || _read_options.max_chunk_size > _read_options.chunk_size)
+                {
+                    wait_read(request.size, std::move(request.async_read_callback));
+                    return;
+                }
+#endif
+
                 namespace asio = boost::asio;
 
-                std::lock_guard<std::mutex> lock(_read_buffer_mutex);
-                _read_buffer.resize(request.size);
+                // Buffer is owned by operation and moved to result without copying
+                auto buffer = std::allocate_shared<pooled_buffer>(pool_allocator<pooled_buffer>(), request.size);
 
                 auto self = this->shared_from_this();
-                _socket->async_read_some(asio::buffer(_read_buffer.data(), _read_buffer.size()),
-                                         async_handler(
+                _socket->async_read_some(asio::buffer(buffer->data(), buffer->size()),
+                                         make_pooled_handler(async_handler(
                                              [self]() {
                                                  auto loop_lock = self->handler_runner.continue_lock();
                                                  return loop_lock.operator bool();
                                              },
-                                             [self, callback = std::move(request.async_read_callback)](size_t transferred) {
-                                                 std::unique_lock<std::mutex> lock(self->_read_buffer_mutex);
-                                                 // TODO: optimize with direct memory operations if
-                                                 // request.size >> transferred
-                                                 read_result result_copy = { true, self->_read_buffer };
-                                                 lock.unlock();
-                                                 result_copy.buffer.resize(transferred);
+                                             [self, buffer, callback = std::move(request.async_read_callback)](size_t transferred) {
+                                                 read_result result;
+                                                 result.success = true;
+                                                 result.buffer = std::move(*buffer);
+                                                 result.buffer.resize(transferred);
                                                  if (callback)
-                                                     callback(result_copy);
+                                                     callback(result);
                                              },
                                              [self]() {
                                                  self->disconnect();
-                                             }));
+                                             })));
             }
 
             void async_write(write_request& request) override
+            {
+                queue_write(request, nullptr);
+            }
+
+            int native_handle() const override
+            {
+                if (!is_connected() || this->is_message_oriented())
+                    return -1;
+                return static_cast<int>(_socket->lowest_layer().native_handle());
+            }
+
+            void async_wait_read(wait_callback_type&& callback) override
+            {
+                async_wait(boost::asio::socket_base::wait_read, std::move(callback));
+            }
+
+            void async_wait_write(wait_callback_type&& callback) override
+            {
+                async_wait(boost::asio::socket_base::wait_write, std::move(callback));
+            }
+
+            void async_acquire_write(wait_callback_type&& callback) override
             {
                 SRV_ASSERT(is_connected());
 
-                namespace asio = boost::asio;
+                {
+                    // It is queued after pending writes
+                    std::lock_guard<std::mutex> lock(_write_mutex);
+                    if (_writing)
+                    {
+                        write_entry entry;
+                        entry.acquired_callback = std::move(callback);
+                        _write_queue.emplace_back(std::move(entry));
+                        return;
+                    }
+                    _writing = true;
+                }
 
-                auto self = this->shared_from_this();
-                _socket->async_write_some(asio::buffer(request.buffer.data(), request.buffer.size()),
-                                          async_handler(
-                                              [self]() {
-                                                  auto loop_lock = self->handler_runner.continue_lock();
-                                                  return loop_lock.operator bool();
-                                              },
-                                              [self, callback = std::move(request.async_write_callback)](size_t transferred) {
-                                                  write_result result = { true, transferred };
-                                                  if (callback)
-                                                      callback(result);
-                                              },
-                                              [self]() {
-                                                  self->disconnect();
-                                              }));
+                if (callback)
+                    callback(true);
+            }
+
+            void release_write() override
+            {
+                // Writing is continued by queued requests
+                write_next();
             }
 
             void set_timeout(long ms, std::function<void(void)> timeout_callback = nullptr)
@@ -160,16 +297,18 @@ namespace network {
                 {
                     SRV_ASSERT(_socket);
 
-                    _socket_timer = std::unique_ptr<asio::steady_timer>(new asio::steady_timer(*_io_service));
+                    if (!_socket_timer)
+                        _socket_timer = std::unique_ptr<asio::steady_timer>(new asio::steady_timer(*_io_service));
+                    // It cancels previous waiting
                     _socket_timer->expires_from_now(std::chrono::milliseconds(ms));
-                    _socket_timer->async_wait([self = this->shared_from_this(), timeout_callback](const error_code& ec) {
+                    _socket_timer->async_wait(make_pooled_handler([self = this->shared_from_this(), timeout_callback](const error_code& ec) {
                         if (!ec)
                         {
                             if (timeout_callback)
                                 timeout_callback();
                             self->close_socket(*self->_socket);
                         }
-                    });
+                    }));
                 }
             }
 
@@ -195,19 +334,274 @@ namespace network {
             virtual void configurate(const std::string& remote_endpoint) = 0;
             virtual void close_socket(socket_type&) = 0;
 
+        protected:
+            using descriptors_type = std::shared_ptr<std::vector<int>>;
+
+            // Descriptors are closed by holder after request has been sent
+            void queue_write(write_request& request, descriptors_type&& descriptors)
+            {
+                SRV_ASSERT(is_connected());
+
+                {
+                    // Composed write could be interleaved with next one
+                    // if it is partial. Writes are serialized
+                    std::lock_guard<std::mutex> lock(_write_mutex);
+                    _write_queue.emplace_back(write_entry { std::move(request), std::move(descriptors), nullptr });
+                    if (_writing)
+                        return;
+                    _writing = true;
+                }
+
+                write_next();
+            }
+
+        private:
+            struct write_entry
+            {
+                write_request request;
+                descriptors_type descriptors;
+                // Writing is taken by async_acquire_write
+                wait_callback_type acquired_callback;
+            };
+
+            using write_entries_type = std::shared_ptr<std::vector<write_entry>>;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            // Buffers are allocated when socket is readable
+            void wait_read(size_t size, async_read_callback_type&& callback)
+            {
+                auto self = this->shared_from_this();
+                _socket->lowest_layer().async_wait(boost::asio::socket_base::wait_read,
+                                                   make_pooled_handler([self, size, callback = std::move(callback)](const boost::system::error_code& ec) mutable {
+                                                       async_handler(
+                                                           [self]() {
+                                                               auto loop_lock = self->handler_runner.continue_lock();
+                                                               return loop_lock.operator bool();
+                                                           },
+                                                           [self, size, &callback](size_t) {
+                                                               self->read_chain(size, std::move(callback));
+                                                           },
+                                                           [self]() {
+                                                               self->disconnect();
+                                                           })(ec, 0);
+                                                   }));
+            }
+
+            void read_chain(size_t size, async_read_callback_type&& callback)
+            {
+                read_result result;
+                auto received = scatter_read(static_cast<int>(_socket->lowest_layer().native_handle()),
+                                             size, _read_options, result.buffer, result.chain);
+                if (received < 0)
+                {
+                    // Readiness could be spurious
+                    wait_read(size, std::move(callback));
+                    return;
+                }
+                if (received == 0)
+                {
+                    disconnect();
+                    return;
+                }
+
+                result.success = true;
+                if (callback)
+                    callback(result);
+            }
+#endif
+
+            void write_next()
+            {
+                namespace asio = boost::asio;
+
+                // Buffers should live until whole operation has completed
+                auto entries = std::make_shared<std::vector<write_entry>>();
+                wait_callback_type acquired_callback;
+                {
+                    std::lock_guard<std::mutex> lock(_write_mutex);
+                    if (_write_queue.empty() || !is_connected())
+                    {
+                        _write_queue.clear();
+                        _writing = false;
+                        return;
+                    }
+
+                    // Writing is kept until release_write
+                    if (_write_queue.front().acquired_callback)
+                    {
+                        acquired_callback = std::move(_write_queue.front().acquired_callback);
+                        _write_queue.pop_front();
+                    }
+
+                    // Queued buffers are sent together. Every buffer
+                    // of message oriented connection is packet.
+                    // Buffer with descriptors is sent alone
+                    auto max_buffers = this->is_message_oriented() ? 1 : max_write_buffers;
+                    while (!acquired_callback && !_write_queue.empty() && entries->size() < max_buffers)
+                    {
+                        if (_write_queue.front().acquired_callback)
+                            break;
+                        bool descriptors = _write_queue.front().descriptors.operator bool();
+                        if (descriptors && !entries->empty())
+                            break;
+                        entries->emplace_back(std::move(_write_queue.front()));
+                        _write_queue.pop_front();
+                        if (descriptors)
+                            break;
+                    }
+                }
+
+                if (acquired_callback)
+                {
+                    acquired_callback(true);
+                    return;
+                }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+                if (entries->front().descriptors)
+                {
+                    wait_write_descriptors(entries);
+                    return;
+                }
+#endif
+
+                std::vector<asio::const_buffer> buffers;
+                buffers.reserve(entries->size());
+                for (auto&& entry : *entries)
+                    buffers.emplace_back(entry.request.buffer.data(), entry.request.buffer.size());
+
+                auto self = this->shared_from_this();
+                asio::async_write(*_socket, buffers,
+                                  make_pooled_handler(async_handler(
+                                      [self]() {
+                                          auto loop_lock = self->handler_runner.continue_lock();
+                                          return loop_lock.operator bool();
+                                      },
+                                      [self, entries](size_t) {
+                                          self->complete_write(*entries);
+                                      },
+                                      [self]() {
+                                          self->fail_write();
+                                      })));
+            }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            void wait_write_descriptors(const write_entries_type& entries)
+            {
+                auto self = this->shared_from_this();
+                _socket->lowest_layer().async_wait(boost::asio::socket_base::wait_write,
+                                                   make_pooled_handler([self, entries](const boost::system::error_code& ec) {
+                                                       async_handler(
+                                                           [self]() {
+                                                               auto loop_lock = self->handler_runner.continue_lock();
+                                                               return loop_lock.operator bool();
+                                                           },
+                                                           [self, &entries](size_t) {
+                                                               self->write_descriptors(entries);
+                                                           },
+                                                           [self]() {
+                                                               self->fail_write();
+                                                           })(ec, 0);
+                                                   }));
+            }
+
+            void write_descriptors(const write_entries_type& entries)
+            {
+                namespace asio = boost::asio;
+
+                auto& entry = entries->front();
+                const auto& buffer = entry.request.buffer;
+                auto sent = send_descriptors(static_cast<int>(_socket->lowest_layer().native_handle()),
+                                             buffer, *entry.descriptors);
+                if (sent < 0)
+                {
+                    // Readiness could be spurious
+                    wait_write_descriptors(entries);
+                    return;
+                }
+                if (sent == 0)
+                {
+                    fail_write();
+                    return;
+                }
+
+                auto written = static_cast<size_t>(sent);
+                if (written == buffer.size())
+                {
+                    complete_write(*entries);
+                    return;
+                }
+
+                // Rest of stream is written without descriptors
+                // before next queued request
+                auto self = this->shared_from_this();
+                asio::async_write(*_socket, asio::buffer(buffer.data() + written, buffer.size() - written),
+                                  make_pooled_handler(async_handler(
+                                      [self]() {
+                                          auto loop_lock = self->handler_runner.continue_lock();
+                                          return loop_lock.operator bool();
+                                      },
+                                      [self, entries](size_t) {
+                                          self->complete_write(*entries);
+                                      },
+                                      [self]() {
+                                          self->fail_write();
+                                      })));
+            }
+#endif
+
+            void complete_write(std::vector<write_entry>& entries)
+            {
+                for (auto&& entry : entries)
+                {
+                    // Duplicated descriptors are in kernel now
+                    entry.descriptors.reset();
+
+                    write_result result = { true, entry.request.buffer.size() };
+                    if (entry.request.async_write_callback)
+                        entry.request.async_write_callback(result);
+                }
+                write_next();
+            }
+
+            void fail_write()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_write_mutex);
+                    _write_queue.clear();
+                }
+                disconnect();
+            }
+
+            void async_wait(boost::asio::socket_base::wait_type type, wait_callback_type&& callback)
+            {
+                SRV_ASSERT(is_connected());
+
+                auto self = this->shared_from_this();
+                _socket->lowest_layer().async_wait(type, make_pooled_handler([self, callback = std::move(callback)](const boost::system::error_code& ec) {
+                    if (!self->handler_runner.continue_lock())
+                        return;
+                    callback(!ec);
+                }));
+            }
+
         protected:
             std::shared_ptr<boost::asio::io_service> _io_service;
             std::unique_ptr<socket_type> _socket;
             uint64_t _id = 0;
             std::string _remote_endpoint;
-            size_t _chunk_size = 0;
+            read_options _read_options;
 
             std::unique_ptr<boost::asio::steady_timer> _socket_timer;
 
-            std::vector<char> _read_buffer;
-            std::mutex _read_buffer_mutex;
-
             std::vector<disconnect_callback_type> _disconnection_callbacks;
+
+        private:
+            static constexpr size_t max_write_buffers = 64;
+
+            std::mutex _write_mutex;
+            std::deque<write_entry> _write_queue;
+            bool _writing = false;
         };
 
     } // namespace transport_layer
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <server_lib/buffer_pool.h>
+
 #include <functional>
 #include <string>
 #include <vector>
@@ -25,6 +27,72 @@ namespace network {
 
             virtual size_t chunk_size() const = 0;
 
+            /**
+             * Read block could grow up to it
+             * if it is greater than chunk_size
+             *
+             */
+            virtual size_t max_chunk_size() const
+            {
+                return chunk_size();
+            }
+
+            /**
+             * Every read returns one message and every write
+             * sends one message (SOCK_SEQPACKET)
+             *
+             */
+            virtual bool is_message_oriented() const
+            {
+                return false;
+            }
+
+            /**
+             * Native stream socket for transfers by kernel (splice).
+             * It is -1 if transport doesn't expose it
+             *
+             */
+            virtual int native_handle() const
+            {
+                return -1;
+            }
+
+            using wait_callback_type = std::function<void(bool /*success*/)>;
+
+            /**
+             * Wait until native socket could be read (written)
+             * without transferring data. Callback is not called
+             * if connection is closed in the meantime
+             *
+             */
+            virtual void async_wait_read(wait_callback_type&& callback)
+            {
+                (void)callback;
+            }
+
+            virtual void async_wait_write(wait_callback_type&& callback)
+            {
+                (void)callback;
+            }
+
+            /**
+             * Take writing of native socket for transfers by kernel.
+             * Callback is called when queued writes have completed.
+             * Next writes are queued until release_write.
+             * Callback is not called if connection is closed
+             * in the meantime
+             *
+             */
+            virtual void async_acquire_write(wait_callback_type&& callback)
+            {
+                if (callback)
+                    callback(true);
+            }
+
+            virtual void release_write()
+            {
+            }
+
             using disconnect_callback_type = std::function<void(size_t /*id*/)>;
 
             virtual void set_disconnect_handler(const disconnect_callback_type&) = 0;
@@ -41,7 +109,21 @@ namespace network {
                  * Read bytes
                  *
                  */
-                std::vector<char> buffer;
+                pooled_buffer buffer;
+
+                /**
+                 * Bytes read after buffer by the same
+                 * scatter call (in order)
+                 *
+                 */
+                std::vector<pooled_buffer> chain;
+
+                /**
+                 * Received file descriptors (SCM_RIGHTS).
+                 * Receiver owns them
+                 *
+                 */
+                std::vector<int> descriptors;
             };
 
             /**
@@ -106,7 +188,7 @@ namespace network {
                  * Bytes to write
                  *
                  */
-                std::vector<char> buffer;
+                pooled_buffer buffer;
 
                 /**
                  * Callback to be called on operation completion
@@ -132,6 +214,25 @@ namespace network {
              *
              */
             virtual void async_write(write_request& request) = 0;
+
+            /**
+             * Async write operation with file descriptors (SCM_RIGHTS)
+             * attached to the first byte
+             *
+             * \param request - Information about what should be written
+             * and what should be done after completion
+             * \param descriptors - Descriptors are duplicated
+             * so caller keeps ownership
+             *
+             * \return 'false' if it is not supported by transport
+             *
+             */
+            virtual bool async_write_descriptors(write_request& request, const std::vector<int>& descriptors)
+            {
+                (void)request;
+                (void)descriptors;
+                return false;
+            }
         };
 
     } // namespace transport_layer
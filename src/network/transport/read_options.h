@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * Read settings of stream connection
+         */
+        struct read_options
+        {
+            /// Initial (minimal) block size
+            size_t chunk_size = 4096;
+            /// Block size could grow up to it
+            size_t max_chunk_size = 4096;
+            /// Blocks to read by one call
+            size_t chain = 1;
+            /// Bytes to read until socket would block. Zero means one read
+            size_t until_would_block = 0;
+        };
+
+        template <typename Config>
+        read_options make_read_options(const Config& config)
+        {
+            read_options options;
+            options.chunk_size = config.chunk_size();
+            options.max_chunk_size = config.max_chunk_size();
+            options.chain = config.read_chain();
+            options.until_would_block = config.read_until_would_block_limit();
+            return options;
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
@@ -0,0 +1,209 @@
+#include "shm_channel.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include <server_lib/asserts.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace {
+            void close_descriptors(std::vector<int>& descriptors)
+            {
+                for (auto fd : descriptors)
+                {
+                    if (fd >= 0)
+                        ::close(fd);
+                }
+                descriptors.clear();
+            }
+        } // namespace
+
+        shm_ring::shm_ring(shm_ring_header* header, char* data, size_t size, int data_event, int space_event)
+            : _header(header)
+            , _data(data)
+            , _size(size)
+            , _data_event(data_event)
+            , _space_event(space_event)
+        {
+        }
+
+        size_t shm_ring::read(char* dest, size_t size)
+        {
+            auto head = _header->head.load(std::memory_order_acquire);
+            auto tail = _header->tail.load(std::memory_order_relaxed);
+            auto count = std::min<size_t>(static_cast<size_t>(head - tail), size);
+            if (!count)
+                return 0;
+
+            auto offset = static_cast<size_t>(tail & (_size - 1));
+            auto first = std::min(count, _size - offset);
+            std::memcpy(dest, _data + offset, first);
+            std::memcpy(dest + first, _data, count - first);
+
+            // Store should be visible before check of waiting flag
+            _header->tail.store(tail + count, std::memory_order_seq_cst);
+            if (_header->producer_waiting.load(std::memory_order_seq_cst) && _header->producer_waiting.exchange(0))
+                notify(_space_event);
+            return count;
+        }
+
+        bool shm_ring::empty() const
+        {
+            return _header->head.load(std::memory_order_seq_cst) == _header->tail.load(std::memory_order_relaxed);
+        }
+
+        bool shm_ring::prepare_consumer_wait()
+        {
+            _header->consumer_waiting.store(1, std::memory_order_seq_cst);
+            if (!empty())
+            {
+                cancel_consumer_wait();
+                return false;
+            }
+            return true;
+        }
+
+        void shm_ring::cancel_consumer_wait()
+        {
+            _header->consumer_waiting.store(0, std::memory_order_relaxed);
+        }
+
+        size_t shm_ring::write(const char* src, size_t size)
+        {
+            auto tail = _header->tail.load(std::memory_order_acquire);
+            auto head = _header->head.load(std::memory_order_relaxed);
+            auto count = std::min<size_t>(_size - static_cast<size_t>(head - tail), size);
+            if (!count)
+                return 0;
+
+            auto offset = static_cast<size_t>(head & (_size - 1));
+            auto first = std::min(count, _size - offset);
+            std::memcpy(_data + offset, src, first);
+            std::memcpy(_data, src + first, count - first);
+
+            _header->head.store(head + count, std::memory_order_seq_cst);
+            if (_header->consumer_waiting.load(std::memory_order_seq_cst) && _header->consumer_waiting.exchange(0))
+                notify(_data_event);
+            return count;
+        }
+
+        bool shm_ring::full() const
+        {
+            return _header->head.load(std::memory_order_relaxed) - _header->tail.load(std::memory_order_seq_cst) == _size;
+        }
+
+        bool shm_ring::prepare_producer_wait()
+        {
+            _header->producer_waiting.store(1, std::memory_order_seq_cst);
+            if (!full())
+            {
+                _header->producer_waiting.store(0, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        void shm_ring::notify(int event)
+        {
+            uint64_t value = 1;
+            // Counter overflow (EAGAIN) means wakeup is pending already
+            while (::write(event, &value, sizeof(value)) < 0 && errno == EINTR)
+                ;
+        }
+
+        shm_channel::shm_channel(size_t ring_size, std::vector<int>&& descriptors)
+            : _ring_size(ring_size)
+            , _descriptors(std::move(descriptors))
+        {
+        }
+
+        shm_channel::~shm_channel()
+        {
+            _upstream.reset();
+            _downstream.reset();
+            if (_memory)
+                ::munmap(_memory, _memory_size);
+            close_descriptors(_descriptors);
+        }
+
+        std::shared_ptr<shm_channel> shm_channel::create(size_t ring_size)
+        {
+            SRV_ASSERT(ring_size > 0 && (ring_size & (ring_size - 1)) == 0);
+
+            std::vector<int> descriptors;
+            descriptors.push_back(::memfd_create("server_lib_shm", MFD_CLOEXEC));
+            for (size_t ci = 1; ci < descriptors_count; ++ci)
+                descriptors.push_back(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+
+            std::shared_ptr<shm_channel> channel { new shm_channel(ring_size, std::move(descriptors)) };
+            for (auto fd : channel->_descriptors)
+                SRV_ASSERT(fd >= 0, std::strerror(errno));
+
+            SRV_ASSERT(::ftruncate(channel->_descriptors[0], static_cast<off_t>(mapping_size(ring_size))) == 0, std::strerror(errno));
+
+            channel->map(true);
+            return channel;
+        }
+
+        std::shared_ptr<shm_channel> shm_channel::open(size_t ring_size, const std::vector<int>& descriptors)
+        {
+            std::shared_ptr<shm_channel> channel { new shm_channel(ring_size, std::vector<int> { descriptors }) };
+
+            SRV_ASSERT(descriptors.size() == descriptors_count, "Invalid descriptors of shared memory");
+            SRV_ASSERT(ring_size >= 4096 && (ring_size & (ring_size - 1)) == 0, "Invalid ring size of shared memory");
+
+            struct stat info;
+            SRV_ASSERT(::fstat(descriptors[0], &info) == 0, std::strerror(errno));
+            SRV_ASSERT(static_cast<size_t>(info.st_size) >= mapping_size(ring_size), "Shared memory is too small");
+
+            channel->map(false);
+            return channel;
+        }
+
+        size_t shm_channel::mapping_size(size_t ring_size)
+        {
+            return 2 * sizeof(shm_ring_header) + 2 * ring_size;
+        }
+
+        void shm_channel::map(bool initialize)
+        {
+            _memory_size = mapping_size(_ring_size);
+            auto* memory = ::mmap(nullptr, _memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, _descriptors[0], 0);
+            SRV_ASSERT(memory != MAP_FAILED, std::strerror(errno));
+            _memory = memory;
+
+            auto* base = static_cast<char*>(_memory);
+            auto* upstream_header = reinterpret_cast<shm_ring_header*>(base);
+            auto* downstream_header = reinterpret_cast<shm_ring_header*>(base + sizeof(shm_ring_header));
+            if (initialize)
+            {
+                // memfd is zero filled. Objects are constructed by creator only
+                new (upstream_header) shm_ring_header();
+                new (downstream_header) shm_ring_header();
+            }
+
+            auto* upstream_data = base + 2 * sizeof(shm_ring_header);
+            auto* downstream_data = upstream_data + _ring_size;
+            _upstream = std::make_unique<shm_ring>(upstream_header, upstream_data, _ring_size, _descriptors[1], _descriptors[2]);
+            _downstream = std::make_unique<shm_ring>(downstream_header, downstream_data, _ring_size, _descriptors[3], _descriptors[4]);
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * Single producer single consumer byte ring in shared memory.
+         * Positions grow monotonically, index is position & (size - 1)
+         */
+        struct shm_ring_header
+        {
+            // Written by producer
+            alignas(64) std::atomic<uint64_t> head;
+            // Written by consumer
+            alignas(64) std::atomic<uint64_t> tail;
+            // Consumer is going to sleep on data eventfd
+            alignas(64) std::atomic<uint32_t> consumer_waiting;
+            // Producer is going to sleep on space eventfd
+            alignas(64) std::atomic<uint32_t> producer_waiting;
+        };
+
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Shared memory atomics should be lock free");
+
+        class shm_ring
+        {
+        public:
+            shm_ring(shm_ring_header* header, char* data, size_t size, int data_event, int space_event);
+
+            // Consumer side
+            size_t read(char* dest, size_t size);
+            bool empty() const;
+            // Return 'false' if data has arrived in the meantime
+            bool prepare_consumer_wait();
+            void cancel_consumer_wait();
+
+            // Producer side
+            size_t write(const char* src, size_t size);
+            bool full() const;
+            bool prepare_producer_wait();
+
+            int data_event() const
+            {
+                return _data_event;
+            }
+
+            int space_event() const
+            {
+                return _space_event;
+            }
+
+        private:
+            static void notify(int event);
+
+            shm_ring_header* const _header;
+            char* const _data;
+            const size_t _size;
+            // Descriptors are owned by channel
+            const int _data_event;
+            const int _space_event;
+        };
+
+        /**
+         * Memory (memfd) and eventfd descriptors of two rings.
+         * Client creates channel and passes descriptors
+         * to server by UNIX socket
+         */
+        class shm_channel
+        {
+        public:
+            static constexpr size_t descriptors_count = 5;
+
+            // Client side
+            static std::shared_ptr<shm_channel> create(size_t ring_size);
+            // Server side. Descriptors are owned by channel even on error
+            static std::shared_ptr<shm_channel> open(size_t ring_size, const std::vector<int>& descriptors);
+
+            ~shm_channel();
+
+            size_t ring_size() const
+            {
+                return _ring_size;
+            }
+
+            const std::vector<int>& descriptors() const
+            {
+                return _descriptors;
+            }
+
+            // Client to server ring
+            shm_ring& upstream()
+            {
+                return *_upstream;
+            }
+
+            // Server to client ring
+            shm_ring& downstream()
+            {
+                return *_downstream;
+            }
+
+        private:
+            shm_channel(size_t ring_size, std::vector<int>&& descriptors);
+
+            void map(bool initialize);
+
+            static size_t mapping_size(size_t ring_size);
+
+            const size_t _ring_size;
+            // memfd, upstream data, upstream space, downstream data, downstream space
+            std::vector<int> _descriptors;
+            void* _memory = nullptr;
+            size_t _memory_size = 0;
+            std::unique_ptr<shm_ring> _upstream;
+            std::unique_ptr<shm_ring> _downstream;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,399 @@
+#include "shm_connection_impl.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "unix_local_connection_impl.h"
+#include "../pooled_handler.h"
+
+#include <server_lib/asserts.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        namespace {
+            constexpr char handshake_magic[4] = { 'S', 'H', 'M', '1' };
+
+            // Client sends it with channel descriptors
+            struct handshake
+            {
+                char magic[4];
+                uint32_t reserved = 0;
+                uint64_t ring_size = 0;
+            };
+        } // namespace
+
+        std::shared_ptr<shm_connection_impl> shm_connection_impl::connect(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                                                          const std::shared_ptr<unix_local_connection_impl>& socket,
+                                                                          size_t ring_size,
+                                                                          std::chrono::microseconds spin)
+        {
+            SRV_ASSERT(socket);
+
+            auto channel = shm_channel::create(ring_size);
+
+            handshake hello;
+            std::memcpy(hello.magic, handshake_magic, sizeof(hello.magic));
+            hello.ring_size = ring_size;
+
+            const auto* data = reinterpret_cast<const char*>(&hello);
+            write_request request = { pooled_buffer { data, data + sizeof(hello) }, nullptr };
+            SRV_ASSERT(socket->async_write_descriptors(request, channel->descriptors()));
+
+            // Server reads ring when handshake is received
+            auto connection = std::make_shared<shm_connection_impl>(io_service, socket, channel, false, spin);
+            connection->watch_socket();
+            return connection;
+        }
+
+        void shm_connection_impl::accept(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                         const std::shared_ptr<unix_local_connection_impl>& socket,
+                                         std::chrono::microseconds spin,
+                                         const connect_callback_type& callback,
+                                         const fail_callback_type& fail_callback)
+        {
+            SRV_ASSERT(socket);
+
+            read_request request = {
+                sizeof(handshake),
+                [io_service, socket, spin, callback, fail_callback](read_result& result) {
+                    try
+                    {
+                        handshake hello;
+                        if (result.buffer.size() == sizeof(hello))
+                            std::memcpy(&hello, result.buffer.data(), sizeof(hello));
+
+                        // Channel owns descriptors from this point
+                        auto channel = shm_channel::open(static_cast<size_t>(hello.ring_size), result.descriptors);
+                        result.descriptors.clear();
+
+                        SRV_ASSERT(std::memcmp(hello.magic, handshake_magic, sizeof(hello.magic)) == 0, "Invalid handshake of shared memory");
+
+                        auto connection = std::make_shared<shm_connection_impl>(io_service, socket, channel, true, spin);
+                        connection->watch_socket();
+
+                        SRV_LOGC_TRACE("shared memory connected");
+
+                        if (callback)
+                            callback(connection);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        SRV_LOGC_ERROR(e.what());
+                        socket->disconnect();
+                        if (fail_callback)
+                            fail_callback(e.what());
+                    }
+                }
+            };
+            socket->async_read(request);
+        }
+
+        shm_connection_impl::shm_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                                 const std::shared_ptr<unix_local_connection_impl>& socket,
+                                                 const std::shared_ptr<shm_channel>& channel,
+                                                 bool server_side,
+                                                 std::chrono::microseconds spin)
+            : _io_service(io_service)
+            , _socket(socket)
+            , _channel(channel)
+            , _input(server_side ? channel->upstream() : channel->downstream())
+            , _output(server_side ? channel->downstream() : channel->upstream())
+            , _data_event(*io_service)
+            , _space_event(*io_service)
+            , _max_spin(spin)
+            , _spin(spin)
+        {
+            SRV_ASSERT(_socket);
+
+            // Descriptors of channel are shared with peer. Asio owns copies
+            int data_event = ::fcntl(_input.data_event(), F_DUPFD_CLOEXEC, 0);
+            SRV_ASSERT(data_event >= 0, std::strerror(errno));
+            _data_event.assign(data_event);
+            int space_event = ::fcntl(_output.space_event(), F_DUPFD_CLOEXEC, 0);
+            SRV_ASSERT(space_event >= 0, std::strerror(errno));
+            _space_event.assign(space_event);
+        }
+
+        uint64_t shm_connection_impl::id() const
+        {
+            return _socket->id();
+        }
+
+        void shm_connection_impl::disconnect()
+        {
+            if (!_connected.exchange(false))
+                return;
+
+            handler_runner.stop();
+
+            error_code ec;
+            _data_event.cancel(ec);
+            _space_event.cancel(ec);
+
+            auto self = shared_from_this();
+
+            std::unique_lock<std::mutex> lock(_disconnect_mutex);
+            auto disconnection_callbacks = _disconnection_callbacks;
+            lock.unlock();
+            for (auto it = disconnection_callbacks.rbegin(); it != disconnection_callbacks.rend(); ++it)
+            {
+                lock.lock();
+                bool cleared = _disconnection_callbacks.empty();
+                lock.unlock();
+                if (cleared)
+                    break;
+                auto callback = *it;
+                callback(id());
+            }
+
+            _socket->set_disconnect_handler(nullptr);
+            _socket->disconnect();
+
+            std::lock_guard<std::mutex> write_lock(_write_mutex);
+            _write_queue.clear();
+        }
+
+        bool shm_connection_impl::is_connected() const
+        {
+            return _connected;
+        }
+
+        std::string shm_connection_impl::remote_endpoint() const
+        {
+            return _socket->remote_endpoint();
+        }
+
+        size_t shm_connection_impl::chunk_size() const
+        {
+            return _socket->chunk_size();
+        }
+
+        void shm_connection_impl::set_disconnect_handler(const disconnect_callback_type& callback)
+        {
+            std::lock_guard<std::mutex> lock(_disconnect_mutex);
+            if (callback)
+            {
+                _disconnection_callbacks.push_back(callback);
+            }
+            else
+            {
+                _disconnection_callbacks.clear();
+            }
+        }
+
+        void shm_connection_impl::watch_socket()
+        {
+            std::weak_ptr<shm_connection_impl> weak_self = shared_from_this();
+
+            _socket->set_disconnect_handler([weak_self](size_t) {
+                if (auto self = weak_self.lock())
+                    self->disconnect();
+            });
+
+            // Nothing is expected from socket except end of stream
+            read_request request = { 1, [weak_self](read_result&) {
+                                        if (auto self = weak_self.lock())
+                                        {
+                                            SRV_LOGC_ERROR("Unexpected data in socket of shared memory connection");
+                                            self->disconnect();
+                                        }
+                                    } };
+            _socket->async_read(request);
+        }
+
+        void shm_connection_impl::async_read(read_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            // Callback should not be called inside async_read
+            post_read_step(request.size, std::move(request.async_read_callback), {});
+        }
+
+        void shm_connection_impl::post_read_step(size_t size, async_read_callback_type&& callback, clock_type::time_point deadline)
+        {
+            auto self = shared_from_this();
+            _io_service->post(make_pooled_handler([self, size, deadline, callback = std::move(callback)]() mutable {
+                try
+                {
+                    if (!self->handler_runner.continue_lock())
+                        return;
+                    self->read_step(size, std::move(callback), deadline);
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                    self->disconnect();
+                }
+            }));
+        }
+
+        void shm_connection_impl::read_step(size_t size, async_read_callback_type&& callback, clock_type::time_point deadline)
+        {
+            if (!is_connected())
+                return;
+
+            bool spinning = deadline != clock_type::time_point {};
+            if (!_input.empty())
+            {
+                // Spin was useful
+                if (spinning)
+                    _spin = std::min(_max_spin, _spin * 2);
+
+                read_result result;
+                result.buffer.resize(size);
+                result.buffer.resize(_input.read(result.buffer.data(), size));
+                result.success = true;
+                if (callback)
+                    callback(result);
+                return;
+            }
+
+            auto now = clock_type::now();
+            if (!spinning)
+            {
+                if (_spin.count() <= 0)
+                {
+                    wait_data(size, std::move(callback));
+                    return;
+                }
+                deadline = now + _spin;
+            }
+            else if (now >= deadline)
+            {
+                _spin /= 2;
+                wait_data(size, std::move(callback));
+                return;
+            }
+
+            // Ring is polled again after pending handlers of loop
+            // (loop could be shared with other connections)
+            post_read_step(size, std::move(callback), deadline);
+        }
+
+        void shm_connection_impl::wait_data(size_t size, async_read_callback_type&& callback)
+        {
+            if (!_input.prepare_consumer_wait())
+            {
+                read_step(size, std::move(callback), {});
+                return;
+            }
+
+            auto self = shared_from_this();
+            _data_event.async_read_some(asio::buffer(&_data_event_value, sizeof(_data_event_value)),
+                                        make_pooled_handler([self, size, callback = std::move(callback)](const error_code& ec, size_t) mutable {
+                                            try
+                                            {
+                                                if (!self->handler_runner.continue_lock())
+                                                    return;
+                                                if (ec)
+                                                {
+                                                    self->disconnect();
+                                                    return;
+                                                }
+                                                self->_input.cancel_consumer_wait();
+                                                // Traffic is resumed. Let spin grow again
+                                                self->_spin = std::min(self->_max_spin, self->_spin + self->_max_spin / 8);
+                                                self->read_step(size, std::move(callback), {});
+                                            }
+                                            catch (const std::exception& e)
+                                            {
+                                                SRV_LOGC_ERROR(e.what());
+                                                self->disconnect();
+                                            }
+                                        }));
+        }
+
+        void shm_connection_impl::async_write(write_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            auto buffer = std::allocate_shared<pooled_buffer>(pool_allocator<pooled_buffer>(), std::move(request.buffer));
+            {
+                std::lock_guard<std::mutex> lock(_write_mutex);
+                _write_queue.push_back({ buffer, 0, std::move(request.async_write_callback) });
+            }
+            flush();
+        }
+
+        void shm_connection_impl::flush()
+        {
+            std::vector<pending_write> completed;
+            {
+                std::lock_guard<std::mutex> lock(_write_mutex);
+                // Waiting handler will continue
+                if (_space_waiting)
+                    return;
+
+                while (!_write_queue.empty())
+                {
+                    auto& item = _write_queue.front();
+                    item.offset += _output.write(item.buffer->data() + item.offset, item.buffer->size() - item.offset);
+                    if (item.offset == item.buffer->size())
+                    {
+                        completed.emplace_back(std::move(item));
+                        _write_queue.pop_front();
+                        continue;
+                    }
+
+                    // Ring is full
+                    if (_output.prepare_producer_wait())
+                    {
+                        _space_waiting = true;
+                        wait_space();
+                        break;
+                    }
+                }
+            }
+
+            for (auto&& item : completed)
+            {
+                write_result result = { true, item.buffer->size() };
+                if (item.callback)
+                    item.callback(result);
+            }
+        }
+
+        void shm_connection_impl::wait_space()
+        {
+            auto self = shared_from_this();
+            _space_event.async_read_some(asio::buffer(&_space_event_value, sizeof(_space_event_value)),
+                                         make_pooled_handler([self](const error_code& ec, size_t) {
+                                             try
+                                             {
+                                                 if (!self->handler_runner.continue_lock())
+                                                     return;
+                                                 if (ec)
+                                                 {
+                                                     self->disconnect();
+                                                     return;
+                                                 }
+                                                 {
+                                                     std::lock_guard<std::mutex> lock(self->_write_mutex);
+                                                     self->_space_waiting = false;
+                                                 }
+                                                 self->flush();
+                                             }
+                                             catch (const std::exception& e)
+                                             {
+                                                 SRV_LOGC_ERROR(e.what());
+                                                 self->disconnect();
+                                             }
+                                         }));
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "connection_impl_i.h"
+#include "shm_channel.h"
+
+#include <server_lib/network/scope_runner.h>
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        class unix_local_connection_impl;
+
+        /**
+         * Connection over pair of shared memory rings. Consumer polls
+         * ring for a while (spin) between other handlers of loop
+         * and then sleeps on eventfd. Producer
+         * signals eventfd only if consumer is sleeping.
+         * UNIX socket of handshake is kept to detect disconnection
+         */
+        class shm_connection_impl : public __connection_impl_i,
+                                    public std::enable_shared_from_this<shm_connection_impl>
+        {
+        public:
+            using connect_callback_type = std::function<void(const std::shared_ptr<__connection_impl_i>&)>;
+            using fail_callback_type = std::function<void(const std::string&)>;
+
+            /**
+             * Client side of handshake. It creates channel and sends it
+             * by connected socket
+             */
+            static std::shared_ptr<shm_connection_impl> connect(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                                                const std::shared_ptr<unix_local_connection_impl>& socket,
+                                                                size_t ring_size,
+                                                                std::chrono::microseconds spin);
+
+            /**
+             * Server side of handshake. It waits channel from
+             * accepted socket
+             */
+            static void accept(const std::shared_ptr<boost::asio::io_service>& io_service,
+                               const std::shared_ptr<unix_local_connection_impl>& socket,
+                               std::chrono::microseconds spin,
+                               const connect_callback_type& callback,
+                               const fail_callback_type& fail_callback);
+
+            shm_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                const std::shared_ptr<unix_local_connection_impl>& socket,
+                                const std::shared_ptr<shm_channel>& channel,
+                                bool server_side,
+                                std::chrono::microseconds spin);
+
+            uint64_t id() const override;
+
+            void disconnect() override;
+
+            bool is_connected() const override;
+
+            std::string remote_endpoint() const override;
+
+            size_t chunk_size() const override;
+
+            void set_disconnect_handler(const disconnect_callback_type& callback) override;
+
+            void async_read(read_request& request) override;
+
+            void async_write(write_request& request) override;
+
+            scope_runner handler_runner;
+
+        private:
+            using buffer_type = std::shared_ptr<pooled_buffer>;
+            using clock_type = std::chrono::steady_clock;
+
+            struct pending_write
+            {
+                buffer_type buffer;
+                size_t offset = 0;
+                async_write_callback_type callback;
+            };
+
+            void watch_socket();
+
+            // Deadline of spin is empty before polling
+            void read_step(size_t size, async_read_callback_type&& callback, clock_type::time_point deadline);
+            void post_read_step(size_t size, async_read_callback_type&& callback, clock_type::time_point deadline);
+            void wait_data(size_t size, async_read_callback_type&& callback);
+
+            // Write as much as ring could take
+            void flush();
+            void wait_space();
+
+            std::shared_ptr<boost::asio::io_service> _io_service;
+            std::shared_ptr<unix_local_connection_impl> _socket;
+            std::shared_ptr<shm_channel> _channel;
+            shm_ring& _input;
+            shm_ring& _output;
+
+            boost::asio::posix::stream_descriptor _data_event;
+            boost::asio::posix::stream_descriptor _space_event;
+            uint64_t _data_event_value = 0;
+            uint64_t _space_event_value = 0;
+
+            const std::chrono::microseconds _max_spin;
+            // Adapted by spin results
+            std::chrono::microseconds _spin;
+
+            std::atomic_bool _connected { true };
+
+            std::mutex _write_mutex;
+            std::deque<pending_write> _write_queue;
+            bool _space_waiting = false;
+
+            std::mutex _disconnect_mutex;
+            std::vector<disconnect_callback_type> _disconnection_callbacks;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
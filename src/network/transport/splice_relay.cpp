@@ -0,0 +1,257 @@
+#include "splice_relay.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include <server_lib/asserts.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace {
+            // Pipe is enlarged to move more by one call
+            constexpr int preferred_pipe_size = 256 * 1024;
+
+            // Transfers before waiting to let other handlers run
+            constexpr size_t max_transfers = 16;
+
+            /**
+             * splice to socket raises SIGPIPE for closed peer (there is no MSG_NOSIGNAL).
+             * SIGPIPE is blocked only for the call. Signal raised by the call
+             * is consumed before mask is restored. Pending one is left as is
+             */
+            class sigpipe_guard
+            {
+            public:
+                sigpipe_guard()
+                {
+                    sigemptyset(&_sigpipe);
+                    sigaddset(&_sigpipe, SIGPIPE);
+
+                    sigset_t pending;
+                    sigemptyset(&pending);
+                    sigpending(&pending);
+                    _pending = sigismember(&pending, SIGPIPE) == 1;
+
+                    pthread_sigmask(SIG_BLOCK, &_sigpipe, &_old_mask);
+                }
+
+                ~sigpipe_guard()
+                {
+                    // Keep error of the call
+                    auto call_errno = errno;
+                    if (_raised && !_pending)
+                    {
+                        timespec zero = {};
+                        while (sigtimedwait(&_sigpipe, nullptr, &zero) < 0 && errno == EINTR)
+                        {
+                        }
+                    }
+                    pthread_sigmask(SIG_SETMASK, &_old_mask, nullptr);
+                    errno = call_errno;
+                }
+
+                void raised()
+                {
+                    _raised = true;
+                }
+
+            private:
+                sigset_t _sigpipe;
+                sigset_t _old_mask;
+                bool _pending = false;
+                bool _raised = false;
+            };
+
+            ssize_t splice_to_socket(int pipe_fd, int socket_fd, size_t size)
+            {
+                sigpipe_guard guard;
+                auto sz = ::splice(pipe_fd, nullptr, socket_fd, nullptr, size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (sz < 0 && errno == EPIPE)
+                    guard.raised();
+                return sz;
+            }
+        } // namespace
+
+        bool splice_relay::supported(const __connection_impl_i& source, const __connection_impl_i& destination)
+        {
+            return source.native_handle() >= 0 && destination.native_handle() >= 0;
+        }
+
+        splice_relay::splice_relay(const std::shared_ptr<__connection_impl_i>& source,
+                                   const std::shared_ptr<__connection_impl_i>& destination,
+                                   transfer_callback_type&& read_callback,
+                                   transfer_callback_type&& written_callback,
+                                   finish_callback_type&& finish_callback)
+            : _source(source)
+            , _destination(destination)
+            , _source_fd(source->native_handle())
+            , _destination_fd(destination->native_handle())
+            , _read_callback(std::move(read_callback))
+            , _written_callback(std::move(written_callback))
+            , _finish_callback(std::move(finish_callback))
+        {
+            SRV_ASSERT(_source_fd >= 0 && _destination_fd >= 0);
+
+            SRV_ASSERT(::pipe2(_pipe, O_NONBLOCK | O_CLOEXEC) == 0, std::string { "pipe2: " } + std::strerror(errno));
+
+            ::fcntl(_pipe[1], F_SETPIPE_SZ, preferred_pipe_size);
+            auto pipe_size = ::fcntl(_pipe[1], F_GETPIPE_SZ);
+            _pipe_size = pipe_size > 0 ? static_cast<size_t>(pipe_size) : 64 * 1024;
+
+            // Socket operations should not block worker
+            for (auto fd : { _source_fd, _destination_fd })
+            {
+                auto flags = ::fcntl(fd, F_GETFL);
+                if (flags >= 0 && !(flags & O_NONBLOCK))
+                    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+            }
+        }
+
+        splice_relay::~splice_relay()
+        {
+            // Relay could be dropped without finish if source is closed
+            release_write();
+
+            ::close(_pipe[0]);
+            ::close(_pipe[1]);
+        }
+
+        void splice_relay::start()
+        {
+            // Queued writes of destination go first.
+            // Next ones wait for relay
+            auto self = shared_from_this();
+            _destination->async_acquire_write([self](bool success) {
+                if (!success)
+                {
+                    self->finish();
+                    return;
+                }
+                self->_write_acquired = true;
+                self->transfer();
+            });
+        }
+
+        void splice_relay::wait_read()
+        {
+            auto self = shared_from_this();
+            _source->async_wait_read([self](bool success) {
+                if (success)
+                    self->transfer();
+                else
+                    self->finish();
+            });
+        }
+
+        void splice_relay::wait_write()
+        {
+            auto self = shared_from_this();
+            _destination->async_wait_write([self](bool success) {
+                if (success)
+                    self->transfer();
+                else
+                    self->finish();
+            });
+        }
+
+        void splice_relay::transfer()
+        {
+            if (!_source->is_connected() || !_destination->is_connected())
+                return;
+
+            for (size_t ci = 0; ci < max_transfers; ++ci)
+            {
+                if (!_in_pipe)
+                {
+                    auto sz = ::splice(_source_fd, nullptr, _pipe[1], nullptr, _pipe_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                    if (sz == 0)
+                    {
+                        SRV_LOGC_TRACE("source is closed");
+                        // Pipe is drained. Peer of destination receives EOF
+                        ::shutdown(_destination_fd, SHUT_WR);
+                        finish();
+                        return;
+                    }
+                    if (sz < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        if (errno == EAGAIN)
+                        {
+                            wait_read();
+                            return;
+                        }
+                        SRV_LOGC_TRACE("splice from source: " << std::strerror(errno));
+                        finish();
+                        return;
+                    }
+
+                    _in_pipe = static_cast<size_t>(sz);
+                    if (_read_callback)
+                        _read_callback(_in_pipe);
+                }
+
+                auto sz = splice_to_socket(_pipe[0], _destination_fd, _in_pipe);
+                if (sz < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    // Destination is not read. Source is not read too
+                    if (errno == EAGAIN)
+                    {
+                        wait_write();
+                        return;
+                    }
+                    SRV_LOGC_TRACE("splice to destination: " << std::strerror(errno));
+                    finish();
+                    return;
+                }
+
+                _in_pipe -= static_cast<size_t>(sz);
+                if (_written_callback)
+                    _written_callback(static_cast<size_t>(sz));
+            }
+
+            // Readiness is checked again by reactor
+            if (_in_pipe)
+                wait_write();
+            else
+                wait_read();
+        }
+
+        void splice_relay::release_write()
+        {
+            if (_write_acquired)
+            {
+                _write_acquired = false;
+                _destination->release_write();
+            }
+        }
+
+        void splice_relay::finish()
+        {
+            release_write();
+
+            auto callback = std::move(_finish_callback);
+            _finish_callback = nullptr;
+            if (callback)
+                callback();
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "connection_impl_i.h"
+
+#include <functional>
+#include <memory>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * Move bytes from one socket to another by splice(2)
+         * through pipe without copying to user space.
+         * Source is not read while pipe is not drained
+         * to destination. Writing of destination is taken
+         * by relay: queued writes are completed before relay
+         * and next ones are delayed until relay is finished.
+         * Destination is half-closed (SHUT_WR) when source is closed
+         * so its peer receives EOF
+         */
+        class splice_relay : public std::enable_shared_from_this<splice_relay>
+        {
+        public:
+            using transfer_callback_type = std::function<void(size_t /*bytes*/)>;
+            using finish_callback_type = std::function<void()>;
+
+            static bool supported(const __connection_impl_i& source, const __connection_impl_i& destination);
+
+            /**
+             * \param read_callback - Bytes are read from source
+             * \param written_callback - Bytes are written to destination
+             * \param finish_callback - Source is closed or any
+             * side is failed
+             */
+            splice_relay(const std::shared_ptr<__connection_impl_i>& source,
+                         const std::shared_ptr<__connection_impl_i>& destination,
+                         transfer_callback_type&& read_callback,
+                         transfer_callback_type&& written_callback,
+                         finish_callback_type&& finish_callback);
+            ~splice_relay();
+
+            void start();
+
+        private:
+            void wait_read();
+            void wait_write();
+            void transfer();
+            void release_write();
+            void finish();
+
+            std::shared_ptr<__connection_impl_i> _source;
+            std::shared_ptr<__connection_impl_i> _destination;
+            const int _source_fd;
+            const int _destination_fd;
+
+            transfer_callback_type _read_callback;
+            transfer_callback_type _written_callback;
+            finish_callback_type _finish_callback;
+
+            int _pipe[2] = { -1, -1 };
+            size_t _pipe_size = 0;
+            // Bytes are read from source and not written yet
+            size_t _in_pipe = 0;
+            bool _write_acquired = false;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -10,8 +10,8 @@ namespace network {
 
         tcp_client_connection_impl::tcp_client_connection_impl(
             const std::shared_ptr<boost::asio::io_service>& io_service,
-            size_t chunk_size)
-            : base_class(io_service, 0, chunk_size, *io_service)
+            const read_options& options)
+            : base_class(io_service, 0, options, *io_service)
         {
         }
 
@@ -10,7 +10,7 @@ namespace network {
         {
         public:
             tcp_client_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
-                                       size_t chunk_size);
+                                       const read_options& options);
 
             void configurate(const std::string& remote_endpoint) override;
             void close_socket(socket_type&) override;
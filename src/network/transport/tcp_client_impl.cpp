@@ -1,8 +1,13 @@
 #include "tcp_client_impl.h"
 #include "tcp_client_connection_impl.h"
+#include "uring_connection_impl.h"
+#include "../socket_options.h"
+#include "../worker_options.h"
 
 #include <server_lib/asserts.h>
 
+#include <cstring>
+
 #include "../../logger_set_internal_group.h"
 
 namespace server_lib {
@@ -41,6 +46,7 @@ namespace network {
                 SRV_ASSERT(_config && _config->valid());
 
                 _worker.change_loop_name(_config->worker_name());
+                apply_worker_options(_worker, *_config);
                 auto connect_ = [this, connect_callback, fail_callback]() {
                     try
                     {
@@ -48,8 +54,54 @@ namespace network {
 
                         SRV_ASSERT(_config);
 
+                        if (_config->io_uring())
+                        {
+#if defined(SERVER_LIB_IO_URING)
+                            if (uring::supported())
+                            {
+                                _uring = std::make_shared<uring_service>(_worker.service(),
+                                                                         _config->io_uring_entries(),
+                                                                         _config->io_uring_buffers(),
+                                                                         _config->chunk_size());
+                                _uring->start();
+                            }
+#endif
+                            if (!_uring)
+                            {
+                                SRV_LOGC_WARN("io_uring is not supported. epoll is used");
+                            }
+                        }
+
+                        if (_uring)
+                        {
+                            auto resolver = std::make_shared<asio::ip::tcp::resolver>(*_worker.service());
+                            asio::ip::tcp::resolver::query query(_config->host(), std::to_string(_config->port()));
+                            resolver->async_resolve(query, [this, connect_callback, fail_callback, resolver](const error_code& ec, asio::ip::tcp::resolver::iterator it) {
+                                try
+                                {
+                                    if (ec)
+                                    {
+                                        if (fail_callback)
+                                            fail_callback(ec.message());
+                                        return;
+                                    }
+
+                                    SRV_LOGC_TRACE("resolved");
+
+                                    connect_uring(it->endpoint(), connect_callback, fail_callback);
+                                }
+                                catch (const std::exception& e)
+                                {
+                                    SRV_LOGC_ERROR(e.what());
+                                    if (fail_callback)
+                                        fail_callback(e.what());
+                                }
+                            });
+                            return;
+                        }
+
                         auto connection = std::make_shared<tcp_client_connection_impl>(_worker.service(),
-                                                                                       _config->chunk_size());
+                                                                                       make_read_options(*_config));
 
                         auto resolver = std::make_shared<asio::ip::tcp::resolver>(*_worker.service());
                         connection->set_timeout(_config->timeout_connect_ms(), [resolver]() {
@@ -73,6 +125,12 @@ namespace network {
                                 {
                                     connection->configurate(_config->host() + ":" + std::to_string(_config->port()));
 
+                                    auto busy_poll_ec = set_socket_busy_poll(connection->socket(), _config->socket_busy_poll());
+                                    if (busy_poll_ec)
+                                    {
+                                        SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                                    }
+
                                     SRV_LOGC_TRACE("connected");
 
                                     if (connect_callback)
@@ -135,6 +193,100 @@ namespace network {
             return false;
         }
 
+        void tcp_client_impl::connect_uring(const asio::ip::tcp::endpoint& endpoint,
+                                            const connect_callback_type& connect_callback,
+                                            const fail_callback_type& fail_callback)
+        {
+#if defined(SERVER_LIB_IO_URING)
+            int fd = ::socket(endpoint.protocol().family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+            SRV_ASSERT(fd >= 0, std::string { "socket: " } + std::strerror(errno));
+
+            // Kernel reads them until completion
+            struct connect_data
+            {
+                asio::ip::tcp::endpoint endpoint;
+                __kernel_timespec timeout;
+            };
+            auto data = std::make_shared<connect_data>();
+            data->endpoint = endpoint;
+            auto timeout_ms = _config->timeout_connect_ms();
+            data->timeout.tv_sec = static_cast<int64_t>(timeout_ms / 1000);
+            data->timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+
+            auto op = make_uring_operation([this, data, fd, connect_callback, fail_callback](int result, unsigned) {
+                try
+                {
+                    if (result < 0)
+                    {
+                        ::close(fd);
+                        // Connection is canceled by linked timeout
+                        auto error = result == -ECANCELED ? ETIMEDOUT : -result;
+                        if (fail_callback)
+                            fail_callback(std::strerror(error));
+                        return;
+                    }
+
+                    auto busy_poll_ec = set_socket_busy_poll(fd, _config->socket_busy_poll());
+                    if (busy_poll_ec)
+                    {
+                        SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                    }
+
+                    auto connection = std::make_shared<uring_connection_impl>(_uring,
+                                                                              fd,
+                                                                              0,
+                                                                              _config->host() + ":" + std::to_string(_config->port()));
+                    connection->start();
+
+                    SRV_LOGC_TRACE("connected");
+
+                    if (connect_callback)
+                        connect_callback(connection);
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                    if (fail_callback)
+                        fail_callback(e.what());
+                }
+            });
+
+            auto prepare_connect = [fd, data, timeout_ms](io_uring_sqe& sqe) {
+                sqe.opcode = IORING_OP_CONNECT;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<uint64_t>(data->endpoint.data());
+                sqe.off = data->endpoint.size();
+                if (timeout_ms > 0)
+                    sqe.flags = IOSQE_IO_LINK;
+            };
+            bool submitted = false;
+            if (timeout_ms > 0)
+            {
+                submitted = _uring->submit(op, prepare_connect, [data](io_uring_sqe& sqe) {
+                    sqe.opcode = IORING_OP_LINK_TIMEOUT;
+                    sqe.fd = -1;
+                    sqe.addr = reinterpret_cast<uint64_t>(&data->timeout);
+                    sqe.len = 1;
+                });
+            }
+            else
+            {
+                submitted = _uring->submit(op, prepare_connect);
+            }
+
+            if (!submitted)
+            {
+                ::close(fd);
+                if (fail_callback)
+                    fail_callback("Client is stopped");
+            }
+#else
+            (void)endpoint;
+            (void)connect_callback;
+            (void)fail_callback;
+#endif
+        }
+
         void tcp_client_impl::post(common_callback_type&& callback)
         {
             _worker.post(std::move(callback));
@@ -147,6 +299,14 @@ namespace network {
             SRV_ASSERT(!_worker.is_run() || !_worker.is_this_loop(),
                        "Can't initiate thread stop in the same thread. It is the way to deadlock");
             _worker.stop();
+
+#if defined(SERVER_LIB_IO_URING)
+            if (_uring)
+            {
+                _uring->shutdown();
+                _uring.reset();
+            }
+#endif
         }
 
     } // namespace transport_layer
@@ -6,12 +6,16 @@
 
 #include <server_lib/event_loop.h>
 
+#include <boost/asio.hpp>
+
 #include <memory>
 
 namespace server_lib {
 namespace network {
     namespace transport_layer {
 
+        class uring_service;
+
         class tcp_client_impl : public __client_impl_i
         {
         public:
@@ -26,10 +30,16 @@ namespace network {
             void post(common_callback_type&& callback) override;
 
         private:
+            void connect_uring(const boost::asio::ip::tcp::endpoint& endpoint,
+                               const connect_callback_type& connect_callback,
+                               const fail_callback_type& fail_callback);
             void stop_worker();
 
             event_loop _worker;
 
+            // If io_uring is enabled and supported
+            std::shared_ptr<uring_service> _uring;
+
             std::unique_ptr<tcp_client_config> _config;
         };
 
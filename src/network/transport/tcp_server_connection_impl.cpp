@@ -11,8 +11,8 @@ namespace network {
         tcp_server_connection_impl::tcp_server_connection_impl(
             const std::shared_ptr<boost::asio::io_service>& io_service,
             uint64_t id,
-            size_t chunk_size)
-            : base_class(io_service, id, chunk_size, *io_service)
+            const read_options& options)
+            : base_class(io_service, id, options, *io_service)
         {
         }
 
@@ -11,7 +11,7 @@ namespace network {
         public:
             tcp_server_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
                                        uint64_t id,
-                                       size_t chunk_size);
+                                       const read_options& options);
 
             void configurate(const std::string&) override;
             void close_socket(socket_type&) override;
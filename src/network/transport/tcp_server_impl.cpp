@@ -1,8 +1,13 @@
 #include "tcp_server_impl.h"
 #include "tcp_server_connection_impl.h"
+#include "uring_connection_impl.h"
+#include "../socket_options.h"
+#include "../worker_options.h"
 
 #include <server_lib/asserts.h>
 
+#include <cstring>
+
 #include "../../logger_set_internal_group.h"
 
 namespace server_lib {
@@ -51,6 +56,7 @@ namespace network {
 
                 _workers = std::make_unique<event_pool>(_config->worker_threads());
                 _workers->change_pool_name(_config->worker_name());
+                apply_worker_options(*_workers, *_config);
                 auto start_ = [this, start_callback]() {
                     try
                     {
@@ -68,7 +74,28 @@ namespace network {
                         _acceptor->bind(endpoint);
                         _acceptor->listen();
 
-                        accept();
+                        if (_config->io_uring())
+                        {
+#if defined(SERVER_LIB_IO_URING)
+                            if (uring::supported())
+                            {
+                                _uring = std::make_shared<uring_service>(_workers->service(),
+                                                                         _config->io_uring_entries(),
+                                                                         _config->io_uring_buffers(),
+                                                                         _config->chunk_size());
+                                _uring->start();
+                            }
+#endif
+                            if (!_uring)
+                            {
+                                SRV_LOGC_WARN("io_uring is not supported. epoll is used");
+                            }
+                        }
+
+                        if (_uring)
+                            accept_uring();
+                        else
+                            accept();
 
                         SRV_LOGC_TRACE("started");
 
@@ -98,9 +125,10 @@ namespace network {
         {
             SRV_ASSERT(_config);
 
-            auto connection = std::make_shared<tcp_server_connection_impl>(_workers->service(),
-                                                                           std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1),
-                                                                           _config->chunk_size());
+            auto connection = std::allocate_shared<tcp_server_connection_impl>(pool_allocator<tcp_server_connection_impl>(),
+                                                                               _workers->service(),
+                                                                               std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1),
+                                                                               make_read_options(*_config));
 
             auto scope_lock = [connection]() -> bool {
                 return connection->handler_runner.continue_lock().operator bool();
@@ -120,6 +148,12 @@ namespace network {
                     {
                         connection->configurate("");
 
+                        auto busy_poll_ec = set_socket_busy_poll(connection->socket(), _config->socket_busy_poll());
+                        if (busy_poll_ec)
+                        {
+                            SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                        }
+
                         SRV_LOGC_TRACE("connected");
 
                         if (_new_connection_callback)
@@ -137,6 +171,81 @@ namespace network {
             });
         }
 
+        void tcp_server_impl::accept_uring()
+        {
+#if defined(SERVER_LIB_IO_URING)
+            auto fd = _acceptor->native_handle();
+            _uring->submit(make_uring_operation([this](int result, unsigned flags) {
+                               on_uring_accept(result, flags);
+                           }),
+                           [fd](io_uring_sqe& sqe) {
+                               sqe.opcode = IORING_OP_ACCEPT;
+                               sqe.fd = fd;
+                               sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+                               sqe.accept_flags = SOCK_CLOEXEC;
+                           });
+#endif
+        }
+
+        void tcp_server_impl::on_uring_accept(int result, unsigned flags)
+        {
+#if defined(SERVER_LIB_IO_URING)
+            // Listening socket is shut down
+            if (result == -EINVAL || result == -EBADF || result == -ECANCELED)
+                return;
+
+            // Multishot accept is stopped by error or kernel
+            if (!(flags & IORING_CQE_F_MORE))
+                accept_uring();
+
+            try
+            {
+                if (result < 0)
+                {
+                    if (_fail_callback)
+                        _fail_callback(std::strerror(-result));
+                    return;
+                }
+
+                std::string remote_endpoint;
+                asio::ip::tcp::endpoint endpoint;
+                socklen_t size = static_cast<socklen_t>(endpoint.capacity());
+                if (::getpeername(result, endpoint.data(), &size) == 0)
+                {
+                    endpoint.resize(size);
+                    remote_endpoint = endpoint.address().to_string();
+                }
+
+                auto busy_poll_ec = set_socket_busy_poll(result, _config->socket_busy_poll());
+                if (busy_poll_ec)
+                {
+                    SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                }
+
+                auto connection = std::allocate_shared<uring_connection_impl>(pool_allocator<uring_connection_impl>(),
+                                                                              _uring,
+                                                                              result,
+                                                                              std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1),
+                                                                              remote_endpoint);
+                connection->start();
+
+                SRV_LOGC_TRACE("connected");
+
+                if (_new_connection_callback)
+                    _new_connection_callback(connection);
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+                if (_fail_callback)
+                    _fail_callback(e.what());
+            }
+#else
+            (void)result;
+            (void)flags;
+#endif
+        }
+
         void tcp_server_impl::stop_impl()
         {
             if (!is_running())
@@ -149,12 +258,25 @@ namespace network {
             if (_acceptor)
             {
                 error_code ec;
+#if defined(SERVER_LIB_IO_URING)
+                // Wake io_uring accept up (it keeps socket opened)
+                if (_uring)
+                    ::shutdown(_acceptor->native_handle(), SHUT_RDWR);
+#endif
                 _acceptor->close(ec);
             }
 
             SRV_ASSERT(!_workers->is_run() || !_workers->is_this_loop(),
                        "Can't initiate thread stop in the same thread. It is the way to deadlock");
             _workers->stop();
+
+#if defined(SERVER_LIB_IO_URING)
+            if (_uring)
+            {
+                _uring->shutdown();
+                _uring.reset();
+            }
+#endif
         }
 
         bool tcp_server_impl::is_running() const
@@ -15,6 +15,7 @@ namespace network {
     namespace transport_layer {
 
         class tcp_server_connection_impl;
+        class uring_service;
 
         class tcp_server_impl : public server_impl_i,
                                 public std::enable_shared_from_this<tcp_server_impl>
@@ -40,12 +41,17 @@ namespace network {
 
         private:
             void accept();
+            void accept_uring();
+            void on_uring_accept(int result, unsigned flags);
             void stop_impl();
 
             std::unique_ptr<event_pool> _workers;
 
             std::unique_ptr<boost::asio::ip::tcp::acceptor> _acceptor;
 
+            // If io_uring is enabled and supported
+            std::shared_ptr<uring_service> _uring;
+
             std::atomic<uint64_t> _next_connection_id;
 
             std::unique_ptr<tcp_server_config> _config;
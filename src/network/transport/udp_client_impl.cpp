@@ -0,0 +1,145 @@
+#include "udp_client_impl.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "udp_connection_impl.h"
+#include "../socket_options.h"
+#include "../worker_options.h"
+
+#include <server_lib/asserts.h>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        udp_client_impl::~udp_client_impl()
+        {
+            try
+            {
+                stop_worker();
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+            }
+        }
+
+        void udp_client_impl::config(const udp_client_config& config)
+        {
+            _config = std::make_unique<udp_client_config>(config);
+        }
+
+        bool udp_client_impl::connect(const connect_callback_type& connect_callback,
+                                      const fail_callback_type& fail_callback)
+        {
+            try
+            {
+                SRV_LOGC_TRACE(__FUNCTION__);
+
+                stop_worker();
+
+                SRV_ASSERT(_config && _config->valid());
+
+                _worker.change_loop_name(_config->worker_name());
+                apply_worker_options(_worker, *_config);
+                auto connect_ = [this, connect_callback, fail_callback]() {
+                    try
+                    {
+                        SRV_LOGC_TRACE("connecting");
+
+                        SRV_ASSERT(_config);
+
+                        auto resolver = std::make_shared<asio::ip::udp::resolver>(*_worker.service());
+                        asio::ip::udp::resolver::query query(_config->host(), std::to_string(_config->port()));
+
+                        auto resolve_step = [this, connect_callback, fail_callback, resolver](
+                                                const error_code& ec, asio::ip::udp::resolver::iterator it) {
+                            try
+                            {
+                                if (ec)
+                                {
+                                    if (fail_callback)
+                                        fail_callback(ec.message());
+                                    return;
+                                }
+
+                                SRV_LOGC_TRACE("resolved");
+
+                                auto socket = std::make_shared<udp_socket_impl>(_worker.service(),
+                                                                                _config->datagram_size(),
+                                                                                _config->batch_size(),
+                                                                                _config->offload());
+                                // Datagrams from other endpoints are filtered by kernel
+                                socket->connect(*it);
+
+                                auto busy_poll_ec = set_socket_busy_poll(socket->socket(), _config->socket_busy_poll());
+                                if (busy_poll_ec)
+                                {
+                                    SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                                }
+
+                                auto connection = std::make_shared<udp_connection_impl>(socket, it->endpoint(), 0, true);
+
+                                std::weak_ptr<udp_connection_impl> weak_connection = connection;
+                                socket->start([weak_connection](const udp_socket_impl::endpoint_type&, pooled_buffer&& datagram) {
+                                    if (auto connection = weak_connection.lock())
+                                        connection->push(std::move(datagram));
+                                });
+
+                                SRV_LOGC_TRACE("connected");
+
+                                if (connect_callback)
+                                    connect_callback(connection);
+                            }
+                            catch (const std::exception& e)
+                            {
+                                SRV_LOGC_ERROR(e.what());
+                                if (fail_callback)
+                                    fail_callback(e.what());
+                            }
+                        };
+                        resolver->async_resolve(query, resolve_step);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        SRV_LOGC_ERROR(e.what());
+                        if (fail_callback)
+                            fail_callback(e.what());
+                    }
+                };
+                _worker.on_start(connect_).start();
+
+                return true;
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+            }
+
+            return false;
+        }
+
+        void udp_client_impl::post(common_callback_type&& callback)
+        {
+            _worker.post(std::move(callback));
+        }
+
+        void udp_client_impl::stop_worker()
+        {
+            SRV_LOGC_TRACE(__FUNCTION__);
+
+            SRV_ASSERT(!_worker.is_run() || !_worker.is_this_loop(),
+                       "Can't initiate thread stop in the same thread. It is the way to deadlock");
+            _worker.stop();
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
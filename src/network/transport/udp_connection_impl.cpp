@@ -0,0 +1,165 @@
+#include "udp_connection_impl.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "../pooled_handler.h"
+
+#include <server_lib/asserts.h>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace {
+            // Datagrams are dropped if application doesn't read them
+            constexpr size_t max_received_datagrams = 4096;
+        } // namespace
+
+        udp_connection_impl::udp_connection_impl(const std::shared_ptr<udp_socket_impl>& socket,
+                                                 const endpoint_type& endpoint,
+                                                 uint64_t id,
+                                                 bool own_socket)
+            : _socket(socket)
+            , _endpoint(endpoint)
+            , _id(id)
+            , _own_socket(own_socket)
+            , _last_activity(std::chrono::steady_clock::now().time_since_epoch().count())
+        {
+            SRV_ASSERT(_socket);
+
+            _remote_endpoint = endpoint.address().to_string() + ":" + std::to_string(endpoint.port());
+        }
+
+        void udp_connection_impl::disconnect()
+        {
+            if (!_connected.exchange(false))
+                return;
+
+            auto self = shared_from_this();
+
+            std::unique_lock<std::mutex> lock(_disconnect_mutex);
+            auto disconnection_callbacks = _disconnection_callbacks;
+            lock.unlock();
+            for (auto it = disconnection_callbacks.rbegin(); it != disconnection_callbacks.rend(); ++it)
+            {
+                lock.lock();
+                bool cleared = _disconnection_callbacks.empty();
+                lock.unlock();
+                if (cleared)
+                    break;
+                auto callback = *it;
+                callback(_id);
+            }
+
+            {
+                std::lock_guard<std::mutex> read_lock(_read_mutex);
+                _received.clear();
+                _read_callback = nullptr;
+            }
+
+            if (_own_socket)
+                _socket->close();
+        }
+
+        void udp_connection_impl::set_disconnect_handler(const disconnect_callback_type& callback)
+        {
+            std::lock_guard<std::mutex> lock(_disconnect_mutex);
+            if (callback)
+            {
+                _disconnection_callbacks.push_back(callback);
+            }
+            else
+            {
+                _disconnection_callbacks.clear();
+            }
+        }
+
+        void udp_connection_impl::async_read(read_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            std::unique_lock<std::mutex> lock(_read_mutex);
+            SRV_ASSERT(!_read_callback, "Read is in progress");
+            if (_received.empty())
+            {
+                _read_callback = std::move(request.async_read_callback);
+                return;
+            }
+
+            auto datagram = std::move(_received.front());
+            _received.pop_front();
+            lock.unlock();
+
+            // Callback should not be called inside async_read
+            auto self = shared_from_this();
+            _socket->service()->post(make_pooled_handler([self, datagram = std::move(datagram), callback = std::move(request.async_read_callback)]() mutable {
+                try
+                {
+                    self->deliver(std::move(datagram), std::move(callback));
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                    self->disconnect();
+                }
+            }));
+        }
+
+        void udp_connection_impl::push(pooled_buffer&& datagram)
+        {
+            if (!is_connected())
+                return;
+
+            _last_activity = std::chrono::steady_clock::now().time_since_epoch().count();
+
+            std::unique_lock<std::mutex> lock(_read_mutex);
+            if (!_read_callback)
+            {
+                if (_received.size() < max_received_datagrams)
+                {
+                    _received.emplace_back(std::move(datagram));
+                }
+                else
+                {
+                    SRV_LOGC_WARN("Datagram from " << _remote_endpoint << " is dropped. Receiving queue is full");
+                }
+                return;
+            }
+
+            auto callback = std::move(_read_callback);
+            _read_callback = nullptr;
+            lock.unlock();
+
+            deliver(std::move(datagram), std::move(callback));
+        }
+
+        void udp_connection_impl::deliver(pooled_buffer&& datagram, async_read_callback_type&& callback)
+        {
+            if (!is_connected() || !callback)
+                return;
+
+            read_result result;
+            result.success = true;
+            result.buffer = std::move(datagram);
+            callback(result);
+        }
+
+        void udp_connection_impl::async_write(write_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            _socket->send(_endpoint, std::move(request.buffer), [callback = std::move(request.async_write_callback)](bool success, size_t size) {
+                if (!callback)
+                    return;
+                write_result result = { success, size };
+                callback(result);
+            });
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "connection_impl_i.h"
+#include "udp_socket_impl.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * Datagrams of one remote endpoint. Every read returns
+         * one datagram and every write sends one datagram
+         */
+        class udp_connection_impl : public __connection_impl_i,
+                                    public std::enable_shared_from_this<udp_connection_impl>
+        {
+        public:
+            using endpoint_type = udp_socket_impl::endpoint_type;
+
+            /**
+             * \param own_socket - Socket is closed on disconnection
+             * (client side)
+             */
+            udp_connection_impl(const std::shared_ptr<udp_socket_impl>& socket,
+                                const endpoint_type& endpoint,
+                                uint64_t id,
+                                bool own_socket);
+
+            uint64_t id() const override
+            {
+                return _id;
+            }
+
+            void disconnect() override;
+
+            bool is_connected() const override
+            {
+                return _connected;
+            }
+
+            std::string remote_endpoint() const override
+            {
+                return _remote_endpoint;
+            }
+
+            size_t chunk_size() const override
+            {
+                return _socket->datagram_size();
+            }
+
+            bool is_message_oriented() const override
+            {
+                return true;
+            }
+
+            void set_disconnect_handler(const disconnect_callback_type& callback) override;
+
+            void async_read(read_request& request) override;
+
+            void async_write(write_request& request) override;
+
+            // Datagram from peer (socket reading thread)
+            void push(pooled_buffer&& datagram);
+
+            std::chrono::steady_clock::time_point last_activity() const
+            {
+                return std::chrono::steady_clock::time_point { std::chrono::steady_clock::duration { _last_activity.load() } };
+            }
+
+        private:
+            void deliver(pooled_buffer&& datagram, async_read_callback_type&& callback);
+
+            std::shared_ptr<udp_socket_impl> _socket;
+            const endpoint_type _endpoint;
+            const uint64_t _id;
+            const bool _own_socket;
+            std::string _remote_endpoint;
+
+            std::atomic_bool _connected { true };
+            std::atomic<std::chrono::steady_clock::rep> _last_activity;
+
+            std::mutex _read_mutex;
+            // Datagrams received before read request
+            std::deque<pooled_buffer> _received;
+            async_read_callback_type _read_callback;
+
+            std::mutex _disconnect_mutex;
+            std::vector<disconnect_callback_type> _disconnection_callbacks;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
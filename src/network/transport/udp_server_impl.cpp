@@ -0,0 +1,235 @@
+#include "udp_server_impl.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "udp_connection_impl.h"
+#include "../pooled_handler.h"
+#include "../socket_options.h"
+#include "../worker_options.h"
+
+#include <server_lib/asserts.h>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        udp_server_impl::udp_server_impl()
+        {
+            _next_connection_id = 1;
+        }
+
+        udp_server_impl::~udp_server_impl()
+        {
+            try
+            {
+                stop_impl();
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+            }
+        }
+
+        void udp_server_impl::config(const udp_server_config& config)
+        {
+            _config = std::make_unique<udp_server_config>(config);
+        }
+
+        bool udp_server_impl::start(const start_callback_type& start_callback,
+                                    const new_connection_callback_type& new_connection_callback,
+                                    const fail_callback_type& fail_callback)
+        {
+            try
+            {
+                SRV_ASSERT(!is_running());
+
+                SRV_ASSERT(_config && _config->valid());
+
+                SRV_LOGC_TRACE("attempts to start");
+
+                _new_connection_callback = new_connection_callback;
+                _fail_callback = fail_callback;
+
+                _workers = std::make_unique<event_pool>(_config->worker_threads());
+                _workers->change_pool_name(_config->worker_name());
+                apply_worker_options(*_workers, *_config);
+                auto start_ = [this, start_callback]() {
+                    try
+                    {
+                        SRV_LOGC_TRACE("starting");
+
+                        asio::ip::udp::endpoint endpoint;
+                        if (!_config->address().empty())
+                            endpoint = asio::ip::udp::endpoint(asio::ip::address::from_string(_config->address()), _config->port());
+                        else
+                            endpoint = asio::ip::udp::endpoint(asio::ip::udp::v4(), _config->port());
+
+                        _socket = std::make_shared<udp_socket_impl>(_workers->service(),
+                                                                    _config->datagram_size(),
+                                                                    _config->batch_size(),
+                                                                    _config->offload());
+                        _socket->bind(endpoint, _config->reuse_address());
+
+                        auto busy_poll_ec = set_socket_busy_poll(_socket->socket(), _config->socket_busy_poll());
+                        if (busy_poll_ec)
+                        {
+                            SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << busy_poll_ec.message());
+                        }
+
+                        _socket->start([this](const endpoint_type& endpoint, pooled_buffer&& datagram) {
+                            on_receive(endpoint, std::move(datagram));
+                        });
+
+                        if (_config->idle_timeout_ms() > 0)
+                        {
+                            _idle_timer = std::make_unique<asio::steady_timer>(*_workers->service());
+                            wait_idle();
+                        }
+
+                        SRV_LOGC_TRACE("started");
+
+                        if (start_callback)
+                            start_callback();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        SRV_LOGC_ERROR(e.what());
+                        if (_fail_callback)
+                            _fail_callback(e.what());
+                    }
+                };
+                _workers->on_start(start_).start();
+
+                return true;
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+            }
+
+            return false;
+        }
+
+        void udp_server_impl::on_receive(const endpoint_type& endpoint, pooled_buffer&& datagram)
+        {
+            std::shared_ptr<udp_connection_impl> connection;
+            bool created = false;
+            {
+                std::lock_guard<std::mutex> lock(_peers_mutex);
+                auto it = _peers.find(endpoint);
+                if (it != _peers.end())
+                {
+                    connection = it->second;
+                }
+                else
+                {
+                    connection = std::allocate_shared<udp_connection_impl>(pool_allocator<udp_connection_impl>(),
+                                                                           _socket,
+                                                                           endpoint,
+                                                                           std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1),
+                                                                           false);
+                    _peers.emplace(endpoint, connection);
+                    created = true;
+                }
+            }
+
+            if (created)
+            {
+                // Connection could be disconnected by application after server removal
+                std::weak_ptr<udp_server_impl> weak_self = shared_from_this();
+                connection->set_disconnect_handler([weak_self, endpoint](size_t) {
+                    if (auto self = weak_self.lock())
+                        self->on_disconnect(endpoint);
+                });
+
+                SRV_LOGC_TRACE("new peer " << connection->remote_endpoint());
+
+                if (_new_connection_callback)
+                    _new_connection_callback(connection);
+            }
+
+            connection->push(std::move(datagram));
+        }
+
+        void udp_server_impl::on_disconnect(const endpoint_type& endpoint)
+        {
+            std::lock_guard<std::mutex> lock(_peers_mutex);
+            _peers.erase(endpoint);
+        }
+
+        void udp_server_impl::wait_idle()
+        {
+            auto timeout = std::chrono::milliseconds(_config->idle_timeout_ms());
+            _idle_timer->expires_from_now(std::max(timeout / 2, std::chrono::milliseconds(1)));
+            _idle_timer->async_wait(make_pooled_handler([this, timeout](const error_code& ec) {
+                if (ec)
+                    return;
+
+                std::vector<std::shared_ptr<udp_connection_impl>> expired;
+                auto deadline = std::chrono::steady_clock::now() - timeout;
+                {
+                    std::lock_guard<std::mutex> lock(_peers_mutex);
+                    for (auto&& item : _peers)
+                    {
+                        if (item.second->last_activity() < deadline)
+                            expired.emplace_back(item.second);
+                    }
+                }
+
+                for (auto&& connection : expired)
+                {
+                    SRV_LOGC_TRACE("peer " << connection->remote_endpoint() << " is idle");
+                    connection->disconnect();
+                }
+
+                wait_idle();
+            }));
+        }
+
+        void udp_server_impl::stop_impl()
+        {
+            if (!is_running())
+            {
+                return;
+            }
+
+            SRV_LOGC_TRACE(__FUNCTION__);
+
+            if (_idle_timer)
+            {
+                error_code ec;
+                _idle_timer->cancel(ec);
+            }
+
+            if (_socket)
+                _socket->close();
+
+            SRV_ASSERT(!_workers->is_run() || !_workers->is_this_loop(),
+                       "Can't initiate thread stop in the same thread. It is the way to deadlock");
+            _workers->stop();
+
+            std::lock_guard<std::mutex> lock(_peers_mutex);
+            _peers.clear();
+        }
+
+        bool udp_server_impl::is_running() const
+        {
+            return _workers && _workers->is_running();
+        }
+
+        void udp_server_impl::post(common_callback_type&& callback)
+        {
+            SRV_ASSERT(_workers);
+            _workers->post(std::move(callback));
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
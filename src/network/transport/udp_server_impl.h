@@ -0,0 +1,74 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "server_impl_i.h"
+#include "udp_socket_impl.h"
+
+#include <server_lib/network/server_config.h>
+#include <server_lib/event_pool.h>
+
+#include <boost/asio.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        class udp_connection_impl;
+
+        class udp_server_impl : public server_impl_i,
+                                public std::enable_shared_from_this<udp_server_impl>
+        {
+        public:
+            udp_server_impl();
+            ~udp_server_impl() override;
+
+            void config(const udp_server_config&);
+
+            bool start(const start_callback_type& start_callback,
+                       const new_connection_callback_type& new_connection_callback,
+                       const fail_callback_type& fail_callback) override;
+
+            void stop() override
+            {
+                stop_impl();
+            }
+
+            bool is_running() const override;
+
+            void post(common_callback_type&& callback) override;
+
+        private:
+            using endpoint_type = udp_socket_impl::endpoint_type;
+
+            void on_receive(const endpoint_type& endpoint, pooled_buffer&& datagram);
+            void on_disconnect(const endpoint_type& endpoint);
+            void wait_idle();
+            void stop_impl();
+
+            std::unique_ptr<event_pool> _workers;
+
+            std::shared_ptr<udp_socket_impl> _socket;
+            std::unique_ptr<boost::asio::steady_timer> _idle_timer;
+
+            std::mutex _peers_mutex;
+            std::map<endpoint_type, std::shared_ptr<udp_connection_impl>> _peers;
+
+            std::atomic<uint64_t> _next_connection_id;
+
+            std::unique_ptr<udp_server_config> _config;
+
+            new_connection_callback_type _new_connection_callback = nullptr;
+            fail_callback_type _fail_callback = nullptr;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
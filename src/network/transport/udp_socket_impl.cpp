@@ -0,0 +1,436 @@
+#include "udp_socket_impl.h"
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include "../pooled_handler.h"
+
+#include <server_lib/asserts.h>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        namespace {
+            // UDP_MAX_SEGMENTS of oldest kernel with GSO
+            constexpr size_t gso_max_segments = 64;
+            // Payload limit of one GSO message
+            constexpr size_t gso_max_size = 63 * 1024;
+            // Segment should fit into Ethernet MTU (IPv6)
+            constexpr size_t gso_max_segment_size = 1452;
+            // With GRO kernel coalesces datagrams up to 64K
+            constexpr size_t gro_buffer_size = 65535;
+            // Let other handlers run if socket is flooded
+            constexpr size_t max_batches_per_wait = 16;
+
+            constexpr size_t control_size = CMSG_SPACE(sizeof(int));
+        } // namespace
+
+        udp_socket_impl::udp_socket_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
+                                         size_t datagram_size,
+                                         size_t batch_size,
+                                         bool offload)
+            : _io_service(io_service)
+            , _socket(*io_service)
+            , _datagram_size(datagram_size)
+            , _batch_size(batch_size)
+            , _gro(offload)
+            , _gso(offload)
+        {
+            SRV_ASSERT(_io_service);
+            SRV_ASSERT(_datagram_size > 0 && _batch_size > 0);
+        }
+
+        void udp_socket_impl::bind(const endpoint_type& endpoint, bool reuse_address)
+        {
+            _socket.open(endpoint.protocol());
+            _socket.set_option(asio::socket_base::reuse_address(reuse_address));
+            _socket.bind(endpoint);
+            setup_offload();
+        }
+
+        void udp_socket_impl::connect(const endpoint_type& endpoint)
+        {
+            _socket.open(endpoint.protocol());
+            _socket.connect(endpoint);
+            _connected_socket = true;
+            setup_offload();
+        }
+
+        void udp_socket_impl::setup_offload()
+        {
+            auto fd = _socket.native_handle();
+            if (_gro)
+            {
+                int enabled = 1;
+                if (::setsockopt(fd, SOL_UDP, UDP_GRO, &enabled, sizeof(enabled)) != 0)
+                {
+                    SRV_LOGC_WARN("UDP GRO is not supported: " << std::strerror(errno));
+                    _gro = false;
+                }
+            }
+            if (_gso)
+            {
+                // Zero disables GSO for socket but segment size is set per message
+                int segment = 0;
+                if (::setsockopt(fd, SOL_UDP, UDP_SEGMENT, &segment, sizeof(segment)) != 0)
+                {
+                    SRV_LOGC_WARN("UDP GSO is not supported: " << std::strerror(errno));
+                    _gso = false;
+                }
+            }
+
+            _read_buffer_size = _gro ? std::max(_datagram_size, gro_buffer_size) : _datagram_size;
+            _read_buffers.resize(_read_buffer_size * _batch_size);
+            _read_messages.resize(_batch_size);
+            _read_iovecs.resize(_batch_size);
+            _read_endpoints.resize(_batch_size);
+            _read_controls.resize(_gro ? control_size * _batch_size : 0);
+
+            _write_messages.resize(_batch_size);
+            _write_iovecs.resize(_batch_size * (_gso ? gso_max_segments : 1));
+            _write_controls.resize(_gso ? control_size * _batch_size : 0);
+        }
+
+        void udp_socket_impl::start(const receive_callback_type& callback)
+        {
+            SRV_ASSERT(_socket.is_open());
+
+            _receive_callback = callback;
+            wait_read();
+        }
+
+        void udp_socket_impl::close()
+        {
+            handler_runner.stop();
+
+            error_code ec;
+            _socket.close(ec);
+
+            std::lock_guard<std::mutex> lock(_write_mutex);
+            _write_queue.clear();
+        }
+
+        void udp_socket_impl::wait_read()
+        {
+            auto self = shared_from_this();
+            _socket.async_wait(asio::socket_base::wait_read, make_pooled_handler([self](const error_code& ec) {
+                                   try
+                                   {
+                                       if (!self->handler_runner.continue_lock())
+                                           return;
+                                       if (ec)
+                                       {
+                                           if (ec != asio::error::operation_aborted)
+                                           {
+                                               SRV_LOGC_ERROR(ec.message());
+                                           }
+                                           return;
+                                       }
+
+                                       for (size_t ci = 0; ci < max_batches_per_wait && self->_socket.is_open(); ++ci)
+                                       {
+                                           if (!self->read_batch())
+                                               break;
+                                       }
+
+                                       if (self->_socket.is_open())
+                                           self->wait_read();
+                                   }
+                                   catch (const std::exception& e)
+                                   {
+                                       SRV_LOGC_ERROR(e.what());
+                                   }
+                               }));
+        }
+
+        bool udp_socket_impl::read_batch()
+        {
+            for (size_t ci = 0; ci < _batch_size; ++ci)
+            {
+                auto& iov = _read_iovecs[ci];
+                iov.iov_base = _read_buffers.data() + ci * _read_buffer_size;
+                iov.iov_len = _read_buffer_size;
+
+                auto& header = _read_messages[ci].msg_hdr;
+                std::memset(&header, 0, sizeof(header));
+                header.msg_name = _read_endpoints[ci].data();
+                header.msg_namelen = static_cast<socklen_t>(_read_endpoints[ci].capacity());
+                header.msg_iov = &iov;
+                header.msg_iovlen = 1;
+                if (_gro)
+                {
+                    header.msg_control = _read_controls.data() + ci * control_size;
+                    header.msg_controllen = control_size;
+                }
+                _read_messages[ci].msg_len = 0;
+            }
+
+            int received = ::recvmmsg(_socket.native_handle(), _read_messages.data(), static_cast<unsigned int>(_batch_size), MSG_DONTWAIT, nullptr);
+            if (received < 0)
+            {
+                switch (errno)
+                {
+                case EINTR:
+                    return true;
+                case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+                case EWOULDBLOCK:
+#endif
+                    return false;
+                case ECONNREFUSED:
+                    // ICMP for previous datagram of connected socket
+                    SRV_LOGC_TRACE("Peer is unreachable");
+                    return true;
+                default:
+                    SRV_LOGC_WARN("Can't receive datagrams: " << std::strerror(errno));
+                    return false;
+                }
+            }
+
+            for (int ci = 0; ci < received && _socket.is_open(); ++ci)
+            {
+                auto& message = _read_messages[ci];
+                if (message.msg_hdr.msg_flags & MSG_TRUNC)
+                {
+                    SRV_LOGC_WARN("Datagram is larger than " << _read_buffer_size << " bytes. Dropped");
+                    continue;
+                }
+
+                auto& endpoint = _read_endpoints[ci];
+                endpoint.resize(message.msg_hdr.msg_namelen);
+
+                size_t size = message.msg_len;
+                size_t segment = size;
+                if (_gro)
+                {
+                    for (auto* cmsg = CMSG_FIRSTHDR(&message.msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&message.msg_hdr, cmsg))
+                    {
+                        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+                        {
+                            int gso_size = 0;
+                            std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+                            if (gso_size > 0)
+                                segment = static_cast<size_t>(gso_size);
+                        }
+                    }
+                }
+
+                const char* data = _read_buffers.data() + ci * _read_buffer_size;
+                // Empty datagram is valid one
+                size_t offset = 0;
+                do
+                {
+                    auto sz = std::min(segment, size - offset);
+                    if (_receive_callback)
+                        _receive_callback(endpoint, pooled_buffer { data + offset, data + offset + sz });
+                    offset += sz;
+                } while (offset < size);
+            }
+
+            return static_cast<size_t>(received) == _batch_size;
+        }
+
+        void udp_socket_impl::send(const endpoint_type& endpoint, pooled_buffer&& buffer, write_callback_type&& callback)
+        {
+            std::lock_guard<std::mutex> lock(_write_mutex);
+            _write_queue.push_back({ endpoint, std::move(buffer), std::move(callback) });
+            // Waiting handler will continue
+            if (_write_waiting || _flush_posted)
+                return;
+
+            // Datagrams that are sent before flush is run
+            // are collected to the same batch
+            _flush_posted = true;
+            auto self = shared_from_this();
+            _io_service->post(make_pooled_handler([self]() {
+                try
+                {
+                    if (!self->handler_runner.continue_lock())
+                        return;
+                    {
+                        std::lock_guard<std::mutex> lock(self->_write_mutex);
+                        self->_flush_posted = false;
+                    }
+                    self->flush();
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                }
+            }));
+        }
+
+        size_t udp_socket_impl::prepare_message(size_t first, mmsghdr& message, iovec* iovecs, char* control)
+        {
+            auto& head = _write_queue[first];
+
+            auto& header = message.msg_hdr;
+            std::memset(&header, 0, sizeof(header));
+            if (!_connected_socket)
+            {
+                header.msg_name = const_cast<sockaddr*>(head.endpoint.data());
+                header.msg_namelen = static_cast<socklen_t>(head.endpoint.size());
+            }
+            header.msg_iov = iovecs;
+            message.msg_len = 0;
+
+            size_t count = 0;
+            size_t total = 0;
+            auto add = [&](pending_write& item) {
+                iovecs[count].iov_base = item.buffer.data();
+                iovecs[count].iov_len = item.buffer.size();
+                total += item.buffer.size();
+                ++count;
+            };
+            add(head);
+
+            // Kernel splits payload by segment size
+            size_t segment = head.buffer.size();
+            if (_gso && segment > 0 && segment <= gso_max_segment_size)
+            {
+                while (first + count < _write_queue.size() && count < gso_max_segments)
+                {
+                    auto& next = _write_queue[first + count];
+                    auto sz = next.buffer.size();
+                    if (next.endpoint != head.endpoint || !sz || sz > segment || total + sz > gso_max_size)
+                        break;
+                    add(next);
+                    // Shorter segment could be the last one only
+                    if (sz < segment)
+                        break;
+                }
+
+                if (count > 1)
+                {
+                    header.msg_control = control;
+                    header.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                    auto* cmsg = CMSG_FIRSTHDR(&header);
+                    cmsg->cmsg_level = SOL_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                    auto gso_size = static_cast<uint16_t>(segment);
+                    std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+                }
+            }
+            header.msg_iovlen = count;
+            return count;
+        }
+
+        void udp_socket_impl::flush()
+        {
+            struct completed_write
+            {
+                write_callback_type callback;
+                bool success;
+                size_t size;
+            };
+            std::vector<completed_write> completed;
+            {
+                std::lock_guard<std::mutex> lock(_write_mutex);
+                if (_write_waiting)
+                    return;
+
+                while (!_write_queue.empty() && _socket.is_open())
+                {
+                    // Datagrams per message
+                    _write_datagrams.clear();
+                    size_t queued = 0;
+                    size_t iovecs_used = 0;
+                    while (_write_datagrams.size() < _batch_size && queued < _write_queue.size())
+                    {
+                        auto index = _write_datagrams.size();
+                        char* control = _gso ? _write_controls.data() + index * control_size : nullptr;
+                        auto count = prepare_message(queued, _write_messages[index], _write_iovecs.data() + iovecs_used, control);
+                        _write_datagrams.push_back(count);
+                        iovecs_used += count;
+                        queued += count;
+                    }
+
+                    int sent = ::sendmmsg(_socket.native_handle(), _write_messages.data(), static_cast<unsigned int>(_write_datagrams.size()), MSG_DONTWAIT);
+                    bool success = true;
+                    if (sent < 0)
+                    {
+                        auto error = errno;
+                        if (error == EINTR)
+                            continue;
+                        if (error == EAGAIN || error == EWOULDBLOCK)
+                        {
+                            _write_waiting = true;
+                            wait_write();
+                            break;
+                        }
+                        if (_write_datagrams[0] > 1 && (error == EINVAL || error == EIO))
+                        {
+                            SRV_LOGC_WARN("UDP GSO is disabled: " << std::strerror(error));
+                            _gso = false;
+                            continue;
+                        }
+
+                        // First message is dropped
+                        SRV_LOGC_WARN("Can't send datagram: " << std::strerror(error));
+                        success = false;
+                        sent = 1;
+                    }
+
+                    for (int ci = 0; ci < sent; ++ci)
+                    {
+                        for (size_t di = 0; di < _write_datagrams[ci]; ++di)
+                        {
+                            auto& item = _write_queue.front();
+                            if (item.callback)
+                                completed.push_back({ std::move(item.callback), success, success ? item.buffer.size() : 0 });
+                            _write_queue.pop_front();
+                        }
+                    }
+                }
+            }
+
+            for (auto&& item : completed)
+            {
+                item.callback(item.success, item.size);
+            }
+        }
+
+        void udp_socket_impl::wait_write()
+        {
+            auto self = shared_from_this();
+            _socket.async_wait(asio::socket_base::wait_write, make_pooled_handler([self](const error_code& ec) {
+                                   try
+                                   {
+                                       if (!self->handler_runner.continue_lock())
+                                           return;
+                                       {
+                                           std::lock_guard<std::mutex> lock(self->_write_mutex);
+                                           self->_write_waiting = false;
+                                           if (ec)
+                                           {
+                                               self->_write_queue.clear();
+                                               return;
+                                           }
+                                       }
+                                       self->flush();
+                                   }
+                                   catch (const std::exception& e)
+                                   {
+                                       SRV_LOGC_ERROR(e.what());
+                                   }
+                               }));
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
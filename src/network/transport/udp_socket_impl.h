@@ -0,0 +1,120 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+
+#include <server_lib/network/scope_runner.h>
+#include <server_lib/buffer_pool.h>
+
+#include <boost/asio.hpp>
+
+#include <sys/socket.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * UDP socket with batched reading (recvmmsg) and
+         * writing (sendmmsg). Datagrams of all peers are
+         * passed through it
+         */
+        class udp_socket_impl : public std::enable_shared_from_this<udp_socket_impl>
+        {
+        public:
+            using endpoint_type = boost::asio::ip::udp::endpoint;
+            using receive_callback_type = std::function<void(const endpoint_type&, pooled_buffer&&)>;
+            using write_callback_type = std::function<void(bool /*success*/, size_t)>;
+
+            udp_socket_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
+                            size_t datagram_size,
+                            size_t batch_size,
+                            bool offload);
+
+            // Server side
+            void bind(const endpoint_type& endpoint, bool reuse_address);
+            // Client side
+            void connect(const endpoint_type& endpoint);
+
+            boost::asio::ip::udp::socket& socket()
+            {
+                return _socket;
+            }
+
+            const std::shared_ptr<boost::asio::io_service>& service() const
+            {
+                return _io_service;
+            }
+
+            size_t datagram_size() const
+            {
+                return _datagram_size;
+            }
+
+            // Callback is called in worker thread for every datagram
+            void start(const receive_callback_type& callback);
+
+            void close();
+
+            void send(const endpoint_type& endpoint, pooled_buffer&& buffer, write_callback_type&& callback);
+
+            scope_runner handler_runner;
+
+        private:
+            struct pending_write
+            {
+                endpoint_type endpoint;
+                pooled_buffer buffer;
+                write_callback_type callback;
+            };
+
+            void setup_offload();
+
+            void wait_read();
+            bool read_batch();
+
+            void flush();
+            void wait_write();
+            // Returns number of queued datagrams in message
+            size_t prepare_message(size_t first, mmsghdr& message, iovec* iovecs, char* control);
+
+            std::shared_ptr<boost::asio::io_service> _io_service;
+            boost::asio::ip::udp::socket _socket;
+            const size_t _datagram_size;
+            const size_t _batch_size;
+            bool _gro = false;
+            bool _gso = false;
+            bool _connected_socket = false;
+
+            receive_callback_type _receive_callback;
+
+            // Used by reading chain only
+            std::vector<char> _read_buffers;
+            std::vector<mmsghdr> _read_messages;
+            std::vector<iovec> _read_iovecs;
+            std::vector<endpoint_type> _read_endpoints;
+            std::vector<char> _read_controls;
+            size_t _read_buffer_size = 0;
+
+            std::mutex _write_mutex;
+            std::deque<pending_write> _write_queue;
+            bool _write_waiting = false;
+            bool _flush_posted = false;
+            std::vector<mmsghdr> _write_messages;
+            std::vector<iovec> _write_iovecs;
+            std::vector<char> _write_controls;
+            std::vector<size_t> _write_datagrams;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -3,6 +3,8 @@
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 
 #include "unix_local_connection_impl.h"
+#include "shm_connection_impl.h"
+#include "../worker_options.h"
 
 #include <server_lib/asserts.h>
 
@@ -47,6 +49,7 @@ namespace network {
                 SRV_ASSERT(_config && _config->valid());
 
                 _worker.change_loop_name(_config->worker_name());
+                apply_worker_options(_worker, *_config);
                 auto connect_ = [this, connect_callback, fail_callback]() {
                     try
                     {
@@ -57,7 +60,11 @@ namespace network {
                         SRV_ASSERT(fs::exists(_config->socket_file()), "Socket not found");
 
                         auto connection = std::make_shared<unix_local_connection_impl>(_worker.service(),
-                                                                                       _config->chunk_size());
+                                                                                       make_read_options(*_config),
+                                                                                       0,
+                                                                                       _config->seqpacket());
+                        if (_config->seqpacket())
+                            connection->open_seqpacket();
                         connection->set_timeout(_config->timeout_connect_ms());
 
                         auto scope_lock = [connection]() {
@@ -77,7 +84,13 @@ namespace network {
 
                                     SRV_LOGC_TRACE("connected");
 
-                                    if (connect_callback)
+                                    if (!connect_callback)
+                                        return;
+                                    if (_config->shared_memory())
+                                        connect_callback(shm_connection_impl::connect(_worker.service(), connection,
+                                                                                      _config->shared_memory_ring_size(),
+                                                                                      _config->shared_memory_spin()));
+                                    else
                                         connect_callback(connection);
                                 }
                                 else
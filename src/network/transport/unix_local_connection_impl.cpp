@@ -4,19 +4,56 @@
 
 #include <server_lib/asserts.h>
 
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
 #include "../../logger_set_internal_group.h"
 
 namespace server_lib {
 namespace network {
     namespace transport_layer {
 
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        namespace {
+            void close_descriptors(const std::vector<int>& descriptors)
+            {
+                for (auto fd : descriptors)
+                    ::close(fd);
+            }
+        } // namespace
+
         unix_local_connection_impl::unix_local_connection_impl(
             const std::shared_ptr<boost::asio::io_service>& io_service,
-            size_t chunk_size, uint64_t id)
-            : base_class(io_service, id, chunk_size, *io_service)
+            const read_options& options, uint64_t id, bool seqpacket)
+            : base_class(io_service, id, options, *io_service)
+            , _seqpacket(seqpacket)
         {
         }
 
+        void unix_local_connection_impl::open_seqpacket()
+        {
+            SRV_ASSERT(_socket);
+
+            int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            SRV_ASSERT(fd >= 0, std::strerror(errno));
+
+            // Asio doesn't check socket type so stream socket object
+            // could own SOCK_SEQPACKET socket
+            error_code ec;
+            _socket->assign(asio::local::stream_protocol(), fd, ec);
+            if (ec)
+            {
+                ::close(fd);
+                SRV_ERROR(ec.message());
+            }
+        }
+
         void unix_local_connection_impl::configurate(const std::string& remote_endpoint)
         {
             SRV_ASSERT(_socket);
@@ -33,6 +70,126 @@ namespace network {
             socket.lowest_layer().cancel(ec);
         }
 
+        void unix_local_connection_impl::async_read(read_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            auto buffer = std::allocate_shared<pooled_buffer>(pool_allocator<pooled_buffer>(), request.size);
+            wait_read(buffer, std::move(request.async_read_callback));
+        }
+
+        void unix_local_connection_impl::wait_read(const buffer_type& buffer, async_read_callback_type&& callback)
+        {
+            auto self = std::static_pointer_cast<unix_local_connection_impl>(this->shared_from_this());
+            _socket->async_wait(socket_type::wait_read,
+                                make_pooled_handler([self, buffer, callback = std::move(callback)](const error_code& ec) mutable {
+                                    try
+                                    {
+                                        if (!self->handler_runner.continue_lock())
+                                            return;
+                                        if (ec)
+                                        {
+                                            self->disconnect();
+                                            return;
+                                        }
+                                        // Readiness could be spurious
+                                        if (!self->try_read(buffer, callback))
+                                            self->wait_read(buffer, std::move(callback));
+                                    }
+                                    catch (const std::exception& e)
+                                    {
+                                        SRV_LOGC_ERROR(e.what());
+                                        self->disconnect();
+                                    }
+                                }));
+        }
+
+        bool unix_local_connection_impl::try_read(const buffer_type& buffer, const async_read_callback_type& callback)
+        {
+            SRV_ASSERT(_socket);
+
+            iovec iov = { buffer->data(), buffer->size() };
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_descriptors)];
+
+            msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            ssize_t received = 0;
+            do
+            {
+                received = ::recvmsg(_socket->native_handle(), &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+            } while (received < 0 && errno == EINTR);
+
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return false;
+
+            read_result result;
+            for (auto* cmsg = CMSG_FIRSTHDR(&msg); received >= 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                    continue;
+
+                auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const auto* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+                for (size_t ci = 0; ci < count; ++ci)
+                {
+                    int fd;
+                    std::memcpy(&fd, data + ci, sizeof(fd));
+                    result.descriptors.push_back(fd);
+                }
+            }
+
+            if (received > 0 && (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+            {
+                SRV_LOGC_ERROR("Message was truncated (chunk size " << buffer->size() << "), disconnecting");
+                received = -1;
+            }
+
+            if (received <= 0)
+            {
+                // Error or end of stream
+                close_descriptors(result.descriptors);
+                disconnect();
+                return true;
+            }
+
+            result.success = true;
+            result.buffer = std::move(*buffer);
+            result.buffer.resize(static_cast<size_t>(received));
+            if (callback)
+                callback(result);
+            else
+                close_descriptors(result.descriptors);
+            return true;
+        }
+
+        bool unix_local_connection_impl::async_write_descriptors(write_request& request, const std::vector<int>& descriptors)
+        {
+            SRV_ASSERT(is_connected());
+            SRV_ASSERT(!request.buffer.empty(), "Descriptors are sent with data only");
+            SRV_ASSERT(!descriptors.empty() && descriptors.size() <= max_descriptors);
+
+            // Duplicates are closed when request has been sent
+            // (kernel holds own references)
+            descriptors_type holder { new std::vector<int>, [](std::vector<int>* pdescriptors) {
+                                         close_descriptors(*pdescriptors);
+                                         delete pdescriptors;
+                                     } };
+            for (auto fd : descriptors)
+            {
+                int copy = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+                SRV_ASSERT(copy >= 0, std::strerror(errno));
+                holder->push_back(copy);
+            }
+
+            // It is queued after pending writes of this socket
+            queue_write(request, std::move(holder));
+            return true;
+        }
+
     } // namespace transport_layer
 } // namespace network
 } // namespace server_lib
@@ -14,10 +14,32 @@ namespace network {
         {
         public:
             unix_local_connection_impl(const std::shared_ptr<boost::asio::io_service>& io_service,
-                                       size_t chunk_size, uint64_t id = 0);
+                                       const read_options& options, uint64_t id = 0, bool seqpacket = false);
+
+            bool is_message_oriented() const override
+            {
+                return _seqpacket;
+            }
+
+            // recvmsg is used to accept descriptors
+            void async_read(read_request& request) override;
+
+            bool async_write_descriptors(write_request& request, const std::vector<int>& descriptors) override;
+
+            // Open SOCK_SEQPACKET socket before connect
+            void open_seqpacket();
 
             void configurate(const std::string& remote_endpoint) override;
             void close_socket(socket_type&) override;
+
+        private:
+            using buffer_type = std::shared_ptr<pooled_buffer>;
+
+            // Return 'false' if socket has no data yet
+            bool try_read(const buffer_type& buffer, const async_read_callback_type& callback);
+            void wait_read(const buffer_type& buffer, async_read_callback_type&& callback);
+
+            const bool _seqpacket = false;
         };
     } // namespace transport_layer
 } // namespace network
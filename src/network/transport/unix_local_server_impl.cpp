@@ -3,11 +3,19 @@
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 
 #include "unix_local_connection_impl.h"
+#include "shm_connection_impl.h"
+#include "../worker_options.h"
 
 #include <server_lib/asserts.h>
 
 #include <boost/filesystem.hpp>
 
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
 #include "../../logger_set_internal_group.h"
 
 namespace server_lib {
@@ -57,15 +65,19 @@ namespace network {
 
                 _workers = std::make_unique<event_pool>(_config->worker_threads());
                 _workers->change_pool_name(_config->worker_name());
+                apply_worker_options(*_workers, *_config);
                 auto start_ = [this, start_callback]() {
                     try
                     {
                         SRV_LOGC_TRACE("starting");
 
                         using stream_protocol = asio::local::stream_protocol;
-                        _acceptor = std::unique_ptr<stream_protocol::acceptor>(new stream_protocol::acceptor(
-                            *_workers->service(),
-                            stream_protocol::endpoint(_config->socket_file())));
+                        if (_config->seqpacket())
+                            _acceptor = create_seqpacket_acceptor();
+                        else
+                            _acceptor = std::unique_ptr<stream_protocol::acceptor>(new stream_protocol::acceptor(
+                                *_workers->service(),
+                                stream_protocol::endpoint(_config->socket_file())));
                         accept();
 
                         SRV_LOGC_TRACE("started");
@@ -92,13 +104,37 @@ namespace network {
             return false;
         }
 
+        std::unique_ptr<asio::local::stream_protocol::acceptor> unix_local_server_impl::create_seqpacket_acceptor()
+        {
+            using stream_protocol = asio::local::stream_protocol;
+
+            int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            SRV_ASSERT(fd >= 0, std::strerror(errno));
+
+            // Asio doesn't check socket type. Accepted sockets
+            // inherit SOCK_SEQPACKET
+            auto acceptor = std::make_unique<stream_protocol::acceptor>(*_workers->service());
+            error_code ec;
+            acceptor->assign(stream_protocol(), fd, ec);
+            if (ec)
+            {
+                ::close(fd);
+                SRV_ERROR(ec.message());
+            }
+            acceptor->bind(stream_protocol::endpoint(_config->socket_file()));
+            acceptor->listen();
+            return acceptor;
+        }
+
         void unix_local_server_impl::accept()
         {
             SRV_ASSERT(_config);
 
-            auto connection = std::make_shared<unix_local_connection_impl>(_workers->service(),
-                                                                           _config->chunk_size(),
-                                                                           std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1));
+            auto connection = std::allocate_shared<unix_local_connection_impl>(pool_allocator<unix_local_connection_impl>(),
+                                                                               _workers->service(),
+                                                                               make_read_options(*_config),
+                                                                               std::atomic_fetch_add<uint64_t>(&_next_connection_id, 1),
+                                                                               _config->seqpacket());
 
             auto scope_lock = [connection]() -> bool {
                 return connection->handler_runner.continue_lock().operator bool();
@@ -120,7 +156,11 @@ namespace network {
 
                         SRV_LOGC_TRACE("connected");
 
-                        if (_new_connection_callback)
+                        if (_config->shared_memory())
+                            shm_connection_impl::accept(_workers->service(), connection,
+                                                        _config->shared_memory_spin(),
+                                                        _new_connection_callback, _fail_callback);
+                        else if (_new_connection_callback)
                             _new_connection_callback(connection);
                     }
                     else if (ec != asio::error::operation_aborted && _fail_callback)
@@ -43,6 +43,7 @@ namespace network {
             void post(common_callback_type&& callback) override;
 
         private:
+            std::unique_ptr<boost::asio::local::stream_protocol::acceptor> create_seqpacket_acceptor();
             void accept();
             void stop_impl();
 
@@ -0,0 +1,363 @@
+#include "uring.h"
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include <server_lib/asserts.h>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace {
+            int io_uring_setup(unsigned entries, io_uring_params* params)
+            {
+                return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+            }
+
+            int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+            {
+                return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+            }
+
+            int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count)
+            {
+                return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+            }
+
+            template <typename T>
+            T* ring_field(void* base, unsigned offset)
+            {
+                return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+            }
+        } // namespace
+
+        uring::uring(unsigned entries)
+        {
+            // Completions of multishot operations outnumber submissions
+            _params.flags = IORING_SETUP_CQSIZE;
+            _params.cq_entries = entries * 4;
+
+            _fd = io_uring_setup(entries, &_params);
+            SRV_ASSERT(_fd >= 0, std::string { "io_uring_setup: " } + std::strerror(errno));
+
+            try
+            {
+                _sq_size = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+                _cq_size = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+                if (_params.features & IORING_FEAT_SINGLE_MMAP)
+                    _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+
+                _sq_ptr = ::mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+                SRV_ASSERT(_sq_ptr != MAP_FAILED, std::strerror(errno));
+                if (_params.features & IORING_FEAT_SINGLE_MMAP)
+                {
+                    _cq_ptr = _sq_ptr;
+                }
+                else
+                {
+                    _cq_ptr = ::mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+                    SRV_ASSERT(_cq_ptr != MAP_FAILED, std::strerror(errno));
+                }
+
+                _sqes_size = _params.sq_entries * sizeof(io_uring_sqe);
+                auto* sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+                SRV_ASSERT(sqes != MAP_FAILED, std::strerror(errno));
+                _sqes = static_cast<io_uring_sqe*>(sqes);
+
+                _sq_head = ring_field<unsigned>(_sq_ptr, _params.sq_off.head);
+                _sq_tail = ring_field<unsigned>(_sq_ptr, _params.sq_off.tail);
+                _sq_mask = *ring_field<unsigned>(_sq_ptr, _params.sq_off.ring_mask);
+                _sq_entries = *ring_field<unsigned>(_sq_ptr, _params.sq_off.ring_entries);
+                _sq_flags = ring_field<unsigned>(_sq_ptr, _params.sq_off.flags);
+                _sq_array = ring_field<unsigned>(_sq_ptr, _params.sq_off.array);
+                _sqe_tail = *_sq_tail;
+
+                // SQE index is the same as SQ index
+                for (unsigned ci = 0; ci < _sq_entries; ++ci)
+                    _sq_array[ci] = ci;
+
+                _cq_head = ring_field<unsigned>(_cq_ptr, _params.cq_off.head);
+                _cq_tail = ring_field<unsigned>(_cq_ptr, _params.cq_off.tail);
+                _cq_mask = *ring_field<unsigned>(_cq_ptr, _params.cq_off.ring_mask);
+                _cqes = ring_field<io_uring_cqe>(_cq_ptr, _params.cq_off.cqes);
+            }
+            catch (...)
+            {
+                unmap();
+                ::close(_fd);
+                throw;
+            }
+        }
+
+        uring::~uring()
+        {
+            unmap();
+            if (_fd >= 0)
+                ::close(_fd);
+        }
+
+        void uring::unmap()
+        {
+            if (_sqes && reinterpret_cast<void*>(_sqes) != MAP_FAILED)
+                ::munmap(_sqes, _sqes_size);
+            if (_cq_ptr && _cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr)
+                ::munmap(_cq_ptr, _cq_size);
+            if (_sq_ptr && _sq_ptr != MAP_FAILED)
+                ::munmap(_sq_ptr, _sq_size);
+            _sqes = nullptr;
+            _cq_ptr = _sq_ptr = nullptr;
+        }
+
+        bool uring::supported()
+        {
+            static const bool result = []() {
+                try
+                {
+                    uring ring(4);
+
+                    constexpr unsigned max_ops = 256;
+                    std::vector<char> buffer(sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op));
+                    auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+                    if (io_uring_register(ring.fd(), IORING_REGISTER_PROBE, probe, max_ops) < 0)
+                        return false;
+
+                    // SEND_ZC comes with multishot recv (Linux 6.0)
+                    for (unsigned op : { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SENDMSG,
+                                         IORING_OP_CONNECT, IORING_OP_LINK_TIMEOUT, IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC })
+                    {
+                        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                            return false;
+                    }
+
+                    // Provided buffer ring (Linux 5.19)
+                    uring_buffer_ring buffers(ring, 0, 1, 64);
+                    return true;
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_TRACE(e.what());
+                }
+                return false;
+            }();
+            return result;
+        }
+
+        bool uring::send_fixed_supported()
+        {
+            static const bool result = []() {
+                if (!supported())
+                    return false;
+
+                int fds[2];
+                if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+                    return false;
+
+                bool result = false;
+                try
+                {
+                    uring ring(4);
+
+                    char buffer[1] = {};
+                    ring.register_buffers({ iovec { buffer, sizeof(buffer) } });
+
+                    // Older kernels reject unknown flag by EINVAL
+                    auto* sqe = ring.get_sqe();
+                    sqe->opcode = IORING_OP_SEND;
+                    sqe->fd = fds[0];
+                    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+                    sqe->len = sizeof(buffer);
+                    sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+                    sqe->buf_index = 0;
+                    ring.submit();
+
+                    io_uring_cqe cqe;
+                    ring.wait(&cqe, 1);
+                    result = cqe.res == static_cast<int>(sizeof(buffer));
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_TRACE(e.what());
+                }
+
+                ::close(fds[0]);
+                ::close(fds[1]);
+                return result;
+            }();
+            return result;
+        }
+
+        io_uring_sqe* uring::get_sqe()
+        {
+            auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+            if (_sqe_tail - head >= _sq_entries)
+                return nullptr;
+
+            auto* sqe = &_sqes[_sqe_tail & _sq_mask];
+            ++_sqe_tail;
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        unsigned uring::pending() const
+        {
+            return _sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        }
+
+        int uring::submit()
+        {
+            __atomic_store_n(_sq_tail, _sqe_tail, __ATOMIC_RELEASE);
+
+            // Not consumed SQEs (including ones of failed attempts)
+            auto to_submit = pending();
+            if (!to_submit)
+                return 0;
+
+            int result = 0;
+            do
+            {
+                result = io_uring_enter(_fd, to_submit, 0, 0);
+            } while (result < 0 && errno == EINTR);
+
+            if (result < 0)
+            {
+                // Completion queue is overflowed. SQEs are submitted later
+                SRV_ASSERT(errno == EAGAIN || errno == EBUSY, std::string { "io_uring_enter: " } + std::strerror(errno));
+                return 0;
+            }
+            return result;
+        }
+
+        size_t uring::peek(io_uring_cqe* cqes, size_t count)
+        {
+            auto head = *_cq_head;
+            auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail && (__atomic_load_n(_sq_flags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW))
+            {
+                // Flush completions that kernel keeps
+                io_uring_enter(_fd, 0, 0, IORING_ENTER_GETEVENTS);
+                tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            }
+
+            auto result = std::min<size_t>(tail - head, count);
+            for (size_t ci = 0; ci < result; ++ci)
+                cqes[ci] = _cqes[(head + ci) & _cq_mask];
+            __atomic_store_n(_cq_head, head + static_cast<unsigned>(result), __ATOMIC_RELEASE);
+            return result;
+        }
+
+        size_t uring::wait(io_uring_cqe* cqes, size_t count)
+        {
+            for (;;)
+            {
+                auto result = peek(cqes, count);
+                if (result > 0)
+                    return result;
+
+                auto entered = io_uring_enter(_fd, 0, 1, IORING_ENTER_GETEVENTS);
+                SRV_ASSERT(entered >= 0 || errno == EINTR, std::string { "io_uring_enter: " } + std::strerror(errno));
+            }
+        }
+
+        void uring::register_buffers(const std::vector<iovec>& buffers)
+        {
+            SRV_ASSERT(io_uring_register(_fd, IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) == 0,
+                       std::string { "IORING_REGISTER_BUFFERS: " } + std::strerror(errno));
+        }
+
+        void uring::register_eventfd(int fd)
+        {
+            SRV_ASSERT(io_uring_register(_fd, IORING_REGISTER_EVENTFD, &fd, 1) == 0,
+                       std::string { "IORING_REGISTER_EVENTFD: " } + std::strerror(errno));
+        }
+
+        void uring::register_buffer_ring(io_uring_buf_ring* ring, unsigned entries, uint16_t group)
+        {
+            io_uring_buf_reg reg {};
+            reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+            reg.ring_entries = entries;
+            reg.bgid = group;
+            SRV_ASSERT(io_uring_register(_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0,
+                       std::string { "IORING_REGISTER_PBUF_RING: " } + std::strerror(errno));
+        }
+
+        void uring::unregister_buffer_ring(uint16_t group)
+        {
+            io_uring_buf_reg reg {};
+            reg.bgid = group;
+            io_uring_register(_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+
+        uring_buffer_ring::uring_buffer_ring(uring& ring, uint16_t group, unsigned count, size_t buffer_size)
+            : _uring(ring)
+            , _group(group)
+            , _count(count)
+            , _buffer_size(buffer_size)
+        {
+            SRV_ASSERT(count > 0 && count <= 32768 && (count & (count - 1)) == 0, "Count of buffers should be power of 2");
+            SRV_ASSERT(buffer_size > 0);
+
+            // Ring should be page aligned
+            auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            _ring_size = (count * sizeof(io_uring_buf) + page_size - 1) / page_size * page_size;
+            auto* memory = ::mmap(nullptr, _ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            SRV_ASSERT(memory != MAP_FAILED, std::strerror(errno));
+            _ring = static_cast<io_uring_buf_ring*>(memory);
+
+            _buffers.resize(count * buffer_size);
+
+            try
+            {
+                _uring.register_buffer_ring(_ring, count, group);
+            }
+            catch (...)
+            {
+                ::munmap(_ring, _ring_size);
+                throw;
+            }
+
+            for (unsigned ci = 0; ci < count; ++ci)
+                add(static_cast<uint16_t>(ci), ci);
+            _tail = static_cast<uint16_t>(count);
+            __atomic_store_n(&_ring->tail, _tail, __ATOMIC_RELEASE);
+        }
+
+        uring_buffer_ring::~uring_buffer_ring()
+        {
+            _uring.unregister_buffer_ring(_group);
+            ::munmap(_ring, _ring_size);
+        }
+
+        void uring_buffer_ring::recycle(uint16_t id)
+        {
+            add(id, 0);
+            ++_tail;
+            __atomic_store_n(&_ring->tail, _tail, __ATOMIC_RELEASE);
+        }
+
+        void uring_buffer_ring::add(uint16_t id, unsigned offset)
+        {
+            // Not '_ring->bufs'. Empty struct of __DECLARE_FLEX_ARRAY
+            // has nonzero size in C++ so it shifts array
+            auto* entries = reinterpret_cast<io_uring_buf*>(_ring);
+            auto& entry = entries[(_tail + offset) & (_count - 1)];
+            entry.addr = reinterpret_cast<uint64_t>(buffer(id));
+            entry.len = static_cast<uint32_t>(_buffer_size);
+            entry.bid = id;
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// Multishot recv and provided buffer rings are required
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+#define SERVER_LIB_IO_URING
+#endif
+#endif
+#endif
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * Minimal io_uring ring (by system calls without liburing).
+         * It is not thread safe
+         */
+        class uring
+        {
+        public:
+            explicit uring(unsigned entries);
+            ~uring();
+
+            uring(const uring&) = delete;
+            uring& operator=(const uring&) = delete;
+
+            /**
+             * Check if kernel supports operations
+             * that are used by transport
+             */
+            static bool supported();
+
+            /**
+             * Check if registered buffers could be sent
+             * (IORING_RECVSEND_FIXED_BUF, Linux 6.10)
+             */
+            static bool send_fixed_supported();
+
+            int fd() const
+            {
+                return _fd;
+            }
+
+            // Return nullptr if submission queue is full
+            io_uring_sqe* get_sqe();
+
+            // Prepared SQEs that are not consumed by kernel yet
+            unsigned pending() const;
+
+            // Free SQEs
+            unsigned space() const
+            {
+                return _sq_entries - pending();
+            }
+
+            // Return number of submitted SQEs
+            int submit();
+
+            // Copy completions. Return number of copied CQEs
+            size_t peek(io_uring_cqe* cqes, size_t count);
+
+            // Block until there is at least one completion
+            size_t wait(io_uring_cqe* cqes, size_t count);
+
+            void register_buffers(const std::vector<iovec>& buffers);
+
+            // Signal eventfd on every completion
+            void register_eventfd(int fd);
+
+            void register_buffer_ring(io_uring_buf_ring* ring, unsigned entries, uint16_t group);
+            void unregister_buffer_ring(uint16_t group);
+
+        private:
+            void unmap();
+
+            int _fd = -1;
+            io_uring_params _params {};
+
+            void* _sq_ptr = nullptr;
+            size_t _sq_size = 0;
+            void* _cq_ptr = nullptr;
+            size_t _cq_size = 0;
+            io_uring_sqe* _sqes = nullptr;
+            size_t _sqes_size = 0;
+
+            unsigned* _sq_head = nullptr;
+            unsigned* _sq_tail = nullptr;
+            unsigned _sq_mask = 0;
+            unsigned _sq_entries = 0;
+            unsigned* _sq_flags = nullptr;
+            unsigned* _sq_array = nullptr;
+            unsigned _sqe_tail = 0;
+
+            unsigned* _cq_head = nullptr;
+            unsigned* _cq_tail = nullptr;
+            unsigned _cq_mask = 0;
+            io_uring_cqe* _cqes = nullptr;
+        };
+
+        /**
+         * Buffers that kernel picks for receiving
+         * (IORING_REGISTER_PBUF_RING)
+         */
+        class uring_buffer_ring
+        {
+        public:
+            uring_buffer_ring(uring& ring, uint16_t group, unsigned count, size_t buffer_size);
+            ~uring_buffer_ring();
+
+            uring_buffer_ring(const uring_buffer_ring&) = delete;
+            uring_buffer_ring& operator=(const uring_buffer_ring&) = delete;
+
+            uint16_t group() const
+            {
+                return _group;
+            }
+
+            const char* buffer(uint16_t id) const
+            {
+                return _buffers.data() + static_cast<size_t>(id) * _buffer_size;
+            }
+
+            // Return buffer to kernel
+            void recycle(uint16_t id);
+
+        private:
+            void add(uint16_t id, unsigned offset);
+
+            uring& _uring;
+            const uint16_t _group;
+            const unsigned _count;
+            const size_t _buffer_size;
+            io_uring_buf_ring* _ring = nullptr;
+            size_t _ring_size = 0;
+            std::vector<char> _buffers;
+            uint16_t _tail = 0;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
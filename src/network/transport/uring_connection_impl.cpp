@@ -0,0 +1,363 @@
+#include "uring_connection_impl.h"
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include "../pooled_handler.h"
+
+#include <server_lib/asserts.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace {
+            // Queued buffers that are sent together
+            constexpr size_t max_send_buffers = 64;
+        } // namespace
+
+        uring_connection_impl::uring_connection_impl(const std::shared_ptr<uring_service>& service,
+                                                     int fd,
+                                                     uint64_t id,
+                                                     const std::string& remote_endpoint)
+            : _service(service)
+            , _fd(fd)
+            , _id(id)
+            , _remote_endpoint(remote_endpoint)
+        {
+            SRV_ASSERT(_service);
+            SRV_ASSERT(_fd >= 0);
+
+            int no_delay = 1;
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        }
+
+        uring_connection_impl::~uring_connection_impl()
+        {
+            if (_fixed_buffer >= 0)
+                _service->release_fixed_buffer(_fixed_buffer);
+            ::close(_fd);
+        }
+
+        void uring_connection_impl::start()
+        {
+            receive();
+        }
+
+        void uring_connection_impl::disconnect()
+        {
+            if (!_connected.exchange(false))
+                return;
+
+            auto self = shared_from_this();
+
+            // Pending operations are completed with errors
+            ::shutdown(_fd, SHUT_RDWR);
+
+            std::unique_lock<std::mutex> lock(_disconnect_mutex);
+            auto disconnection_callbacks = _disconnection_callbacks;
+            lock.unlock();
+            for (auto it = disconnection_callbacks.rbegin(); it != disconnection_callbacks.rend(); ++it)
+            {
+                lock.lock();
+                bool cleared = _disconnection_callbacks.empty();
+                lock.unlock();
+                if (cleared)
+                    break;
+                auto callback = *it;
+                callback(_id);
+            }
+
+            std::lock_guard<std::mutex> read_lock(_read_mutex);
+            _received.clear();
+            _read_callback = nullptr;
+        }
+
+        void uring_connection_impl::set_disconnect_handler(const disconnect_callback_type& callback)
+        {
+            std::lock_guard<std::mutex> lock(_disconnect_mutex);
+            if (callback)
+            {
+                _disconnection_callbacks.push_back(callback);
+            }
+            else
+            {
+                _disconnection_callbacks.clear();
+            }
+        }
+
+        void uring_connection_impl::async_read(read_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            std::unique_lock<std::mutex> lock(_read_mutex);
+            SRV_ASSERT(!_read_callback, "Read is in progress");
+            if (_received.empty())
+            {
+                _read_callback = std::move(request.async_read_callback);
+                return;
+            }
+
+            auto buffer = std::move(_received.front());
+            _received.pop_front();
+            lock.unlock();
+
+            // Callback should not be called inside async_read
+            auto self = shared_from_this();
+            _service->service()->post(make_pooled_handler([self, buffer = std::move(buffer), callback = std::move(request.async_read_callback)]() mutable {
+                try
+                {
+                    self->deliver(std::move(buffer), std::move(callback));
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_ERROR(e.what());
+                    self->disconnect();
+                }
+            }));
+        }
+
+        void uring_connection_impl::receive()
+        {
+            auto self = shared_from_this();
+            auto fd = _fd;
+            auto group = _service->buffer_group();
+            _service->submit(make_uring_operation([self](int result, unsigned flags) {
+                                 self->on_receive(result, flags);
+                             }),
+                             [fd, group](io_uring_sqe& sqe) {
+                                 sqe.opcode = IORING_OP_RECV;
+                                 sqe.fd = fd;
+                                 sqe.ioprio = IORING_RECV_MULTISHOT;
+                                 sqe.flags = IOSQE_BUFFER_SELECT;
+                                 sqe.buf_group = group;
+                             });
+        }
+
+        void uring_connection_impl::on_receive(int result, unsigned flags)
+        {
+            if (result > 0)
+            {
+                auto buffer = _service->take_buffer(flags, static_cast<size_t>(result));
+
+                // Multishot recv is stopped by kernel (completion queue overflow)
+                if (!(flags & IORING_CQE_F_MORE) && is_connected())
+                    receive();
+
+                std::unique_lock<std::mutex> lock(_read_mutex);
+                if (!is_connected())
+                    return;
+                if (!_read_callback)
+                {
+                    _received.emplace_back(std::move(buffer));
+                    return;
+                }
+
+                auto callback = std::move(_read_callback);
+                _read_callback = nullptr;
+                lock.unlock();
+
+                deliver(std::move(buffer), std::move(callback));
+                return;
+            }
+
+            if (result == -ENOBUFS)
+            {
+                // All provided buffers were in use. They are returned
+                // after copying so receiving could be continued
+                if (is_connected())
+                    receive();
+                return;
+            }
+
+            if (result < 0 && result != -ECANCELED)
+            {
+                SRV_LOGC_TRACE("recv: " << std::strerror(-result));
+            }
+
+            disconnect();
+        }
+
+        void uring_connection_impl::deliver(pooled_buffer&& buffer, async_read_callback_type&& callback)
+        {
+            if (!is_connected() || !callback)
+                return;
+
+            read_result result;
+            result.success = true;
+            result.buffer = std::move(buffer);
+            callback(result);
+        }
+
+        void uring_connection_impl::async_write(write_request& request)
+        {
+            SRV_ASSERT(is_connected());
+
+            {
+                std::lock_guard<std::mutex> lock(_write_mutex);
+                _write_queue.emplace_back(std::move(request));
+                if (_writing)
+                    return;
+                _writing = true;
+            }
+
+            write_next();
+        }
+
+        void uring_connection_impl::write_next()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_write_mutex);
+                if (_write_queue.empty() || !is_connected())
+                {
+                    _write_queue.clear();
+                    _writing = false;
+                    return;
+                }
+
+                _sending.clear();
+                _sending_size = 0;
+                _sent = 0;
+                while (!_write_queue.empty() && _sending.size() < max_send_buffers)
+                {
+                    _sending_size += _write_queue.front().buffer.size();
+                    _sending.emplace_back(std::move(_write_queue.front()));
+                    _write_queue.pop_front();
+                }
+            }
+
+            if (_sending_size <= _service->buffer_size())
+                _fixed_buffer = _service->acquire_fixed_buffer();
+
+            if (_fixed_buffer >= 0)
+            {
+                auto* data = _service->fixed_buffer(_fixed_buffer);
+                for (auto&& request : _sending)
+                {
+                    std::memcpy(data, request.buffer.data(), request.buffer.size());
+                    data += request.buffer.size();
+                }
+            }
+            else
+            {
+                _iovecs.clear();
+                for (auto&& request : _sending)
+                {
+                    if (!request.buffer.empty())
+                        _iovecs.push_back(iovec { request.buffer.data(), request.buffer.size() });
+                }
+            }
+
+            send();
+        }
+
+        void uring_connection_impl::send()
+        {
+            auto self = shared_from_this();
+            auto op = make_uring_operation([self](int result, unsigned) {
+                self->on_written(result);
+            });
+
+            auto fd = _fd;
+            bool submitted = false;
+            if (_fixed_buffer >= 0)
+            {
+                auto* data = _service->fixed_buffer(_fixed_buffer) + _sent;
+                auto size = static_cast<uint32_t>(_sending_size - _sent);
+                auto index = static_cast<uint16_t>(_fixed_buffer);
+                submitted = _service->submit(op, [fd, data, size, index](io_uring_sqe& sqe) {
+                    sqe.opcode = IORING_OP_SEND;
+                    sqe.fd = fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(data);
+                    sqe.len = size;
+                    sqe.msg_flags = MSG_NOSIGNAL;
+                    sqe.ioprio = IORING_RECVSEND_FIXED_BUF;
+                    sqe.buf_index = index;
+                });
+            }
+            else
+            {
+                _message = {};
+                _message.msg_iov = _iovecs.data();
+                _message.msg_iovlen = _iovecs.size();
+                auto* message = &_message;
+                submitted = _service->submit(op, [fd, message](io_uring_sqe& sqe) {
+                    sqe.opcode = IORING_OP_SENDMSG;
+                    sqe.fd = fd;
+                    sqe.addr = reinterpret_cast<uint64_t>(message);
+                    sqe.len = 1;
+                    sqe.msg_flags = MSG_NOSIGNAL;
+                });
+            }
+
+            if (!submitted)
+                on_written(-ECANCELED);
+        }
+
+        void uring_connection_impl::on_written(int result)
+        {
+            if (result > 0)
+            {
+                _sent += static_cast<size_t>(result);
+                if (_sent < _sending_size && is_connected())
+                {
+                    // Partial send
+                    if (_fixed_buffer < 0)
+                    {
+                        auto skip = static_cast<size_t>(result);
+                        auto it = _iovecs.begin();
+                        for (; it != _iovecs.end() && skip >= it->iov_len; ++it)
+                            skip -= it->iov_len;
+                        _iovecs.erase(_iovecs.begin(), it);
+                        _iovecs.front().iov_base = static_cast<char*>(_iovecs.front().iov_base) + skip;
+                        _iovecs.front().iov_len -= skip;
+                    }
+                    send();
+                    return;
+                }
+            }
+
+            bool success = result >= 0 && _sent == _sending_size;
+
+            if (_fixed_buffer >= 0)
+            {
+                _service->release_fixed_buffer(_fixed_buffer);
+                _fixed_buffer = -1;
+            }
+            _iovecs.clear();
+
+            std::vector<write_request> sent;
+            sent.swap(_sending);
+            for (auto&& request : sent)
+            {
+                if (!request.async_write_callback)
+                    continue;
+                write_result write_result = { success, success ? request.buffer.size() : 0 };
+                request.async_write_callback(write_result);
+            }
+
+            if (!success)
+            {
+                if (result < 0 && result != -ECANCELED)
+                {
+                    SRV_LOGC_TRACE("send: " << std::strerror(-result));
+                }
+                disconnect();
+            }
+
+            write_next();
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
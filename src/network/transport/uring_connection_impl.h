@@ -0,0 +1,108 @@
+#pragma once
+
+#include "uring_service.h"
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include "connection_impl_i.h"
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * TCP connection driven by io_uring. It receives by multishot
+         * recv into provided buffers and sends queued buffers
+         * together (from registered buffer if they fit it)
+         */
+        class uring_connection_impl : public __connection_impl_i,
+                                      public std::enable_shared_from_this<uring_connection_impl>
+        {
+        public:
+            /**
+             * \param fd - Connected socket. Connection owns it
+             */
+            uring_connection_impl(const std::shared_ptr<uring_service>& service,
+                                  int fd,
+                                  uint64_t id,
+                                  const std::string& remote_endpoint);
+            ~uring_connection_impl() override;
+
+            void start();
+
+            uint64_t id() const override
+            {
+                return _id;
+            }
+
+            void disconnect() override;
+
+            bool is_connected() const override
+            {
+                return _connected;
+            }
+
+            std::string remote_endpoint() const override
+            {
+                return _remote_endpoint;
+            }
+
+            size_t chunk_size() const override
+            {
+                return _service->buffer_size();
+            }
+
+            void set_disconnect_handler(const disconnect_callback_type& callback) override;
+
+            void async_read(read_request& request) override;
+
+            void async_write(write_request& request) override;
+
+        private:
+            void receive();
+            void on_receive(int result, unsigned flags);
+            void deliver(pooled_buffer&& buffer, async_read_callback_type&& callback);
+
+            void write_next();
+            void send();
+            void on_written(int result);
+
+            std::shared_ptr<uring_service> _service;
+            const int _fd;
+            const uint64_t _id;
+            const std::string _remote_endpoint;
+
+            std::atomic_bool _connected { true };
+
+            std::mutex _read_mutex;
+            // Chunks received before read request
+            std::deque<pooled_buffer> _received;
+            async_read_callback_type _read_callback;
+
+            std::mutex _write_mutex;
+            std::deque<write_request> _write_queue;
+            bool _writing = false;
+
+            // Send in progress (one at a time)
+            std::vector<write_request> _sending;
+            std::vector<iovec> _iovecs;
+            msghdr _message {};
+            int _fixed_buffer = -1;
+            size_t _sending_size = 0;
+            size_t _sent = 0;
+
+            std::mutex _disconnect_mutex;
+            std::vector<disconnect_callback_type> _disconnection_callbacks;
+        };
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
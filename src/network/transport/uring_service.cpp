@@ -0,0 +1,279 @@
+#include "uring_service.h"
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include "../pooled_handler.h"
+
+#include <server_lib/asserts.h>
+
+#include <sys/eventfd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "../../logger_set_internal_group.h"
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        namespace asio = boost::asio;
+        using error_code = boost::system::error_code;
+
+        namespace {
+            constexpr uint16_t provided_buffer_group = 0;
+
+            // Completions to handle per ring lock
+            constexpr size_t max_completions = 64;
+        } // namespace
+
+        uring_service::uring_service(const std::shared_ptr<asio::io_service>& service,
+                                     unsigned entries,
+                                     unsigned buffers,
+                                     size_t buffer_size)
+            : _service(service)
+            , _buffer_size(buffer_size)
+            , _events(*service)
+        {
+            SRV_ASSERT(_service);
+
+            _ring = std::make_unique<uring>(entries);
+            _provided_buffers = std::make_unique<uring_buffer_ring>(*_ring, provided_buffer_group, buffers, buffer_size);
+
+            if (uring::send_fixed_supported())
+            {
+                auto count = std::max(1u, buffers / 4);
+                _fixed_buffers.resize(count * buffer_size);
+                std::vector<iovec> iovecs;
+                iovecs.reserve(count);
+                for (unsigned ci = 0; ci < count; ++ci)
+                    iovecs.push_back(iovec { fixed_buffer(static_cast<int>(ci)), buffer_size });
+                try
+                {
+                    // Pinned memory is limited by RLIMIT_MEMLOCK
+                    _ring->register_buffers(iovecs);
+                    for (unsigned ci = count; ci > 0; --ci)
+                        _free_fixed_buffers.push_back(static_cast<int>(ci - 1));
+                }
+                catch (const std::exception& e)
+                {
+                    SRV_LOGC_WARN("Can't register io_uring buffers: " << e.what());
+                    _fixed_buffers.clear();
+                }
+            }
+
+            int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            SRV_ASSERT(fd >= 0, std::string { "eventfd: " } + std::strerror(errno));
+            _events.assign(fd);
+            _ring->register_eventfd(fd);
+        }
+
+        uring_service::~uring_service()
+        {
+            try
+            {
+                shutdown();
+            }
+            catch (const std::exception& e)
+            {
+                SRV_LOGC_ERROR(e.what());
+            }
+        }
+
+        void uring_service::start()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                SRV_ASSERT(_ring, "Service is shut down");
+                _running = true;
+            }
+            read_events();
+        }
+
+        void uring_service::shutdown()
+        {
+            std::unordered_map<operation*, operation_ptr> operations;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_ring)
+                    return;
+                _running = false;
+
+                // Kernel should not touch buffers after they are freed
+                if (!_operations.empty())
+                {
+                    reserve(1);
+                    auto* sqe = _ring->get_sqe();
+                    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                    sqe->fd = -1;
+                    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+                    sqe->user_data = 0;
+                    _ring->submit();
+
+                    io_uring_cqe cqes[max_completions];
+                    while (!_operations.empty())
+                    {
+                        auto count = _ring->wait(cqes, max_completions);
+                        for (size_t ci = 0; ci < count; ++ci)
+                        {
+                            if (!(cqes[ci].flags & IORING_CQE_F_MORE))
+                                _operations.erase(reinterpret_cast<operation*>(cqes[ci].user_data));
+                        }
+                    }
+                }
+                operations.swap(_operations);
+
+                _provided_buffers.reset();
+                _ring.reset();
+            }
+
+            error_code ec;
+            _events.close(ec);
+        }
+
+        uint16_t uring_service::buffer_group() const
+        {
+            return provided_buffer_group;
+        }
+
+        pooled_buffer uring_service::take_buffer(unsigned flags, size_t size)
+        {
+            SRV_ASSERT(flags & IORING_CQE_F_BUFFER);
+            SRV_ASSERT(size <= _buffer_size);
+
+            auto id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            auto* data = _provided_buffers->buffer(id);
+            pooled_buffer result { data, data + size };
+            _provided_buffers->recycle(id);
+            return result;
+        }
+
+        int uring_service::acquire_fixed_buffer()
+        {
+            std::lock_guard<std::mutex> lock(_fixed_mutex);
+            if (_free_fixed_buffers.empty())
+                return -1;
+            auto index = _free_fixed_buffers.back();
+            _free_fixed_buffers.pop_back();
+            return index;
+        }
+
+        void uring_service::release_fixed_buffer(int index)
+        {
+            std::lock_guard<std::mutex> lock(_fixed_mutex);
+            _free_fixed_buffers.push_back(index);
+        }
+
+        void uring_service::reserve(size_t count)
+        {
+            if (_ring->space() < count)
+                _ring->submit();
+            SRV_ASSERT(_ring->space() >= count, "io_uring submission queue is full");
+        }
+
+        void uring_service::schedule_submit()
+        {
+            if (_submit_posted)
+                return;
+            _submit_posted = true;
+
+            auto self = shared_from_this();
+            _service->post(make_pooled_handler([self]() {
+                std::lock_guard<std::mutex> lock(self->_mutex);
+                self->_submit_posted = false;
+                if (self->_running)
+                    self->_ring->submit();
+            }));
+        }
+
+        void uring_service::read_events()
+        {
+            // Counter is reset by reading so event could not be lost
+            // between draining and waiting
+            auto self = shared_from_this();
+            _events.async_read_some(asio::buffer(&_events_count, sizeof(_events_count)),
+                                    make_pooled_handler([self](const error_code& ec, size_t) {
+                                        if (ec)
+                                        {
+                                            if (ec != asio::error::operation_aborted && ec != asio::error::bad_descriptor)
+                                            {
+                                                SRV_LOGC_ERROR("io_uring events: " << ec.message());
+                                            }
+                                            return;
+                                        }
+
+                                        self->drain();
+                                        self->read_events();
+                                    }));
+        }
+
+        void uring_service::drain()
+        {
+            struct completion
+            {
+                operation_ptr op;
+                int result = 0;
+                unsigned flags = 0;
+            };
+
+            io_uring_cqe cqes[max_completions];
+            completion completed[max_completions];
+            for (;;)
+            {
+                size_t count = 0;
+                size_t ready = 0;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (!_running)
+                        return;
+
+                    count = _ring->peek(cqes, max_completions);
+                    for (size_t ci = 0; ci < count; ++ci)
+                    {
+                        auto it = _operations.find(reinterpret_cast<operation*>(cqes[ci].user_data));
+                        if (it == _operations.end())
+                            continue;
+
+                        auto& item = completed[ready++];
+                        item.result = cqes[ci].res;
+                        item.flags = cqes[ci].flags;
+                        if (item.flags & IORING_CQE_F_MORE)
+                        {
+                            item.op = it->second;
+                        }
+                        else
+                        {
+                            item.op = std::move(it->second);
+                            _operations.erase(it);
+                        }
+                    }
+                }
+
+                // Operations could submit new ones
+                for (size_t ci = 0; ci < ready; ++ci)
+                {
+                    try
+                    {
+                        completed[ci].op->complete(completed[ci].result, completed[ci].flags);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        SRV_LOGC_ERROR(e.what());
+                    }
+                    completed[ci].op.reset();
+                }
+
+                if (count < max_completions)
+                    break;
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_running)
+                _ring->submit();
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "uring.h"
+
+#if defined(SERVER_LIB_IO_URING)
+
+#include <server_lib/buffer_pool.h>
+
+#include <boost/asio.hpp>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+    namespace transport_layer {
+
+        /**
+         * io_uring of one io_service. Completions are signaled
+         * by eventfd that is read by io_service so they are handled
+         * in its threads (one at a time). Submissions are collected
+         * and entered once per handler burst
+         */
+        class uring_service : public std::enable_shared_from_this<uring_service>
+        {
+        public:
+            struct operation
+            {
+                virtual ~operation() = default;
+
+                /**
+                 * \param result - cqe.res
+                 * \param flags - cqe.flags. Operation is kept
+                 * while IORING_CQE_F_MORE is set
+                 */
+                virtual void complete(int result, unsigned flags) = 0;
+            };
+
+            using operation_ptr = std::shared_ptr<operation>;
+
+            /**
+             * \param entries - Size of submission queue
+             * \param buffers - Count of provided (receive) buffers.
+             * Quarter of them is registered for sending
+             * \param buffer_size - Size of every buffer
+             */
+            uring_service(const std::shared_ptr<boost::asio::io_service>& service,
+                          unsigned entries,
+                          unsigned buffers,
+                          size_t buffer_size);
+            ~uring_service();
+
+            void start();
+
+            // Should be called when io_service is stopped
+            void shutdown();
+
+            const std::shared_ptr<boost::asio::io_service>& service() const
+            {
+                return _service;
+            }
+
+            /**
+             * Fill consecutive SQEs (by callbacks with io_uring_sqe& argument).
+             * Completion of the first one is passed to operation.
+             * Completions of others (linked) are ignored
+             *
+             * \return 'false' if service is shut down
+             */
+            template <typename... Prepare>
+            bool submit(const operation_ptr& op, Prepare&&... prepare)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_running)
+                    return false;
+
+                constexpr size_t count = sizeof...(Prepare);
+                reserve(count);
+
+                io_uring_sqe* sqes[count];
+                for (auto& sqe : sqes)
+                    sqe = _ring->get_sqe();
+
+                size_t index = 0;
+                int unpack[] = { (prepare(*sqes[index++]), 0)... };
+                (void)unpack;
+
+                sqes[0]->user_data = reinterpret_cast<uint64_t>(op.get());
+                for (index = 1; index < count; ++index)
+                    sqes[index]->user_data = 0;
+
+                _operations[op.get()] = op;
+                schedule_submit();
+                return true;
+            }
+
+            /**
+             * Buffer group for IOSQE_BUFFER_SELECT
+             */
+            uint16_t buffer_group() const;
+
+            /**
+             * Copy received data from provided buffer
+             * and return buffer to kernel
+             *
+             * \param flags - cqe.flags with IORING_CQE_F_BUFFER
+             */
+            pooled_buffer take_buffer(unsigned flags, size_t size);
+
+            /**
+             * Registered buffers to send
+             * (if uring::send_fixed_supported).
+             *
+             * \return index or -1 if all of them are used
+             */
+            int acquire_fixed_buffer();
+            void release_fixed_buffer(int index);
+
+            char* fixed_buffer(int index)
+            {
+                return _fixed_buffers.data() + static_cast<size_t>(index) * _buffer_size;
+            }
+
+            size_t buffer_size() const
+            {
+                return _buffer_size;
+            }
+
+        private:
+            void reserve(size_t count);
+            void schedule_submit();
+            void read_events();
+            void drain();
+
+            std::shared_ptr<boost::asio::io_service> _service;
+            const size_t _buffer_size;
+
+            std::mutex _mutex;
+            bool _running = false;
+            bool _submit_posted = false;
+            std::unique_ptr<uring> _ring;
+            std::unique_ptr<uring_buffer_ring> _provided_buffers;
+            std::unordered_map<operation*, operation_ptr> _operations;
+
+            // Completion events
+            boost::asio::posix::stream_descriptor _events;
+            uint64_t _events_count = 0;
+
+            std::vector<char> _fixed_buffers;
+            std::mutex _fixed_mutex;
+            std::vector<int> _free_fixed_buffers;
+        };
+
+        template <typename Callback>
+        class uring_callback_operation : public uring_service::operation
+        {
+        public:
+            explicit uring_callback_operation(Callback&& callback)
+                : _callback(std::move(callback))
+            {
+            }
+
+            void complete(int result, unsigned flags) override
+            {
+                _callback(result, flags);
+            }
+
+        private:
+            Callback _callback;
+        };
+
+        template <typename Callback>
+        uring_service::operation_ptr make_uring_operation(Callback callback)
+        {
+            return std::make_shared<uring_callback_operation<Callback>>(std::move(callback));
+        }
+
+    } // namespace transport_layer
+} // namespace network
+} // namespace server_lib
+
+#endif //SERVER_LIB_IO_URING
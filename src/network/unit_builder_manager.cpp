@@ -26,6 +26,7 @@ namespace network {
     unit_builder_manager::operator<<(const std::string& data)
     {
         _buffer += data;
+        _fed += data.size();
 
         while (build_unit())
             ;
@@ -36,6 +37,10 @@ namespace network {
     void unit_builder_manager::reset()
     {
         _buffer.clear();
+        _available_replies.clear();
+        _available_ends.clear();
+        if (_builder)
+            _builder->reset();
     }
 
     bool unit_builder_manager::build_unit()
@@ -50,6 +55,8 @@ namespace network {
         if (_builder->unit_ready())
         {
             _available_replies.push_back(_builder->get_unit());
+            // Builder removes bytes of unit from buffer
+            _available_ends.push_back(_fed - _buffer.size());
             _builder->reset();
 
             return true;
@@ -76,6 +83,14 @@ namespace network {
         SRV_ASSERT(receive_available(), "No available unit");
 
         _available_replies.pop_front();
+        _available_ends.pop_front();
+    }
+
+    uint64_t unit_builder_manager::front_end() const
+    {
+        SRV_ASSERT(receive_available(), "No available unit");
+
+        return _available_ends.front();
     }
 
     bool unit_builder_manager::receive_available() const
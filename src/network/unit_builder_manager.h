@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <stdexcept>
@@ -65,6 +66,22 @@ namespace network {
          */
         bool receive_available() const;
 
+        /**
+         * \return number of bytes passed by operator<<
+         *
+         */
+        uint64_t fed() const
+        {
+            return _fed;
+        }
+
+        /**
+         * \return number of bytes passed by operator<<
+         * up to the end of the first available unit
+         *
+         */
+        uint64_t front_end() const;
+
         /**
          * Reset the unit builder to its initial state (clear internal buffer and stages)
          *
@@ -98,6 +115,14 @@ namespace network {
          *
          */
         std::deque<unit> _available_replies;
+
+        /**
+         * Stream offsets of available replies ends
+         *
+         */
+        std::deque<uint64_t> _available_ends;
+
+        uint64_t _fed = 0;
     };
 
 } // namespace network
@@ -5,6 +5,7 @@
 #include <server_lib/network/web/web_client_config.h>
 
 #include "http_utility.h"
+#include "../worker_options.h"
 
 #include <limits>
 #include <mutex>
@@ -383,6 +384,7 @@ namespace network {
 
                     _workers = std::make_unique<event_pool>(_config.worker_threads());
                     _workers->change_pool_name(_config.worker_name());
+                    apply_worker_options(*_workers, _config);
 
                     auto start_ = [this, start_callback]() {
                         try
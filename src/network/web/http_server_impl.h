@@ -5,6 +5,10 @@
 #include <server_lib/network/web/web_server_config.h>
 
 #include "http_utility.h"
+#include "../network_counters.h"
+#include "../pooled_handler.h"
+#include "../socket_options.h"
+#include "../worker_options.h"
 
 #include <functional>
 #include <iostream>
@@ -55,6 +59,8 @@ namespace network {
             class __http_session;
 
         public:
+            class __http_request;
+
             class __http_response : public std::enable_shared_from_this<__http_response>,
                                     public std::ostream,
                                     public web_server_response_i
@@ -65,6 +71,7 @@ namespace network {
                 __http_response(std::shared_ptr<__http_session> session, long timeout_content)
                     : std::ostream(&_streambuf)
                     , _session(std::move(session))
+                    , _request(_session->request)
                     , _timeout_content(timeout_content)
                 {
                     SRV_LOGC_TRACE(__FUNCTION__);
@@ -127,10 +134,18 @@ namespace network {
                 {
                     _session->connection->set_timeout(_timeout_content);
                     auto self = this->shared_from_this(); // Keep Response instance alive through the following async_write
+                    auto& counters = *_session->connection->counters;
+                    auto queued = _streambuf.size();
+                    counters.queued_bytes.add(queued);
                     asio::async_write(*_session->connection->socket, _streambuf,
-                                      [self, callback](const error_code& ec, size_t /*bytes_transferred*/) {
+                                      make_pooled_handler([self, callback, queued](const error_code& ec, size_t bytes_transferred) {
                                           try
                                           {
+                                              auto& counters = *self->_session->connection->counters;
+                                              counters.queued_bytes.sub(queued);
+                                              counters.bytes_out.add(bytes_transferred);
+                                              counters.write_calls.add();
+
                                               self->_session->connection->cancel_timeout();
                                               auto lock = self->_session->connection->handler_runner->continue_lock();
                                               if (!lock)
@@ -142,7 +157,7 @@ namespace network {
                                           {
                                               SRV_LOGC_ERROR(e.what());
                                           }
-                                      });
+                                      }));
                 }
 
                 /// Write directly to stream buffer using std::ostream::write
@@ -206,14 +221,18 @@ namespace network {
                 asio::streambuf _streambuf;
 
                 std::shared_ptr<__http_session> _session;
+                // Request (and its arena) is alive while response exists
+                std::shared_ptr<__http_request> _request;
                 long _timeout_content;
             };
 
+            using request_streambuf = asio::basic_streambuf<arena_allocator<char>>;
+
             class __http_content : public std::istream
             {
                 friend class server_base_impl<config_type, socket_type>;
 
-                __http_content(asio::streambuf& streambuf)
+                __http_content(request_streambuf& streambuf)
                     : std::istream(&streambuf)
                     , _streambuf(streambuf)
                 {
@@ -247,7 +266,7 @@ namespace network {
                 }
 
             private:
-                asio::streambuf& _streambuf;
+                request_streambuf& _streambuf;
             };
 
             class __http_request : public web_request_i
@@ -258,11 +277,13 @@ namespace network {
 
                 __http_request(size_t max_request_streambuf_size,
                                std::shared_ptr<asio::ip::tcp::endpoint> remote_endpoint,
-                               uint64_t id)
-                    : _streambuf(max_request_streambuf_size)
-                    , _id(id)
+                               uint64_t id,
+                               memory_arena& arena)
+                    : _id(id)
                     , _content(_streambuf)
                     , _remote_endpoint(std::move(remote_endpoint))
+                    , _arena(arena)
+                    , _streambuf(max_request_streambuf_size, arena_allocator<char>(arena))
                 {
                     SRV_LOGC_TRACE(__FUNCTION__);
                 }
@@ -365,8 +386,15 @@ namespace network {
                     return __http_query_string::parse(_query_string);
                 }
 
+                arena_allocator<char> get_allocator() const override
+                {
+                    return arena_allocator<char>(_arena);
+                }
+
             private:
-                asio::streambuf _streambuf;
+                memory_arena& _arena;
+
+                request_streambuf _streambuf;
             };
 
         protected:
@@ -374,19 +402,30 @@ namespace network {
             {
             public:
                 template <typename... Args>
-                __http_connection(std::shared_ptr<__http_scope_runner> handler_runner, Args&&... args)
+                __http_connection(std::shared_ptr<__http_scope_runner> handler_runner,
+                                  std::shared_ptr<network_counters> counters,
+                                  Args&&... args)
                     : handler_runner(std::move(handler_runner))
+                    , counters(std::move(counters))
                     , socket(new socket_type(std::forward<Args>(args)...))
+                    , arena(std::make_shared<memory_arena>())
                 {
                     SRV_LOGC_TRACE(__FUNCTION__);
                 }
                 ~__http_connection()
                 {
                     SRV_LOGC_TRACE(__FUNCTION__);
+
+                    if (accepted)
+                        counters->active_connections.sub(1);
                 }
 
                 std::shared_ptr<__http_scope_runner> handler_runner;
 
+                std::shared_ptr<network_counters> counters;
+                // Connection was accepted (it is created before accepting)
+                bool accepted = false;
+
                 std::unique_ptr<socket_type> socket; // Socket must be unique_ptr since asio::ssl::stream<asio::ip::tcp::socket> is not movable
                 std::mutex socket_close_mutex;
 
@@ -394,6 +433,9 @@ namespace network {
 
                 std::shared_ptr<asio::ip::tcp::endpoint> remote_endpoint;
 
+                // Request-scoped memory. It is reset between requests
+                std::shared_ptr<memory_arena> arena;
+
                 void close()
                 {
                     error_code ec;
@@ -413,10 +455,10 @@ namespace network {
                     timer = std::unique_ptr<asio::steady_timer>(new asio::steady_timer(get_io_service(*socket)));
                     timer->expires_from_now(std::chrono::seconds(seconds));
                     auto self = this->shared_from_this();
-                    timer->async_wait([self](const error_code& ec) {
+                    timer->async_wait(make_pooled_handler([self](const error_code& ec) {
                         if (!ec)
                             self->close();
-                    });
+                    }));
                 }
 
                 void cancel_timeout()
@@ -444,10 +486,19 @@ namespace network {
                         this->connection->remote_endpoint = std::make_shared<asio::ip::tcp::endpoint>(
                             this->connection->socket->lowest_layer().remote_endpoint(ec));
                     }
-                    request = std::shared_ptr<__http_request>(new __http_request(
+                    // Request is placed in arena. Deleter keeps arena alive
+                    // for requests that have been kept by handler
+                    auto arena = this->connection->arena;
+                    auto* prequest = new (arena->allocate(sizeof(__http_request), alignof(__http_request))) __http_request(
                         max_request_streambuf_size,
                         this->connection->remote_endpoint,
-                        std::atomic_fetch_add<uint64_t>(&next_request_id, 1)));
+                        std::atomic_fetch_add<uint64_t>(&next_request_id, 1),
+                        *arena);
+                    request = std::shared_ptr<__http_request>(
+                        prequest, [arena](__http_request* prequest) {
+                            prequest->~__http_request();
+                        },
+                        pool_allocator<__http_request>());
                 }
                 ~__http_session()
                 {
@@ -456,6 +507,9 @@ namespace network {
 
                 std::shared_ptr<__http_connection> connection;
                 std::shared_ptr<__http_request> request;
+
+                // Request header has been read (for RTT)
+                std::chrono::steady_clock::time_point read_time;
             };
 
         protected:
@@ -535,6 +589,16 @@ namespace network {
                 return _workers && _workers->is_running();
             }
 
+            network_stats stats() const
+            {
+                return counters->snapshot();
+            }
+
+            loop_stats workers_stats() const
+            {
+                return _workers ? _workers->stats() : loop_stats {};
+            }
+
             virtual bool start(const start_callback_type& start_callback)
             {
                 try
@@ -545,6 +609,7 @@ namespace network {
 
                     _workers = std::make_unique<event_pool>(_config.worker_threads());
                     _workers->change_pool_name(_config.worker_name());
+                    apply_worker_options(*_workers, _config);
 
                     auto callback = [this, start_callback]() {
                         try
@@ -641,23 +706,41 @@ namespace network {
 
             std::shared_ptr<__http_scope_runner> handler_runner;
 
+            std::shared_ptr<network_counters> counters;
+
             server_base_impl(const config_type& config)
                 : _config(config)
                 , connections(new std::unordered_set<__http_connection*>())
                 , connections_mutex(new std::mutex())
                 , handler_runner(new __http_scope_runner())
+                , counters(std::make_shared<network_counters>())
             {
                 _next_request_id = 1;
             }
 
             virtual void accept() = 0;
 
+            void on_accepted(__http_connection& connection)
+            {
+                connection.accepted = true;
+                counters->connections.add();
+                counters->active_connections.add();
+            }
+
+            // Count bytes that were appended to request stream buffer by read operation
+            void on_read(const std::shared_ptr<__http_session>& session, size_t streambuf_size_before)
+            {
+                auto size = session->request->_streambuf.size();
+                counters->bytes_in.add(size > streambuf_size_before ? size - streambuf_size_before : 0);
+                counters->read_calls.add();
+            }
+
             template <typename... Args>
             std::shared_ptr<__http_connection> create_connection(Args&&... args)
             {
                 auto connections = this->connections;
                 auto connections_mutex = this->connections_mutex;
-                auto connection = std::shared_ptr<__http_connection>(new __http_connection(handler_runner, std::forward<Args>(args)...), [connections, connections_mutex](__http_connection* connection) {
+                auto connection = std::shared_ptr<__http_connection>(new __http_connection(handler_runner, counters, std::forward<Args>(args)...), [connections, connections_mutex](__http_connection* connection) {
                     {
                         std::unique_lock<std::mutex> lock(*connections_mutex);
                         auto it = connections->find(connection);
@@ -676,14 +759,17 @@ namespace network {
             void read(const std::shared_ptr<__http_session>& session)
             {
                 session->connection->set_timeout(_config.timeout_request());
-                auto callback = [this, session](const error_code& ec, size_t bytes_transferred) {
+                auto streambuf_size = session->request->_streambuf.size();
+                auto callback = [this, session, streambuf_size](const error_code& ec, size_t bytes_transferred) {
                     try
                     {
                         session->connection->cancel_timeout();
                         auto lock = session->connection->handler_runner->continue_lock();
                         if (!lock)
                             return;
+                        this->on_read(session, streambuf_size);
                         session->request->_header_read_time = std::chrono::system_clock::now();
+                        session->read_time = std::chrono::steady_clock::now();
                         if ((!ec || ec == asio::error::not_found) && session->request->_streambuf.size() == session->request->_streambuf.max_size())
                         {
                             auto response = std::shared_ptr<__http_response>(new __http_response(session, this->_config.timeout_content()));
@@ -731,11 +817,13 @@ namespace network {
                                 if (content_length > num_additional_bytes)
                                 {
                                     session->connection->set_timeout(_config.timeout_content());
-                                    asio::async_read(*session->connection->socket, session->request->_streambuf, asio::transfer_exactly(content_length - num_additional_bytes), [this, session](const error_code& ec, size_t /*bytes_transferred*/) {
+                                    auto streambuf_size = session->request->_streambuf.size();
+                                    asio::async_read(*session->connection->socket, session->request->_streambuf, asio::transfer_exactly(content_length - num_additional_bytes), [this, session, streambuf_size](const error_code& ec, size_t /*bytes_transferred*/) {
                                         session->connection->cancel_timeout();
                                         auto lock = session->connection->handler_runner->continue_lock();
                                         if (!lock)
                                             return;
+                                        this->on_read(session, streambuf_size);
                                         if (!ec)
                                         {
                                             if (session->request->_streambuf.size() == session->request->_streambuf.max_size())
@@ -772,19 +860,21 @@ namespace network {
                         SRV_LOGC_ERROR(e.what());
                     }
                 };
-                asio::async_read_until(*session->connection->socket, session->request->_streambuf, "\r\n\r\n", std::move(callback));
+                asio::async_read_until(*session->connection->socket, session->request->_streambuf, "\r\n\r\n", make_pooled_handler(std::move(callback)));
             }
 
             void read_chunked_transfer_encoded(const std::shared_ptr<__http_session>& session, const std::shared_ptr<asio::streambuf>& chunks_streambuf)
             {
                 session->connection->set_timeout(_config.timeout_content());
-                auto callback = [this, session, chunks_streambuf](const error_code& ec, size_t bytes_transferred) {
+                auto streambuf_size = session->request->_streambuf.size();
+                auto callback = [this, session, chunks_streambuf, streambuf_size](const error_code& ec, size_t bytes_transferred) {
                     try
                     {
                         session->connection->cancel_timeout();
                         auto lock = session->connection->handler_runner->continue_lock();
                         if (!lock)
                             return;
+                        this->on_read(session, streambuf_size);
                         if ((!ec || ec == asio::error::not_found) && session->request->_streambuf.size() == session->request->_streambuf.max_size())
                         {
                             auto response = std::shared_ptr<__http_response>(new __http_response(session, this->_config.timeout_content()));
@@ -817,11 +907,13 @@ namespace network {
                             if ((2 + length) > num_additional_bytes)
                             {
                                 session->connection->set_timeout(_config.timeout_content());
-                                asio::async_read(*session->connection->socket, session->request->_streambuf, asio::transfer_exactly(2 + length - num_additional_bytes), [this, session, chunks_streambuf, length](const error_code& ec, size_t /*bytes_transferred*/) {
+                                auto streambuf_size = session->request->_streambuf.size();
+                                asio::async_read(*session->connection->socket, session->request->_streambuf, asio::transfer_exactly(2 + length - num_additional_bytes), [this, session, chunks_streambuf, length, streambuf_size](const error_code& ec, size_t /*bytes_transferred*/) {
                                     session->connection->cancel_timeout();
                                     auto lock = session->connection->handler_runner->continue_lock();
                                     if (!lock)
                                         return;
+                                    this->on_read(session, streambuf_size);
                                     if (!ec)
                                     {
                                         if (session->request->_streambuf.size() == session->request->_streambuf.max_size())
@@ -850,7 +942,7 @@ namespace network {
                         SRV_LOGC_ERROR(e.what());
                     }
                 };
-                asio::async_read_until(*session->connection->socket, session->request->_streambuf, "\r\n", std::move(callback));
+                asio::async_read_until(*session->connection->socket, session->request->_streambuf, "\r\n", make_pooled_handler(std::move(callback)));
             }
 
             void read_chunked_transfer_encoded_chunk(const std::shared_ptr<__http_session>& session, const std::shared_ptr<asio::streambuf>& chunks_streambuf, unsigned long length)
@@ -891,6 +983,8 @@ namespace network {
 
             void find_resource(const std::shared_ptr<__http_session>& session)
             {
+                counters->units_in.add();
+
                 // Upgrade connection
                 if (on_upgrade)
                 {
@@ -932,6 +1026,31 @@ namespace network {
                     write(session, it->second);
             }
 
+            std::shared_ptr<__http_session> next_session(const std::shared_ptr<__http_response>& response)
+            {
+                auto& session = response->_session;
+                auto& connection = session->connection;
+
+                // Response is sent when handler has released it. Thus request
+                // is referred by session and this response only if handler
+                // has not kept the request. Then request memory is released at once.
+                // Otherwise the request keeps previous arena
+                if (session->request.use_count() == 2 && response->_request == session->request)
+                {
+                    response->_request.reset();
+                    session->request.reset();
+                }
+                if (connection->arena.use_count() == 1)
+                    connection->arena->reset();
+                else
+                    connection->arena = std::make_shared<memory_arena>();
+
+                return std::make_shared<__http_session>(
+                    _config.max_request_streambuf_size(),
+                    connection,
+                    _next_request_id);
+            }
+
             void write(const std::shared_ptr<__http_session>& session,
                        std::function<void(std::shared_ptr<typename server_base_impl<config_type, socket_type>::__http_response>,
                                           std::shared_ptr<typename server_base_impl<config_type, socket_type>::__http_request>)>& resource_function)
@@ -944,36 +1063,31 @@ namespace network {
                         {
                             if (!ec)
                             {
+                                counters->units_out.add();
+                                counters->rtt.record(std::chrono::steady_clock::now() - response->_session->read_time);
+
                                 if (response->_close_connection_after_response)
                                     return;
 
-                                auto range = response->_session->request->_header.equal_range("Connection");
+                                auto range = response->_request->_header.equal_range("Connection");
                                 for (auto it = range.first; it != range.second; it++)
                                 {
                                     if (case_insensitive_equal(it->second, "close"))
                                         return;
                                     else if (case_insensitive_equal(it->second, "keep-alive"))
                                     {
-                                        auto new_session = std::make_shared<__http_session>(
-                                            this->_config.max_request_streambuf_size(),
-                                            response->_session->connection,
-                                            this->_next_request_id);
-                                        this->read(new_session);
+                                        this->read(this->next_session(response));
                                         return;
                                     }
                                 }
-                                if (response->_session->request->_http_version >= "1.1")
+                                if (response->_request->_http_version >= "1.1")
                                 {
-                                    auto new_session = std::make_shared<__http_session>(
-                                        this->_config.max_request_streambuf_size(),
-                                        response->_session->connection,
-                                        this->_next_request_id);
-                                    this->read(new_session);
+                                    this->read(this->next_session(response));
                                     return;
                                 }
                             }
                             else if (this->on_error)
-                                this->on_error(response->_session->request, ec);
+                                this->on_error(response->_request, ec);
                         }
                         catch (const std::exception& e)
                         {
@@ -1036,10 +1150,18 @@ namespace network {
 
                         if (!ec)
                         {
+                            this->on_accepted(*connection);
+
                             asio::ip::tcp::no_delay option(true);
                             error_code ec;
                             session->connection->socket->set_option(option, ec);
 
+                            ec = set_socket_busy_poll(*session->connection->socket, _config.socket_busy_poll());
+                            if (ec)
+                            {
+                                SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << ec.message());
+                            }
+
                             this->read(session);
                         }
                         else if (this->on_error)
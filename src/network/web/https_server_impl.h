@@ -72,10 +72,18 @@ namespace network {
 
                     if (!ec)
                     {
+                        this->on_accepted(*connection);
+
                         asio::ip::tcp::no_delay option(true);
                         error_code ec;
                         session->connection->socket->lowest_layer().set_option(option, ec);
 
+                        ec = set_socket_busy_poll(*session->connection->socket, _config.socket_busy_poll());
+                        if (ec)
+                        {
+                            SRV_LOGC_WARN("Can't set SO_BUSY_POLL: " << ec.message());
+                        }
+
                         session->connection->set_timeout(_config.timeout_request());
                         session->connection->socket->async_handshake(asio::ssl::stream_base::server, [this, session](const error_code& ec) {
                             session->connection->cancel_timeout();
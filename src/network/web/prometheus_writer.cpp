@@ -0,0 +1,130 @@
+#include "prometheus_writer.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace server_lib {
+namespace network {
+    namespace web {
+
+        namespace {
+            std::string escape_label(const std::string& value)
+            {
+                std::string result;
+                result.reserve(value.size());
+                for (auto ch : value)
+                {
+                    switch (ch)
+                    {
+                    case '\\':
+                        result.append("\\\\");
+                        break;
+                    case '"':
+                        result.append("\\\"");
+                        break;
+                    case '\n':
+                        result.append("\\n");
+                        break;
+                    default:
+                        result.push_back(ch);
+                    }
+                }
+                return result;
+            }
+
+            std::string seconds(std::chrono::nanoseconds value)
+            {
+                std::stringstream ss;
+                ss << std::setprecision(9) << static_cast<double>(value.count()) / 1e9;
+                return ss.str();
+            }
+
+            std::string sample(const std::string& name, const std::string& labels, const std::string& value)
+            {
+                std::string result { name };
+                result.push_back('{');
+                result.append(labels);
+                result.append("} ");
+                result.append(value);
+                return result;
+            }
+        } // namespace
+
+        void prometheus_writer::add(const std::string& source, const network_stats& stats)
+        {
+            counter("server_lib_connections_total", "Connections since start", source, stats.connections);
+            gauge("server_lib_active_connections", "Connections are currently open", source, stats.active_connections);
+            counter("server_lib_received_bytes_total", "Bytes received", source, stats.bytes_in);
+            counter("server_lib_sent_bytes_total", "Bytes sent", source, stats.bytes_out);
+            counter("server_lib_received_units_total", "Protocol units (requests, messages) received", source, stats.units_in);
+            counter("server_lib_sent_units_total", "Protocol units (responses, messages) sent", source, stats.units_out);
+            counter("server_lib_read_calls_total", "Completed read operations", source, stats.read_calls);
+            counter("server_lib_write_calls_total", "Completed write operations", source, stats.write_calls);
+            gauge("server_lib_queued_bytes", "Bytes are waiting for write", source, stats.queued_bytes);
+            summary("server_lib_rtt_seconds", "Request/response round trip time", source, stats.rtt);
+        }
+
+        void prometheus_writer::add(const std::string& source, const loop_stats& stats)
+        {
+            counter("server_lib_loop_posts_total", "Handlers posted to loop", source, stats.posts);
+            gauge("server_lib_loop_queue_size", "Handlers are waiting for execution", source, stats.queue_size);
+            gauge("server_lib_loop_max_queue_size", "Maximum queue depth", source, stats.max_queue_size);
+            counter("server_lib_loop_stalls_total", "Handlers that exceeded stall threshold", source, stats.stalls);
+            summary("server_lib_loop_queue_latency_seconds", "Time from post to handler start", source, stats.queue_latency);
+            summary("server_lib_loop_handler_duration_seconds", "Handler execution time", source, stats.handler_duration);
+        }
+
+        std::string prometheus_writer::str() const
+        {
+            std::stringstream ss;
+            for (auto&& name : _order)
+            {
+                auto& item = _families.at(name);
+                ss << "# HELP " << name << ' ' << item.help << '\n';
+                ss << "# TYPE " << name << ' ' << item.type << '\n';
+                for (auto&& line : item.samples)
+                    ss << line << '\n';
+            }
+            return ss.str();
+        }
+
+        void prometheus_writer::counter(const std::string& name, const std::string& help,
+                                        const std::string& source, uint64_t value)
+        {
+            get_family(name, help, "counter").samples.emplace_back(sample(name, "source=\"" + escape_label(source) + "\"", std::to_string(value)));
+        }
+
+        void prometheus_writer::gauge(const std::string& name, const std::string& help,
+                                      const std::string& source, uint64_t value)
+        {
+            get_family(name, help, "gauge").samples.emplace_back(sample(name, "source=\"" + escape_label(source) + "\"", std::to_string(value)));
+        }
+
+        void prometheus_writer::summary(const std::string& name, const std::string& help,
+                                        const std::string& source, const latency_summary& value)
+        {
+            auto& item = get_family(name, help, "summary");
+            auto label = "source=\"" + escape_label(source) + "\"";
+            item.samples.emplace_back(sample(name, label + ",quantile=\"0.5\"", seconds(value.p50)));
+            item.samples.emplace_back(sample(name, label + ",quantile=\"0.9\"", seconds(value.p90)));
+            item.samples.emplace_back(sample(name, label + ",quantile=\"0.99\"", seconds(value.p99)));
+            item.samples.emplace_back(sample(name, label + ",quantile=\"0.999\"", seconds(value.p999)));
+            // Histogram doesn't keep exact sum
+            item.samples.emplace_back(sample(name + "_sum", label, seconds(value.mean * value.count)));
+            item.samples.emplace_back(sample(name + "_count", label, std::to_string(value.count)));
+        }
+
+        prometheus_writer::family& prometheus_writer::get_family(const std::string& name, const std::string& help, const char* type)
+        {
+            auto it = _families.find(name);
+            if (it == _families.end())
+            {
+                _order.emplace_back(name);
+                it = _families.emplace(name, family { help, type, {} }).first;
+            }
+            return it->second;
+        }
+
+    } // namespace web
+} // namespace network
+} // namespace server_lib
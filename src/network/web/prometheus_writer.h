@@ -0,0 +1,49 @@
+#pragma once
+
+#include <server_lib/network/network_stats.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace server_lib {
+namespace network {
+    namespace web {
+
+        /**
+         * Render statistics in Prometheus text exposition format (0.0.4).
+         * Samples are grouped by metric family so HELP and TYPE
+         * are written once. Every sample is labeled by source
+         */
+        class prometheus_writer
+        {
+        public:
+            void add(const std::string& source, const network_stats&);
+            void add(const std::string& source, const loop_stats&);
+
+            std::string str() const;
+
+        private:
+            struct family
+            {
+                std::string help;
+                std::string type;
+                std::vector<std::string> samples;
+            };
+
+            void counter(const std::string& name, const std::string& help,
+                         const std::string& source, uint64_t value);
+            void gauge(const std::string& name, const std::string& help,
+                       const std::string& source, uint64_t value);
+            void summary(const std::string& name, const std::string& help,
+                         const std::string& source, const latency_summary&);
+
+            family& get_family(const std::string& name, const std::string& help, const char* type);
+
+            std::vector<std::string> _order;
+            std::map<std::string, family> _families;
+        };
+
+    } // namespace web
+} // namespace network
+} // namespace server_lib
@@ -3,6 +3,7 @@
 
 #include "http_server_impl.h"
 #include "https_server_impl.h"
+#include "prometheus_writer.h"
 
 #include "../../logger_set_internal_group.h"
 
@@ -19,6 +20,7 @@ namespace network {
                                                                  std::pair<size_t,
                                                                            app_request_callback_type>>>;
             using common_callback_type = std::function<void()>;
+            using metrics_callback_type = std::function<std::string()>;
 
             virtual ~web_server_impl_i() = default;
 
@@ -32,6 +34,14 @@ namespace network {
             virtual bool is_running() const = 0;
 
             virtual void post(common_callback_type&& callback) = 0;
+
+            virtual network_stats stats() const = 0;
+
+            virtual loop_stats workers_stats() const = 0;
+
+            // Serve metrics if they are enabled by config.
+            // Return 'true' if they are
+            virtual bool set_metrics_handler(const metrics_callback_type&) = 0;
         };
 
         template <typename socket_type>
@@ -78,6 +88,31 @@ namespace network {
                 this->_workers->post(std::move(callback));
             }
 
+            network_stats stats() const override
+            {
+                return base_type::stats();
+            }
+
+            loop_stats workers_stats() const override
+            {
+                return base_type::workers_stats();
+            }
+
+            bool set_metrics_handler(const metrics_callback_type& callback) override
+            {
+                const auto& path = this->_config.metrics_path();
+                if (path.empty() || !callback)
+                    return false;
+
+                this->resource["^" + path + "$"]["GET"] = [callback](std::shared_ptr<typename base_type::__http_response> response,
+                                                                     std::shared_ptr<typename base_type::__http_request>) {
+                    web_header header;
+                    header.emplace("Content-Type", "text/plain; version=0.0.4");
+                    std::static_pointer_cast<web_server_response_i>(response)->post(http_status_code::success_ok, callback(), header);
+                };
+                return true;
+            }
+
         private:
             void set_start_handler(const app_start_callback_type& callback)
             {
@@ -190,10 +225,12 @@ namespace network {
             {
                 SRV_ASSERT(!is_running());
 
-                SRV_ASSERT(!_request_callbacks.empty(), "Request handler required");
-
                 _impl = create_impl();
 
+                bool metrics = _impl->set_metrics_handler(std::bind(&web_server::render_metrics, this));
+
+                SRV_ASSERT(metrics || !_request_callbacks.empty(), "Request handler required");
+
                 auto start_handler = std::bind(&web_server::on_start_impl, this);
                 auto fail_handler = std::bind(&web_server::on_fail_impl, this, std::placeholders::_1, std::placeholders::_2);
 
@@ -207,6 +244,21 @@ namespace network {
             return *this;
         }
 
+        std::string web_server::render_metrics()
+        {
+            prometheus_writer writer;
+            writer.add("web_server", stats());
+            if (_impl)
+                writer.add("web_server", _impl->workers_stats());
+
+            std::lock_guard<std::mutex> lock(_metrics_mutex);
+            for (auto&& item : _network_metrics)
+                writer.add(item.first, item.second());
+            for (auto&& item : _loop_metrics)
+                writer.add(item.first, item.second());
+            return writer.str();
+        }
+
         void web_server::on_start_impl()
         {
             _start_observer.notify();
@@ -247,6 +299,29 @@ namespace network {
             return _impl && _impl->is_running();
         }
 
+        network_stats web_server::stats() const
+        {
+            if (!_impl)
+                return {};
+            return _impl->stats();
+        }
+
+        web_server& web_server::add_metrics(const std::string& source, network_stats_callback_type&& callback)
+        {
+            SRV_ASSERT(callback);
+            std::lock_guard<std::mutex> lock(_metrics_mutex);
+            _network_metrics.emplace_back(source, std::move(callback));
+            return *this;
+        }
+
+        web_server& web_server::add_metrics(const std::string& source, loop_stats_callback_type&& callback)
+        {
+            SRV_ASSERT(callback);
+            std::lock_guard<std::mutex> lock(_metrics_mutex);
+            _loop_metrics.emplace_back(source, std::move(callback));
+            return *this;
+        }
+
         web_server& web_server::on_start(start_callback_type&& callback)
         {
             _start_observer.subscribe(std::forward<start_callback_type>(callback));
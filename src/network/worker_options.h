@@ -0,0 +1,21 @@
+#pragma once
+
+namespace server_lib {
+namespace network {
+
+    /**
+     * Apply thread options from network config
+     * to worker event_loop or event_pool before start
+     */
+    template <typename Loop, typename Config>
+    void apply_worker_options(Loop& loop, const Config& config)
+    {
+        loop.enable_busy_poll(config.busy_poll_budget());
+        loop.pin_to_cpus(config.worker_cpus());
+        loop.bind_to_numa_node(config.worker_numa_node());
+        loop.set_nice(config.worker_nice());
+        loop.set_realtime_priority(config.worker_realtime_priority());
+    }
+
+} // namespace network
+} // namespace server_lib
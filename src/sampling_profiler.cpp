@@ -0,0 +1,501 @@
+#include <server_lib/sampling_profiler.h>
+#include <server_lib/platform_config.h>
+
+#include <boost/stacktrace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <dlfcn.h>
+
+// Old glibc doesn't define it
+#if !defined(sigev_notify_thread_id)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+#include "logger_set_internal_group.h"
+
+namespace server_lib {
+
+namespace {
+    constexpr size_t max_sample_frames = 64;
+
+    struct sample
+    {
+        std::atomic_bool ready { false };
+        int thread = -1;
+        void* frames[max_sample_frames + 1];
+    };
+
+    // Preallocated storage. Signal handler only claims slots
+    struct sample_buffer
+    {
+        explicit sample_buffer(size_t capacity)
+            : capacity(capacity)
+            , samples(new sample[capacity])
+        {
+        }
+
+        const size_t capacity;
+        std::unique_ptr<sample[]> samples;
+        std::atomic<size_t> next { 0 };
+        std::atomic<size_t> dropped { 0 };
+    };
+
+    std::atomic<sample_buffer*> active_buffer { nullptr };
+
+    // Index of thread name for samples. It is set by add_thread
+    // (before any signal) so reading in signal handler doesn't
+    // allocate TLS
+    thread_local int tls_thread_index = -1;
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    void on_profiling_signal(int)
+    {
+        auto saved_errno = errno;
+        auto* buffer = active_buffer.load(std::memory_order_acquire);
+        auto thread_index = tls_thread_index;
+        if (buffer && thread_index >= 0)
+        {
+            auto idx = buffer->next.fetch_add(1, std::memory_order_relaxed);
+            if (idx < buffer->capacity)
+            {
+                auto& item = buffer->samples[idx];
+                item.thread = thread_index;
+                // Stack is terminated by zero frame
+                auto count = boost::stacktrace::safe_dump_to(item.frames, sizeof(item.frames));
+                item.frames[std::min(count, max_sample_frames)] = nullptr;
+                item.ready.store(true, std::memory_order_release);
+            }
+            else
+            {
+                buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        errno = saved_errno;
+    }
+
+    bool install_profiling_handler()
+    {
+        static const bool installed = []() {
+            // The first unwinding loads unwinder library. It is not
+            // safe in signal handler
+            void* frames[2];
+            boost::stacktrace::safe_dump_to(frames, sizeof(frames));
+
+            struct sigaction action = {};
+            action.sa_handler = on_profiling_signal;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            return sigaction(SIGPROF, &action, nullptr) == 0;
+        }();
+        return installed;
+    }
+#endif
+
+    std::string frame_name(void* address, std::unordered_map<void*, std::string>& cache)
+    {
+        auto it = cache.find(address);
+        if (it != cache.end())
+            return it->second;
+
+        auto name = boost::stacktrace::frame(address).name();
+        if (name.empty())
+        {
+            // Not exported symbol. Module offset could be
+            // resolved offline (addr2line -e module offset)
+            std::stringstream ss;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            Dl_info info;
+            if (dladdr(address, &info) && info.dli_fname && info.dli_fbase)
+            {
+                std::string module { info.dli_fname };
+                auto pos = module.rfind('/');
+                if (pos != std::string::npos)
+                    module = module.substr(pos + 1);
+                ss << module << "+0x" << std::hex
+                   << (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+            }
+            else
+#endif
+                ss << address;
+            name = ss.str();
+        }
+        // Separator of collapsed format
+        std::replace(name.begin(), name.end(), ';', ':');
+        std::replace(name.begin(), name.end(), '\n', ' ');
+        cache.emplace(address, name);
+        return name;
+    }
+} // namespace
+
+class sampling_profiler_impl
+{
+public:
+    struct thread_entry
+    {
+        int name_index = -1;
+        long native_thread_id = 0;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        pthread_t native_handle {};
+        timer_t timer {};
+#endif
+        bool has_timer = false;
+    };
+
+    ~sampling_profiler_impl()
+    {
+        stop();
+    }
+
+    bool start(std::chrono::microseconds period, size_t max_samples)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_running)
+            return false;
+
+        if (!install_profiling_handler())
+        {
+            SRV_LOGC_ERROR("Can't install SIGPROF handler");
+            return false;
+        }
+
+        // Previous buffer could be still read by late signal.
+        // It is released on next start only
+        _previous_buffer = std::move(_buffer);
+        _buffer = std::make_unique<sample_buffer>(std::max<size_t>(1, max_samples));
+        _period = std::max(period, std::chrono::microseconds(100));
+        prune_names();
+        active_buffer.store(_buffer.get(), std::memory_order_release);
+        _running = true;
+
+        for (auto&& item : _threads)
+            start_timer(item.second);
+
+        SRV_LOGC_INFO("Sampling profiler has started for " << _threads.size() << " threads");
+        return true;
+#else
+        (void)period;
+        (void)max_samples;
+        return false;
+#endif
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running)
+            return;
+
+        for (auto&& item : _threads)
+            stop_timer(item.second);
+
+        active_buffer.store(nullptr, std::memory_order_release);
+        _running = false;
+
+        SRV_LOGC_INFO("Sampling profiler has stopped. Samples: " << samples_impl() << ", dropped: " << dropped_impl());
+    }
+
+    bool is_running() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _running;
+    }
+
+    size_t samples() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return samples_impl();
+    }
+
+    size_t dropped() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return dropped_impl();
+    }
+
+    std::string collapsed_stacks() const
+    {
+        std::map<std::string, size_t> stacks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_buffer)
+                return {};
+
+            std::unordered_map<void*, std::string> names;
+            auto count = samples_impl();
+            for (size_t ci = 0; ci < count; ++ci)
+            {
+                auto& item = _buffer->samples[ci];
+                if (!item.ready.load(std::memory_order_acquire))
+                    continue;
+
+                std::vector<void*> frames;
+                for (size_t cj = 0; cj < max_sample_frames && item.frames[cj]; ++cj)
+                    frames.push_back(item.frames[cj]);
+
+                // Skip frames of signal handler and signal trampoline
+                static constexpr size_t handler_frames = 2;
+                if (frames.size() <= handler_frames)
+                    continue;
+
+                auto name_it = _thread_names.find(item.thread);
+                std::string stack = name_it != _thread_names.end()
+                                        ? name_it->second
+                                        : std::string { "unknown" };
+                // Collapsed format starts from outermost frame
+                for (auto it = frames.rbegin(); it != frames.rend() - handler_frames; ++it)
+                {
+                    stack.push_back(';');
+                    stack.append(frame_name(*it, names));
+                }
+                ++stacks[stack];
+            }
+        }
+
+        std::stringstream ss;
+        for (auto&& item : stacks)
+            ss << item.first << ' ' << item.second << '\n';
+        return ss.str();
+    }
+
+    void add_thread(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_threads.count(std::this_thread::get_id()))
+            return;
+
+        auto thread_name = name.empty() ? std::string { "thread" } : name;
+        std::replace(thread_name.begin(), thread_name.end(), ';', ':');
+        std::replace(thread_name.begin(), thread_name.end(), ' ', '_');
+
+        // Threads with the same name share index
+        auto name_it = _name_indexes.find(thread_name);
+        if (name_it == _name_indexes.end())
+        {
+            auto index = _next_name_index++;
+            _thread_names.emplace(index, thread_name);
+            name_it = _name_indexes.emplace(thread_name, index).first;
+        }
+
+        thread_entry entry;
+        entry.name_index = name_it->second;
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        entry.native_thread_id = syscall(SYS_gettid);
+        entry.native_handle = pthread_self();
+#endif
+        tls_thread_index = entry.name_index;
+        auto& item = _threads.emplace(std::this_thread::get_id(), entry).first->second;
+        if (_running)
+            start_timer(item);
+    }
+
+    void remove_thread()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _threads.find(std::this_thread::get_id());
+        if (it == _threads.end())
+            return;
+
+        stop_timer(it->second);
+        _threads.erase(it);
+        // Name is kept for collected samples until next start
+        tls_thread_index = -1;
+    }
+
+private:
+    // Samples of previous session are not read anymore thus only
+    // names of registered threads are kept
+    void prune_names()
+    {
+        std::set<int> used;
+        for (auto&& item : _threads)
+            used.insert(item.second.name_index);
+
+        for (auto it = _thread_names.begin(); it != _thread_names.end();)
+        {
+            if (used.count(it->first))
+            {
+                ++it;
+                continue;
+            }
+            _name_indexes.erase(it->second);
+            it = _thread_names.erase(it);
+        }
+    }
+
+    size_t samples_impl() const
+    {
+        if (!_buffer)
+            return 0;
+        return std::min(_buffer->next.load(), _buffer->capacity);
+    }
+
+    size_t dropped_impl() const
+    {
+        if (!_buffer)
+            return 0;
+        return _buffer->dropped.load();
+    }
+
+    void start_timer(thread_entry& entry)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (entry.has_timer)
+            return;
+
+        clockid_t clock_id;
+        if (pthread_getcpuclockid(entry.native_handle, &clock_id) != 0)
+        {
+            SRV_LOGC_WARN("Can't get CPU clock for thread " << entry.native_thread_id);
+            return;
+        }
+
+        struct sigevent event = {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_notify_thread_id = static_cast<pid_t>(entry.native_thread_id);
+        if (timer_create(clock_id, &event, &entry.timer) != 0)
+        {
+            SRV_LOGC_WARN("Can't create profiling timer for thread " << entry.native_thread_id);
+            return;
+        }
+
+        auto sec = std::chrono::duration_cast<std::chrono::seconds>(_period);
+        struct itimerspec spec = {};
+        spec.it_interval.tv_sec = static_cast<time_t>(sec.count());
+        spec.it_interval.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(_period - sec).count());
+        spec.it_value = spec.it_interval;
+        if (timer_settime(entry.timer, 0, &spec, nullptr) != 0)
+        {
+            timer_delete(entry.timer);
+            SRV_LOGC_WARN("Can't start profiling timer for thread " << entry.native_thread_id);
+            return;
+        }
+        entry.has_timer = true;
+#else
+        (void)entry;
+#endif
+    }
+
+    void stop_timer(thread_entry& entry)
+    {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+        if (!entry.has_timer)
+            return;
+        timer_delete(entry.timer);
+        entry.has_timer = false;
+#else
+        (void)entry;
+#endif
+    }
+
+    mutable std::mutex _mutex;
+    bool _running = false;
+    std::chrono::microseconds _period;
+    std::unique_ptr<sample_buffer> _buffer;
+    std::unique_ptr<sample_buffer> _previous_buffer;
+    std::map<int, std::string> _thread_names;
+    std::map<std::string, int> _name_indexes;
+    int _next_name_index = 0;
+    std::map<std::thread::id, thread_entry> _threads;
+};
+
+sampling_profiler::sampling_profiler()
+    : _impl(std::make_unique<sampling_profiler_impl>())
+{
+}
+
+sampling_profiler::~sampling_profiler()
+{
+}
+
+sampling_profiler& sampling_profiler::instance()
+{
+    static sampling_profiler profiler;
+    return profiler;
+}
+
+bool sampling_profiler::start(std::chrono::microseconds period, size_t max_samples)
+{
+    return _impl->start(period, max_samples);
+}
+
+void sampling_profiler::stop()
+{
+    _impl->stop();
+}
+
+bool sampling_profiler::is_running() const
+{
+    return _impl->is_running();
+}
+
+bool sampling_profiler::toggle(const std::string& output_path)
+{
+    if (!is_running())
+        return start();
+
+    stop();
+    return dump(output_path);
+}
+
+size_t sampling_profiler::samples() const
+{
+    return _impl->samples();
+}
+
+size_t sampling_profiler::dropped() const
+{
+    return _impl->dropped();
+}
+
+std::string sampling_profiler::collapsed_stacks() const
+{
+    return _impl->collapsed_stacks();
+}
+
+bool sampling_profiler::dump(const std::string& output_path) const
+{
+    std::ofstream output(output_path, std::ios::out | std::ios::trunc);
+    if (!output.is_open())
+    {
+        SRV_LOGC_ERROR("Can't open " << output_path);
+        return false;
+    }
+    output << collapsed_stacks();
+    output.close();
+
+    SRV_LOGC_INFO("Profile has written to " << output_path);
+    return !output.fail();
+}
+
+void sampling_profiler::add_thread(const std::string& name)
+{
+    _impl->add_thread(name);
+}
+
+void sampling_profiler::remove_thread()
+{
+    _impl->remove_thread();
+}
+
+} // namespace server_lib
@@ -2,14 +2,24 @@
 
 #if defined(SERVER_LIB_PLATFORM_LINUX)
 #include <server_lib/asserts.h>
+#include <server_lib/event_loop.h>
 #include <memory>
 #include <functional>
+#include <list>
+#include <deque>
+#include <sstream>
+#include <utility>
 
 #include <memory.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <spawn.h>
 
 #include <ext/stdio_filebuf.h>
 
@@ -21,22 +31,475 @@ namespace /*impl*/
     private:
         int _fd[2];
 
+        static void close_fd(int& fd)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+
     public:
         const inline int read_fd() const { return _fd[0]; }
         const inline int write_fd() const { return _fd[1]; }
         explicit cpipe()
         {
-            SRV_ASSERT(pipe(_fd) == 0, "Failed to create pipe");
+            // Pipes must not leak to other children spawned concurrently
+            SRV_ASSERT(pipe2(_fd, O_CLOEXEC) == 0, "Failed to create pipe");
         }
+        void close_read() { close_fd(_fd[0]); }
+        void close_write() { close_fd(_fd[1]); }
+        // Ownership is passed to caller. It prevents
+        // closing of reused descriptor number twice
+        int release_read() { return std::exchange(_fd[0], -1); }
+        int release_write() { return std::exchange(_fd[1], -1); }
         void close()
         {
-            ::close(_fd[0]);
-            ::close(_fd[1]);
+            close_read();
+            close_write();
         }
         ~cpipe() { close(); }
     };
+
+    constexpr size_t transfer_chunk_size = 64 * 1024;
+
+    void set_nonblocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        SRV_ASSERT(flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0, "Failed to set non-blocking mode");
+    }
+
+    bool write_all(int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            auto n = ::write(fd, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN)
+                {
+                    pollfd pfd { fd, POLLOUT, 0 };
+                    ::poll(&pfd, 1, -1);
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // One direction of communication between own non-blocking end of
+    // the child pipe and user descriptor (or memory)
+    struct pipe_channel
+    {
+        int pipe_fd = -1;
+        int fd = -1;
+        const char* input = nullptr;
+        size_t input_size = 0;
+        std::string* output = nullptr;
+        bool use_splice = true;
+        std::string pending;
+
+        bool active() const
+        {
+            return pipe_fd >= 0;
+        }
+
+        void finish()
+        {
+            ::close(pipe_fd);
+            pipe_fd = -1;
+        }
+    };
+
+    // Pipe is writable. Return false if channel has finished
+    bool feed_pipe(pipe_channel& ch)
+    {
+        ssize_t n = 0;
+        if (!ch.pending.empty())
+        {
+            // Rest of read/write copying
+            n = ::write(ch.pipe_fd, ch.pending.data(), ch.pending.size());
+            if (n > 0)
+                ch.pending.erase(0, static_cast<size_t>(n));
+        }
+        else if (ch.fd < 0)
+        {
+            if (!ch.input_size)
+                return false;
+
+            if (ch.use_splice)
+            {
+                // Map user pages to pipe. Input is not changed until pipe is closed
+                iovec iov { const_cast<char*>(ch.input), ch.input_size };
+                n = ::vmsplice(ch.pipe_fd, &iov, 1, SPLICE_F_NONBLOCK);
+                if (n < 0 && (errno == EINVAL || errno == ENOSYS))
+                {
+                    ch.use_splice = false;
+                    return true;
+                }
+            }
+            else
+            {
+                n = ::write(ch.pipe_fd, ch.input, ch.input_size);
+            }
+            if (n > 0)
+            {
+                ch.input += n;
+                ch.input_size -= static_cast<size_t>(n);
+                return ch.input_size > 0;
+            }
+        }
+        else if (ch.use_splice)
+        {
+            n = ::splice(ch.fd, nullptr, ch.pipe_fd, nullptr, transfer_chunk_size,
+                         SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+            if (n == 0)
+                return false;
+            if (n < 0 && errno == EINVAL)
+            {
+                // Input descriptor doesn't support splice
+                ch.use_splice = false;
+                return true;
+            }
+        }
+        else
+        {
+            ch.pending.resize(transfer_chunk_size);
+            n = ::read(ch.fd, &ch.pending[0], ch.pending.size());
+            ch.pending.resize(n > 0 ? static_cast<size_t>(n) : 0);
+            if (n == 0)
+                return false;
+            if (n > 0)
+                return true;
+        }
+
+        return n >= 0 || errno == EAGAIN || errno == EINTR;
+    }
+
+    // Pipe is readable. Return false if channel has finished
+    bool drain_pipe(pipe_channel& ch)
+    {
+        ssize_t n = 0;
+        if (ch.fd < 0)
+        {
+            auto sz = ch.output->size();
+            ch.output->resize(sz + transfer_chunk_size);
+            n = ::read(ch.pipe_fd, &(*ch.output)[sz], transfer_chunk_size);
+            ch.output->resize(sz + (n > 0 ? static_cast<size_t>(n) : 0));
+        }
+        else if (ch.use_splice)
+        {
+            n = ::splice(ch.pipe_fd, nullptr, ch.fd, nullptr, transfer_chunk_size,
+                         SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
+            if (n < 0 && errno == EINVAL)
+            {
+                // Output descriptor doesn't support splice (O_APPEND file for instance)
+                ch.use_splice = false;
+                return true;
+            }
+        }
+        else
+        {
+            char buff[transfer_chunk_size];
+            n = ::read(ch.pipe_fd, buff, sizeof(buff));
+            if (n > 0 && !write_all(ch.fd, buff, static_cast<size_t>(n)))
+                return false;
+        }
+
+        if (n == 0)
+            return false;
+        return n > 0 || errno == EAGAIN || errno == EINTR;
+    }
+
+    // Serve all channels until they have finished.
+    // Child pipes are multiplexed so the child never blocks on full pipe
+    void transfer(pipe_channel& in, pipe_channel& out, pipe_channel& err)
+    {
+        pipe_channel* channels[] = { &in, &out, &err };
+        for (auto* ch : channels)
+        {
+            if (ch->active())
+                set_nonblocking(ch->pipe_fd);
+        }
+        if (in.active() && in.fd < 0 && !in.input_size)
+            in.finish();
+
+        while (in.active() || out.active() || err.active())
+        {
+            pollfd pfds[3];
+            pipe_channel* polled[3];
+            nfds_t nfds = 0;
+            for (auto* ch : channels)
+            {
+                if (!ch->active())
+                    continue;
+                pfds[nfds] = { ch->pipe_fd, static_cast<short>(ch == &in ? POLLOUT : POLLIN), 0 };
+                polled[nfds++] = ch;
+            }
+
+            if (::poll(pfds, nfds, -1) < 0)
+            {
+                SRV_ASSERT(errno == EINTR, "Failed to poll pipes");
+                continue;
+            }
+
+            for (nfds_t ci = 0; ci < nfds; ++ci)
+            {
+                if (!pfds[ci].revents)
+                    continue;
+
+                auto& ch = *polled[ci];
+                bool keep = (&ch == &in) ? (!(pfds[ci].revents & POLLERR) && feed_pipe(ch)) : drain_pipe(ch);
+                if (!keep)
+                    ch.finish();
+            }
+        }
+    }
 } // namespace
 
+// Non-blocking stdio served by event loop
+class spawn_async_stdio : public std::enable_shared_from_this<spawn_async_stdio>
+{
+public:
+    using output_callback_type = spawn::output_callback_type;
+    using drain_callback_type = spawn::drain_callback_type;
+
+    spawn_async_stdio(event_loop& loop, size_t chunk_size)
+        : _loop(loop)
+        , _service(loop.service())
+        , _stdout(*_service, chunk_size)
+        , _stderr(*_service, chunk_size)
+    {
+        SRV_ASSERT(_service);
+        SRV_ASSERT(chunk_size > 0);
+    }
+
+    void start(int stdin_fd,
+               int stdout_fd, output_callback_type&& on_stdout, std::string&& stdout_buffered,
+               int stderr_fd, output_callback_type&& on_stderr, std::string&& stderr_buffered)
+    {
+        if (stdin_fd >= 0)
+            _stdin = std::make_unique<boost::asio::posix::stream_descriptor>(*_service, stdin_fd);
+        _stdout.open(stdout_fd, std::move(on_stdout));
+        _stderr.open(stderr_fd, std::move(on_stderr));
+
+        auto self = shared_from_this();
+        _loop.post([this, self, stdout_buffered, stderr_buffered]() {
+            // Data that had been read by stream before switching
+            _stdout.call(stdout_buffered.data(), stdout_buffered.size());
+            _stderr.call(stderr_buffered.data(), stderr_buffered.size());
+            read_next(_stdout);
+            read_next(_stderr);
+        });
+    }
+
+    size_t write(std::string&& data)
+    {
+        size_t pending = _pending.fetch_add(data.size()) + data.size();
+
+        auto self = shared_from_this();
+        _loop.post([this, self, data = std::move(data)]() mutable {
+            if (_closed || !_stdin)
+            {
+                _pending.fetch_sub(data.size());
+                return;
+            }
+            _write_queue.emplace_back(std::move(data));
+            if (!_writing)
+                write_next();
+        });
+        return pending;
+    }
+
+    void set_drain(drain_callback_type&& callback, size_t low_watermark)
+    {
+        auto self = shared_from_this();
+        _loop.post([this, self, callback, low_watermark]() {
+            _drain_callback = callback;
+            _low_watermark = low_watermark;
+        });
+    }
+
+    void close_stdin()
+    {
+        auto self = shared_from_this();
+        _loop.post([this, self]() {
+            _close_stdin_requested = true;
+            if (!_writing)
+                write_next();
+        });
+    }
+
+    size_t pending() const
+    {
+        return _pending.load();
+    }
+
+    void close()
+    {
+        auto self = shared_from_this();
+        auto close_ = [this, self]() {
+            _closed = true;
+            boost::system::error_code ec;
+            if (_stdin)
+                _stdin->close(ec);
+            _stdout.pipe.close(ec);
+            _stderr.pipe.close(ec);
+            // Completion of batch is ignored after closing
+            if (_writing)
+                _pending.fetch_sub(batch_size());
+            drop_queue();
+        };
+        if (_loop.is_this_loop())
+            close_();
+        else
+            _loop.post(close_);
+    }
+
+private:
+    struct output_stream
+    {
+        output_stream(boost::asio::io_service& service, size_t chunk_size)
+            : pipe(service)
+            , buffer(chunk_size)
+        {
+        }
+
+        void open(int fd, output_callback_type&& callback_)
+        {
+            if (fd >= 0)
+                pipe.assign(fd);
+            callback = std::move(callback_);
+        }
+
+        void call(const char* data, size_t size)
+        {
+            if (size > 0 && callback)
+                callback(data, size);
+        }
+
+        boost::asio::posix::stream_descriptor pipe;
+        std::vector<char> buffer;
+        output_callback_type callback;
+    };
+
+    void read_next(output_stream& stream)
+    {
+        if (!stream.pipe.is_open())
+            return;
+
+        auto self = shared_from_this();
+        stream.pipe.async_read_some(boost::asio::buffer(stream.buffer),
+                                    [this, self, &stream](const boost::system::error_code& ec, size_t size) {
+                                        if (_closed)
+                                            return;
+
+                                        stream.call(stream.buffer.data(), size);
+                                        if (ec)
+                                        {
+                                            boost::system::error_code ec_;
+                                            stream.pipe.close(ec_);
+                                            if (stream.callback)
+                                                stream.callback(nullptr, 0);
+                                            return;
+                                        }
+                                        read_next(stream);
+                                    });
+    }
+
+    // Writes that are posted later release own bytes themselves
+    void drop_queue()
+    {
+        size_t dropped = 0;
+        for (const auto& chunk : _write_queue)
+            dropped += chunk.size();
+        _write_queue.clear();
+        _pending.fetch_sub(dropped);
+    }
+
+    size_t batch_size() const
+    {
+        size_t result = 0;
+        for (const auto& chunk : _write_batch)
+            result += chunk.size();
+        return result;
+    }
+
+    void write_next()
+    {
+        if (_write_queue.empty())
+        {
+            if (_close_stdin_requested && _stdin)
+            {
+                boost::system::error_code ec;
+                _stdin->close(ec);
+                _stdin.reset();
+            }
+            return;
+        }
+
+        // Gather several chunks for single writev
+        static const size_t max_batch = 64;
+        _write_batch.clear();
+        std::vector<boost::asio::const_buffer> buffers;
+        while (!_write_queue.empty() && _write_batch.size() < max_batch)
+        {
+            _write_batch.emplace_back(std::move(_write_queue.front()));
+            _write_queue.pop_front();
+        }
+        // Buffers refer to batch that must not be changed before write completion
+        buffers.reserve(_write_batch.size());
+        for (const auto& chunk : _write_batch)
+            buffers.emplace_back(boost::asio::buffer(chunk));
+
+        _writing = true;
+        auto self = shared_from_this();
+        boost::asio::async_write(*_stdin, buffers,
+                                 [this, self](const boost::system::error_code& ec, size_t) {
+                                     _writing = false;
+                                     if (_closed)
+                                         return;
+
+                                     _pending.fetch_sub(batch_size());
+                                     if (ec)
+                                     {
+                                         // Process has closed stdin
+                                         drop_queue();
+                                         boost::system::error_code ec_;
+                                         _stdin->close(ec_);
+                                         _stdin.reset();
+                                     }
+
+                                     if (_drain_callback && _pending.load() <= _low_watermark)
+                                         _drain_callback();
+
+                                     if (_stdin)
+                                         write_next();
+                                 });
+    }
+
+    event_loop& _loop;
+    std::shared_ptr<boost::asio::io_service> _service;
+    std::unique_ptr<boost::asio::posix::stream_descriptor> _stdin;
+    output_stream _stdout;
+    output_stream _stderr;
+
+    std::deque<std::string> _write_queue;
+    std::vector<std::string> _write_batch;
+    std::atomic_size_t _pending { 0 };
+    bool _writing = false;
+    bool _close_stdin_requested = false;
+    bool _closed = false;
+    drain_callback_type _drain_callback;
+    size_t _low_watermark = 0;
+};
+
 class spawn_iml
 {
 private:
@@ -49,6 +512,42 @@ private:
     std::ostream& _stdin;
     std::istream& _stdout;
     std::istream& _stderr;
+    std::stringbuf _stdout_data;
+    std::stringbuf _stderr_data;
+    std::shared_ptr<spawn_async_stdio> _async;
+
+    // Take pipe descriptor from stream. Stream becomes unusable
+    int detach_stdin()
+    {
+        if (!_write_buf || !_write_buf->is_open())
+            return -1;
+
+        _write_buf->pubsync();
+        // Children spawned concurrently must not inherit pipe
+        int fd = fcntl(_write_buf->fd(), F_DUPFD_CLOEXEC, 0);
+        _write_buf->close();
+        _stdin.rdbuf(nullptr);
+        return fd;
+    }
+
+    int detach_output(std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>& buf, std::istream& stream, std::string& buffered)
+    {
+        if (!buf || !buf->is_open())
+            return -1;
+
+        // Keep data that has been already read to stream buffer
+        auto sz = buf->in_avail();
+        if (sz > 0)
+        {
+            buffered.resize(static_cast<size_t>(sz));
+            buffered.resize(static_cast<size_t>(buf->sgetn(&buffered[0], sz)));
+        }
+
+        int fd = fcntl(buf->fd(), F_DUPFD_CLOEXEC, 0);
+        buf->close();
+        stream.rdbuf(nullptr);
+        return fd;
+    }
 
 public:
     pid_t child_pid = -1;
@@ -61,7 +560,8 @@ public:
               std::istream& stderr_r,
               const args_type& args,
               const envs_type& envs,
-              bool with_path)
+              bool with_path,
+              spawn::launch_method launch)
         : _stdin(stdin_r)
         , _stdout(stdout_r)
         , _stderr(stderr_r)
@@ -103,9 +603,27 @@ public:
             *penv = NULL;
         }
 
-        child_pid = fork();
-        SRV_ASSERT(child_pid != -1, "Failed to start child process");
-        if (child_pid == 0)
+        if (launch == spawn::launch_method::posix_spawn)
+            child_pid = posix_spawn_child(pargv, penvv, with_path);
+        else
+            child_pid = fork_child(pargv, penvv, with_path);
+
+        _write_pipe.close_read();
+        _read_stdout_pipe.close_write();
+        _read_stderr_pipe.close_write();
+        _write_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_write_pipe.release_write(), std::ios::out));
+        _read_stdout_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_read_stdout_pipe.release_read(), std::ios::in));
+        _read_stderr_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_read_stderr_pipe.release_read(), std::ios::in));
+        _stdin.rdbuf(_write_buf.get());
+        _stdout.rdbuf(_read_stdout_buf.get());
+        _stderr.rdbuf(_read_stderr_buf.get());
+    }
+
+    pid_t fork_child(char** pargv, char** penvv, bool with_path)
+    {
+        pid_t pid = fork();
+        SRV_ASSERT(pid != -1, "Failed to start child process");
+        if (pid == 0)
         {
             dup2(_write_pipe.read_fd(), STDIN_FILENO);
             dup2(_read_stdout_pipe.write_fd(), STDOUT_FILENO);
@@ -130,23 +648,119 @@ public:
             }
             SRV_ASSERT(result != -1, "Failed to execute child process");
         }
+        return pid;
+    }
+
+    pid_t posix_spawn_child(char** pargv, char** penvv, bool with_path)
+    {
+        // glibc creates child by clone(CLONE_VM | CLONE_VFORK).
+        // Page tables of parent are not copied unlike fork
+        posix_spawn_file_actions_t actions;
+        SRV_ASSERT(posix_spawn_file_actions_init(&actions) == 0, "Failed to start child process");
+        // Other pipe ends are closed by O_CLOEXEC
+        posix_spawn_file_actions_adddup2(&actions, _write_pipe.read_fd(), STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, _read_stdout_pipe.write_fd(), STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, _read_stderr_pipe.write_fd(), STDERR_FILENO);
+
+        posix_spawnattr_t attr;
+        SRV_ASSERT(posix_spawnattr_init(&attr) == 0, "Failed to start child process");
+#if defined(POSIX_SPAWN_USEVFORK)
+        // It is default for modern glibc
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_USEVFORK);
+#endif
+
+        pid_t pid = -1;
+        char** penv = penvv ? penvv : environ;
+        int result = with_path ? posix_spawnp(&pid, pargv[0], &actions, &attr, pargv, penv)
+                               : posix_spawn(&pid, pargv[0], &actions, &attr, pargv, penv);
+
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+
+        SRV_ASSERT(result == 0, "Failed to execute child process");
+        return pid;
+    }
+
+    void send_eof()
+    {
+        _write_buf->close();
+    }
+
+    void communicate(int input_fd, const std::string* input, int output_fd)
+    {
+        SRV_ASSERT(!_async, "Stdio is served by event loop");
+
+        std::string stdout_data, stderr_data;
+        pipe_channel in, out, err;
+
+        in.pipe_fd = detach_stdin();
+        in.fd = input_fd;
+        if (input)
+        {
+            in.input = input->data();
+            in.input_size = input->size();
+        }
+
+        out.pipe_fd = detach_output(_read_stdout_buf, _stdout, stdout_data);
+        if (output_fd >= 0)
+        {
+            write_all(output_fd, stdout_data.data(), stdout_data.size());
+            stdout_data.clear();
+            out.fd = output_fd;
+        }
         else
         {
-            close(_write_pipe.read_fd());
-            close(_read_stdout_pipe.write_fd());
-            close(_read_stderr_pipe.write_fd());
-            _write_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_write_pipe.write_fd(), std::ios::out));
-            _read_stdout_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_read_stdout_pipe.read_fd(), std::ios::in));
-            _read_stderr_buf = std::unique_ptr<__gnu_cxx::stdio_filebuf<char>>(new __gnu_cxx::stdio_filebuf<char>(_read_stderr_pipe.read_fd(), std::ios::in));
-            _stdin.rdbuf(_write_buf.get());
-            _stdout.rdbuf(_read_stdout_buf.get());
-            _stderr.rdbuf(_read_stderr_buf.get());
+            out.output = &stdout_data;
+        }
+
+        err.pipe_fd = detach_output(_read_stderr_buf, _stderr, stderr_data);
+        err.output = &stderr_data;
+
+        bool attach_stdout = out.active();
+        bool attach_stderr = err.active();
+
+        transfer(in, out, err);
+
+        if (attach_stdout)
+        {
+            _stdout_data.str(std::move(stdout_data));
+            _stdout.rdbuf(&_stdout_data);
+        }
+        if (attach_stderr)
+        {
+            _stderr_data.str(std::move(stderr_data));
+            _stderr.rdbuf(&_stderr_data);
         }
     }
 
-    void send_eof()
+    void async_io(event_loop& loop,
+                  spawn::output_callback_type&& on_stdout,
+                  spawn::output_callback_type&& on_stderr,
+                  size_t chunk_size)
     {
-        _write_buf->close();
+        SRV_ASSERT(!_async, "Stdio is already served by event loop");
+
+        std::string stdout_buffered, stderr_buffered;
+        int stdin_fd = detach_stdin();
+        int stdout_fd = detach_output(_read_stdout_buf, _stdout, stdout_buffered);
+        int stderr_fd = detach_output(_read_stderr_buf, _stderr, stderr_buffered);
+
+        _async = std::make_shared<spawn_async_stdio>(loop, chunk_size);
+        _async->start(stdin_fd,
+                      stdout_fd, std::move(on_stdout), std::move(stdout_buffered),
+                      stderr_fd, std::move(on_stderr), std::move(stderr_buffered));
+    }
+
+    spawn_async_stdio& async()
+    {
+        SRV_ASSERT(_async, "Stdio is not served by event loop");
+        return *_async;
+    }
+
+    void close_async()
+    {
+        if (_async)
+            _async->close();
     }
 
     int wait()
@@ -173,7 +787,7 @@ spawn::spawn(const args_type& args)
     , stderr(NULL)
 {
     _args = args;
-    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, envs_type {}, false);
+    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, envs_type {}, false, launch_method::posix_spawn);
 }
 
 spawn::spawn(const args_type& args, const envs_type& envs)
@@ -183,7 +797,7 @@ spawn::spawn(const args_type& args, const envs_type& envs)
 {
     _args = args;
     _envs = envs;
-    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, _envs, false);
+    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, _envs, false, launch_method::posix_spawn);
 }
 
 spawn::spawn(const args_type& args, const envs_type& envs, bool with_path)
@@ -193,7 +807,17 @@ spawn::spawn(const args_type& args, const envs_type& envs, bool with_path)
 {
     _args = args;
     _envs = envs;
-    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, _envs, with_path);
+    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, _envs, with_path, launch_method::posix_spawn);
+}
+
+spawn::spawn(const args_type& args, const envs_type& envs, bool with_path, launch_method launch)
+    : stdin(NULL)
+    , stdout(NULL)
+    , stderr(NULL)
+{
+    _args = args;
+    _envs = envs;
+    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, _envs, with_path, launch);
 }
 
 #define SET_ARGS(args)
@@ -205,11 +829,15 @@ spawn::spawn(const args_type& args, bool with_path)
     , stderr(NULL)
 {
     _args = args;
-    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, envs_type {}, with_path);
+    _impl = std::make_unique<spawn_iml>(stdin, stdout, stderr, _args, envs_type {}, with_path, launch_method::posix_spawn);
 }
 
 spawn::~spawn()
 {
+    // Close pipes to not be blocked by process
+    // that writes to full pipe
+    _impl->close_async();
+
     if (-1 == _returnstatus)
     {
         if (!poll())
@@ -243,15 +871,51 @@ bool spawn::poll()
 
 spawn& spawn::communicate(const std::string& input)
 {
-    if (!input.empty())
-    {
-        stdin << input;
-    }
-    _impl->send_eof();
+    _impl->communicate(-1, &input, -1);
     wait();
     return *this;
 }
 
+spawn& spawn::communicate(int input_fd, int output_fd)
+{
+    SRV_ASSERT(input_fd >= 0 && output_fd >= 0);
+
+    _impl->communicate(input_fd, nullptr, output_fd);
+    wait();
+    return *this;
+}
+
+spawn& spawn::async_io(event_loop& loop,
+                       output_callback_type&& on_stdout,
+                       output_callback_type&& on_stderr,
+                       size_t chunk_size)
+{
+    _impl->async_io(loop, std::move(on_stdout), std::move(on_stderr), chunk_size);
+    return *this;
+}
+
+size_t spawn::async_write(std::string data)
+{
+    return _impl->async().write(std::move(data));
+}
+
+spawn& spawn::on_drain(drain_callback_type&& callback, size_t low_watermark)
+{
+    _impl->async().set_drain(std::move(callback), low_watermark);
+    return *this;
+}
+
+spawn& spawn::async_close_stdin()
+{
+    _impl->async().close_stdin();
+    return *this;
+}
+
+size_t spawn::async_pending() const
+{
+    return _impl->async().pending();
+}
+
 spawn& spawn::send_signal(int sig)
 {
     ::kill(_impl->child_pid, sig);
@@ -296,63 +960,156 @@ int spawn::sigcode() const
     return 0;
 }
 
-spawn_polling::spawn_polling(const spawn_ptr& spawn)
-{
-    _break.store(false);
-    _pool_size.store(0);
-    if (spawn)
-        append(spawn);
-    _thread = std::make_unique<std::thread>(std::bind(&spawn_polling::wait, this));
-}
-
-spawn_polling::~spawn_polling()
+class spawn_polling_impl
 {
-    _break.store(true);
-    _thread->join();
-    _thread.reset();
-}
+public:
+    using exit_callback_type = spawn_polling::exit_callback_type;
 
-spawn_polling& spawn_polling::append(const spawn_ptr& spawn)
-{
-    if (!_break)
+    spawn_polling_impl(std::atomic_size_t& pool_size)
+        : _pool_size(pool_size)
     {
-        std::lock_guard<std::mutex> lock(_pool_protector);
-        _pool.push_back(spawn);
-        std::atomic_fetch_add<size_t>(&_pool_size, 1);
+        _loop.change_loop_name("spawn_polling");
+        _loop.start();
     }
-    return *this;
-}
 
-void spawn_polling::wait()
-{
-    while (!_break)
+    ~spawn_polling_impl()
     {
-        std::unique_lock<std::mutex> lock(_pool_protector);
-        decltype(_pool) pool = std::move(_pool);
-        lock.unlock();
-        for (const auto& spawn : pool)
+        try
+        {
+            _loop.wait([this]() {
+                _sigchld.reset();
+                for (auto&& child : _children)
+                {
+                    child.pidfd.reset();
+                    child.spawn->kill();
+                }
+                _children.clear();
+            });
+            _loop.stop();
+        }
+        catch (const std::exception&)
         {
-            bool break_ = _break.load();
-            if (break_ || !spawn->poll())
+        }
+    }
+
+    void append(const spawn_ptr& spawn, exit_callback_type&& callback)
+    {
+        _loop.post([this, spawn, callback = std::move(callback)]() mutable {
+            _children.emplace_back();
+            auto it = std::prev(_children.end());
+            it->spawn = spawn;
+            it->callback = std::move(callback);
+
+            if (!watch_pidfd(it))
             {
-                if (!break_)
-                    lock.lock();
-                _pool.push_back(spawn);
-                if (!break_)
-                    lock.unlock();
+                watch_sigchld();
+                // SIGCHLD could be missed before signal set installation
+                if (it->spawn->poll())
+                    finish(it);
             }
-            else
+        });
+    }
+
+private:
+    struct child
+    {
+        spawn_ptr spawn;
+        exit_callback_type callback;
+        std::unique_ptr<boost::asio::posix::stream_descriptor> pidfd;
+    };
+    using children_type = std::list<child>;
+
+    bool watch_pidfd(children_type::iterator it)
+    {
+#if defined(SYS_pidfd_open)
+        int fd = static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(it->spawn->pid()), 0));
+        if (fd < 0)
+            return false; // ENOSYS for kernels < 5.3
+
+        it->pidfd = std::make_unique<boost::asio::posix::stream_descriptor>(*_loop.service(), fd);
+
+        // pidfd becomes readable when child has finished
+        auto on_exit = [this, it](const boost::system::error_code& ec, auto&&...) {
+            if (ec)
+                return;
+            it->spawn->wait(); // it doesn't block here
+            finish(it);
+        };
+#if BOOST_VERSION >= 106600
+        it->pidfd->async_wait(boost::asio::posix::descriptor_base::wait_read, on_exit);
+#else
+        it->pidfd->async_read_some(boost::asio::null_buffers(), on_exit);
+#endif
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void watch_sigchld()
+    {
+        if (_sigchld)
+            return;
+
+        _sigchld = std::make_unique<boost::asio::signal_set>(*_loop.service(), SIGCHLD);
+        wait_sigchld();
+    }
+
+    void wait_sigchld()
+    {
+        _sigchld->async_wait([this](const boost::system::error_code& ec, int) {
+            if (ec)
+                return;
+
+            // Signals are merged. Check all children that are not watched by pidfd
+            for (auto it = _children.begin(); it != _children.end();)
             {
-                std::atomic_fetch_sub<size_t>(&_pool_size, 1);
+                auto current = it++;
+                if (!current->pidfd && current->spawn->poll())
+                    finish(current);
             }
-        }
+
+            wait_sigchld();
+        });
     }
 
-    for (const auto& spawn : _pool)
+    void finish(children_type::iterator it)
     {
-        spawn->kill();
+        auto spawn = it->spawn;
+        auto callback = std::move(it->callback);
+        _children.erase(it);
+        std::atomic_fetch_sub<size_t>(&_pool_size, 1);
+
+        if (callback)
+            callback(spawn);
     }
-    _pool.clear();
+
+    std::atomic_size_t& _pool_size;
+    children_type _children;
+    std::unique_ptr<boost::asio::signal_set> _sigchld;
+    event_loop _loop;
+};
+
+spawn_polling::spawn_polling(const spawn_ptr& spawn)
+{
+    _pool_size.store(0);
+    _impl = std::make_unique<spawn_polling_impl>(_pool_size);
+    if (spawn)
+        append(spawn);
+}
+
+spawn_polling::~spawn_polling()
+{
+    _impl.reset();
+}
+
+spawn_polling& spawn_polling::append(const spawn_ptr& spawn, exit_callback_type&& callback)
+{
+    SRV_ASSERT(spawn);
+
+    std::atomic_fetch_add<size_t>(&_pool_size, 1);
+    _impl->append(spawn, std::move(callback));
+    return *this;
 }
 
 } // namespace server_lib
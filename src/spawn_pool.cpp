@@ -0,0 +1,415 @@
+#include <server_lib/spawn_pool.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <server_lib/event_loop.h>
+#include <server_lib/network/protocols.h>
+#include <server_lib/asserts.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+
+#include <unistd.h>
+#include <signal.h>
+
+#include "logger_set_internal_group.h"
+
+namespace server_lib {
+
+class spawn_pool_impl
+{
+public:
+    using response_callback_type = spawn_pool::response_callback_type;
+
+    spawn_pool_impl(const spawn::args_type& worker_args,
+                    const size_t nb_workers,
+                    const size_t max_in_flight,
+                    const size_t msg_max_size)
+        : _worker_args(worker_args)
+        , _max_in_flight(max_in_flight ? max_in_flight : nb_workers * 16)
+        , _msg_max_size(msg_max_size)
+        , _protocol(msg_max_size)
+    {
+        SRV_ASSERT(!_worker_args.empty());
+        SRV_ASSERT(nb_workers > 0);
+
+        _workers.reserve(nb_workers);
+        for (size_t ci = 0; ci < nb_workers; ++ci)
+            _workers.emplace_back(std::make_unique<worker>(msg_max_size));
+
+        _loop.change_loop_name("spawn_pool");
+    }
+
+    ~spawn_pool_impl()
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR(e.what());
+        }
+    }
+
+    void start()
+    {
+        if (_loop.is_running())
+            return;
+
+        _stopping = false;
+        _polling = std::make_unique<spawn_polling>();
+        _loop.start();
+        _loop.wait([this]() {
+            for (size_t ci = 0; ci < _workers.size(); ++ci)
+                start_worker(ci);
+        });
+    }
+
+    void stop()
+    {
+        if (!_loop.is_running())
+            return;
+
+        _loop.wait([this]() {
+            _stopping = true;
+            for (auto& w : _workers)
+                fail(w->waiting);
+            fail(_backlog);
+        });
+
+        // Kill workers. No exit callbacks after that
+        _polling.reset();
+
+        _loop.wait([this]() {
+            for (auto& w : _workers)
+                w->process.reset();
+        });
+        _loop.stop();
+    }
+
+    bool request(const std::string& payload, response_callback_type&& callback)
+    {
+        SRV_ASSERT(payload.size() <= _msg_max_size, "Request is too big");
+        SRV_ASSERT(_loop.is_running(), "Pool is not started");
+
+        if (_in_flight.fetch_add(1) >= _max_in_flight)
+        {
+            _in_flight.fetch_sub(1);
+            return false;
+        }
+
+        _loop.post([this, payload, callback]() {
+            if (_stopping)
+            {
+                _in_flight.fetch_sub(1);
+                if (callback)
+                    callback(false, {});
+                return;
+            }
+            _backlog.emplace_back(payload, callback);
+            dispatch();
+        });
+        return true;
+    }
+
+    size_t in_flight() const
+    {
+        return _in_flight.load();
+    }
+
+    size_t restarts() const
+    {
+        return _restarts.load();
+    }
+
+    std::vector<int> worker_pids()
+    {
+        std::vector<int> result;
+        if (!_loop.is_running())
+            return result;
+
+        _loop.wait([this, &result]() {
+            for (auto& w : _workers)
+            {
+                if (w->process)
+                    result.emplace_back(w->process->pid());
+            }
+        });
+        return result;
+    }
+
+private:
+    using request_type = std::pair<std::string, response_callback_type>;
+
+    struct worker
+    {
+        worker(const size_t msg_max_size)
+            : builder(msg_max_size)
+        {
+        }
+
+        spawn_ptr process;
+        std::deque<response_callback_type> waiting;
+        std::string input;
+        network::msg_protocol builder;
+    };
+
+    void start_worker(size_t idx)
+    {
+        auto& w = *_workers[idx];
+        w.input.clear();
+        w.builder.reset();
+
+        try
+        {
+            auto process = std::make_shared<spawn>(_worker_args, spawn::envs_type {}, true, spawn::launch_method::posix_spawn);
+            auto* pprocess = process.get();
+            process->async_io(
+                _loop,
+                [this, idx, pprocess](const char* data, size_t size) {
+                    on_output(idx, pprocess, data, size);
+                },
+                [pprocess](const char* data, size_t size) {
+                    // Logging could be compiled out
+                    (void)pprocess;
+                    (void)data;
+                    if (size > 0)
+                    {
+                        SRV_LOGC_TRACE("Worker " << pprocess->pid() << ": " << std::string(data, size));
+                    }
+                });
+            w.process = process;
+
+            _polling->append(process, [this, idx](const spawn_ptr& process) {
+                _loop.post([this, idx, process]() {
+                    on_worker_exit(idx, process);
+                });
+            });
+
+            SRV_LOGC_TRACE("Worker #" << idx << " has started: " << process->pid());
+        }
+        catch (const std::exception& e)
+        {
+            SRV_LOGC_ERROR("Can't start worker #" << idx << ": " << e.what());
+            restart_worker(idx);
+            return;
+        }
+
+        dispatch();
+    }
+
+    void restart_worker(size_t idx)
+    {
+        // Delay prevents busy restarting for worker crashed at startup
+        _loop.post(std::chrono::milliseconds(100), [this, idx]() {
+            if (!_stopping)
+                start_worker(idx);
+        });
+    }
+
+    void on_worker_exit(size_t idx, const spawn_ptr& process)
+    {
+        auto& w = *_workers[idx];
+        if (_stopping || w.process != process)
+            return;
+
+        SRV_LOGC_WARN("Worker " << process->pid() << " has finished with code " << process->returncode());
+
+        fail(w.waiting);
+        w.process.reset();
+        _restarts.fetch_add(1);
+        restart_worker(idx);
+    }
+
+    void on_output(size_t idx, spawn* pprocess, const char* data, size_t size)
+    {
+        auto& w = *_workers[idx];
+        if (_stopping || w.process.get() != pprocess || !size)
+            return;
+
+        w.input.append(data, size);
+        try
+        {
+            while (!w.input.empty())
+            {
+                w.builder << w.input;
+                if (!w.builder.unit_ready())
+                    break;
+
+                auto response = w.builder.get_unit();
+                w.builder.reset();
+
+                SRV_ASSERT(!w.waiting.empty(), "Unexpected response");
+
+                auto callback = std::move(w.waiting.front());
+                w.waiting.pop_front();
+                _in_flight.fetch_sub(1);
+                if (callback)
+                    callback(true, response.is_string() ? response.as_string() : std::string {});
+            }
+        }
+        catch (const std::exception& e)
+        {
+            // Broken protocol. Worker will be restarted
+            SRV_LOGC_ERROR("Worker " << pprocess->pid() << ": " << e.what());
+            ::kill(pprocess->pid(), SIGKILL);
+            return;
+        }
+
+        dispatch();
+    }
+
+    void dispatch()
+    {
+        while (!_backlog.empty())
+        {
+            worker* pworker = nullptr;
+            for (auto& w : _workers)
+            {
+                if (w->process && (!pworker || w->waiting.size() < pworker->waiting.size()))
+                    pworker = w.get();
+            }
+            if (!pworker)
+                return;
+
+            auto& req = _backlog.front();
+            pworker->process->async_write(_protocol.create(req.first).to_network_string());
+            pworker->waiting.emplace_back(std::move(req.second));
+            _backlog.pop_front();
+        }
+    }
+
+    template <typename Queue>
+    void fail(Queue& queue)
+    {
+        auto failed = std::move(queue);
+        queue.clear();
+        for (auto& item : failed)
+        {
+            _in_flight.fetch_sub(1);
+            call_failed(item);
+        }
+    }
+
+    static void call_failed(response_callback_type& callback)
+    {
+        if (callback)
+            callback(false, {});
+    }
+
+    static void call_failed(request_type& request)
+    {
+        call_failed(request.second);
+    }
+
+    const spawn::args_type _worker_args;
+    const size_t _max_in_flight;
+    const size_t _msg_max_size;
+    const network::msg_protocol _protocol;
+
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::deque<request_type> _backlog;
+    bool _stopping = false;
+
+    std::atomic_size_t _in_flight { 0 };
+    std::atomic_size_t _restarts { 0 };
+
+    std::unique_ptr<spawn_polling> _polling;
+    event_loop _loop;
+};
+
+spawn_pool::spawn_pool(const spawn::args_type& worker_args,
+                       const size_t nb_workers,
+                       const size_t max_in_flight,
+                       const size_t msg_max_size)
+    : _impl(std::make_unique<spawn_pool_impl>(worker_args, nb_workers, max_in_flight, msg_max_size))
+{
+}
+
+spawn_pool::~spawn_pool()
+{
+    _impl.reset();
+}
+
+spawn_pool& spawn_pool::start()
+{
+    _impl->start();
+    return *this;
+}
+
+void spawn_pool::stop()
+{
+    _impl->stop();
+}
+
+bool spawn_pool::request(const std::string& payload, response_callback_type&& callback)
+{
+    return _impl->request(payload, std::move(callback));
+}
+
+size_t spawn_pool::in_flight() const
+{
+    return _impl->in_flight();
+}
+
+size_t spawn_pool::restarts() const
+{
+    return _impl->restarts();
+}
+
+std::vector<int> spawn_pool::worker_pids() const
+{
+    return _impl->worker_pids();
+}
+
+int spawn_pool::serve(request_handler_type&& handler, const size_t msg_max_size)
+{
+    SRV_ASSERT(handler);
+
+    network::msg_protocol protocol { msg_max_size };
+    std::string input;
+    char buff[64 * 1024];
+    while (true)
+    {
+        auto n = ::read(STDIN_FILENO, buff, sizeof(buff));
+        if (n == 0)
+            return 0;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+
+        input.append(buff, static_cast<size_t>(n));
+        while (!input.empty())
+        {
+            protocol << input;
+            if (!protocol.unit_ready())
+                break;
+
+            auto request = protocol.get_unit();
+            protocol.reset();
+
+            auto response = protocol.create(handler(request.is_string() ? request.as_string() : std::string {})).to_network_string();
+            const char* data = response.data();
+            size_t left = response.size();
+            while (left > 0)
+            {
+                auto written = ::write(STDOUT_FILENO, data, left);
+                if (written < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return 1;
+                }
+                data += written;
+                left -= static_cast<size_t>(written);
+            }
+        }
+    }
+}
+
+} // namespace server_lib
+#endif // SERVER_LIB_PLATFORM_LINUX
@@ -0,0 +1,276 @@
+#include "stall_watchdog.h"
+
+#include <server_lib/platform_config.h>
+
+#include <boost/stacktrace.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include "logger_set_internal_group.h"
+
+namespace server_lib {
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+namespace {
+    constexpr size_t max_sample_frames = 64;
+
+    // Only watchdog thread requests samples so single slot is enough
+    struct stack_sample
+    {
+        // Thread that should dump stack. Signal handler claims it by reset
+        std::atomic<long> thread_id { 0 };
+        std::atomic_bool ready { false };
+        size_t frames_count = 0;
+        void* frames[max_sample_frames];
+    };
+
+    stack_sample sample;
+
+    int sample_signal()
+    {
+        return SIGRTMIN + 5;
+    }
+
+    void on_sample_signal(int)
+    {
+        auto saved_errno = errno;
+        long tid = syscall(SYS_gettid);
+        long expected = tid;
+        if (sample.thread_id.compare_exchange_strong(expected, 0))
+        {
+            // Unwinder of glibc steps through signal frame
+            auto count = backtrace(sample.frames, static_cast<int>(max_sample_frames));
+            sample.frames_count = count > 0 ? static_cast<size_t>(count) : 0;
+            sample.ready.store(true);
+        }
+        errno = saved_errno;
+    }
+
+    bool install_sample_handler()
+    {
+        static const bool installed = []() {
+            // The first call loads unwinder library. It is not
+            // safe in signal handler
+            void* frames[1];
+            backtrace(frames, 1);
+
+            struct sigaction action = {};
+            action.sa_handler = on_sample_signal;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            return sigaction(sample_signal(), &action, nullptr) == 0;
+        }();
+        return installed;
+    }
+} // namespace
+#endif
+
+stall_probe::stall_probe(const std::string& loop_name, std::chrono::nanoseconds threshold)
+    : loop_name(loop_name)
+    , threshold(threshold)
+    , handler_started(0)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    native_thread_id = syscall(SYS_gettid);
+    native_handle = pthread_self();
+#endif
+}
+
+stall_watchdog::~stall_watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_one();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+stall_watchdog& stall_watchdog::instance()
+{
+    static stall_watchdog watchdog;
+    return watchdog;
+}
+
+int64_t stall_watchdog::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void stall_watchdog::add(stall_probe* probe)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _probes.emplace_back(probe);
+        if (!_thread.joinable())
+        {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            if (!install_sample_handler())
+            {
+                SRV_LOGC_WARN("Can't install stack sampling handler. Stalls will be logged without stack");
+            }
+#endif
+            _thread = std::thread([this]() { run(); });
+        }
+    }
+    _condition.notify_one();
+}
+
+void stall_watchdog::remove(stall_probe* probe)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _probes.erase(std::remove(_probes.begin(), _probes.end(), probe), _probes.end());
+    // Signal could be sent to thread of this probe right now
+    _sampled_condition.wait(lock, [this, probe]() { return _sampling != probe; });
+}
+
+void stall_watchdog::run()
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    // Don't inherit name of loop thread
+    pthread_setname_np(pthread_self(), "stall_watchdog");
+#endif
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop)
+    {
+        if (_probes.empty())
+        {
+            _condition.wait(lock);
+            continue;
+        }
+
+        // Check several times per threshold to report stall in time
+        auto period = std::chrono::nanoseconds::max();
+        for (auto* probe : _probes)
+            period = std::min(period, probe->threshold / 4);
+        period = std::max<std::chrono::nanoseconds>(period, std::chrono::milliseconds(1));
+
+        _condition.wait_for(lock, period);
+        if (!_stop)
+            check(lock);
+    }
+}
+
+void stall_watchdog::check(std::unique_lock<std::mutex>& lock)
+{
+    struct stall
+    {
+        stall_probe* probe;
+        int64_t started;
+        std::string loop_name;
+        long native_thread_id;
+        std::chrono::nanoseconds duration;
+        std::vector<void*> frames;
+    };
+    std::vector<stall> stalls;
+
+    auto now = now_ns();
+    for (auto* probe : _probes)
+    {
+        auto started = probe->handler_started.load();
+        if (!started || started == probe->reported)
+            continue;
+
+        auto duration = std::chrono::nanoseconds(now - started);
+        if (duration < probe->threshold)
+            continue;
+
+        // Report once per handler
+        probe->reported = started;
+        stalls.push_back({ probe, started, probe->loop_name, probe->native_thread_id, duration, {} });
+    }
+
+    if (stalls.empty())
+        return;
+
+    // Don't keep loops waiting for sampling (remove() waits
+    // only for probe that is being sampled) and logger
+    for (auto&& item : stalls)
+    {
+        // Probe could be removed or handler could be finished while lock was released
+        if (std::find(_probes.begin(), _probes.end(), item.probe) == _probes.end() || item.probe->handler_started.load() != item.started)
+            continue;
+
+        _sampling = item.probe;
+        auto native_thread_id = item.probe->native_thread_id;
+        auto native_handle = item.probe->native_handle;
+        lock.unlock();
+        item.frames = sample_stack(native_thread_id, native_handle);
+        lock.lock();
+        _sampling = nullptr;
+        _sampled_condition.notify_all();
+    }
+
+    lock.unlock();
+    for (auto&& item : stalls)
+    {
+        // Frames are resolved to symbols here (not in signal handler)
+        std::stringstream stack;
+        if (!item.frames.empty())
+        {
+            stack << ". Stack:\n"
+                  << boost::stacktrace::stacktrace::from_dump(item.frames.data(), item.frames.size() * sizeof(void*));
+        }
+
+        SRV_LOGC_WARN("Loop '" << item.loop_name << "' (thread " << item.native_thread_id
+                               << ") is blocked by handler for "
+                               << std::chrono::duration_cast<std::chrono::milliseconds>(item.duration).count()
+                               << " ms" << stack.str());
+    }
+    lock.lock();
+}
+
+std::vector<void*> stall_watchdog::sample_stack(long native_thread_id, std::thread::native_handle_type native_handle)
+{
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    if (!install_sample_handler())
+        return {};
+
+    sample.ready = false;
+    sample.thread_id = native_thread_id;
+    if (pthread_kill(native_handle, sample_signal()) != 0)
+    {
+        sample.thread_id = 0;
+        return {};
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (!sample.ready)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            // Thread could block signal. Cancel if signal handler
+            // has not claimed the request yet
+            if (sample.thread_id.exchange(0) != 0)
+                return {};
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    // Skip frames of signal handler and signal trampoline
+    static constexpr size_t handler_frames = 2;
+    auto count = std::min(sample.frames_count, max_sample_frames);
+    if (count <= handler_frames)
+        return {};
+    return std::vector<void*>(sample.frames + handler_frames, sample.frames + count);
+#else
+    (void)native_thread_id;
+    (void)native_handle;
+    return {};
+#endif
+}
+
+} // namespace server_lib
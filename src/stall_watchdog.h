@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace server_lib {
+
+/**
+ * Loop thread state that is observed by stall_watchdog.
+ * It is created by loop thread for time of run()
+ */
+struct stall_probe
+{
+    stall_probe(const std::string& loop_name, std::chrono::nanoseconds threshold);
+
+    const std::string loop_name;
+    const std::chrono::nanoseconds threshold;
+    // Start of current handler (steady clock, ns). 0 for idle thread
+    std::atomic<int64_t> handler_started;
+    // Nested handlers (poll inside handler)
+    int depth = 0;
+    // Last start that has been reported (watchdog thread only)
+    int64_t reported = 0;
+    long native_thread_id = 0;
+    std::thread::native_handle_type native_handle {};
+};
+
+/**
+ * Single thread that checks loop threads for handlers
+ * that have been running longer than threshold.
+ * Stack of blocked thread is sampled by signal (Linux)
+ * and it is logged with warning
+ */
+class stall_watchdog
+{
+    stall_watchdog() = default;
+
+public:
+    ~stall_watchdog();
+
+    static stall_watchdog& instance();
+
+    void add(stall_probe*);
+    void remove(stall_probe*);
+
+    static int64_t now_ns();
+
+private:
+    void run();
+    void check(std::unique_lock<std::mutex>&);
+    std::vector<void*> sample_stack(long native_thread_id, std::thread::native_handle_type native_handle);
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::vector<stall_probe*> _probes;
+    // Probe of thread that is being sampled without lock
+    stall_probe* _sampling = nullptr;
+    std::condition_variable _sampled_condition;
+    std::thread _thread;
+    bool _stop = false;
+};
+
+} // namespace server_lib
@@ -1,127 +1,223 @@
 #include <server_lib/thread_local_storage.h>
 #include <server_lib/asserts.h>
 
+#include <mutex>
+#include <vector>
+
 #include <memory.h>
 
 namespace server_lib {
 
+namespace {
+    struct tls_buffer
+    {
+        bool created = false;
+        std::vector<unsigned char> data;
+    };
+
+    struct tls_slot
+    {
+        // Generation of storage instance that owns the slot.
+        // 0 for empty slot
+        uint64_t generation = 0;
+        std::vector<tls_buffer> buffers;
+    };
+
+    using tls_slots_type = std::vector<tls_slot>;
+
+    // Slots of calling thread indexed by storage slot.
+    // Pointer is trivially destructible thus it is valid
+    // even after thread_local objects of thread have been destroyed
+    // (static storage instance is destroyed at exit after them)
+    thread_local tls_slots_type* tls_slots = nullptr;
+    thread_local bool tls_slots_released = false;
+
+    // Slots are released at thread exit
+    struct tls_slots_owner
+    {
+        tls_slots_type slots;
+
+        ~tls_slots_owner()
+        {
+            tls_slots = nullptr;
+            tls_slots_released = true;
+        }
+    };
+
+    thread_local tls_slots_owner tls_owner;
+
+    tls_slots_type& own_slots()
+    {
+        if (!tls_slots)
+        {
+            SRV_ASSERT(!tls_slots_released, "Thread local storage has been already released");
+            tls_slots = &tls_owner.slots;
+        }
+        return *tls_slots;
+    }
+
+    // Slot indexes are reused. Generation distinguishes
+    // data of destroyed storage instance
+    class tls_slot_registry
+    {
+    public:
+        void acquire(size_t& slot, uint64_t& generation)
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            if (_free.empty())
+            {
+                slot = _next++;
+            }
+            else
+            {
+                slot = _free.back();
+                _free.pop_back();
+            }
+            generation = ++_generation;
+        }
+
+        void release(size_t slot)
+        {
+            const std::lock_guard<std::mutex> lock(_mutex);
+            _free.push_back(slot);
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<size_t> _free;
+        size_t _next = 0;
+        uint64_t _generation = 0;
+    };
+
+    tls_slot_registry& slot_registry()
+    {
+        static tls_slot_registry registry;
+        return registry;
+    }
+
+    tls_buffer* find_buffer(size_t slot, uint64_t generation, uint8_t buff_idx)
+    {
+        if (!tls_slots || slot >= tls_slots->size())
+            return nullptr;
+
+        auto& tslot = (*tls_slots)[slot];
+        if (tslot.generation != generation)
+            return nullptr;
+
+        auto& buffer = tslot.buffers[buff_idx];
+        return buffer.created ? &buffer : nullptr;
+    }
+
+    tls_buffer& emplace_buffer(size_t slot, uint64_t generation, uint8_t buffers_count, uint8_t buff_idx)
+    {
+        auto& slots = own_slots();
+        if (slot >= slots.size())
+            slots.resize(slot + 1);
+
+        auto& tslot = slots[slot];
+        if (tslot.generation != generation)
+        {
+            // Drop data of destroyed storage
+            tslot.generation = generation;
+            tslot.buffers.clear();
+            tslot.buffers.resize(buffers_count);
+        }
+
+        auto& buffer = tslot.buffers[buff_idx];
+        buffer.created = true;
+        return buffer;
+    }
+} // namespace
+
 thread_local_storage::thread_local_storage(uint8_t buffers_count)
-    : _buffers(buffers_count)
-    , _buffers_count(buffers_count)
+    : _buffers_count(buffers_count)
 {
-    SRV_ASSERT(_buffers.size() > 0);
+    SRV_ASSERT(_buffers_count > 0);
+
+    slot_registry().acquire(_slot, _generation);
 }
 
-size_t thread_local_storage::size(uint8_t buff_idx) const
+thread_local_storage::~thread_local_storage()
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
+    // Release at least data of calling thread immediately
+    // (if slots of thread have not been released yet)
+    if (tls_slots && _slot < tls_slots->size() && (*tls_slots)[_slot].generation == _generation)
+        (*tls_slots)[_slot] = {};
+
+    slot_registry().release(_slot);
+}
 
-    auto tid = std::this_thread::get_id();
+size_t thread_local_storage::size(uint8_t buff_idx) const
+{
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    SRV_ASSERT(it != storage.end());
-    return it->second.size();
+    auto* buffer = find_buffer(_slot, _generation, buff_idx);
+    SRV_ASSERT(buffer);
+    return buffer->data.size();
 }
 
 thread_local_storage::buffers_type* thread_local_storage::create(size_t sz, uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    auto tid = std::this_thread::get_id();
-
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    if (storage.end() == it)
-    {
-        it = storage.emplace(std::piecewise_construct, std::forward_as_tuple(tid), std::forward_as_tuple(sz)).first;
-    }
-    else
-    {
-        it->second.resize(sz);
-        memset(it->second.data(), 0, sz);
-    }
+    auto& buffer = emplace_buffer(_slot, _generation, _buffers_count, buff_idx);
+    buffer.data.resize(sz);
+    memset(buffer.data.data(), 0, sz);
 
-    return it->second.data();
+    return buffer.data.data();
 }
 
 thread_local_storage::buffers_type* thread_local_storage::create(const string_ref& src, uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    auto tid = std::this_thread::get_id();
+    auto& buffer = emplace_buffer(_slot, _generation, _buffers_count, buff_idx);
+    buffer.data.resize(src.size());
+    memcpy(buffer.data.data(), src.data(), src.size());
 
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    if (storage.end() == it)
-    {
-        it = storage.emplace(std::piecewise_construct, std::forward_as_tuple(tid), std::forward_as_tuple(src.size())).first;
-    }
-    else
-    {
-        it->second.resize(src.size());
-    }
-    memcpy(it->second.data(), src.data(), src.size());
-
-    return it->second.data();
+    return buffer.data.data();
 }
 
 thread_local_storage::buffers_type* thread_local_storage::get(uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
-
-    auto tid = std::this_thread::get_id();
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    SRV_ASSERT(storage.end() != it, "Not found");
-    return it->second.data();
+    auto* buffer = find_buffer(_slot, _generation, buff_idx);
+    SRV_ASSERT(buffer, "Not found");
+    return buffer->data.data();
 }
 
 void thread_local_storage::resize(size_t new_sz, uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
     SRV_ASSERT(new_sz > 0, "Invalid size");
 
-    auto tid = std::this_thread::get_id();
-
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    SRV_ASSERT(storage.end() != it, "Not found");
-    it->second.resize(new_sz);
+    auto* buffer = find_buffer(_slot, _generation, buff_idx);
+    SRV_ASSERT(buffer, "Not found");
+    buffer->data.resize(new_sz);
 }
 
 void thread_local_storage::remove(uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
-
-    auto tid = std::this_thread::get_id();
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    if (storage.end() != it)
-        storage.erase(it);
+    auto* buffer = find_buffer(_slot, _generation, buff_idx);
+    if (buffer)
+    {
+        buffer->created = false;
+        buffer->data = {};
+    }
 }
 
 string_ref thread_local_storage::get_ref(uint8_t buff_idx)
 {
-    SRV_ASSERT(buff_idx < _buffers_count.load(), "Unregistered buffer");
-
-    auto tid = std::this_thread::get_id();
+    SRV_ASSERT(buff_idx < _buffers_count, "Unregistered buffer");
 
-    const std::lock_guard<std::mutex> lock(_tid_mutex);
-    auto& storage = _buffers[buff_idx];
-    auto it = storage.find(tid);
-    if (storage.end() == it)
+    auto* buffer = find_buffer(_slot, _generation, buff_idx);
+    if (!buffer)
         return {};
 
-    return { reinterpret_cast<char*>(it->second.data()), it->second.size() };
+    return { reinterpret_cast<char*>(buffer->data.data()), buffer->data.size() };
 }
 
 } // namespace server_lib
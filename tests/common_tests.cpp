@@ -1,11 +1,16 @@
 #include "tests_common.h"
 
 #include <server_lib/asserts.h>
+#include <server_lib/buffer_pool.h>
 #include <server_lib/emergency_helper.h>
 #include <server_lib/logging_helper.h>
+#include <server_lib/memory_arena.h>
 
 #include <boost/filesystem.hpp>
 
+#include <cstring>
+#include <thread>
+
 namespace server_lib {
 namespace tests {
 
@@ -48,6 +53,72 @@ namespace tests {
         BOOST_CHECK_THROW(test_false(), std::logic_error);
     }
 
+    BOOST_AUTO_TEST_CASE(buffer_pool_check)
+    {
+        print_current_test_name();
+
+        // Freed block is reused by the same thread
+        void* p = buffer_pool::allocate(100);
+        BOOST_REQUIRE(p);
+        buffer_pool::deallocate(p, 100);
+        BOOST_REQUIRE_EQUAL(buffer_pool::allocate(128), p);
+        buffer_pool::deallocate(p, 128);
+
+        // Blocks are moved between threads
+        std::vector<void*> blocks;
+        for (size_t ci = 0; ci < 1000; ++ci)
+        {
+            blocks.emplace_back(buffer_pool::allocate(ci % 2 ? 40 : 4000));
+            std::memset(blocks.back(), 0xff, ci % 2 ? 40 : 4000);
+        }
+
+        std::thread th([&blocks]() {
+            for (size_t ci = 0; ci < blocks.size(); ++ci)
+                buffer_pool::deallocate(blocks[ci], ci % 2 ? 40 : 4000);
+
+            pooled_buffer buffer(buffer_pool::max_block_size + 1, 'a');
+            pooled_string str(buffer.begin(), buffer.end());
+            BOOST_CHECK_EQUAL(str.size(), buffer.size());
+        });
+        th.join();
+
+        pooled_buffer buffer { 'a', 'b', 'c' };
+        buffer.resize(10000, 'd');
+        BOOST_CHECK_EQUAL(std::string(buffer.begin(), buffer.begin() + 4), "abcd");
+    }
+
+    BOOST_AUTO_TEST_CASE(memory_arena_check)
+    {
+        print_current_test_name();
+
+        memory_arena arena { 1024 };
+
+        auto* p1 = static_cast<char*>(arena.allocate(10, 1));
+        auto* p2 = static_cast<char*>(arena.allocate(8, 8));
+        BOOST_REQUIRE_EQUAL(reinterpret_cast<uintptr_t>(p2) % 8, 0u);
+        BOOST_REQUIRE_GE(p2, p1 + 10);
+
+        // Big allocation doesn't break current block
+        auto* big = static_cast<char*>(arena.allocate(100 * 1024));
+        std::memset(big, 0xff, 100 * 1024);
+        auto* p3 = static_cast<char*>(arena.allocate(8, 8));
+        BOOST_REQUIRE_EQUAL(p3, p2 + 8);
+        BOOST_REQUIRE_EQUAL(arena.allocated(), 10u + 8u + 100u * 1024u + 8u);
+
+        using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+        std::vector<arena_string, arena_allocator<arena_string>> strings { arena_allocator<arena_string>(arena) };
+        for (size_t ci = 0; ci < 100; ++ci)
+            strings.emplace_back(std::string(100, 'a' + ci % 26).c_str(), strings.get_allocator());
+        BOOST_CHECK_EQUAL(strings[99].c_str(), std::string(100, 'v'));
+        strings.clear();
+        strings.shrink_to_fit();
+
+        // First block is reused
+        arena.reset();
+        BOOST_REQUIRE_EQUAL(arena.allocated(), 0u);
+        BOOST_REQUIRE_EQUAL(arena.allocate(10, 1), static_cast<void*>(p1));
+    }
+
 #if !defined(SERVER_LIB_PLATFORM_WINDOWS)
     BOOST_AUTO_TEST_CASE(stack_check)
     {
@@ -3,6 +3,14 @@
 #include <server_lib/logging_helper.h>
 #include <server_lib/event_loop.h>
 #include <server_lib/event_pool.h>
+#include <server_lib/sampling_profiler.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 
 namespace server_lib {
@@ -381,6 +389,193 @@ namespace tests {
         BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
     }
 
+    BOOST_AUTO_TEST_CASE(event_loop_busy_poll_check)
+    {
+        print_current_test_name();
+
+        for (auto spin_budget : { std::chrono::microseconds { 500 }, std::chrono::microseconds::max() })
+        {
+            server_lib::event_loop loop;
+
+            BOOST_REQUIRE_NO_THROW(loop.change_loop_name("BP").enable_busy_poll(spin_budget).pin_to_cpu(0).start());
+            BOOST_REQUIRE(loop.is_busy_poll());
+
+            // Both immediate and delayed callbacks are invoked
+            // after spin budget has expired
+            for (size_t ci = 0; ci < 3; ++ci)
+            {
+                int value = 0;
+                loop.wait([&]() {
+                    ++value;
+                });
+                BOOST_REQUIRE_EQUAL(value, 1);
+
+                std::this_thread::sleep_for(2ms);
+            }
+
+            bool done_test = false;
+            std::mutex done_test_cond_guard;
+            std::condition_variable done_test_cond;
+
+            loop.post(5ms, [&]() {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                BOOST_REQUIRE_EQUAL(pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset), 0);
+                BOOST_CHECK_EQUAL(CPU_COUNT(&cpuset), 1);
+                BOOST_CHECK(CPU_ISSET(0, &cpuset));
+#endif
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            });
+
+            BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+            BOOST_REQUIRE_NO_THROW(loop.stop());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(event_loop_thread_options_check)
+    {
+        print_current_test_name();
+
+        BOOST_CHECK(server_lib::event_loop::numa_node_cpus(100000).empty());
+
+        server_lib::event_loop loop;
+
+        BOOST_CHECK_THROW(loop.bind_to_numa_node(100000), std::logic_error);
+        BOOST_CHECK_THROW(loop.set_nice(20), std::logic_error);
+
+        auto node_cpus = server_lib::event_loop::numa_node_cpus(0);
+        if (!node_cpus.empty())
+            loop.bind_to_numa_node(0);
+
+        // Nice value can be raised without privileges
+        BOOST_REQUIRE_NO_THROW(loop.change_loop_name("TO").set_nice(5).start());
+
+        loop.wait([&]() {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            errno = 0;
+            auto nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+            BOOST_CHECK_EQUAL(nice, 5);
+
+            if (!node_cpus.empty())
+            {
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                BOOST_REQUIRE_EQUAL(pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset), 0);
+                BOOST_CHECK_EQUAL(static_cast<size_t>(CPU_COUNT(&cpuset)), node_cpus.size());
+                for (auto cpu : node_cpus)
+                    BOOST_CHECK(CPU_ISSET(cpu, &cpuset));
+            }
+#endif
+        });
+
+        // Options for running loop are applied in loop thread
+        BOOST_REQUIRE_NO_THROW(loop.set_nice(6));
+        loop.wait([&]() {
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+            BOOST_CHECK_EQUAL(getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid))), 6);
+#endif
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE(event_loop_stats_check)
+    {
+        print_current_test_name();
+
+        server_lib::latency_histogram histogram;
+        for (int ci = 1; ci <= 1000; ++ci)
+            histogram.record(std::chrono::microseconds(ci));
+
+        auto summary = histogram.summary();
+        BOOST_CHECK_EQUAL(summary.count, 1000u);
+        BOOST_CHECK(summary.min == 1us);
+        BOOST_CHECK(summary.max == 1000us);
+        // Relative error is less than 1/16
+        BOOST_CHECK_GE(summary.p50.count(), 500000);
+        BOOST_CHECK_LE(summary.p50.count(), 500000 + 500000 / 16);
+        BOOST_CHECK_GE(summary.p99.count(), 990000);
+        BOOST_CHECK(summary.p999 <= summary.max);
+
+        server_lib::event_loop loop;
+
+        BOOST_REQUIRE_NO_THROW(loop.change_loop_name("ST").set_stall_threshold(20ms).start());
+        BOOST_REQUIRE(loop.is_stats_enabled());
+
+        // Queue is stuffed while the first handler is blocking loop
+        loop.post([]() {
+            std::this_thread::sleep_for(50ms);
+        });
+        for (size_t ci = 0; ci < 10; ++ci)
+            loop.post([]() {});
+        loop.wait([]() {});
+
+        auto stats = loop.stats();
+        BOOST_CHECK_GE(stats.posts, 12u);
+        BOOST_CHECK_GE(stats.executed, 12u);
+        BOOST_CHECK_GE(stats.max_queue_size, 11u);
+        // Only the last handler could be finishing
+        BOOST_CHECK_LE(stats.queue_size, 1u);
+        BOOST_CHECK_EQUAL(stats.stalls, 1u);
+        BOOST_CHECK_GT(stats.posts_per_sec, 0);
+        BOOST_CHECK(stats.handler_duration.max >= 50ms);
+        BOOST_CHECK(stats.queue_latency.max >= 40ms);
+
+        loop.reset_stats();
+        BOOST_REQUIRE_NO_THROW(loop.enable_stats(false));
+        loop.wait([]() {});
+
+        stats = loop.stats();
+        BOOST_CHECK_EQUAL(stats.posts, 0u);
+        BOOST_CHECK_EQUAL(stats.queue_latency.count, 0u);
+        BOOST_CHECK_EQUAL(stats.stalls, 0u);
+    }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    BOOST_AUTO_TEST_CASE(sampling_profiler_check)
+    {
+        print_current_test_name();
+
+        auto& profiler = server_lib::sampling_profiler::instance();
+
+        server_lib::event_loop loop;
+
+        BOOST_REQUIRE_NO_THROW(loop.change_loop_name("PR").start());
+        loop.wait([]() {});
+
+        BOOST_REQUIRE(profiler.start(1ms));
+        BOOST_CHECK(!profiler.start());
+        BOOST_CHECK(profiler.is_running());
+
+        // Only CPU time of loop thread is sampled
+        loop.wait([]() {
+            volatile uint64_t value = 0;
+            auto finish = std::chrono::steady_clock::now() + 300ms;
+            while (std::chrono::steady_clock::now() < finish)
+                value = value + 1;
+        });
+
+        profiler.stop();
+        BOOST_CHECK(!profiler.is_running());
+        BOOST_REQUIRE_GT(profiler.samples(), 0u);
+        BOOST_CHECK_EQUAL(profiler.dropped(), 0u);
+
+        auto stacks = profiler.collapsed_stacks();
+        BOOST_REQUIRE(!stacks.empty());
+        std::stringstream ss(stacks);
+        std::string line;
+        while (std::getline(ss, line))
+        {
+            BOOST_CHECK_EQUAL(line.find("PR;"), 0u);
+            // Line ends with sample count
+            auto pos = line.rfind(' ');
+            BOOST_REQUIRE(pos != std::string::npos);
+            BOOST_CHECK_GT(std::stoul(line.substr(pos + 1)), 0u);
+        }
+    }
+#endif
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,244 @@
+#include "tests_common.h"
+
+#include <server_lib/log_files_watchdog.h>
+#include <server_lib/logging_helper.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/copy.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace server_lib {
+namespace tests {
+
+    namespace bfs = boost::filesystem;
+
+    class temporary_log_dir
+    {
+    public:
+        temporary_log_dir()
+        {
+            _dir = bfs::temp_directory_path() / bfs::unique_path();
+            bfs::create_directories(_dir);
+        }
+
+        ~temporary_log_dir()
+        {
+            boost::system::error_code ec;
+            bfs::remove_all(_dir, ec);
+        }
+
+        const bfs::path& dir() const
+        {
+            return _dir;
+        }
+
+        void create_log(const std::string& file_name)
+        {
+            std::ofstream output { (_dir / file_name).generic_string() };
+            output << current_test_name() << " message\n";
+        }
+
+        size_t count_logs(const std::string& extension) const
+        {
+            size_t result = 0;
+            for (bfs::directory_iterator it(_dir), endit; it != endit; ++it)
+            {
+                if (it->path().extension() == extension)
+                    ++result;
+            }
+            return result;
+        }
+
+        bool waiting_for_logs(const std::string& extension, const size_t expected, size_t sec_timeout = 10) const
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(sec_timeout);
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                if (count_logs(extension) == expected)
+                    return true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+
+    private:
+        bfs::path _dir;
+    };
+
+    BOOST_FIXTURE_TEST_SUITE(log_files_watchdog_tests, temporary_log_dir)
+
+    BOOST_AUTO_TEST_CASE(compress_log_check)
+    {
+        print_current_test_name();
+
+        namespace bio = boost::iostreams;
+
+        std::string data;
+        for (size_t ci = 0; ci < 1000; ++ci)
+        {
+            data.append(current_test_name());
+            data.append(" message ");
+            data.append(std::to_string(ci));
+            data.push_back('\n');
+        }
+
+        auto file = dir() / "test_1.log";
+        {
+            std::ofstream output { file.generic_string(), std::ios_base::binary };
+            output << data;
+        }
+
+        auto stats = log_files_watchdog::compress_log(file);
+
+        BOOST_REQUIRE_EQUAL(stats.files, 1u);
+        BOOST_REQUIRE_EQUAL(stats.input_bytes, data.size());
+        BOOST_REQUIRE_GT(stats.output_bytes, 0u);
+        BOOST_REQUIRE_LT(stats.output_bytes, stats.input_bytes);
+
+        BOOST_REQUIRE(!bfs::exists(file));
+        auto packed_file = dir() / "test_1.log.gz";
+        BOOST_REQUIRE(bfs::exists(packed_file));
+
+        std::ifstream input { packed_file.generic_string(), std::ios_base::binary };
+        bio::filtering_istreambuf decompressor;
+        decompressor.push(bio::gzip_decompressor {});
+        decompressor.push(input);
+        std::stringstream unpacked;
+        bio::copy(decompressor, unpacked);
+
+        BOOST_REQUIRE_EQUAL(unpacked.str(), data);
+    }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    BOOST_AUTO_TEST_CASE(compress_log_write_error_check)
+    {
+        print_current_test_name();
+
+        auto file = dir() / "test_1.log";
+        {
+            std::ofstream output { file.generic_string(), std::ios_base::binary };
+            for (size_t ci = 0; ci < 1000; ++ci)
+                output << current_test_name() << " message " << ci << '\n';
+        }
+
+        // Every write fails with ENOSPC
+        auto tmp_file = dir() / "test_1.log.gz.tmp";
+        bfs::create_symlink("/dev/full", tmp_file);
+
+        BOOST_REQUIRE_THROW(log_files_watchdog::compress_log(file), std::logic_error);
+
+        BOOST_REQUIRE(bfs::exists(file));
+        BOOST_REQUIRE(!bfs::exists(dir() / "test_1.log.gz"));
+        BOOST_REQUIRE(!bfs::exists(bfs::symlink_status(tmp_file)));
+    }
+#endif
+
+    BOOST_AUTO_TEST_CASE(rotation_handler_check)
+    {
+        print_current_test_name();
+
+        create_log("test_1.log");
+
+        logger::rotation_handler_type handler;
+        {
+            log_files_watchdog watchdog { dir(), "test_", "%N", ".log", 1 };
+
+            handler = watchdog.rotation_handler(log_files_watchdog::remove_log);
+            watchdog.start();
+
+            handler((dir() / "test_1.log").generic_string());
+
+            BOOST_REQUIRE(waiting_for_logs(".log", 0));
+        }
+
+        create_log("test_2.log");
+
+        // Watchdog is destroyed
+        handler((dir() / "test_2.log").generic_string());
+
+        BOOST_REQUIRE(bfs::exists(dir() / "test_2.log"));
+    }
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    BOOST_AUTO_TEST_CASE(auto_watch_action_check)
+    {
+        print_current_test_name();
+
+        const size_t max_files = 3;
+
+        create_log("test_1.log");
+        create_log("test_2.log");
+
+        log_files_watchdog watchdog { dir(), "test_", "%N", ".log", max_files };
+
+        watchdog.auto_watch(log_files_watchdog::remove_log);
+        watchdog.start();
+
+        for (size_t ci = 3; ci <= 10; ++ci)
+        {
+            create_log("test_" + std::to_string(ci) + ".log");
+        }
+        // Not matched
+        create_log("other_1.log");
+
+        BOOST_REQUIRE(waiting_for_logs(".log", max_files + 1));
+        BOOST_REQUIRE(bfs::exists(dir() / "other_1.log"));
+    }
+
+    BOOST_AUTO_TEST_CASE(auto_watch_strategy_check)
+    {
+        print_current_test_name();
+
+        const size_t max_files = 2;
+
+        log_files_watchdog watchdog { dir(), "test_", "%N", ".log", max_files };
+
+        watchdog.auto_watch(log_files_watchdog::remove_excess_logs);
+        watchdog.start();
+
+        for (size_t ci = 1; ci <= 5; ++ci)
+        {
+            create_log("test_" + std::to_string(ci) + ".log");
+        }
+
+        BOOST_REQUIRE(waiting_for_logs(".log", max_files));
+    }
+
+    BOOST_AUTO_TEST_CASE(auto_compress_check)
+    {
+        print_current_test_name();
+
+        const size_t max_files = 2;
+        const size_t total_files = 8;
+
+        log_files_watchdog watchdog { dir(), "test_", "%N", ".log", max_files };
+
+        watchdog.auto_compress(2);
+        watchdog.start();
+
+        for (size_t ci = 1; ci <= total_files; ++ci)
+        {
+            create_log("test_" + std::to_string(ci) + ".log");
+        }
+
+        BOOST_REQUIRE(waiting_for_logs(".gz", total_files - max_files));
+        BOOST_REQUIRE_EQUAL(count_logs(".log"), max_files);
+
+        // Wait for workers
+        watchdog.stop();
+
+        auto stats = watchdog.compression_stats();
+        BOOST_REQUIRE_EQUAL(stats.files, total_files - max_files);
+        BOOST_REQUIRE_GT(stats.input_bytes, 0u);
+    }
+#endif
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
@@ -267,7 +267,7 @@ namespace tests {
 
         flush();
 
-        std::ifstream input(tmp_log);
+        std::ifstream input(tmp_log_segment);
 
         size_t rows = 0;
         for (std::string line; std::getline(input, line); ++rows)
@@ -331,7 +331,7 @@ namespace tests {
         BOOST_REQUIRE_GE(log_size, 1);
         BOOST_REQUIRE_LE(log_size, 1024);
 
-        std::ifstream input(tmp_log);
+        std::ifstream input(tmp_log_segment);
 
         size_t rows = 0;
         for (std::string line; std::getline(input, line); ++rows)
@@ -341,6 +341,113 @@ namespace tests {
         BOOST_REQUIRE_GE(rows, 1);
     }
 
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+    BOOST_AUTO_TEST_CASE(mmap_file_logger_level_check)
+    {
+        print_current_test_name();
+
+        auto tmp_log = create_temp_file(current_test_name());
+        auto tmp_log_pattern = tmp_log + "_%N.log";
+        auto tmp_log_segment = tmp_log + "_0.log";
+
+        set_level(logger::level_debug).init_mmap_file_log(tmp_log_pattern.c_str(), 1);
+
+        LOG_TRACE(current_test_name() << " message");
+        LOG_DEBUG(current_test_name() << " message");
+        LOG_INFO(current_test_name() << " message");
+        LOG_WARN(current_test_name() << " message");
+        LOG_ERROR(current_test_name() << " message");
+        LOG_FATAL(current_test_name() << " message");
+
+        flush();
+
+        std::ifstream input(tmp_log_segment);
+
+        size_t rows = 0;
+        for (std::string line; std::getline(input, line) && !line.empty() && line[0]; ++rows)
+        {
+            switch (rows)
+            {
+            case 0:
+            {
+                BOOST_REQUIRE(line.find("[debug]") != std::string::npos);
+                break;
+            }
+            case 4:
+            {
+                BOOST_REQUIRE(line.find("[fatal]") != std::string::npos);
+                break;
+            }
+            default:;
+            }
+        }
+
+        BOOST_REQUIRE_EQUAL(rows, 5);
+
+        input.close();
+        boost::filesystem::remove(tmp_log_segment);
+    }
+
+    BOOST_AUTO_TEST_CASE(mmap_file_logger_without_counter_check)
+    {
+        print_current_test_name();
+
+        auto tmp_log = create_temp_file(current_test_name());
+
+        BOOST_REQUIRE_THROW(init_mmap_file_log(tmp_log.c_str(), 1), std::logic_error);
+    }
+
+    BOOST_AUTO_TEST_CASE(mmap_file_logger_rotation_check)
+    {
+        print_current_test_name();
+
+        auto tmp_log = create_temp_file(current_test_name());
+        auto tmp_log_pattern = tmp_log + "_%N.log";
+
+        std::mutex rotated_guard;
+        std::vector<std::string> rotated;
+
+        set_level(logger::level_debug).init_mmap_file_log(tmp_log_pattern.c_str(), 1, [&](const std::string& file_path) {
+            std::lock_guard<std::mutex> lck(rotated_guard);
+            rotated.emplace_back(file_path);
+        });
+
+        for (size_t ci = 0; ci < 100; ++ci)
+        {
+            LOG_DEBUG(current_test_name() << " message");
+            LOG_INFO(current_test_name() << " message");
+        }
+
+        flush();
+
+        // Replace destination to close the last segment
+        init_cli_log();
+
+        std::lock_guard<std::mutex> lck(rotated_guard);
+
+        BOOST_REQUIRE_GT(rotated.size(), 1);
+
+        for (size_t ci = 0; ci < rotated.size(); ++ci)
+        {
+            BOOST_REQUIRE_EQUAL(rotated[ci], tmp_log + "_" + std::to_string(ci) + ".log");
+
+            size_t log_size = static_cast<size_t>(boost::filesystem::file_size(rotated[ci]));
+
+            BOOST_REQUIRE_GE(log_size, 1);
+            BOOST_REQUIRE_LE(log_size, 1024);
+
+            std::ifstream input(rotated[ci]);
+            std::string line;
+            BOOST_REQUIRE(std::getline(input, line));
+            BOOST_REQUIRE(line.find(" message") != std::string::npos);
+            input.close();
+
+            boost::filesystem::remove(rotated[ci]);
+        }
+        BOOST_REQUIRE(!boost::filesystem::exists(tmp_log + "_" + std::to_string(rotated.size()) + ".log"));
+    }
+#endif
+
     BOOST_AUTO_TEST_CASE(cli_alternative_check)
     {
         print_current_test_name();
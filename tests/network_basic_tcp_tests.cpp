@@ -814,6 +814,461 @@ namespace tests {
         BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
     }
 
+
+    BOOST_AUTO_TEST_CASE(tcp_stats_check)
+    {
+        print_current_test_name();
+
+        msg_protocol protocol;
+
+        server server;
+        client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string ping_cmd = "ping";
+        const std::string pong_cmd = "pong";
+        const size_t pings = 10;
+
+        size_t pongs = 0;
+        connection_stats client_connection_stats;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_receive([&](pconnection pconn, unit) {
+                BOOST_REQUIRE_NO_THROW(pconn->send(pong_cmd));
+            });
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), pong_cmd);
+
+            if (++pongs < pings)
+            {
+                BOOST_REQUIRE_NO_THROW(pconn->send(ping_cmd));
+                return;
+            }
+
+            client_connection_stats = pconn->stats();
+
+            // Finish test
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                    pconn->on_receive(client_recieve_callback);
+                                    BOOST_REQUIRE_NO_THROW(pconn->send(ping_cmd));
+                                })
+                              .connect(
+                                  client.configurate_tcp()
+                                      .set_worker_name("!C-T")
+                                      .set_address(host, port)
+                                      .set_protocol(protocol)));
+        };
+
+        server.on_start(
+                  [&]() {
+                      client_run();
+                  })
+            .on_new_connection(
+                server_new_connection_callback)
+            .start(
+                server.configurate_tcp()
+                    .set_worker_name("!S-T")
+                    .set_address(host, port)
+                    .set_protocol(protocol));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK_EQUAL(client_connection_stats.units_in, pings);
+        BOOST_CHECK_EQUAL(client_connection_stats.units_out, pings);
+        BOOST_CHECK_EQUAL(client_connection_stats.rtt_count, pings);
+        BOOST_CHECK_GT(client_connection_stats.rtt_max.count(), 0);
+        BOOST_CHECK_GE(client_connection_stats.bytes_in, pings * pong_cmd.size());
+        BOOST_CHECK_GE(client_connection_stats.bytes_out, pings * ping_cmd.size());
+        BOOST_CHECK_GT(client_connection_stats.read_calls, 0u);
+
+        auto client_stats = client.stats();
+        BOOST_CHECK_EQUAL(client_stats.connections, 1u);
+        BOOST_CHECK_EQUAL(client_stats.active_connections, 1u);
+        BOOST_CHECK_EQUAL(client_stats.units_in, pings);
+        BOOST_CHECK_EQUAL(client_stats.rtt.count, pings);
+
+        auto server_stats = server.stats();
+        BOOST_CHECK_EQUAL(server_stats.connections, 1u);
+        BOOST_CHECK_EQUAL(server_stats.units_in, pings);
+        BOOST_CHECK_EQUAL(server_stats.bytes_in, client_connection_stats.bytes_out);
+    }
+
+    BOOST_AUTO_TEST_CASE(tcp_io_uring_check)
+    {
+        print_current_test_name();
+
+        // Falls back to epoll if kernel doesn't support io_uring
+        const size_t chunk_size = 1024;
+        msg_protocol protocol { 20 * chunk_size };
+
+        server server;
+        client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        // Small units are sent together from registered buffer,
+        // large one is sent by sendmsg and received by several chunks
+        std::vector<std::string> units = { "first",
+                                           std::string(10 * chunk_size, 'x'),
+                                           "third" };
+        const size_t pings = 20;
+        for (size_t ci = 0; ci < pings; ++ci)
+            units.emplace_back("ping " + std::to_string(ci));
+
+        std::vector<std::string> received;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            BOOST_REQUIRE(pconn);
+
+            BOOST_CHECK_EQUAL(pconn->remote_endpoint(), host);
+
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                     // Echo
+                     BOOST_REQUIRE_NO_THROW(pconn->send(unit.as_string()));
+                 })
+                .on_disconnect([&](size_t) {
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    done_test = true;
+                    done_test_cond.notify_one();
+                });
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE(unit.is_string());
+
+            received.emplace_back(unit.as_string());
+            if (received.size() == units.size())
+                pconn->disconnect();
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                    pconn->on_receive(client_recieve_callback);
+
+                                    for (auto&& unit : units)
+                                        pconn->post(unit);
+                                    BOOST_REQUIRE_NO_THROW(pconn->commit());
+                                })
+                              .connect(
+                                  client.configurate_tcp()
+                                      .set_worker_name("!C-T")
+                                      .set_address(host, port)
+                                      .set_chunk_size(chunk_size)
+                                      .set_timeout_connect(1s)
+                                      .enable_io_uring(64, 64)
+                                      .set_protocol(protocol)));
+        };
+
+        BOOST_REQUIRE(server.on_start(client_run)
+                          .on_new_connection(server_new_connection_callback)
+                          .start(
+                              server.configurate_tcp()
+                                  .set_worker_name("!S-T")
+                                  .set_address(host, port)
+                                  .set_chunk_size(chunk_size)
+                                  .enable_io_uring(64, 64)
+                                  .set_protocol(protocol)
+                                  .set_worker_threads(2))
+                          .wait());
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK(received == units);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(tcp_io_uring_fail_client_connection_check)
+    {
+        print_current_test_name();
+
+        event_loop client_th;
+
+        client_th.change_loop_name("!C");
+
+        msg_protocol protocol;
+
+        client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto client_fail_callback = [&](const std::string& err) {
+            LOG_TRACE("********* client_fail_callback: " << err);
+
+            client_th.post([&] {
+                // Finish test
+                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                done_test = true;
+                done_test_cond.notify_one();
+            });
+        };
+
+        auto client_run = [&]() {
+            LOG_TRACE("********* client run");
+
+            // Connection is linked with timeout
+            BOOST_REQUIRE(client.on_fail(client_fail_callback)
+                              .connect(
+                                  client.configurate_tcp()
+                                      .set_worker_name("!C-T")
+                                      .set_address(host, port)
+                                      .set_timeout_connect(1s)
+                                      .enable_io_uring()
+                                      .set_protocol(protocol)));
+        };
+
+        client_th.on_start(client_run).start();
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+    }
+
+    BOOST_AUTO_TEST_CASE(tcp_read_chain_check)
+    {
+        print_current_test_name();
+
+        const size_t chunk_size = 1024;
+        msg_protocol protocol { 200 * chunk_size };
+
+        server server;
+        client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        std::vector<std::string> units = { "first",
+                                           std::string(100 * chunk_size, 'x'),
+                                           "third" };
+        const size_t pings = 20;
+        for (size_t ci = 0; ci < pings; ++ci)
+            units.emplace_back("ping " + std::to_string(ci));
+
+        std::vector<std::string> received;
+        connection_stats server_stats;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                     // Echo
+                     BOOST_REQUIRE_NO_THROW(pconn->send(unit.as_string()));
+                 })
+                .on_disconnect([&, weak_pconn = std::weak_ptr<connection>(pconn)]() {
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    auto pconn = weak_pconn.lock();
+                    BOOST_REQUIRE(pconn);
+                    server_stats = pconn->stats();
+                    done_test = true;
+                    done_test_cond.notify_one();
+                });
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE(unit.is_string());
+
+            received.emplace_back(unit.as_string());
+            if (received.size() == units.size())
+                pconn->disconnect();
+        };
+
+        auto client_run = [&]() {
+            // Adaptive block is read by one call
+            BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                    pconn->on_receive(client_recieve_callback);
+
+                                    for (auto&& unit : units)
+                                        pconn->post(unit);
+                                    BOOST_REQUIRE_NO_THROW(pconn->commit());
+                                })
+                              .connect(
+                                  client.configurate_tcp()
+                                      .set_worker_name("!C-T")
+                                      .set_address(host, port)
+                                      .set_chunk_size(chunk_size)
+                                      .enable_adaptive_chunk_size(64 * chunk_size)
+                                      .set_protocol(protocol)));
+        };
+
+        // Blocks are read by scatter calls until socket would block
+        BOOST_REQUIRE(server.on_start(client_run)
+                          .on_new_connection(server_new_connection_callback)
+                          .start(
+                              server.configurate_tcp()
+                                  .set_worker_name("!S-T")
+                                  .set_address(host, port)
+                                  .set_chunk_size(chunk_size)
+                                  .enable_adaptive_chunk_size(16 * chunk_size)
+                                  .set_read_chain(4)
+                                  .enable_read_until_would_block()
+                                  .set_protocol(protocol))
+                          .wait());
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK(received == units);
+        BOOST_CHECK_EQUAL(server_stats.units_in, units.size());
+        BOOST_CHECK_LT(server_stats.read_calls, server_stats.bytes_in / chunk_size);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(tcp_pipe_check)
+    {
+        print_current_test_name();
+
+        const size_t chunk_size = 1024;
+        msg_protocol protocol { 200 * chunk_size };
+
+        server backend;
+        server proxy;
+        client upstream;
+        client client;
+
+        std::string host = get_default_address();
+        auto backend_port = get_free_port();
+        auto proxy_port = get_free_port();
+        while (proxy_port == backend_port)
+            proxy_port = get_free_port();
+
+        // Large unit is relayed by several transfers
+        std::vector<std::string> units = { "first",
+                                           std::string(100 * chunk_size, 'x'),
+                                           "third" };
+        const size_t pings = 20;
+        for (size_t ci = 0; ci < pings; ++ci)
+            units.emplace_back("ping " + std::to_string(ci));
+
+        size_t units_size = 0;
+        for (auto&& unit : units)
+            units_size += protocol.create(unit).to_network_string().size();
+
+        std::vector<std::string> received;
+        connection_stats inbound_stats;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto backend_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                     // Echo
+                     BOOST_REQUIRE_NO_THROW(pconn->send(unit.as_string()));
+                 })
+                .on_disconnect([&](size_t) {
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    done_test = true;
+                    done_test_cond.notify_one();
+                });
+        };
+
+        auto proxy_new_connection_callback = [&](pconnection inbound) {
+            inbound->on_receive([&](pconnection inbound, unit unit) {
+                BOOST_REQUIRE_EQUAL(unit.as_string(), "hello");
+
+                // Peer waits for response so nothing is dropped by piping
+                BOOST_REQUIRE(upstream.on_connect([&, inbound](pconnection pconn) {
+                                          inbound->send(std::string { "ready" });
+
+                                          pconn->pipe_to(inbound);
+                                          inbound->pipe_to(pconn);
+                                          inbound->on_disconnect([&, pconn]() {
+                                              inbound_stats = inbound->stats();
+                                              pconn->disconnect();
+                                          });
+                                      })
+                                  .connect(
+                                      upstream.configurate_tcp()
+                                          .set_worker_name("!U-T")
+                                          .set_address(host, backend_port)
+                                          .set_chunk_size(chunk_size)
+                                          .set_protocol(protocol)));
+            });
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE(unit.is_string());
+
+            if (unit.as_string() == "ready")
+            {
+                for (auto&& unit : units)
+                    pconn->post(unit);
+                BOOST_REQUIRE_NO_THROW(pconn->commit());
+                return;
+            }
+
+            received.emplace_back(unit.as_string());
+            if (received.size() == units.size())
+                pconn->disconnect();
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                    pconn->on_receive(client_recieve_callback);
+                                    BOOST_REQUIRE_NO_THROW(pconn->send(std::string { "hello" }));
+                                })
+                              .connect(
+                                  client.configurate_tcp()
+                                      .set_worker_name("!C-T")
+                                      .set_address(host, proxy_port)
+                                      .set_chunk_size(chunk_size)
+                                      .set_protocol(protocol)));
+        };
+
+        BOOST_REQUIRE(backend.on_new_connection(backend_new_connection_callback)
+                          .start(
+                              backend.configurate_tcp()
+                                  .set_worker_name("!S-T")
+                                  .set_address(host, backend_port)
+                                  .set_chunk_size(chunk_size)
+                                  .set_protocol(protocol))
+                          .wait());
+
+        BOOST_REQUIRE(proxy.on_start(client_run)
+                          .on_new_connection(proxy_new_connection_callback)
+                          .start(
+                              proxy.configurate_tcp()
+                                  .set_worker_name("!P-T")
+                                  .set_address(host, proxy_port)
+                                  .set_chunk_size(chunk_size)
+                                  .set_protocol(protocol))
+                          .wait());
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK(received == units);
+        // Relayed bytes are counted without units
+        BOOST_CHECK_EQUAL(inbound_stats.bytes_in, protocol.create("hello").to_network_string().size() + units_size);
+        BOOST_CHECK_EQUAL(inbound_stats.units_in, 1u);
+
+        proxy.stop();
+        backend.stop();
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
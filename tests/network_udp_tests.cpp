@@ -0,0 +1,177 @@
+#include <server_lib/platform_config.h>
+
+#if defined(SERVER_LIB_PLATFORM_LINUX)
+#include "network_common.h"
+
+#include <server_lib/event_loop.h>
+#include <server_lib/logging_helper.h>
+
+#include <server_lib/network/server.h>
+#include <server_lib/network/client.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <set>
+
+namespace server_lib {
+namespace tests {
+
+    using namespace server_lib::network;
+    using namespace std::chrono_literals;
+
+    BOOST_FIXTURE_TEST_SUITE(network_udp_tests, basic_network_fixture)
+
+    void udp_echo_test(basic_network_fixture& fixture, bool offload)
+    {
+        server server;
+        client client;
+
+        std::string host = fixture.get_default_address();
+        auto port = fixture.get_free_port();
+
+        // Equal sized datagrams could be sent by single GSO message
+        const size_t datagrams = 100;
+        const size_t batch_size = 8;
+        auto make_datagram = [](size_t index) {
+            return std::string(200, static_cast<char>('a' + index % 26)) + std::to_string(index);
+        };
+
+        std::set<std::string> received;
+        size_t server_received = 0;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            BOOST_REQUIRE(pconn);
+
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                ++server_received;
+
+                // Echo
+                BOOST_REQUIRE_NO_THROW(pconn->send(unit.as_string()));
+            });
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE(unit.is_string());
+
+            received.insert(unit.as_string());
+            if (received.size() < datagrams)
+                return;
+
+            pconn->disconnect();
+
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto client_run = [&]() {
+            BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                    pconn->on_receive(client_recieve_callback);
+
+                                    // Every unit is separate datagram
+                                    for (size_t ci = 0; ci < datagrams; ++ci)
+                                    {
+                                        pconn->post(make_datagram(ci));
+                                        if (ci % batch_size == batch_size - 1)
+                                            BOOST_REQUIRE_NO_THROW(pconn->commit());
+                                    }
+                                    BOOST_REQUIRE_NO_THROW(pconn->commit());
+                                })
+                              .connect(client.configurate_udp()
+                                           .set_address(host, port)
+                                           .set_batch_size(batch_size)
+                                           .enable_offload(offload)));
+        };
+
+        BOOST_REQUIRE(server.on_start(client_run)
+                          .on_new_connection(server_new_connection_callback)
+                          .start(server.configurate_udp()
+                                     .set_address(host, port)
+                                     .set_batch_size(batch_size)
+                                     .enable_offload(offload))
+                          .wait());
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK_EQUAL(received.size(), datagrams);
+        BOOST_CHECK(received.count(make_datagram(0)) > 0);
+        BOOST_CHECK(received.count(make_datagram(datagrams - 1)) > 0);
+        BOOST_CHECK_GE(server_received, datagrams);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(udp_echo_check)
+    {
+        print_current_test_name();
+
+        udp_echo_test(*this, false);
+    }
+
+    BOOST_AUTO_TEST_CASE(udp_offload_echo_check)
+    {
+        print_current_test_name();
+
+        udp_echo_test(*this, true);
+    }
+
+    BOOST_AUTO_TEST_CASE(udp_idle_timeout_check)
+    {
+        print_current_test_name();
+
+        server server;
+        client client;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        const std::string ping_cmd = "ping";
+
+        std::string server_endpoint;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            server_endpoint = pconn->remote_endpoint();
+
+            pconn->on_receive([&](pconnection, unit unit) {
+                     BOOST_REQUIRE_EQUAL(unit.as_string(), ping_cmd);
+                 })
+                .on_disconnect([&]() {
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    done_test = true;
+                    done_test_cond.notify_one();
+                });
+        };
+
+        BOOST_REQUIRE(server.on_new_connection(server_new_connection_callback)
+                          .start(server.configurate_udp()
+                                     .set_address(host, port)
+                                     .set_idle_timeout(100ms))
+                          .wait());
+
+        BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                BOOST_REQUIRE_NO_THROW(pconn->send(ping_cmd));
+                            })
+                          .connect(client.configurate_udp()
+                                       .set_address(host, port)));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK_EQUAL(server_endpoint.find(host + ":"), 0u);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace server_lib
+#endif //SERVER_LIB_PLATFORM_LINUX
@@ -16,6 +16,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <unistd.h>
+
 namespace server_lib {
 namespace tests {
 
@@ -721,6 +723,222 @@ namespace tests {
         BOOST_REQUIRE(!socket_exist());
     }
 
+    BOOST_AUTO_TEST_CASE(unix_local_seqpacket_check)
+    {
+        print_current_test_name();
+
+        server server;
+        client client;
+
+        // Raw bytes that are not valid msg_protocol frames
+        const std::vector<std::string> units = { "first", std::string(3000, '\xff'), "third" };
+        const std::string reply_cmd = "done";
+
+        std::vector<std::string> received;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_disconnect_callback = [&]() {
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                     BOOST_REQUIRE(unit.is_string());
+                     received.emplace_back(unit.as_string());
+                     if (received.size() == units.size())
+                         BOOST_REQUIRE_NO_THROW(pconn->send(reply_cmd));
+                 })
+                .on_disconnect(server_disconnect_callback);
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), reply_cmd);
+
+            pconn->disconnect();
+        };
+
+        BOOST_REQUIRE(server.on_new_connection(server_new_connection_callback)
+                          .start(server.configurate_unix_local()
+                                     .set_socket_file(socket_file)
+                                     .enable_seqpacket())
+                          .wait());
+
+        BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                pconn->on_receive(client_recieve_callback);
+
+                                // Every unit is separate packet
+                                for (auto&& unit : units)
+                                    pconn->post(unit);
+                                BOOST_REQUIRE_NO_THROW(pconn->commit());
+                            })
+                          .connect(client.configurate_unix_local()
+                                       .set_socket_file(socket_file)
+                                       .enable_seqpacket()));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK(received == units);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(unix_local_descriptors_passing_check)
+    {
+        print_current_test_name();
+
+        msg_protocol protocol;
+
+        server server;
+        client client;
+
+        const std::string before_cmd = "before";
+        const std::string fd_cmd = "pipe";
+        const std::string pipe_data = "data from pipe";
+
+        std::string received_data;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_disconnect_callback = [&]() {
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_disconnect(server_disconnect_callback);
+
+            int fds[2];
+            BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+            BOOST_REQUIRE_EQUAL(::write(fds[1], pipe_data.data(), pipe_data.size()), static_cast<ssize_t>(pipe_data.size()));
+            ::close(fds[1]);
+
+            // Descriptor is duplicated for sending
+            BOOST_REQUIRE_NO_THROW(pconn->post(before_cmd).send(fd_cmd, { fds[0] }));
+            ::close(fds[0]);
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            if (unit.as_string() != fd_cmd)
+            {
+                BOOST_REQUIRE_EQUAL(unit.as_string(), before_cmd);
+                return;
+            }
+
+            auto descriptors = pconn->take_descriptors();
+            BOOST_REQUIRE_EQUAL(descriptors.size(), 1u);
+
+            char buff[64];
+            auto sz = ::read(descriptors[0], buff, sizeof(buff));
+            ::close(descriptors[0]);
+            BOOST_REQUIRE_GT(sz, 0);
+            received_data.assign(buff, static_cast<size_t>(sz));
+
+            pconn->disconnect();
+        };
+
+        BOOST_REQUIRE(server.on_new_connection(server_new_connection_callback)
+                          .start(server.configurate_unix_local()
+                                     .set_socket_file(socket_file)
+                                     .set_protocol(protocol))
+                          .wait());
+
+        BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                pconn->on_receive(client_recieve_callback);
+                            })
+                          .connect(client.configurate_unix_local()
+                                       .set_socket_file(socket_file)
+                                       .set_protocol(protocol)));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK_EQUAL(received_data, pipe_data);
+
+        server.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(unix_local_shared_memory_check)
+    {
+        print_current_test_name();
+
+        // Messages are larger than ring to check wrap around
+        // and waiting for free space
+        const size_t ring_size = 4096;
+        msg_protocol protocol { 5 * ring_size };
+
+        server server;
+        client client;
+
+        const std::vector<std::string> units = { "first", std::string(3 * ring_size, 'x'), "third" };
+        const size_t pings = 20;
+
+        size_t server_received = 0;
+        size_t client_received = 0;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        auto server_disconnect_callback = [&]() {
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto server_new_connection_callback = [&](pconnection pconn) {
+            pconn->on_receive([&](pconnection pconn, unit unit) {
+                     BOOST_REQUIRE_EQUAL(unit.as_string(), units[server_received % units.size()]);
+                     ++server_received;
+                     // Echo
+                     BOOST_REQUIRE_NO_THROW(pconn->send(unit.as_string()));
+                 })
+                .on_disconnect(server_disconnect_callback);
+        };
+
+        auto client_recieve_callback = [&](pconnection pconn, unit unit) {
+            BOOST_REQUIRE_EQUAL(unit.as_string(), units[client_received % units.size()]);
+            if (++client_received < pings * units.size())
+                return;
+
+            pconn->disconnect();
+        };
+
+        BOOST_REQUIRE(server.on_new_connection(server_new_connection_callback)
+                          .start(server.configurate_unix_local()
+                                     .set_socket_file(socket_file)
+                                     .set_protocol(protocol)
+                                     .enable_shared_memory(ring_size))
+                          .wait());
+
+        BOOST_REQUIRE(client.on_connect([&](pconnection pconn) {
+                                pconn->on_receive(client_recieve_callback);
+
+                                for (size_t ci = 0; ci < pings; ++ci)
+                                {
+                                    for (auto&& unit : units)
+                                        BOOST_REQUIRE_NO_THROW(pconn->send(unit));
+                                }
+                            })
+                          .connect(client.configurate_unix_local()
+                                       .set_socket_file(socket_file)
+                                       .set_protocol(protocol)
+                                       .enable_shared_memory(ring_size)));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_CHECK_EQUAL(server_received, pings * units.size());
+        BOOST_CHECK_EQUAL(client_received, pings * units.size());
+
+        server.stop();
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -4,6 +4,9 @@
 #include <server_lib/observer.h>
 #include <server_lib/simple_observer.h>
 
+#include <thread>
+#include <atomic>
+
 
 namespace server_lib {
 namespace tests {
@@ -411,6 +414,238 @@ namespace tests {
         BOOST_REQUIRE_EQUAL(arg2, arg2_val);
     }
 
+    BOOST_AUTO_TEST_CASE(simple_observer_subscribe_in_notify_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(int)>;
+        using observer_type = simple_observable<callback_type>;
+
+        observer_type observer;
+
+        int first_calls = 0;
+        int second_calls = 0;
+        observer.subscribe([&](int) {
+            if (!first_calls++)
+            {
+                // Subscribe in notification is allowed.
+                // New subscriber is not notified for current event
+                observer.subscribe([&](int) {
+                    ++second_calls;
+                });
+            }
+        });
+
+        observer.notify(1);
+
+        BOOST_REQUIRE_EQUAL(first_calls, 1);
+        BOOST_REQUIRE_EQUAL(second_calls, 0);
+
+        observer.notify(2);
+
+        BOOST_REQUIRE_EQUAL(first_calls, 2);
+        BOOST_REQUIRE_EQUAL(second_calls, 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(simple_observer_mt_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(const std::string&)>;
+        using observer_type = simple_observable<callback_type>;
+
+        observer_type observer;
+
+        const size_t subscribers = 50;
+        std::atomic<size_t> calls { 0 };
+        std::atomic_bool invalid_value { false };
+
+        std::thread publisher([&]() {
+            while (!observer.is_any_subscriber())
+                std::this_thread::yield();
+            for (size_t ci = 0; ci < 1000; ++ci)
+            {
+                observer.notify(std::string { "test" });
+            }
+        });
+
+        for (size_t ci = 0; ci < subscribers; ++ci)
+        {
+            observer.subscribe([&](const std::string& value) {
+                if (value != "test")
+                    invalid_value = true;
+                ++calls;
+            });
+        }
+
+        publisher.join();
+
+        BOOST_REQUIRE(!invalid_value);
+
+        calls = 0;
+        observer.notify(std::string { "test" });
+        BOOST_REQUIRE_EQUAL(calls.load(), subscribers);
+    }
+
+    BOOST_AUTO_TEST_CASE(observer_weak_check)
+    {
+        print_current_test_name();
+
+        server_lib::observable<test_sink_i> testing_observable;
+
+        test_observer_impl observer1;
+        auto observer2 = std::make_shared<test_observer_impl>();
+
+        testing_observable.subscribe(observer1);
+        testing_observable.subscribe(observer2);
+
+        testing_observable.notify(&test_sink_i::on_test1);
+
+        BOOST_REQUIRE(observer1.expect_on_test1());
+        BOOST_REQUIRE(observer2->expect_on_test1());
+
+        observer2.reset();
+        observer1.reset();
+
+        BOOST_REQUIRE_NO_THROW(testing_observable.notify(&test_sink_i::on_test1));
+        BOOST_REQUIRE(observer1.expect_on_test1());
+    }
+
+    BOOST_AUTO_TEST_CASE(simple_observer_unsubscribe_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(int)>;
+        using observer_type = simple_observable<callback_type>;
+
+        observer_type observer;
+
+        int calls1 = 0;
+        int calls2 = 0;
+        int calls3 = 0;
+
+        auto subscription1 = observer.subscribe([&](int) { ++calls1; });
+        {
+            scoped_subscription subscription2 = observer.subscribe([&](int) { ++calls2; });
+            // Not controlled
+            observer.subscribe([&](int) { ++calls3; });
+
+            BOOST_REQUIRE(subscription1.is_active());
+            BOOST_REQUIRE(subscription2.is_active());
+
+            observer.notify(1);
+        }
+
+        observer.notify(2);
+
+        subscription1.unsubscribe();
+
+        BOOST_REQUIRE(!subscription1.is_active());
+
+        observer.notify(3);
+
+        BOOST_REQUIRE_EQUAL(calls1, 2);
+        BOOST_REQUIRE_EQUAL(calls2, 1);
+        BOOST_REQUIRE_EQUAL(calls3, 3);
+        BOOST_REQUIRE(observer.is_any_subscriber());
+
+        // Many temporary subscriptions don't grow notification list
+        for (size_t ci = 0; ci < 100; ++ci)
+        {
+            scoped_subscription temporary = observer.subscribe([&](int) { ++calls1; });
+            observer.notify(4);
+        }
+
+        BOOST_REQUIRE_EQUAL(calls1, 2 + 100);
+        BOOST_REQUIRE_EQUAL(calls3, 3 + 100);
+    }
+
+    BOOST_AUTO_TEST_CASE(simple_observer_weak_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(int)>;
+        using observer_type = simple_observable<callback_type>;
+
+        observer_type observer;
+
+        struct owner_type
+        {
+            int calls = 0;
+        };
+
+        auto owner = std::make_shared<owner_type>();
+        int calls = 0;
+
+        observer.subscribe_weak(owner, [powner = owner.get(), &calls](int) {
+            ++powner->calls;
+            ++calls;
+        });
+
+        BOOST_REQUIRE(observer.is_any_subscriber());
+
+        observer.notify(1);
+
+        BOOST_REQUIRE_EQUAL(owner->calls, 1);
+
+        owner.reset();
+
+        BOOST_REQUIRE(!observer.is_any_subscriber());
+
+        observer.notify(2);
+
+        BOOST_REQUIRE_EQUAL(calls, 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(simple_observer_destroy_in_notify_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(void)>;
+        using observer_type = simple_observable<callback_type>;
+
+        auto observer = std::make_unique<observer_type>();
+
+        int calls = 0;
+        auto temporary = observer->subscribe([&]() { ++calls; });
+        temporary.unsubscribe();
+        observer->subscribe([&]() {
+            observer.reset();
+        });
+        observer->subscribe([&]() { ++calls; });
+
+        observer->notify();
+
+        BOOST_REQUIRE(!observer);
+        BOOST_REQUIRE_EQUAL(calls, 1);
+    }
+
+    BOOST_AUTO_TEST_CASE(simple_observer_copy_check)
+    {
+        print_current_test_name();
+
+        using callback_type = std::function<void(int)>;
+        using observer_type = simple_observable<callback_type>;
+
+        observer_type observer;
+
+        int calls = 0;
+        auto subscription1 = observer.subscribe([&](int) { ++calls; });
+
+        observer_type observer_copy { observer };
+
+        subscription1.unsubscribe();
+
+        observer.notify(1);
+        BOOST_REQUIRE_EQUAL(calls, 0);
+        BOOST_REQUIRE(!observer.is_any_subscriber());
+
+        // Copy has own subscription
+        observer_copy.notify(2);
+        BOOST_REQUIRE_EQUAL(calls, 1);
+        BOOST_REQUIRE(observer_copy.is_any_subscriber());
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -7,13 +7,18 @@
 
 #include <server_lib/logging_helper.h>
 #include <server_lib/spawn.h>
+#include <server_lib/spawn_pool.h>
 #include <server_lib/event_loop.h>
 #include <ssl_helpers/hash.h>
 #include <ssl_helpers/encoding.h>
 
+#include <boost/filesystem.hpp>
+
 #include <string>
 #include <chrono>
+#include <fstream>
 #include <unistd.h>
+#include <fcntl.h>
 
 namespace server_lib {
 namespace tests {
@@ -194,6 +199,41 @@ namespace tests {
         }
     }
 
+    BOOST_AUTO_TEST_CASE(spawn_async_exit_callback_check)
+    {
+        print_current_test_name();
+
+        const size_t spawn_count = 10;
+        spawn_polling poll;
+
+        std::atomic_size_t finished_count { 0 };
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        for (size_t ci = 0; ci < spawn_count; ++ci)
+        {
+            spawn_ptr sleep = std::make_shared<spawn>(spawn::args_type { "sleep", "0.1" }, true);
+
+            poll.append(sleep, [&, spawn_count](const spawn_ptr& finished) {
+                if (finished->returncode() != 0 || finished->sigcode() != 0)
+                    return;
+
+                if (++finished_count == spawn_count)
+                {
+                    // Finish test
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    done_test = true;
+                    done_test_cond.notify_one();
+                }
+            });
+        }
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+        BOOST_REQUIRE_EQUAL(finished_count.load(), spawn_count);
+        BOOST_REQUIRE(poll.empty());
+    }
+
     BOOST_AUTO_TEST_CASE(spawn_async_multy_aborted_check)
     {
         print_current_test_name();
@@ -287,6 +327,114 @@ namespace tests {
         BOOST_CHECK_EQUAL(ssl_helpers::to_hex(bin_data), ssl_helpers::to_hex(std::string(buff.data(), buff.size())));
     }
 
+    BOOST_AUTO_TEST_CASE(spawn_big_output_communication_check)
+    {
+        print_current_test_name();
+
+        // Output exceeds pipe capacity
+        const size_t output_size = 1024 * 1024;
+
+        spawn head({ "head", "-c", std::to_string(output_size), "/dev/zero" }, true);
+
+        head.communicate();
+
+        std::string output { std::istreambuf_iterator<char>(head.stdout), std::istreambuf_iterator<char>() };
+        BOOST_CHECK_EQUAL(output.size(), output_size);
+        BOOST_CHECK_EQUAL(head.returncode(), 0);
+    }
+
+    BOOST_AUTO_TEST_CASE(spawn_splice_communication_check)
+    {
+        print_current_test_name();
+
+        const size_t data_size = 1024 * 1024 + 7;
+
+        auto input_path = create_binary_data_file(data_size);
+        auto output_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+        int input_fd = ::open(input_path.c_str(), O_RDONLY);
+        int output_fd = ::open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        BOOST_REQUIRE(input_fd >= 0 && output_fd >= 0);
+
+        spawn cat({ "cat" }, true);
+
+        cat.communicate(input_fd, output_fd);
+
+        ::close(input_fd);
+        ::close(output_fd);
+
+        BOOST_CHECK_EQUAL(cat.returncode(), 0);
+        BOOST_REQUIRE_EQUAL(boost::filesystem::file_size(output_path), data_size);
+
+        std::ifstream input_file(input_path.generic_string(), std::ios::binary);
+        std::ifstream output_file(output_path.generic_string(), std::ios::binary);
+        BOOST_CHECK(std::equal(std::istreambuf_iterator<char>(input_file), std::istreambuf_iterator<char>(),
+                               std::istreambuf_iterator<char>(output_file)));
+
+        boost::filesystem::remove(input_path);
+        boost::filesystem::remove(output_path);
+    }
+
+    BOOST_AUTO_TEST_CASE(spawn_async_io_check)
+    {
+        print_current_test_name();
+
+        const size_t chunk_size = 16 * 1024;
+        const size_t chunks = 256;
+        const size_t high_watermark = 8 * chunk_size;
+
+        server_lib::event_loop loop;
+        loop.change_loop_name("spawn_io");
+        loop.start();
+        loop.wait();
+
+        spawn cat({ "cat" }, true);
+
+        std::string output;
+        size_t max_pending = 0;
+        size_t written = 0;
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        std::function<void()> write_next = [&]() {
+            // Back-pressure: stop writing until pending data have drained
+            while (written < chunks)
+            {
+                auto pending = cat.async_write(std::string(chunk_size, static_cast<char>('a' + written % 26)));
+                ++written;
+                max_pending = std::max(max_pending, pending);
+                if (pending >= high_watermark)
+                    return;
+            }
+            cat.async_close_stdin();
+        };
+
+        cat.async_io(loop,
+                     [&](const char* data, size_t size) {
+                         if (!size)
+                         {
+                             // Finish test
+                             std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                             done_test = true;
+                             done_test_cond.notify_one();
+                             return;
+                         }
+                         output.append(data, size);
+                     })
+            .on_drain([&]() { write_next(); });
+
+        loop.post([&]() { write_next(); });
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        BOOST_REQUIRE_EQUAL(output.size(), chunk_size * chunks);
+        BOOST_CHECK_EQUAL(output[0], 'a');
+        BOOST_CHECK_EQUAL(output.back(), static_cast<char>('a' + (chunks - 1) % 26));
+        BOOST_CHECK_LT(max_pending, high_watermark + chunk_size);
+        BOOST_CHECK_EQUAL(cat.wait().returncode(), 0);
+    }
+
     BOOST_AUTO_TEST_CASE(spawn_suspended_check)
     {
         print_current_test_name();
@@ -366,6 +514,14 @@ namespace tests {
         BOOST_CHECK_EQUAL(bash.sigcode(), bash.returncode());
     }
 
+    BOOST_AUTO_TEST_CASE(spawn_exec_error_check)
+    {
+        print_current_test_name();
+
+        // posix_spawn reports exec error to parent
+        BOOST_REQUIRE_THROW(spawn({ "/nonexistent/spawn_exec_error_check" }), std::logic_error);
+    }
+
     BOOST_AUTO_TEST_CASE(spawn_returncode_check)
     {
         print_current_test_name();
@@ -417,6 +573,106 @@ namespace tests {
         BOOST_CHECK_EQUAL(bash.returncode(), 0);
     }
 
+    BOOST_AUTO_TEST_CASE(spawn_pool_check)
+    {
+        print_current_test_name();
+
+        const size_t requests = 200;
+        const size_t max_in_flight = 8;
+
+        // 'cat' echoes framed requests
+        spawn_pool pool({ "cat" }, 3, max_in_flight);
+        pool.start();
+
+        std::mutex guard;
+        size_t sent = 0;
+        size_t succeeded = 0;
+        size_t rejected = 0;
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        std::function<void()> send_next;
+        send_next = [&]() {
+            std::unique_lock<std::mutex> lck(guard);
+            while (sent < requests)
+            {
+                auto payload = "request #" + std::to_string(sent);
+                if (!pool.request(payload, [&, payload](bool success, const std::string& response) {
+                        {
+                            std::unique_lock<std::mutex> lck(guard);
+                            if (success && response == payload)
+                                ++succeeded;
+                            if (succeeded == requests)
+                            {
+                                // Finish test
+                                std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                                done_test = true;
+                                done_test_cond.notify_one();
+                            }
+                        }
+                        send_next();
+                    }))
+                {
+                    ++rejected;
+                    return;
+                }
+                ++sent;
+            }
+        };
+
+        send_next();
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+        BOOST_CHECK_EQUAL(succeeded, requests);
+        BOOST_CHECK_GT(rejected, 0u);
+        BOOST_CHECK_EQUAL(pool.worker_pids().size(), 3u);
+
+        pool.stop();
+    }
+
+    BOOST_AUTO_TEST_CASE(spawn_pool_restart_check)
+    {
+        print_current_test_name();
+
+        spawn_pool pool({ "cat" }, 2);
+        pool.start();
+
+        auto pids = pool.worker_pids();
+        BOOST_REQUIRE_EQUAL(pids.size(), 2u);
+
+        ::kill(pids[0], SIGKILL);
+
+        for (size_t ci = 0; ci < 50 && (pool.restarts() < 1 || pool.worker_pids().size() < 2); ++ci)
+            std::this_thread::sleep_for(100ms);
+
+        BOOST_REQUIRE_EQUAL(pool.restarts(), 1u);
+
+        auto new_pids = pool.worker_pids();
+        BOOST_REQUIRE_EQUAL(new_pids.size(), 2u);
+        BOOST_CHECK(std::find(new_pids.begin(), new_pids.end(), pids[0]) == new_pids.end());
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+        std::atomic_size_t succeeded { 0 };
+
+        for (size_t ci = 0; ci < 4; ++ci)
+        {
+            BOOST_REQUIRE(pool.request("ping", [&](bool success, const std::string& response) {
+                if (success && response == "ping" && ++succeeded == 4)
+                {
+                    // Finish test
+                    std::unique_lock<std::mutex> lck(done_test_cond_guard);
+                    done_test = true;
+                    done_test_cond.notify_one();
+                }
+            }));
+        }
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace server_lib
@@ -144,6 +144,38 @@ namespace tests {
         storage.remove();
     }
 
+    BOOST_AUTO_TEST_CASE(local_storage_slot_reuse_check)
+    {
+        print_current_test_name();
+
+        constexpr size_t STORAGE_SIZE = 1024;
+        {
+            thread_local_storage storage(2);
+            storage.create(STORAGE_SIZE, 1);
+            BOOST_REQUIRE_EQUAL(storage.size(1), STORAGE_SIZE);
+            BOOST_REQUIRE(storage.get_ref(0).empty());
+
+            std::thread th([&]() {
+                // Buffer is dedicated to main thread
+                BOOST_CHECK(storage.get_ref(1).empty());
+                storage.create(STORAGE_SIZE / 2, 1);
+                BOOST_CHECK_EQUAL(storage.size(1), STORAGE_SIZE / 2);
+            });
+            th.join();
+
+            BOOST_REQUIRE_EQUAL(storage.size(1), STORAGE_SIZE);
+        }
+
+        // Slot of destroyed storage is reused without its data
+        thread_local_storage storage(2);
+        BOOST_REQUIRE(storage.get_ref(1).empty());
+        BOOST_REQUIRE_THROW(storage.get(1), std::logic_error);
+
+        storage.create(STORAGE_SIZE, 1);
+        storage.remove(1);
+        BOOST_REQUIRE(storage.get_ref(1).empty());
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 } // namespace tests
 } // namespace server_lib
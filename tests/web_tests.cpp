@@ -857,6 +857,96 @@ namespace tests {
         BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
     }
 
+
+    BOOST_AUTO_TEST_CASE(server_metrics_check)
+    {
+        print_current_test_name();
+
+        using namespace web;
+
+        web_server server;
+
+        std::string host = get_default_address();
+        auto port = get_free_port();
+
+        auto server_request_callback = [](
+                                           std::shared_ptr<web_request_i> request,
+                                           std::shared_ptr<web_server_response_i> response) {
+            response->post(http_status_code::success_ok, "pong", { { "Content-Type", "text/plain" } });
+        };
+
+        const std::string RESOURCE_PATH = "/test";
+        const std::string METRICS_PATH = "/metrics";
+
+        BOOST_REQUIRE(server
+                          .on_request(RESOURCE_PATH, server_request_callback)
+                          .add_metrics("extra", []() {
+                              network::network_stats stats;
+                              stats.bytes_in = 42;
+                              return stats;
+                          })
+                          .start(
+                              server.configurate()
+                                  .set_address(host, port)
+                                  .set_worker_name("!S")
+                                  .enable_metrics(METRICS_PATH))
+                          .wait());
+
+        web_client client;
+
+        bool done_test = false;
+        std::mutex done_test_cond_guard;
+        std::condition_variable done_test_cond;
+
+        std::string metrics;
+
+        auto metrics_for_client = [&](std::shared_ptr<web_response_i> response,
+                                      const std::string& err) {
+            BOOST_REQUIRE(response);
+            long status_code = std::atol(response->status_code().c_str());
+            BOOST_REQUIRE_EQUAL(static_cast<int>(status_code), static_cast<int>(http_status_code::success_ok));
+
+            metrics = response->load_content();
+
+            // Finish test
+            std::unique_lock<std::mutex> lck(done_test_cond_guard);
+            done_test = true;
+            done_test_cond.notify_one();
+        };
+
+        auto respose_for_client = [&](std::shared_ptr<web_response_i> response,
+                                      const std::string& err) {
+            BOOST_REQUIRE(response);
+
+            client.request(METRICS_PATH, "GET", "", metrics_for_client);
+        };
+
+        BOOST_REQUIRE(client
+                          .start(
+                              client.configurate()
+                                  .set_address(host, port)
+                                  .set_worker_name("!C"))
+                          .wait());
+
+        client.request(RESOURCE_PATH, "ping", std::move(respose_for_client));
+
+        BOOST_REQUIRE(waiting_for_asynch_test(done_test, done_test_cond, done_test_cond_guard));
+
+        LOG_TRACE(metrics);
+
+        BOOST_CHECK_NE(metrics.find("# TYPE server_lib_received_units_total counter"), std::string::npos);
+        // Both requests are received by the moment of rendering
+        BOOST_CHECK_NE(metrics.find("server_lib_received_units_total{source=\"web_server\"} 2"), std::string::npos);
+        BOOST_CHECK_NE(metrics.find("server_lib_received_bytes_total{source=\"extra\"} 42"), std::string::npos);
+        BOOST_CHECK_NE(metrics.find("server_lib_loop_posts_total{source=\"web_server\"}"), std::string::npos);
+        BOOST_CHECK_NE(metrics.find("server_lib_rtt_seconds{source=\"web_server\",quantile=\"0.99\"}"), std::string::npos);
+
+        auto stats = server.stats();
+        BOOST_CHECK_EQUAL(stats.units_in, 2u);
+        BOOST_CHECK_GT(stats.bytes_in, 0u);
+        BOOST_CHECK_GT(stats.read_calls, 0u);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests